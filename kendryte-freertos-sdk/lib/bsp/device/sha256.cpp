@@ -48,6 +48,9 @@ static inline uint64_t byteswap64(uint64_t x)
     return ((uint64_t)BYTESWAP(b) << 32) | (uint64_t)BYTESWAP(a);
 }
 
+/* Blocks in the persistent DMA buffer: an 80-byte header pads to 2 blocks */
+#define SHA256_DMA_BUF_BLOCKS 4
+
 class k_sha256_driver : public sha256_driver, public static_object, public free_object_access
 {
 public:
@@ -69,6 +72,18 @@ public:
 
     virtual void on_last_close() override
     {
+        if (dma_write_)
+        {
+            dma_close(dma_write_);
+            dma_write_ = 0;
+        }
+        if (event_write_)
+        {
+            vSemaphoreDelete(event_write_);
+            event_write_ = nullptr;
+        }
+        free(dma_buf_);
+        dma_buf_ = nullptr;
         sysctl_clock_disable(clock_);
     }
 
@@ -76,37 +91,61 @@ public:
     {
         COMMON_ENTRY;
 
+        size_t blocks = (input_data.size() + SHA256_BLOCK_LEN + 8) / SHA256_BLOCK_LEN;
+        uint32_t *buf;
+
+        prepare();
+        buf = blocks <= SHA256_DMA_BUF_BLOCKS && dma_buf_ ? dma_buf_ : (uint32_t *)malloc(blocks * SHA256_BLOCK_LEN);
+        configASSERT(buf);
+        calculate(buf, input_data.data(), input_data.size(), output_data.data());
+        if (buf != dma_buf_)
+            free(buf);
+    }
+
+private:
+    /* The DMA channel, its completion event and the DMA buffer are taken on first use and kept until the last close */
+    void prepare()
+    {
+        if (!dma_buf_)
+            dma_buf_ = (uint32_t *)malloc(SHA256_DMA_BUF_BLOCKS * SHA256_BLOCK_LEN);
+        if (!event_write_)
+            event_write_ = xSemaphoreCreateBinary();
+        if (!dma_write_)
+        {
+            dma_write_ = dma_open_free();
+            dma_set_request_source(dma_write_, SYSCTL_DMA_SELECT_SHA_RX_REQ);
+        }
+    }
+
+    /* The engine produces a single digest per run, so messages cannot share a DMA transfer */
+    void calculate(uint32_t *buf, const uint8_t *input, size_t input_len, uint8_t *output)
+    {
         uint32_t i = 0;
         sha256_context_t context;
-        sha256_.sha_function_reg_0.sha_endian = SHA256_BIG_ENDIAN;
-        sha256_.sha_function_reg_0.sha_en = ENABLE_SHA;
-        sha256_.sha_num_reg.sha_data_cnt = (input_data.size() + SHA256_BLOCK_LEN + 8) / SHA256_BLOCK_LEN;
-        context.dma_buf = (uint32_t *)malloc((input_data.size() + SHA256_BLOCK_LEN + 8) / SHA256_BLOCK_LEN * 16 * sizeof(uint32_t));
+
+        context.dma_buf = buf;
         context.buffer_len = 0L;
         context.dma_buf_len = 0L;
         context.total_len = 0L;
-        for (i = 0; i < (sizeof(context.dma_buf) / 4); i++)
-            context.dma_buf[i] = 0;
-        sha256_update_buf(&context, input_data.data(), input_data.size());
+        sha256_update_buf(&context, input, input_len);
         sha256_final_buf(&context);
 
-        uintptr_t dma_write = dma_open_free();
-
-        dma_set_request_source(dma_write, SYSCTL_DMA_SELECT_SHA_RX_REQ);
-
-        SemaphoreHandle_t event_write = xSemaphoreCreateBinary();
+        sha256_.sha_function_reg_0.sha_endian = SHA256_BIG_ENDIAN;
+        sha256_.sha_function_reg_0.sha_en = ENABLE_SHA;
+        sha256_.sha_num_reg.sha_data_cnt = context.dma_buf_len / 16;
 
-        dma_transmit_async(dma_write, context.dma_buf, &sha256_.sha_data_in1, 1, 0, sizeof(uint32_t), context.dma_buf_len, 16, event_write);
+        dma_transmit_async(dma_write_, context.dma_buf, &sha256_.sha_data_in1, 1, 0, sizeof(uint32_t), context.dma_buf_len, 16, event_write_);
         sha256_.sha_function_reg_1.dma_en = 0x1;
-        configASSERT(xSemaphoreTake(event_write, portMAX_DELAY) == pdTRUE);
+        configASSERT(xSemaphoreTake(event_write_, portMAX_DELAY) == pdTRUE);
 
         while (!(sha256_.sha_function_reg_0.sha_en))
             ;
+        /* The caller's buffer may be unaligned */
         for (i = 0; i < SHA256_HASH_WORDS; i++)
-            *((uint32_t *)&output_data[i * 4]) = sha256_.sha_result[SHA256_HASH_WORDS - i - 1];
-        free(context.dma_buf);
-        dma_close(dma_write);
-        vSemaphoreDelete(event_write);
+        {
+            uint32_t word = sha256_.sha_result[SHA256_HASH_WORDS - i - 1];
+            memcpy(&output[i * 4], &word, sizeof(word));
+        }
     }
 
 private:
@@ -156,6 +195,9 @@ private:
     volatile sha256_t &sha256_;
     sysctl_clock_t clock_;
     SemaphoreHandle_t free_mutex_;
+    uintptr_t dma_write_ = 0;
+    SemaphoreHandle_t event_write_ = nullptr;
+    uint32_t *dma_buf_ = nullptr;
 };
 
 static k_sha256_driver dev0_driver(SHA256_BASE_ADDR, SYSCTL_CLOCK_SHA);
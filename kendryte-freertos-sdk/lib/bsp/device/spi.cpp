@@ -91,6 +91,7 @@ public:
 
     double set_clock_rate(k_spi_device_driver &device, double clock_rate);
     void set_endian(k_spi_device_driver &device, uint32_t endian);
+    void set_dma_threshold(k_spi_device_driver &device, size_t frames);
     int read(k_spi_device_driver &device, gsl::span<uint8_t> buffer);
     int write(k_spi_device_driver &device, gsl::span<const uint8_t> buffer);
     int transfer_full_duplex(k_spi_device_driver &device, gsl::span<const uint8_t> write_buffer, gsl::span<uint8_t> read_buffer);
@@ -567,6 +568,11 @@ public:
     {
         spi_->set_endian(*this, endian);
     }
+
+    virtual void set_dma_threshold(size_t frames) override
+    {
+        spi_->set_dma_threshold(*this, frames);
+    }
 	
     virtual int read(gsl::span<uint8_t> buffer) override
     {
@@ -633,6 +639,7 @@ private:
     uint32_t baud_rate_ = 0x2;
     uint32_t buffer_width_ = 0;
     uint32_t endian_ = 0;
+    size_t dma_threshold_ = SPI_TRANSMISSION_THRESHOLD;
 };
 
 object_ptr<spi_device_driver> k_spi_driver::get_device(spi_mode_t mode, spi_frame_format_t frame_format, uint32_t chip_select_mask, uint32_t data_bit_length)
@@ -657,6 +664,11 @@ void k_spi_driver::set_endian(k_spi_device_driver &device, uint32_t endian)
     device.endian_ = endian;
 }
 
+void k_spi_driver::set_dma_threshold(k_spi_device_driver &device, size_t frames)
+{
+    device.dma_threshold_ = std::max(frames, (size_t)1);
+}
+
 int k_spi_driver::read(k_spi_device_driver &device, gsl::span<uint8_t> buffer)
 {
     COMMON_ENTRY;
@@ -831,7 +843,7 @@ int k_spi_driver::read_write(k_spi_device_driver &device, gsl::span<const uint8_
     auto buffer_write = write_buffer.data();
     uint32_t i = 0;
 
-    if (rx_frames < SPI_TRANSMISSION_THRESHOLD)
+    if (rx_frames < device.dma_threshold_)
     {
         vTaskEnterCritical();
         size_t index, fifo_len;
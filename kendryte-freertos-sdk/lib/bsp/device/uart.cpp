@@ -12,6 +12,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
 #include <FreeRTOS.h>
 #include <hal.h>
 #include <kernel/driver_impl.hpp>
@@ -25,8 +26,13 @@
 using namespace sys;
 
 #define UART_BRATE_CONST 16
-#define RINGBUFF_LEN 64
+#define RINGBUFF_LEN 512
+#define UART_DMA_THRESHOLD 8
+/* Longest write sent in one DMA transfer; covers a full AUC request burst */
+#define UART_DMA_BUFFER_LEN 256
 
+/* Single producer (IRQ) and single consumer (read): head belongs to the
+ * reader, tail to the IRQ, length is shared and only touched atomically */
 typedef struct
 {
     size_t head;
@@ -38,8 +44,8 @@ typedef struct
 class k_uart_driver : public uart_driver, public static_object, public free_object_access
 {
 public:
-    k_uart_driver(uintptr_t base_addr, sysctl_clock_t clock, plic_irq_t irq)
-        : uart_(*reinterpret_cast<volatile uart_t *>(base_addr)), clock_(clock), irq_(irq)
+    k_uart_driver(uintptr_t base_addr, sysctl_clock_t clock, plic_irq_t irq, sysctl_dma_select_t dma_req)
+        : uart_(*reinterpret_cast<volatile uart_t *>(base_addr)), clock_(clock), irq_(irq), dma_req_(dma_req)
     {
     }
 
@@ -58,6 +64,11 @@ public:
         ring_buff->tail = 0;
         ring_buff->length = 0;
         recv_buf_ = ring_buff;
+        /* TX channel and word buffer are held while the port is open, so a
+         * write never waits for a free channel or allocates */
+        dma_words_ = new uint32_t[UART_DMA_BUFFER_LEN];
+        dma_write_ = dma_open_free();
+        dma_set_request_source(dma_write_, dma_req_);
         pic_set_irq_handler(irq_, on_irq_apbuart_recv, this);
         pic_set_irq_priority(irq_, 1);
         pic_set_irq_enable(irq_, 1);
@@ -65,6 +76,8 @@ public:
 
     virtual void on_last_close() override
     {
+        dma_close(dma_write_);
+        delete[] dma_words_;
         sysctl_clock_disable(clock_);
         delete recv_buf_;
     }
@@ -117,6 +130,9 @@ public:
         uart_.LCR = (databits - 5) | (stopbit_val << 2) | (parity_val << 3);
         uart_.LCR &= ~(1u << 7);
         uart_.MCR &= ~3;
+        /* FIFO enabled, DMA mode 1, TX request at 2 chars left, RX trigger at
+         * half FIFO; the character timeout interrupt flushes shorter tails */
+        uart_.FCR = (2u << 6) | (1u << 4) | (1u << 3) | 1u;
         uart_.IER = 1;
     }
 
@@ -127,6 +143,22 @@ public:
 
     virtual int write(gsl::span<const uint8_t> buffer) override
     {
+        if (buffer.size() >= UART_DMA_THRESHOLD)
+        {
+            /* THR takes 32-bit DMA elements: widen each byte to a word */
+            size_t sent = 0;
+            while (sent < buffer.size())
+            {
+                size_t len = std::min(buffer.size() - sent, (size_t)UART_DMA_BUFFER_LEN);
+                for (size_t i = 0; i < len; i++)
+                    dma_words_[i] = buffer[sent + i];
+
+                dma_transmit(dma_write_, dma_words_, &uart_.THR, 1, 0, sizeof(uint32_t), len, 1);
+                sent += len;
+            }
+            return sent;
+        }
+
         auto it = buffer.begin();
         int write = 0;
         while (write < buffer.size())
@@ -156,12 +188,12 @@ private:
     {
         ringbuffer_t *ring_buff = recv_buf_;
 
-        if (ring_buff->length >= RINGBUFF_LEN)
+        if (__atomic_load_n(&ring_buff->length, __ATOMIC_ACQUIRE) >= RINGBUFF_LEN)
             return -1;
 
         ring_buff->ring_buffer[ring_buff->tail] = rdata;
         ring_buff->tail = (ring_buff->tail + 1) % RINGBUFF_LEN;
-        ring_buff->length++;
+        __atomic_fetch_add(&ring_buff->length, 1, __ATOMIC_RELEASE);
         return 0;
     }
 
@@ -171,11 +203,11 @@ private:
         size_t cnt = 0;
         while (len)
         {
-            if(ring_buff->length)
+            if(__atomic_load_n(&ring_buff->length, __ATOMIC_ACQUIRE))
             {
                 *(rData++) = ring_buff->ring_buffer[ring_buff->head];
                 ring_buff->head = (ring_buff->head + 1) % RINGBUFF_LEN;
-                ring_buff->length--;
+                __atomic_fetch_sub(&ring_buff->length, 1, __ATOMIC_RELEASE);
                 cnt++;
                 len--;
             }
@@ -187,7 +219,8 @@ private:
                 }
                 else
                 {
-                    return -1;
+                    /* Bytes already taken from the ring must not be lost */
+                    return cnt ? cnt : -1;
                 }
             }
         }
@@ -216,15 +249,18 @@ private:
     volatile uart_t &uart_;
     sysctl_clock_t clock_;
     plic_irq_t irq_;
+    sysctl_dma_select_t dma_req_;
     SemaphoreHandle_t receive_event_;
 
     ringbuffer_t *recv_buf_;
+    uintptr_t dma_write_;
+    uint32_t *dma_words_;
     size_t read_timeout_ = portMAX_DELAY;
 };
 
-static k_uart_driver dev0_driver(UART1_BASE_ADDR, SYSCTL_CLOCK_UART1, IRQN_UART1_INTERRUPT);
-static k_uart_driver dev1_driver(UART2_BASE_ADDR, SYSCTL_CLOCK_UART2, IRQN_UART2_INTERRUPT);
-static k_uart_driver dev2_driver(UART3_BASE_ADDR, SYSCTL_CLOCK_UART3, IRQN_UART3_INTERRUPT);
+static k_uart_driver dev0_driver(UART1_BASE_ADDR, SYSCTL_CLOCK_UART1, IRQN_UART1_INTERRUPT, SYSCTL_DMA_SELECT_UART1_TX_REQ);
+static k_uart_driver dev1_driver(UART2_BASE_ADDR, SYSCTL_CLOCK_UART2, IRQN_UART2_INTERRUPT, SYSCTL_DMA_SELECT_UART2_TX_REQ);
+static k_uart_driver dev2_driver(UART3_BASE_ADDR, SYSCTL_CLOCK_UART3, IRQN_UART3_INTERRUPT, SYSCTL_DMA_SELECT_UART3_TX_REQ);
 
 driver &g_uart_driver_uart0 = dev0_driver;
 driver &g_uart_driver_uart1 = dev1_driver;
@@ -135,6 +135,12 @@ enum
 /* Diagnostics */
 #define configCHECK_FOR_STACK_OVERFLOW          1
 
+/* Trace: called on every context switch with the switched-in task's core and
+   whether it is that core's idle task. Used for per-core load accounting; the
+   default in os_entry.c is a weak no-op the application may override. */
+extern void vApplicationTaskSwitchedIn(uint32_t core, int is_idle);
+#define traceTASK_SWITCHED_IN()					vApplicationTaskSwitchedIn( ( uint32_t ) uxPsrId, pxCurrentTCB[ uxPsrId ] == xIdleTaskHandle[ uxPsrId ] )
+
 /* configASSERT behaviour */
 extern void vPortFatal(const char* file, int line, const char* message);
 /* Normal assert() semantics without relying on the provision of an assert.h header file. */
@@ -321,6 +321,18 @@ double spi_dev_set_clock_rate(handle_t file, double clock_rate);
 
 void spi_dev_set_endian(handle_t file, uint32_t endian);
 
+/**
+ * @brief       Set the transfer size from which a SPI device uses DMA
+ *
+ * Shorter transfers are done by polling the FIFO inside a critical section.
+ * Set a low threshold for devices exchanging short frames at a high rate so
+ * that the CPU is released while the frame is on the bus.
+ *
+ * @param[in]   file            The SPI device handle
+ * @param[in]   frames          Minimum frames per transfer to use DMA
+ */
+void spi_dev_set_dma_threshold(handle_t file, size_t frames);
+
 /**
  * @brief       Transfer data between a SPI device using full duplex
  *
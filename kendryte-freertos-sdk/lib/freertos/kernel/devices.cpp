@@ -494,6 +494,12 @@ void spi_dev_set_endian(handle_t file, uint32_t endian)
     return spi_device->set_endian(endian);
 }
 
+void spi_dev_set_dma_threshold(handle_t file, size_t frames)
+{
+    COMMON_ENTRY(spi_device);
+    spi_device->set_dma_threshold(frames);
+}
+
 int spi_dev_transfer_full_duplex(handle_t file, const uint8_t *write_buffer, size_t write_len, uint8_t *read_buffer, size_t read_len)
 {
     COMMON_ENTRY(spi_device);
@@ -91,6 +91,12 @@ void vApplicationIdleHook(void)
 {
 }
 
+__attribute__((weak)) void vApplicationTaskSwitchedIn(uint32_t core, int is_idle)
+{
+    (void)core;
+    (void)is_idle;
+}
+
 void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize)
 {
     UBaseType_t uxPsrId = uxPortGetProcessorId();
@@ -18,6 +18,7 @@
  */
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -28,6 +29,23 @@
 #include "cgminer.h"
 #include "pool.h"
 #include "avalon10.h"
+#include "validator.h"
+#include "cores.h"
+#include "asic_spi.h"
+#include "auc_uart.h"
+#include "asic_xport.h"
+#include "tune_store.h"
+#include "autotune.h"
+#include "efficiency.h"
+#include "fan.h"
+#include "throttle.h"
+#include "balance.h"
+#include "powercap.h"
+#include "health.h"
+#include "recovery.h"
+#include "yieldmon.h"
+#include "hasher.h"
+#include "mock_hardware.h"
 
 /* ===========================================================================
  * ЛОКАЛЬНЫЕ КОНСТАНТЫ
@@ -35,12 +53,58 @@
 
 static const char *TAG = "API";
 
+/**
+ * @brief Место в конце буфера под закрывающие скобки ответа
+ */
+#define API_RESP_TAIL       16
+
 /* ===========================================================================
  * ВНЕШНИЕ ПЕРЕМЕННЫЕ
  * =========================================================================== */
 
 extern avalon10_info_t *g_avalon10_info;
 
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Дописывание в ответ целиком или никак
+ * 
+ * Элементы списков дописываются с len - API_RESP_TAIL, закрывающие
+ * скобки - с полным len: при нехватке места список обрывается на целом
+ * элементе, а JSON остаётся закрытым. *offset никогда не выходит за
+ * буфер, поэтому возвращённая длина ответа не больше len - 1.
+ * 
+ * @param response  Буфер ответа
+ * @param len       Доступная длина буфера
+ * @param offset    Текущая длина ответа (обновляется)
+ * @return          0 если дописано, -1 если не поместилось
+ */
+static int __attribute__((format(printf, 4, 5)))
+resp_append(char *response, int len, int *offset, const char *fmt, ...)
+{
+    va_list ap;
+    int avail = len - *offset;
+    int n;
+    
+    if (avail <= 1) {
+        return -1;
+    }
+    
+    va_start(ap, fmt);
+    n = vsnprintf(response + *offset, avail, fmt, ap);
+    va_end(ap);
+    
+    if (n < 0 || n >= avail) {
+        response[*offset] = '\0';
+        return -1;
+    }
+    
+    *offset += n;
+    return 0;
+}
+
 /* ===========================================================================
  * ОБРАБОТЧИКИ КОМАНД
  * =========================================================================== */
@@ -62,24 +126,41 @@ static int cmd_version(char *response, int len)
 static int cmd_summary(char *response, int len)
 {
     uint64_t accepted = 0, rejected = 0;
+    static const float zero_ghs[AVALON10_HASHRATE_WINDOWS];
+    const float *ghs = g_avalon10_info ? g_avalon10_info->total_ghs : zero_ghs;
+    double av = g_avalon10_info ? g_avalon10_info->total_hashrate_avg / 1e9 : 0;
+    
     get_pool_stats(&accepted, &rejected);
     
     time_t elapsed = time(NULL) - g_start_time;
     
+    /* Хэшрейт по проверенным nonce сложности 1, а не по частоте */
     return snprintf(response, len,
         "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":11}],"
         "\"SUMMARY\":[{"
         "\"Elapsed\":%ld,"
         "\"GHS 5s\":%.2f,"
         "\"GHS av\":%.2f,"
+        "\"MHS av\":%.2f,"
+        "\"MHS 5s\":%.2f,"
+        "\"MHS 1m\":%.2f,"
+        "\"MHS 5m\":%.2f,"
+        "\"MHS 15m\":%.2f,"
+        "\"Difficulty1 Work\":%llu,"
         "\"Accepted\":%llu,"
         "\"Rejected\":%llu,"
         "\"Hardware Errors\":%llu,"
         "\"Pool Rejected%%\":%.2f"
         "}]}\n",
         elapsed,
-        g_avalon10_info ? g_avalon10_info->total_hashrate / 1e9 : 0,
-        g_avalon10_info ? g_avalon10_info->total_hashrate / 1e9 : 0,
+        ghs[AVALON10_HASHRATE_5S],
+        av,
+        av * 1e3,
+        ghs[AVALON10_HASHRATE_5S] * 1e3,
+        ghs[AVALON10_HASHRATE_1M] * 1e3,
+        ghs[AVALON10_HASHRATE_5M] * 1e3,
+        ghs[AVALON10_HASHRATE_15M] * 1e3,
+        g_avalon10_info ? (unsigned long long)g_avalon10_info->total_diff1 : 0,
         (unsigned long long)accepted,
         (unsigned long long)rejected,
         g_avalon10_info ? (unsigned long long)g_avalon10_info->total_hw_errors : 0,
@@ -142,19 +223,45 @@ static int cmd_devs(char *response, int len)
                 "\"Enabled\":\"%s\","
                 "\"Status\":\"%s\","
                 "\"Temperature\":%.1f,"
+                "\"MHS av\":%.2f,"
                 "\"MHS 5s\":%.2f,"
+                "\"MHS 1m\":%.2f,"
+                "\"MHS 5m\":%.2f,"
+                "\"MHS 15m\":%.2f,"
+                "\"Difficulty1 Work\":%llu,"
                 "\"Accepted\":%lu,"
                 "\"Rejected\":%lu,"
-                "\"Hardware Errors\":%lu"
+                "\"Hardware Errors\":%lu,"
+                "\"Nonce Backlog\":%u,"
+                "\"Nonce Backlog Max\":%u,"
+                "\"Nonces Drained\":%lu,"
+                "\"Drain Overruns\":%lu,"
+                "\"Work Queued\":%u,"
+                "\"Idle Chips\":%u,"
+                "\"Work Refills\":%lu,"
+                "\"Work Starved\":%lu"
                 "}",
                 i,
                 module->enabled ? "Y" : "N",
                 avalon10_state_str(module->state),
                 module->temp_avg / 10.0,
-                module->hashrate / 1e6,
+                module->hashrate_avg / 1e6,
+                module->ghs[AVALON10_HASHRATE_5S] * 1e3,
+                module->ghs[AVALON10_HASHRATE_1M] * 1e3,
+                module->ghs[AVALON10_HASHRATE_5M] * 1e3,
+                module->ghs[AVALON10_HASHRATE_15M] * 1e3,
+                (unsigned long long)module->diff1,
                 (unsigned long)module->accepted,
                 (unsigned long)module->rejected,
-                (unsigned long)module->hw_errors);
+                (unsigned long)module->hw_errors,
+                module->nonce_backlog,
+                module->nonce_backlog_max,
+                (unsigned long)module->nonce_drained,
+                (unsigned long)module->drain_overruns,
+                module->work_queued,
+                module->idle_chips,
+                (unsigned long)module->work_refills,
+                (unsigned long)module->work_starved);
         }
     }
     
@@ -192,6 +299,15 @@ static int cmd_stats(char *response, int len)
         "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":70}],\"STATS\":[");
     
     if (g_avalon10_info) {
+        const powercap_stats_t *ps = powercap_get_stats();
+        unsigned int backlog = 0;
+        unsigned long starved = 0;
+        
+        for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+            backlog += g_avalon10_info->modules[i].nonce_backlog;
+            starved += g_avalon10_info->modules[i].work_starved;
+        }
+        
         offset += snprintf(response + offset, len - offset,
             "{"
             "\"ID\":\"AVA10\","
@@ -203,8 +319,16 @@ static int cmd_stats(char *response, int len)
             "\"Temp\":%.1f,"
             "\"Fan1\":%d,"
             "\"Fan2\":%d,"
+            "\"Fan1 RPM\":%d,"
+            "\"Fan2 RPM\":%d,"
             "\"Freq\":%d,"
-            "\"Volt\":%d"
+            "\"Volt\":%d,"
+            "\"Nonce Backlog\":%u,"
+            "\"Work Depth\":%d,"
+            "\"Work Starved\":%lu,"
+            "\"Power\":%lu,"
+            "\"Power Limit\":%lu,"
+            "\"Power Headroom\":%ld"
             "}",
             (unsigned long)g_avalon10_info->uptime,
             g_avalon10_info->module_count,
@@ -214,14 +338,1217 @@ static int cmd_stats(char *response, int len)
             g_avalon10_info->modules[0].temp_avg / 10.0,
             g_avalon10_info->fan_pwm[0],
             g_avalon10_info->fan_pwm[1],
+            g_avalon10_info->fan_rpm[0],
+            g_avalon10_info->fan_rpm[1],
             g_avalon10_info->default_freq[0],
-            g_avalon10_info->default_voltage);
+            g_avalon10_info->default_voltage,
+            backlog,
+            g_avalon10_info->work_depth,
+            starved,
+            (unsigned long)ps->power,
+            (unsigned long)ps->limit,
+            (long)ps->headroom);
+    }
+    
+    /* Конвейер проверки nonce: глубина и задержка каждой ступени */
+    validator_stats_t vs;
+    validator_get_stats(&vs);
+    
+    offset += snprintf(response + offset, len - offset,
+        "%s{"
+        "\"ID\":\"PIPELINE\","
+        "\"Ring Depth\":%lu,"
+        "\"Ring Depth Max\":%lu,"
+        "\"Ring Drops\":%lu,"
+        "\"Ring Latency Avg us\":%lu,"
+        "\"Ring Latency Max us\":%lu,"
+        "\"Verify Avg us\":%lu,"
+        "\"Batches\":%llu,"
+        "\"Batch Max\":%lu,"
+        "\"Validated\":%llu,"
+        "\"Diff1\":%llu,"
+        "\"Shares\":%llu,"
+        "\"HW Errors\":%llu,"
+        "\"Stale\":%llu,"
+        "\"Submit Depth\":%lu,"
+        "\"Submit Depth Max\":%lu,"
+        "\"Submit Drops\":%lu,"
+        "\"Submit Latency Avg us\":%lu,"
+        "\"Submit Latency Max us\":%lu"
+        "}",
+        g_avalon10_info ? "," : "",
+        (unsigned long)vs.ring.depth,
+        (unsigned long)vs.ring.depth_max,
+        (unsigned long)vs.ring.drops,
+        (unsigned long)(vs.ring.count ? vs.ring.lat_sum_us / vs.ring.count : 0),
+        (unsigned long)vs.ring.lat_max_us,
+        (unsigned long)(vs.validated ? vs.verify_us / vs.validated : 0),
+        (unsigned long long)vs.batches,
+        (unsigned long)vs.batch_max,
+        (unsigned long long)vs.validated,
+        (unsigned long long)vs.diff1,
+        (unsigned long long)vs.shares,
+        (unsigned long long)vs.hw_errors,
+        (unsigned long long)vs.stale,
+        (unsigned long)vs.submit.depth,
+        (unsigned long)vs.submit.depth_max,
+        (unsigned long)vs.submit.drops,
+        (unsigned long)(vs.submit.count ? vs.submit.lat_sum_us / vs.submit.count : 0),
+        (unsigned long)vs.submit.lat_max_us);
+    
+    /* SPI транспорт ASIC: темп обменов и стоимость кадра */
+    asic_spi_stats_t ss;
+    asic_spi_get_stats(&ss);
+    
+    offset += snprintf(response + offset, len - offset,
+        ",{"
+        "\"ID\":\"SPI\","
+        "\"Frames\":%llu,"
+        "\"Xfers\":%llu,"
+        "\"Bursts\":%llu,"
+        "\"Bytes\":%llu,"
+        "\"Errors\":%llu,"
+        "\"Timeouts\":%llu,"
+        "\"TPS\":%lu,"
+        "\"TPS Max\":%lu,"
+        "\"FPS\":%lu,"
+        "\"FPS Max\":%lu,"
+        "\"Cycles/Frame\":%lu,"
+        "\"CPU Cycles/Frame\":%lu,"
+        "\"Frame Max us\":%lu,"
+        "\"Inflight Max\":%lu"
+        "}",
+        (unsigned long long)ss.frames,
+        (unsigned long long)ss.xfers,
+        (unsigned long long)ss.bursts,
+        (unsigned long long)ss.bytes,
+        (unsigned long long)ss.errors,
+        (unsigned long long)ss.timeouts,
+        (unsigned long)ss.tps,
+        (unsigned long)ss.tps_max,
+        (unsigned long)ss.fps,
+        (unsigned long)ss.fps_max,
+        (unsigned long)ss.cycles_per_frame,
+        (unsigned long)ss.cpu_cycles_per_frame,
+        (unsigned long)ss.us_per_frame_max,
+        (unsigned long)ss.inflight_max);
+    
+    /* Загрузка ядер: 0 - сеть, 1 - тракт майнинга */
+    cores_load_t l0, l1;
+    cores_get_load(CORE_NET, &l0);
+    cores_get_load(CORE_MINING, &l1);
+    
+    offset += snprintf(response + offset, len - offset,
+        ",{"
+        "\"ID\":\"CORES\","
+        "\"Core0 Util\":%.2f,"
+        "\"Core0 Util Max\":%.2f,"
+        "\"Core0 Switches\":%llu,"
+        "\"Core1 Util\":%.2f,"
+        "\"Core1 Util Max\":%.2f,"
+        "\"Core1 Switches\":%llu"
+        "}",
+        l0.util / 100.0,
+        l0.util_max / 100.0,
+        (unsigned long long)l0.switches,
+        l1.util / 100.0,
+        l1.util_max / 100.0,
+        (unsigned long long)l1.switches);
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда cores - раскладка задач по ядрам и загрузка ядер
+ */
+static int cmd_cores(char *response, int len)
+{
+    const cores_task_t *t;
+    int offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":70}],\"CORES\":[");
+    
+    for (int c = 0; c < CORES_NUM; c++) {
+        cores_load_t l;
+    
+        cores_get_load(c, &l);
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Core\":%d,\"Util\":%.2f,\"Util Max\":%.2f,"
+            "\"Busy us\":%llu,\"Idle us\":%llu,\"Switches\":%llu,\"Tasks\":%lu}",
+            c ? "," : "", c,
+            l.util / 100.0,
+            l.util_max / 100.0,
+            (unsigned long long)l.busy_us,
+            (unsigned long long)l.idle_us,
+            (unsigned long long)l.switches,
+            (unsigned long)l.tasks);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "],\"TASKS\":[");
+    
+    for (int i = 0; (t = cores_get_task(i)) != NULL && offset < len; i++) {
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Name\":\"%s\",\"Core\":%d,\"Prio\":%d,\"Stack\":%d}",
+            i ? "," : "", t->name, t->core, t->prio, t->stack);
     }
     
     offset += snprintf(response + offset, len - offset, "]}\n");
     return offset;
 }
 
+/**
+ * @brief Команда auc - статистика AUC UART (auc|test - проверка канала)
+ */
+static int cmd_auc(char *response, int len, const char *param)
+{
+    const auc_state_t *st;
+    int offset, ok = -1;
+    
+    /* Проверка канала: 64 пакета по AUC_MAX_INFLIGHT запросов STATUS */
+    if (param && strncmp(param, "test", 4) == 0) {
+        ok = auc_loopback_test(0, 64);
+    }
+    
+    st = auc_get_stats();
+    if (!st->initialized) {
+        return snprintf(response, len,
+            "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":71,"
+            "\"Msg\":\"AUC not initialized\"}]}\n");
+    }
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":71}],\"AUC\":[{"
+        "\"Baud\":%lu,"
+        "\"TX Packets\":%lu,"
+        "\"RX Packets\":%lu,"
+        "\"TX Bytes\":%llu,"
+        "\"RX Bytes\":%llu,"
+        "\"CRC Errors\":%lu,"
+        "\"Timeouts\":%lu,"
+        "\"Retries\":%lu,"
+        "\"Lost\":%lu,"
+        "\"Unmatched\":%lu,"
+        "\"Stale\":%lu,"
+        "\"Resync Bytes\":%lu,"
+        "\"Inflight\":%lu,"
+        "\"Inflight Max\":%lu,"
+        "\"RTT us\":%lu,"
+        "\"RTT Max us\":%lu",
+        (unsigned long)st->baudrate,
+        (unsigned long)st->tx_packets,
+        (unsigned long)st->rx_packets,
+        (unsigned long long)st->tx_bytes,
+        (unsigned long long)st->rx_bytes,
+        (unsigned long)st->crc_errors,
+        (unsigned long)st->timeouts,
+        (unsigned long)st->retries,
+        (unsigned long)st->lost,
+        (unsigned long)st->unmatched,
+        (unsigned long)st->stale,
+        (unsigned long)st->resync_bytes,
+        (unsigned long)st->inflight,
+        (unsigned long)st->inflight_max,
+        (unsigned long)st->rtt_us_last,
+        (unsigned long)st->rtt_us_max);
+    
+    if (ok >= 0) {
+        offset += snprintf(response + offset, len - offset,
+            ",\"Test OK\":%d,\"Test Total\":%d", ok, 64 * AUC_MAX_INFLIGHT);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "}]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда boot - время этапов загрузки от сброса
+ */
+static int cmd_boot(char *response, int len)
+{
+    const cgminer_boot_mark_t *m;
+    uint32_t prev = 0;
+    int offset;
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":73}],\"BOOT\":[");
+    
+    for (int i = 0; (m = cgminer_boot_get(i)) != NULL && offset < len; i++) {
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Phase\":\"%s\",\"ms\":%lu,\"Delta ms\":%lu}",
+            i ? "," : "", m->phase, (unsigned long)m->ms, (unsigned long)(m->ms - prev));
+        prev = m->ms;
+    }
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда tune - сохранённые топология и настройки ASIC
+ * 
+ * Параметры: "save" - записать текущее состояние, "clear" - стереть
+ * обе копии (следующая загрузка - с настройками по умолчанию).
+ */
+static int cmd_tune(char *response, int len, const char *param)
+{
+    const tune_store_stats_t *st;
+    
+    if (param && strncmp(param, "save", 4) == 0) {
+        tune_store_request_save();
+    } else if (param && strncmp(param, "clear", 5) == 0) {
+        tune_store_clear();
+    }
+    
+    st = tune_store_get_stats();
+    
+    return snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":74}],\"TUNE\":[{"
+        "\"Loaded\":%d,"
+        "\"Restored Modules\":%d,"
+        "\"Slot\":\"%s\","
+        "\"Seq\":%lu,"
+        "\"Saves\":%lu,"
+        "\"Errors\":%lu,"
+        "\"Rejected\":%lu,"
+        "\"Saved At\":%lu,"
+        "\"Save Pending\":%d}]}\n",
+        st->loaded,
+        st->restored,
+        st->slot < 0 ? "-" : (st->slot ? "B" : "A"),
+        (unsigned long)st->seq,
+        (unsigned long)st->saves,
+        (unsigned long)st->errors,
+        (unsigned long)st->rejected,
+        (unsigned long)st->saved_at,
+        param && strncmp(param, "save", 4) == 0);
+}
+
+/**
+ * @brief Значение поля чипа для команды chips
+ */
+static uint32_t chip_field(const avalon10_chip_t *chip, int field)
+{
+    switch (field) {
+    case 1:  return chip->nonces;
+    case 2:  return chip->hw_errors;
+    case 3:  return chip->shares;
+    case 4:  return chip->freq;
+    case 5:  return (uint32_t)(chip->ghs[AVALON10_HASHRATE_1M] * 1e3f);
+    default: return chip->diff1;
+    }
+}
+
+/**
+ * @brief Битовая карта чипов модуля в hex (бит i = чип i, младший в начале)
+ */
+static int chip_bitmap(char *out, int len, const avalon10_module_t *module, int weak)
+{
+    int offset = 0;
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MINER_CNT; i += 8) {
+        uint8_t bits = 0;
+    
+        for (int j = 0; j < 8 && i + j < AVALON10_DEFAULT_MINER_CNT; j++) {
+            const avalon10_chip_t *chip = &module->chips[i + j];
+    
+            if (weak ? avalon10_chip_weak(chip) : chip->enabled) {
+                bits |= 1 << j;
+            }
+        }
+        offset += snprintf(out + offset, len - offset, "%02x", bits);
+    }
+    
+    return offset;
+}
+
+/**
+ * @brief Команда chips - статистика чипов модуля
+ * 
+ * Параметры: "M[,поле]", поле - diff1 (по умолчанию), nonces, hw, shares,
+ * freq или mhs (хэшрейт за 1 мин). Одно поле за запрос: массив на 114 чипов укладывается в
+ * буфер ответа.
+ */
+static int cmd_chips(char *response, int len, const char *param)
+{
+    static const char *fields[] = { "diff1", "nonces", "hw", "shares", "freq", "mhs" };
+    const avalon10_module_t *module;
+    char enabled[AVALON10_DEFAULT_MINER_CNT / 4 + 3];
+    char weak[AVALON10_DEFAULT_MINER_CNT / 4 + 3];
+    int m = 0, field = 0, offset;
+    
+    if (param && param[0] >= '0' && param[0] <= '9') {
+        m = param[0] - '0';
+        if (param[1] == ',') {
+            for (int f = 0; f < (int)(sizeof(fields) / sizeof(fields[0])); f++) {
+                if (strncmp(param + 2, fields[f], strlen(fields[f])) == 0) {
+                    field = f;
+                }
+            }
+        }
+    }
+    
+    if (!g_avalon10_info || m >= AVALON10_DEFAULT_MODULARS) {
+        return snprintf(response, len,
+            "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":75,"
+            "\"Msg\":\"Invalid module\"}]}\n");
+    }
+    
+    module = &g_avalon10_info->modules[m];
+    chip_bitmap(enabled, sizeof(enabled), module, 0);
+    chip_bitmap(weak, sizeof(weak), module, 1);
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":75}],\"CHIPS\":[{"
+        "\"Module\":%d,"
+        "\"Chips\":%d,"
+        "\"Enabled\":\"%s\","
+        "\"Weak\":\"%s\","
+        "\"Bad Chip IDs\":%lu,"
+        "\"Field\":\"%s\","
+        "\"Values\":[",
+        m,
+        AVALON10_DEFAULT_MINER_CNT,
+        enabled,
+        weak,
+        (unsigned long)module->bad_chip_ids,
+        fields[field]);
+    
+    if (offset >= len) {
+        offset = len - 1;
+    }
+    for (int i = 0; i < AVALON10_DEFAULT_MINER_CNT; i++) {
+        if (resp_append(response, len - API_RESP_TAIL, &offset, "%s%lu", i ? "," : "",
+                        (unsigned long)chip_field(&module->chips[i], field)) < 0) {
+            break;
+        }
+    }
+    
+    resp_append(response, len, &offset, "]}]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда autotune - автонастройка частоты чипов
+ * 
+ * Параметры: "on" / "off" - включить или выключить, "reset" - начать
+ * подбор заново, "budget,N" - бюджет HW ошибок (‰).
+ */
+static int cmd_autotune(char *response, int len, const char *param)
+{
+    const autotune_stats_t *st;
+    int offset;
+    
+    if (param && strncmp(param, "on", 2) == 0) {
+        g_config.autotune = 1;
+    } else if (param && strncmp(param, "off", 3) == 0) {
+        g_config.autotune = 0;
+    } else if (param && strncmp(param, "reset", 5) == 0) {
+        autotune_reset(-1);
+    } else if (param && strncmp(param, "budget,", 7) == 0) {
+        int budget = atoi(param + 7);
+    
+        if (budget <= 0 || budget > 500) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":76,"
+                "\"Msg\":\"Invalid budget\"}]}\n");
+        }
+        g_config.autotune_hw_budget = budget;
+    }
+    
+    st = autotune_get_stats();
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":76}],\"AUTOTUNE\":[{"
+        "\"Enabled\":%d,"
+        "\"Paused\":%d,"
+        "\"HW Budget\":%d,"
+        "\"Probing\":%d,"
+        "\"Settled\":%d,"
+        "\"Steps Up\":%lu,"
+        "\"Steps Down\":%lu,"
+        "\"Changed At\":%lu}],\"MODULES\":[",
+        g_config.autotune != 0,
+        st->paused,
+        g_config.autotune_hw_budget,
+        st->probing,
+        st->settled,
+        (unsigned long)st->steps_up,
+        (unsigned long)st->steps_down,
+        (unsigned long)st->changed_at);
+    
+    for (int m = 0, n = 0; g_avalon10_info && m < AVALON10_DEFAULT_MODULARS; m++) {
+        const avalon10_module_t *module = &g_avalon10_info->modules[m];
+        int fmin = 0, fmax = 0, settled = 0, chips = 0;
+        uint32_t fsum = 0;
+    
+        if (module->state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+    
+        for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            const avalon10_chip_t *chip = &module->chips[c];
+    
+            if (!chip->enabled) {
+                continue;
+            }
+            if (!chips || chip->freq < fmin) fmin = chip->freq;
+            if (chip->freq > fmax) fmax = chip->freq;
+            fsum += chip->freq;
+            settled += autotune_get_chip(m, c)->state == AUTOTUNE_CHIP_SETTLED;
+            chips++;
+        }
+    
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Module\":%d,\"Chips\":%d,\"Settled\":%d,"
+            "\"Freq Min\":%d,\"Freq Avg\":%lu,\"Freq Max\":%d}",
+            n++ ? "," : "", m, chips, settled,
+            fmin, (unsigned long)(chips ? fsum / chips : 0), fmax);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда efficiency - подбор напряжения
+ * 
+ * Параметры: "off" - выключить, "jth" - минимум J/TH, "cap,N" - максимум
+ * хэшрейта под лимитом N Вт на весь майнер (тот же лимит держит powercap),
+ * "vmax,N" - верхняя граница напряжения (mV), "restart" - начать поиск
+ * заново.
+ */
+static int cmd_efficiency(char *response, int len, const char *param)
+{
+    static const char *phases[] = { "Idle", "Settle", "Measure", "Done" };
+    const efficiency_stats_t *st;
+    int offset;
+    
+    if (param && strncmp(param, "off", 3) == 0) {
+        g_config.efficiency = EFFICIENCY_MODE_OFF;
+    } else if (param && strncmp(param, "jth", 3) == 0) {
+        g_config.efficiency = EFFICIENCY_MODE_JTH;
+    } else if (param && strncmp(param, "cap,", 4) == 0) {
+        int cap = atoi(param + 4);
+    
+        if (cap <= 0) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":77,"
+                "\"Msg\":\"Invalid power cap\"}]}\n");
+        }
+        g_config.power_cap = cap;
+        g_config.efficiency = EFFICIENCY_MODE_CAP;
+    } else if (param && strncmp(param, "vmax,", 5) == 0) {
+        int vmax = atoi(param + 5);
+    
+        if (vmax < AVALON10_VOLTAGE_MIN || vmax > AVALON10_VOLTAGE_MAX) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":77,"
+                "\"Msg\":\"Invalid voltage\"}]}\n");
+        }
+        g_config.efficiency_vmax = vmax;
+    } else if (param && strncmp(param, "restart", 7) == 0) {
+        efficiency_restart(-1);
+    }
+    
+    st = efficiency_get_stats();
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":77}],\"EFFICIENCY\":[{"
+        "\"Mode\":%d,"
+        "\"Paused\":%d,"
+        "\"Power\":%lu,"
+        "\"Power Cap\":%d,"
+        "\"Module Cap\":%d,"
+        "\"Voltage Max\":%d,"
+        "\"Searches\":%lu,"
+        "\"Changed At\":%lu}],\"MODULES\":[",
+        g_config.efficiency,
+        st->paused,
+        (unsigned long)st->power,
+        g_config.power_cap,
+        st->power_cap,
+        g_config.efficiency_vmax,
+        (unsigned long)st->searches,
+        (unsigned long)st->changed_at);
+    
+    for (int m = 0, n = 0; g_avalon10_info && m < AVALON10_DEFAULT_MODULARS; m++) {
+        const avalon10_module_t *module = &g_avalon10_info->modules[m];
+        const efficiency_module_t *em = efficiency_get_module(m);
+    
+        if (module->state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+    
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Module\":%d,\"Phase\":\"%s\",\"Voltage\":%d,"
+            "\"Power\":%lu,\"Telemetry\":%d,\"Points\":%d,"
+            "\"Last Voltage\":%d,\"Last GHS\":%.2f,\"Last JTH\":%.2f,"
+            "\"Best Voltage\":%d,\"Best Power\":%d,"
+            "\"Best GHS\":%.2f,\"Best JTH\":%.2f}",
+            n++ ? "," : "", m, phases[em->phase & 3], module->voltage,
+            (unsigned long)efficiency_module_power(module), module->power != 0,
+            em->points, em->last.voltage, (double)em->last.ghs, (double)em->last.jth,
+            em->best.voltage, em->best.power, (double)em->best.ghs, (double)em->best.jth);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда fan - ПИД вентиляторов
+ * 
+ * Параметры: "pid,KP,KI,KD" - коэффициенты регулятора, "target,N" - целевая
+ * температура (°C, ступенька для снятия переходной характеристики);
+ * в эмуляции "stall,F,0|1" - заблокировать ротор вентилятора F.
+ */
+static int cmd_fan(char *response, int len, const char *param)
+{
+    const fan_pid_t *pid = fan_get_pid();
+    int offset;
+    
+    if (param && strncmp(param, "pid,", 4) == 0) {
+        float kp = 0, ki = 0, kd = 0;
+    
+        if (sscanf(param + 4, "%f,%f,%f", &kp, &ki, &kd) != 3 ||
+            kp < 0 || ki < 0 || kd < 0) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":78,"
+                "\"Msg\":\"Invalid PID gains\"}]}\n");
+        }
+        fan_set_gains(kp, ki, kd);
+    } else if (param && strncmp(param, "target,", 7) == 0) {
+        int target = atoi(param + 7);
+    
+        if (target < 50 || target > 85) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":78,"
+                "\"Msg\":\"Invalid target\"}]}\n");
+        }
+        g_config.temp_target = target;
+        if (g_avalon10_info) {
+            g_avalon10_info->temp_target = target;
+        }
+    }
+#if MOCK_ASIC
+    else if (param && strncmp(param, "stall,", 6) == 0) {
+        int fan = 0, on = 0;
+    
+        if (sscanf(param + 6, "%d,%d", &fan, &on) == 2) {
+            mock_fan_set_stalled(fan, on);
+        }
+    }
+#endif
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":78}],\"FAN\":[{"
+        "\"Kp\":%.3f,"
+        "\"Ki\":%.3f,"
+        "\"Kd\":%.3f,"
+        "\"Temp\":%.1f,"
+        "\"Target\":%d}],\"FANS\":[",
+        (double)pid->kp,
+        (double)pid->ki,
+        (double)pid->kd,
+        (double)pid->temp,
+        g_avalon10_info ? g_avalon10_info->temp_target : g_config.temp_target);
+    
+    for (int i = 0; i < AVALON10_FAN_COUNT; i++) {
+        const fan_state_t *st = fan_get_state(i);
+    
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Fan\":%d,\"PWM\":%d,\"RPM\":%d,\"Out\":%.2f,"
+            "\"Integral\":%.2f,\"Stalled\":%d,\"Stalls\":%lu}",
+            i ? "," : "", i, st->pwm, st->rpm, (double)st->out,
+            (double)st->integ, st->stalled, (unsigned long)st->stalls);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда throttle - снижение хэшрейта при нагреве
+ * 
+ * В эмуляции "inlet,M,T" - температура воздуха на входе модуля M (°C),
+ * чтобы проверить снижение в тёплом корпусе.
+ */
+static int cmd_throttle(char *response, int len, const char *param)
+{
+    const throttle_stats_t *ts = throttle_get_stats();
+    int offset;
+    
+#if MOCK_ASIC
+    if (param && strncmp(param, "inlet,", 6) == 0) {
+        int m = 0, t = 0;
+        mock_asic_module_t *mod;
+    
+        if (sscanf(param + 6, "%d,%d", &m, &t) != 2 || t < 0 || t > 60 ||
+            !(mod = mock_asic_get_module(m))) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":79,"
+                "\"Msg\":\"Invalid inlet\"}]}\n");
+        }
+        mock_asic_set_temperature(m, (int16_t)(t * 10), mod->temp_out);
+    }
+#else
+    (void)param;
+#endif
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":79}],\"THROTTLE\":[{"
+        "\"Throttled\":%d,"
+        "\"Cutoffs\":%lu,"
+        "\"Start\":%d,"
+        "\"Overheat\":%d,"
+        "\"Cutoff\":%d}],\"MODULES\":[",
+        ts->throttled,
+        (unsigned long)ts->cutoffs,
+        g_avalon10_info ? g_avalon10_info->temp_overheat - THROTTLE_BAND_C : 0,
+        g_avalon10_info ? g_avalon10_info->temp_overheat : 0,
+        g_avalon10_info ? g_avalon10_info->temp_cutoff : 0);
+    
+    for (int m = 0, n = 0; g_avalon10_info && m < AVALON10_DEFAULT_MODULARS; m++) {
+        const avalon10_module_t *module = &g_avalon10_info->modules[m];
+        const throttle_module_t *tm = throttle_get_module(m);
+    
+        if (module->state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+    
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Module\":%d,\"Temp\":%.1f,\"Slope\":%.3f,\"Predicted\":%.1f,"
+            "\"Scale\":%.1f,\"Duty\":%d,\"Engaged\":%d,\"Events\":%lu}",
+            n++ ? "," : "", m,
+            module->temp_max / 10.0, (double)tm->slope, (double)tm->predicted,
+            (double)tm->scale, tm->duty, tm->engaged, (unsigned long)tm->events);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда balance - тепловая балансировка модулей
+ * 
+ * Параметры: "off", "hashrate[,N]" - бюджет N GH/s, "power[,N]" - бюджет
+ * N Вт (без N - 90% ёмкости модулей), "reset" - сбросить поправки.
+ */
+static int cmd_balance(char *response, int len, const char *param)
+{
+    const balance_stats_t *st;
+    int offset;
+    
+    if (param && strncmp(param, "off", 3) == 0) {
+        g_config.balance = BALANCE_MODE_OFF;
+    } else if (param && (strncmp(param, "hashrate", 8) == 0 || strncmp(param, "power", 5) == 0)) {
+        int mode = param[0] == 'h' ? BALANCE_MODE_HASHRATE : BALANCE_MODE_POWER;
+        const char *comma = strchr(param, ',');
+        int budget = comma ? atoi(comma + 1) : 0;
+    
+        if (budget < 0) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":80,"
+                "\"Msg\":\"Invalid budget\"}]}\n");
+        }
+        if (mode != g_config.balance || budget != g_config.balance_budget) {
+            balance_reset();
+        }
+        g_config.balance = mode;
+        g_config.balance_budget = budget;
+    } else if (param && strncmp(param, "reset", 5) == 0) {
+        balance_reset();
+    }
+    
+    st = balance_get_stats();
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":80}],\"BALANCE\":[{"
+        "\"Mode\":%d,"
+        "\"Budget\":%.1f,"
+        "\"Capacity\":%.1f,"
+        "\"Base Share\":%.2f,"
+        "\"Spread\":%.1f,"
+        "\"Rounds\":%lu,"
+        "\"At\":%lu}],\"MODULES\":[",
+        g_config.balance,
+        (double)st->budget,
+        (double)st->capacity,
+        (double)st->base,
+        (double)st->spread,
+        (unsigned long)st->rounds,
+        (unsigned long)st->at);
+    
+    for (int m = 0, n = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        const balance_module_t *bm = balance_get_module(m);
+    
+        if (!bm->active) {
+            continue;
+        }
+    
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Module\":%d,\"Temp\":%.1f,\"Capacity\":%.1f,"
+            "\"Offset\":%.2f,\"Share\":%.2f}",
+            n++ ? "," : "", m, (double)bm->temp, (double)bm->capacity,
+            (double)bm->offset, (double)bm->share);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда power - жёсткий лимит мощности
+ * 
+ * Параметры: "limit,N" - лимит N Вт на весь майнер, "off" - снять лимит.
+ * Лимит общий с efficiency|cap,N (g_config.power_cap).
+ */
+static int cmd_power(char *response, int len, const char *param)
+{
+    const powercap_stats_t *st;
+    int offset;
+    
+    if (param && strncmp(param, "off", 3) == 0) {
+        g_config.power_cap = 0;
+    } else if (param && strncmp(param, "limit,", 6) == 0) {
+        int limit = atoi(param + 6);
+    
+        if (limit <= 0) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":81,"
+                "\"Msg\":\"Invalid power limit\"}]}\n");
+        }
+        g_config.power_cap = limit;
+    }
+    
+    st = powercap_get_stats();
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":81}],\"POWER\":[{"
+        "\"Limit\":%d,"
+        "\"Power\":%lu,"
+        "\"Headroom\":%ld,"
+        "\"Demand\":%.0f,"
+        "\"Limited\":%d,"
+        "\"Short\":%d,"
+        "\"Changed At\":%lu}],\"MODULES\":[",
+        g_config.power_cap,
+        (unsigned long)st->power,
+        (long)st->headroom,
+        (double)st->demand,
+        st->limited,
+        st->short_budget,
+        (unsigned long)st->changed_at);
+    
+    for (int m = 0, n = 0; g_avalon10_info && m < AVALON10_DEFAULT_MODULARS; m++) {
+        const powercap_module_t *pm = powercap_get_module(m);
+    
+        if (g_avalon10_info->modules[m].state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+    
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Module\":%d,\"Power\":%.1f,\"Calibration\":%.3f,"
+            "\"Leakage\":%.1f,\"Full\":%.1f,\"Cost mW/MHz\":%.2f,\"Share\":%.2f}",
+            n++ ? "," : "", m, (double)pm->power, (double)pm->cal,
+            (double)pm->fixed, (double)pm->full, (double)pm->cost, (double)pm->share);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда health - выключенные чипы
+ * 
+ * Параметры: "reprobe[,M]" - пробовать выключенные чипы сейчас (все
+ * модули или модуль M).
+ */
+static int cmd_health(char *response, int len, const char *param)
+{
+    const health_stats_t *st;
+    int offset;
+    
+    if (param && strncmp(param, "reprobe", 7) == 0) {
+        health_reprobe(param[7] == ',' ? atoi(param + 8) : -1);
+    }
+    
+    st = health_get_stats();
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":82}],\"HEALTH\":[{"
+        "\"Isolated\":%d,"
+        "\"Probing\":%d,"
+        "\"Isolations\":%lu,"
+        "\"Recoveries\":%lu,"
+        "\"Module Errors\":%lu,"
+        "\"Changed At\":%lu}],\"MODULES\":[",
+        st->isolated,
+        st->probing,
+        (unsigned long)st->isolations,
+        (unsigned long)st->recoveries,
+        (unsigned long)st->module_errors,
+        (unsigned long)st->changed_at);
+    
+    if (offset >= len) {
+        offset = len - 1;
+    }
+    
+    for (int m = 0, n = 0; g_avalon10_info && m < AVALON10_DEFAULT_MODULARS; m++) {
+        const avalon10_module_t *module = &g_avalon10_info->modules[m];
+        const health_module_t *hm = health_get_module(m);
+    
+        if (module->state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+    
+        if (resp_append(response, len - API_RESP_TAIL, &offset,
+                "%s{\"Module\":%d,\"Active\":%d,\"Failed\":%d,\"HW Rate\":%d,\"Chips\":[",
+                n++ ? "," : "", m, module->active_chips, module->failed_chips, hm->rate) < 0) {
+            break;
+        }
+    
+        /* Только чипы не в работе: номер, состояние, неудачные пробы */
+        for (int c = 0, k = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            const health_chip_t *hc = health_get_chip(m, c);
+    
+            if (hc->state == HEALTH_CHIP_OK) {
+                continue;
+            }
+            if (resp_append(response, len - API_RESP_TAIL, &offset,
+                    "%s{\"Chip\":%d,\"State\":\"%s\",\"HW Rate\":%d,\"Probes\":%d}",
+                    k++ ? "," : "", c,
+                    hc->state == HEALTH_CHIP_PROBE ? "Probe" : "Isolated",
+                    hc->rate, hc->probes) < 0) {
+                break;
+            }
+        }
+    
+        resp_append(response, len, &offset, "]}");
+    }
+    
+    resp_append(response, len, &offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда recovery - сброс зависших модулей
+ * 
+ * Параметры: "reset,M" - сбросить модуль M сейчас (в паузе - не дожидаясь
+ * её конца). В эмуляции "wedge,M,K" - зависание модуля M до сброса
+ * (MOCK_WEDGE_*: 1 - не отвечает, 2 - нет nonce, 3 - шторм CRC).
+ */
+static int cmd_recovery(char *response, int len, const char *param)
+{
+    const recovery_stats_t *st;
+    int offset;
+    
+    if (param && strncmp(param, "reset,", 6) == 0) {
+        if (recovery_request(atoi(param + 6), RECOVERY_REASON_MANUAL) != 0) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":83,"
+                "\"Msg\":\"Invalid module\"}]}\n");
+        }
+    }
+#if MOCK_ASIC
+    else if (param && strncmp(param, "wedge,", 6) == 0) {
+        int m = 0, k = 0;
+    
+        if (sscanf(param + 6, "%d,%d", &m, &k) == 2) {
+            mock_asic_set_wedge(m, k);
+        }
+    }
+#endif
+    
+    st = recovery_get_stats();
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":83}],\"RECOVERY\":[{"
+        "\"Recovering\":%d,"
+        "\"Resets\":%lu,"
+        "\"Restores\":%lu,"
+        "\"Failures\":%lu,"
+        "\"Changed At\":%lu}],\"MODULES\":[",
+        st->recovering,
+        (unsigned long)st->resets,
+        (unsigned long)st->restores,
+        (unsigned long)st->failures,
+        (unsigned long)st->changed_at);
+    
+    for (int m = 0, n = 0; g_avalon10_info && m < AVALON10_DEFAULT_MODULARS; m++) {
+        const avalon10_module_t *module = &g_avalon10_info->modules[m];
+        const recovery_module_t *rm = recovery_get_module(m);
+    
+        if (module->state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+    
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Module\":%d,\"State\":\"%s\",\"Recovery\":\"%s\",\"Reason\":\"%s\","
+            "\"Attempts\":%d,\"Resets\":%lu,\"Poll Errors\":%d,\"Bad Replies\":%lu,"
+            "\"Expected\":%.1f}",
+            n++ ? "," : "", m, avalon10_state_str(module->state),
+            rm->state == RECOVERY_RESET ? "Reset" :
+            rm->state == RECOVERY_BACKOFF ? "Backoff" : "Watch",
+            recovery_reason_str(rm->reason), rm->attempts, (unsigned long)rm->resets,
+            module->poll_errors, (unsigned long)module->bad_replies, (double)rm->expect);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда yield - недобор nonce, мёртвые ядра и чипы
+ * 
+ * Параметры: "reset" - оценка заново (после замены платы или чипов).
+ */
+static int cmd_yield(char *response, int len, const char *param)
+{
+    const yieldmon_stats_t *st;
+    int offset;
+    
+    if (param && strncmp(param, "reset", 5) == 0) {
+        yieldmon_reset();
+    }
+    
+    st = yieldmon_get_stats();
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":84}],\"YIELD\":[{"
+        "\"Slow\":%d,"
+        "\"Dead\":%d,"
+        "\"Dead Cores\":%d,"
+        "\"Degraded\":%d,"
+        "\"Windows\":%lu,"
+        "\"Changed At\":%lu}],\"MODULES\":[",
+        st->slow,
+        st->dead,
+        st->dead_cores,
+        st->degraded,
+        (unsigned long)st->windows,
+        (unsigned long)st->changed_at);
+    
+    if (offset >= len) {
+        offset = len - 1;
+    }
+    
+    for (int m = 0, n = 0; g_avalon10_info && m < AVALON10_DEFAULT_MODULARS; m++) {
+        const avalon10_module_t *module = &g_avalon10_info->modules[m];
+        const yieldmon_module_t *ym = yieldmon_get_module(m);
+    
+        if (module->state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+    
+        if (resp_append(response, len - API_RESP_TAIL, &offset,
+                "%s{\"Module\":%d,\"Yield\":%d,\"Capacity\":%d,\"Degraded\":%d,"
+                "\"Slow\":%d,\"Dead\":%d,\"Dead Cores\":%d,\"Chips\":[",
+                n++ ? "," : "", m, ym->yield == YIELDMON_NO_YIELD ? -1 : ym->yield,
+                ym->capacity, ym->degraded, ym->slow, ym->dead, ym->dead_cores) < 0) {
+            break;
+        }
+    
+        /* Только чипы с недобором или мёртвыми ядрами */
+        for (int c = 0, k = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            const yieldmon_chip_t *yc = yieldmon_get_chip(m, c);
+    
+            if (yc->state == YIELDMON_CHIP_OK && !yc->dead_cores) {
+                continue;
+            }
+            if (resp_append(response, len - API_RESP_TAIL, &offset,
+                    "%s{\"Chip\":%d,\"State\":\"%s\",\"Yield\":%d,\"Dead Cores\":%d,\"Freq\":%d}",
+                    k++ ? "," : "", c, yieldmon_state_str(yc->state),
+                    yc->yield == YIELDMON_NO_YIELD ? -1 : yc->yield, yc->dead_cores,
+                    module->chips[c].freq) < 0) {
+                break;
+            }
+        }
+    
+        resp_append(response, len, &offset, "]}");
+    }
+    
+    resp_append(response, len, &offset, "]}\n");
+    return offset;
+}
+
+/**
+ * @brief Команда hash - бэкенды SHA256
+ * 
+ * Параметры: "bench" - замерить заново; "auto", "soft", "hard", "swar" - выбрать
+ * бэкенд (auto - самый быстрый по замеру).
+ */
+static int cmd_hash(char *response, int len, const char *param)
+{
+    int offset;
+    
+    if (param && strncmp(param, "bench", 5) == 0) {
+        hasher_bench();
+    } else if (param && param[0]) {
+        char name[16];
+        int type;
+    
+        strncpy(name, param, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+        name[strcspn(name, "\r\n")] = '\0';
+    
+        type = hasher_parse(name);
+        if (type < 0 || hasher_select(type) != 0) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":85,"
+                "\"Msg\":\"Backend not available\"}]}\n");
+        }
+        g_config.hasher = type;
+    }
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":85}],\"HASH\":[{"
+        "\"Mode\":\"%s\","
+        "\"Active\":\"%s\"}],\"BACKENDS\":[",
+        hasher_name(g_config.hasher),
+        hasher_name(hasher_active()));
+    
+    for (int t = HASHER_SOFT, n = 0; t < HASHER_COUNT; t++) {
+        const hasher_stats_t *hs = hasher_get_stats(t);
+    
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Backend\":\"%s\",\"Available\":%d,\"ns 80\":%lu,\"ns 64\":%lu,"
+            "\"Hashes\":%llu}",
+            n++ ? "," : "", hasher_name(t), hs->available,
+            (unsigned long)hs->ns80, (unsigned long)hs->ns64,
+            (unsigned long long)hs->hashes);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+
+#if MOCK_ASIC
+/**
+ * @brief Команда sim - эмулятор поиска nonce
+ * 
+ * Параметры: "seed,N" - новое зерно; "chip,M,C,P" - темп чипа C модуля M
+ * (% от номинала); "faults,M,H,S" - испорченные nonce и зависания модуля
+ * M (на миллион).
+ */
+static int cmd_sim(char *response, int len, const char *param)
+{
+    int offset;
+    
+    if (param && strncmp(param, "seed,", 5) == 0) {
+        mock_asic_sim_seed((uint32_t)strtoul(param + 5, NULL, 0));
+    } else if (param && strncmp(param, "chip,", 5) == 0) {
+        int m = 0, c = 0, p = 0;
+    
+        if (sscanf(param + 5, "%d,%d,%d", &m, &c, &p) == 3) {
+            mock_asic_set_chip_rate(m, c, p);
+        }
+    } else if (param && strncmp(param, "faults,", 7) == 0) {
+        unsigned long h = 0, st = 0;
+        int m = 0;
+    
+        if (sscanf(param + 7, "%d,%lu,%lu", &m, &h, &st) == 3) {
+            mock_asic_set_faults(m, (uint32_t)h, (uint32_t)st);
+        }
+    }
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":86}],\"SIM\":[{"
+        "\"Diff Bits\":%d,"
+        "\"Share Bits\":%d}],\"MODULES\":[",
+        MOCK_SIM_DIFF_BITS, MOCK_SIM_SHARE_BITS);
+    
+    for (int m = 0; m < MOCK_ASIC_MODULES; m++) {
+        const mock_asic_module_t *mod = mock_asic_get_module(m);
+    
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Module\":%d,\"Hashes\":%llu,\"Found\":%lu,\"HW Injected\":%lu,"
+            "\"Lost\":%lu,\"Lag\":%llu,\"FIFO\":%lu,\"HW ppm\":%lu,"
+            "\"Stall ppm\":%lu,\"Wedge\":%d}",
+            m ? "," : "", m, (unsigned long long)mod->sim_hashes,
+            (unsigned long)mod->sim_found, (unsigned long)mod->sim_hw_errors,
+            (unsigned long)mod->sim_lost, (unsigned long long)mod->sim_lag,
+            (unsigned long)mod->nonce_fifo, (unsigned long)mod->hw_err_ppm,
+            (unsigned long)mod->stall_ppm, mod->wedge);
+    }
+    
+    offset += snprintf(response + offset, len - offset, "]}\n");
+    return offset;
+}
+#endif
+
+/**
+ * @brief Команда xport - транспорты модулей
+ * 
+ * Параметры: "M,имя" - назначить модулю M транспорт (spi, auc, mock,
+ * replay); "record" / "stop" - запись трассы обменов.
+ */
+static int cmd_xport(char *response, int len, const char *param)
+{
+    int offset;
+    
+    if (param && strncmp(param, "record", 6) == 0) {
+        asic_xport_trace_start();
+    } else if (param && strncmp(param, "stop", 4) == 0) {
+        asic_xport_trace_stop();
+    } else if (param && param[0] >= '0' && param[0] <= '9' && param[1] == ',') {
+        char name[16];
+        int m = param[0] - '0';
+        int type;
+    
+        strncpy(name, param + 2, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+        name[strcspn(name, "\r\n")] = '\0';
+    
+        type = asic_xport_parse(name);
+        if (m >= AVALON10_DEFAULT_MODULARS || type < 0 || asic_xport_bind(m, type) != 0) {
+            return snprintf(response, len,
+                "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":72,"
+                "\"Msg\":\"Invalid transport\"}]}\n");
+        }
+        if (g_avalon10_info) {
+            g_avalon10_info->modules[m].xport = (uint8_t)type;
+        }
+    }
+    
+    offset = snprintf(response, len,
+        "{\"STATUS\":[{\"STATUS\":\"S\",\"Code\":72}],\"MODULES\":[");
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Module\":%d,\"Xport\":\"%s\"}",
+            i ? "," : "", i, asic_xport_name(asic_xport_type(i)));
+    }
+    
+    offset += snprintf(response + offset, len - offset, "],\"XPORT\":[");
+    
+    for (int t = 0; t < ASIC_XPORT_COUNT && offset < len; t++) {
+        asic_xport_stats_t xs;
+    
+        asic_xport_get_stats(t, &xs);
+        offset += snprintf(response + offset, len - offset,
+            "%s{\"Name\":\"%s\",\"Modules\":%lu,\"Batches\":%llu,"
+            "\"Requests\":%llu,\"Replies\":%llu,\"Sent\":%llu,"
+            "\"Errors\":%lu,\"Bad Replies\":%lu,\"Avg us\":%lu,\"Max us\":%lu}",
+            t ? "," : "", asic_xport_name(t),
+            (unsigned long)xs.modules,
+            (unsigned long long)xs.batches,
+            (unsigned long long)xs.requests,
+            (unsigned long long)xs.replies,
+            (unsigned long long)xs.sent,
+            (unsigned long)xs.errors,
+            (unsigned long)xs.bad_replies,
+            (unsigned long)xs.us_avg,
+            (unsigned long)xs.us_max);
+    }
+    
+    int trace_n;
+    asic_xport_trace_get(&trace_n);
+    offset += snprintf(response + offset, len - offset,
+        "],\"Trace\":%d}\n", trace_n);
+    return offset;
+}
+
 /* ===========================================================================
  * ОСНОВНЫЕ ФУНКЦИИ API
  * =========================================================================== */
@@ -240,6 +1567,8 @@ int api_handle_request(const char *request, char *response, int resp_len)
     strncpy(cmd, request, sizeof(cmd) - 1);
     char *p = strchr(cmd, '|');
     if (p) *p = '\0';
+    const char *param = strchr(request, '|');
+    param = param ? param + 1 : NULL;
     p = strchr(cmd, '\n');
     if (p) *p = '\0';
     
@@ -262,6 +1591,59 @@ int api_handle_request(const char *request, char *response, int resp_len)
     else if (strcmp(cmd, "stats") == 0) {
         return cmd_stats(response, resp_len);
     }
+    else if (strcmp(cmd, "cores") == 0) {
+        return cmd_cores(response, resp_len);
+    }
+    else if (strcmp(cmd, "auc") == 0) {
+        return cmd_auc(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "xport") == 0) {
+        return cmd_xport(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "boot") == 0) {
+        return cmd_boot(response, resp_len);
+    }
+    else if (strcmp(cmd, "tune") == 0) {
+        return cmd_tune(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "chips") == 0) {
+        return cmd_chips(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "autotune") == 0) {
+        return cmd_autotune(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "efficiency") == 0) {
+        return cmd_efficiency(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "fan") == 0) {
+        return cmd_fan(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "throttle") == 0) {
+        return cmd_throttle(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "balance") == 0) {
+        return cmd_balance(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "power") == 0) {
+        return cmd_power(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "health") == 0) {
+        return cmd_health(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "recovery") == 0) {
+        return cmd_recovery(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "yield") == 0) {
+        return cmd_yield(response, resp_len, param);
+    }
+    else if (strcmp(cmd, "hash") == 0) {
+        return cmd_hash(response, resp_len, param);
+    }
+#if MOCK_ASIC
+    else if (strcmp(cmd, "sim") == 0) {
+        return cmd_sim(response, resp_len, param);
+    }
+#endif
     else {
         return snprintf(response, resp_len,
             "{\"STATUS\":[{\"STATUS\":\"E\",\"Code\":14,"
@@ -357,13 +1739,14 @@ int api_server_start(int port)
     
     api_server_running = 1;
     
-    /* Создаём задачу API сервера */
-    xTaskCreate(
+    /* Создаём задачу API сервера на сетевом ядре */
+    cores_task_create(
         api_server_task,
         "api_server",
         4096,
         (void *)(intptr_t)port,
         API_TASK_PRIORITY,
+        CORE_NET,
         NULL
     );
     
@@ -17,6 +17,7 @@
  * - devs      - информация об устройствах
  * - config    - конфигурация
  * - stats     - детальная статистика
+ * - cores     - раскладка задач по ядрам и загрузка ядер
  * - restart   - перезапуск майнера
  * 
  * =============================================================================
@@ -33,7 +34,7 @@
 
 #define API_DEFAULT_PORT    4028    /* Порт по умолчанию */
 #define API_MAX_RESPONSE    8192    /* Максимальный размер ответа */
-#define API_TASK_PRIORITY   3       /* Приоритет задачи API */
+#define API_TASK_PRIORITY   TASK_PRIO_API   /* Приоритет задачи API (cores.h) */
 
 /* ===========================================================================
  * ПРОТОТИПЫ ФУНКЦИЙ
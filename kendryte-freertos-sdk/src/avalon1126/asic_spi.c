@@ -0,0 +1,556 @@
+/**
+ * =============================================================================
+ * @file    asic_spi.c
+ * @brief   Avalon A1126pro - SPI транспорт пакетов ASIC (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Два слота кадров, очередь слотов на передачу и задача asic_spi, которая
+ * выполняет обмены через DMA драйвер SPI0 (или эмулятор при MOCK_ASIC).
+ * 
+ * ВЛАДЕНИЕ СЛОТАМИ:
+ * - Свободные слоты лежат в free_q. Вызывающий забирает слот, заполняет
+ *   его и кладёт индекс в work_q.
+ * - Кадр без ожидания ответа задача asic_spi сама возвращает в free_q.
+ * - Кадр с ожиданием: задача отдаёт семафор слота, вызывающий копирует
+ *   ответ и возвращает слот.
+ * - Вызывающий не дождался (таймаут): он снимает want_rx и уходит с
+ *   ошибкой, слот после конца передачи возвращает задача asic_spi.
+ *   Кто первым сбросил want_rx (атомарный обмен), тот и решает судьбу
+ *   слота, поэтому слот не теряется и не возвращается дважды.
+ * 
+ * Одиночный кадр - частный случай пакета из одного кадра: слот всегда
+ * содержит n кадров одинаковой длины, уложенных подряд, и передаётся
+ * одним вызовом драйвера.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <semphr.h>
+#include <clint.h>
+#include <encoding.h>
+
+#include "asic_spi.h"
+#include "avalon10.h"
+#include "cores.h"
+#include "cgminer.h"
+#include "mock_hardware.h"
+
+#if !MOCK_ASIC
+#include <devices.h>
+#include <fpioa.h>
+#endif
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "AsicSPI";
+
+#if !MOCK_ASIC
+/* Пины SPI0 и аппаратные CS модулей */
+#define ASIC_SPI_CLK_PIN    6
+#define ASIC_SPI_MOSI_PIN   7
+#define ASIC_SPI_MISO_PIN   8
+#define ASIC_SPI_CS_PIN_BASE 20     /* Пины 20-23 = SPI0_SS0..3 */
+#endif
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ТИПЫ
+ * =========================================================================== */
+
+/**
+ * @brief Слот передачи
+ */
+typedef struct asic_spi_slot {
+    uint8_t tx[ASIC_SPI_XFER_MAX] __attribute__((aligned(8)));
+    uint8_t rx[ASIC_SPI_XFER_MAX] __attribute__((aligned(8)));
+    size_t len;                     /* Длина передачи */
+    int n;                          /* Кадров в передаче */
+    int module_id;                  /* Модуль */
+    int want_rx;                    /* 1 = вызывающий ждёт ответ (атомарно) */
+    int result;                     /* Результат обмена */
+    uint64_t t_submit;              /* mtime постановки */
+    SemaphoreHandle_t done;         /* Завершение обмена */
+} asic_spi_slot_t;
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static asic_spi_slot_t slots[ASIC_SPI_SLOTS];
+static QueueHandle_t free_q = NULL;
+static QueueHandle_t work_q = NULL;
+static TaskHandle_t spi_task = NULL;
+
+#if !MOCK_ASIC
+static handle_t spi_dev[AVALON10_DEFAULT_MODULARS];
+#endif
+
+static asic_spi_stats_t stats;
+static uint64_t stat_cycles_sum;        /* Сумма тактов передач */
+static uint64_t stat_cycles_frames;     /* Кадров в stat_cycles_sum */
+static uint64_t stat_cpu_cycles_sum;    /* Сумма тактов вызывающей стороны */
+static uint64_t stat_cpu_frames;        /* Кадров в stat_cpu_cycles_sum */
+static uint64_t window_xfers;           /* xfers на начало окна tps */
+static uint64_t window_frames;          /* frames на начало окна tps */
+static uint64_t window_t;               /* mtime начала окна tps */
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Такты mtime в микросекунды
+ */
+static uint32_t mtime_to_us(uint64_t ticks)
+{
+    uint64_t ticks_per_us = uxPortGetCPUClock() / CLINT_CLOCK_DIV / 1000000UL;
+    
+    if (ticks_per_us == 0) {
+        ticks_per_us = 1;
+    }
+    
+    return (uint32_t)(ticks / ticks_per_us);
+}
+
+/**
+ * @brief Учёт тактов вызывающей стороны
+ */
+static void account_cpu(uint64_t cycles, int frames)
+{
+    stat_cpu_cycles_sum += cycles;
+    stat_cpu_frames += frames;
+}
+
+/**
+ * @brief Проверка параметров пакета
+ */
+static int burst_valid(int module_id, int n, size_t frame_len)
+{
+    return module_id >= 0 && module_id < AVALON10_DEFAULT_MODULARS &&
+           n > 0 && n <= ASIC_SPI_BURST_MAX &&
+           frame_len > 0 && frame_len <= ASIC_SPI_FRAME_MAX;
+}
+
+/**
+ * @brief Захват свободного слота
+ * @return          Индекс слота или -1 по таймауту
+ */
+static int slot_take(uint32_t timeout)
+{
+    uint8_t idx;
+    UBaseType_t busy;
+    
+    if (!free_q || xQueueReceive(free_q, &idx, pdMS_TO_TICKS(timeout)) != pdTRUE) {
+        stats.timeouts++;
+        return -1;
+    }
+    
+    busy = ASIC_SPI_SLOTS - uxQueueMessagesWaiting(free_q);
+    if (busy > stats.inflight_max) {
+        stats.inflight_max = busy;
+    }
+    
+    return idx;
+}
+
+/**
+ * @brief Возврат слота в список свободных
+ */
+static void slot_release(int idx)
+{
+    uint8_t i = (uint8_t)idx;
+    
+    xQueueSend(free_q, &i, 0);
+}
+
+/**
+ * @brief Заполнение слота кадрами и постановка в очередь передачи
+ */
+static void slot_queue(int idx, int module_id, const uint8_t *const frames[], int n,
+                       size_t frame_len, int want_rx)
+{
+    asic_spi_slot_t *s = &slots[idx];
+    uint8_t i = (uint8_t)idx;
+    
+    for (int f = 0; f < n; f++) {
+        if (frames[f]) {
+            memcpy(s->tx + f * frame_len, frames[f], frame_len);
+        } else {
+            memset(s->tx + f * frame_len, ASIC_SPI_IDLE_BYTE, frame_len);
+        }
+    }
+    s->len = frame_len * n;
+    s->n = n;
+    s->module_id = module_id;
+    s->want_rx = want_rx;
+    s->result = -1;
+    s->t_submit = clint->mtime;
+    
+    xQueueSend(work_q, &i, portMAX_DELAY);
+}
+
+/**
+ * @brief Физическая передача (один CS, одна DMA-передача)
+ */
+static int spi_transfer(int module_id, const uint8_t *tx, uint8_t *rx, size_t len)
+{
+#if MOCK_ASIC
+    return mock_asic_spi_transfer(module_id, tx, rx, len);
+#else
+    if (spi_dev_transfer_full_duplex(spi_dev[module_id], tx, len, rx, len) != (int)len) {
+        return -1;
+    }
+    return 0;
+#endif
+}
+
+/* ===========================================================================
+ * ЗАДАЧА ПЕРЕДАЧИ
+ * =========================================================================== */
+
+/**
+ * @brief Задача asic_spi
+ * 
+ * Выполняет передачи в порядке постановки. На время DMA-передачи
+ * заблокирована в драйвере на семафоре завершения DMA.
+ */
+static void asic_spi_task(void *pvParameters)
+{
+    uint8_t idx;
+    
+    (void)pvParameters;
+    
+    log_message(LOG_DEBUG, "TASKSTART Core %d asic_spi", (int)uxPortGetProcessorId());
+    
+    while (!g_want_quit) {
+        asic_spi_slot_t *s;
+        uint64_t t_done;
+        uint32_t us;
+    
+        if (xQueueReceive(work_q, &idx, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+    
+        s = &slots[idx];
+        s->result = spi_transfer(s->module_id, s->tx, s->rx, s->len);
+        t_done = clint->mtime;
+    
+        if (s->result == 0) {
+            stats.frames += s->n;
+            stats.xfers++;
+            if (s->n > 1) {
+                stats.bursts++;
+            }
+            stats.bytes += s->len;
+        } else {
+            stats.errors++;
+        }
+    
+        stat_cycles_sum += (t_done - s->t_submit) * CLINT_CLOCK_DIV;
+        stat_cycles_frames += s->n;
+        us = mtime_to_us(t_done - s->t_submit);
+        if (us > stats.us_per_frame_max) {
+            stats.us_per_frame_max = us;
+        }
+    
+        /* Вызывающий ещё ждёт - ему семафор, иначе слот освобождаем сами */
+        if (__atomic_exchange_n(&s->want_rx, 0, __ATOMIC_ACQ_REL)) {
+            xSemaphoreGive(s->done);
+        } else {
+            slot_release(idx);
+        }
+    }
+    
+    vTaskDelete(NULL);
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Инициализация SPI0, устройств модулей и задачи asic_spi
+ */
+int asic_spi_init(void)
+{
+    if (spi_task) {
+        return 0;
+    }
+    
+#if !MOCK_ASIC
+    handle_t spi = io_open(ASIC_SPI_DEVICE_PATH);
+    
+    if (!spi) {
+        log_message(LOG_ERR, "%s: Не удалось открыть %s", TAG, ASIC_SPI_DEVICE_PATH);
+        return -1;
+    }
+    
+    fpioa_set_function(ASIC_SPI_CLK_PIN, FUNC_SPI0_SCLK);
+    fpioa_set_function(ASIC_SPI_MOSI_PIN, FUNC_SPI0_D0);
+    fpioa_set_function(ASIC_SPI_MISO_PIN, FUNC_SPI0_D1);
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        fpioa_set_function(ASIC_SPI_CS_PIN_BASE + i, FUNC_SPI0_SS0 + i);
+    
+        /* Отдельное устройство на модуль: CS выставляет контроллер */
+        spi_dev[i] = spi_get_device(spi, SPI_MODE_0, SPI_FF_STANDARD, 1U << i, 8);
+        spi_dev_set_clock_rate(spi_dev[i], ASIC_SPI_CLK_RATE);
+    
+        /* Кадр 40 байт - всегда через DMA, без опроса FIFO в критической секции */
+        spi_dev_set_dma_threshold(spi_dev[i], 1);
+    }
+#endif
+    
+    memset(&stats, 0, sizeof(stats));
+    stat_cycles_sum = 0;
+    stat_cycles_frames = 0;
+    stat_cpu_cycles_sum = 0;
+    stat_cpu_frames = 0;
+    window_xfers = 0;
+    window_frames = 0;
+    window_t = clint->mtime;
+    
+    free_q = xQueueCreate(ASIC_SPI_SLOTS, sizeof(uint8_t));
+    work_q = xQueueCreate(ASIC_SPI_SLOTS, sizeof(uint8_t));
+    if (!free_q || !work_q) {
+        log_message(LOG_ERR, "%s: Не удалось создать очереди", TAG);
+        return -1;
+    }
+    
+    for (int i = 0; i < ASIC_SPI_SLOTS; i++) {
+        slots[i].done = xSemaphoreCreateBinary();
+        if (!slots[i].done) {
+            log_message(LOG_ERR, "%s: Не удалось создать семафор слота", TAG);
+            return -1;
+        }
+        slot_release(i);
+    }
+    
+    if (cores_task_create(asic_spi_task, "asic_spi", ASIC_SPI_TASK_STACK, NULL,
+                          TASK_PRIO_ASIC_SPI, CORE_MINING, &spi_task) != 0) {
+        return -1;
+    }
+    
+    log_message(LOG_INFO, "%s: SPI0 @ %d MHz, DMA, %d слота по %d кадров",
+               TAG, ASIC_SPI_CLK_RATE / 1000000, ASIC_SPI_SLOTS, ASIC_SPI_BURST_MAX);
+    
+    return 0;
+}
+
+/**
+ * @brief Постановка пакета кадров на передачу без ожидания ответа
+ */
+int asic_spi_burst_submit(int module_id, const uint8_t *const frames[], int n,
+                          size_t frame_len, uint32_t timeout)
+{
+    uint64_t c0 = read_csr(mcycle);
+    int idx;
+    
+    if (!frames || !burst_valid(module_id, n, frame_len)) {
+        return -1;
+    }
+    
+    idx = slot_take(timeout);
+    if (idx < 0) {
+        return -1;
+    }
+    
+    slot_queue(idx, module_id, frames, n, frame_len, 0);
+    
+    account_cpu(read_csr(mcycle) - c0, n);
+    
+    return 0;
+}
+
+/**
+ * @brief Постановка пакета кадров с последующим ожиданием ответа
+ */
+int asic_spi_burst_start(int module_id, const uint8_t *const frames[], int n,
+                         size_t frame_len, uint32_t timeout)
+{
+    uint64_t c0;
+    int idx;
+    
+    if (!frames || !burst_valid(module_id, n, frame_len)) {
+        return -1;
+    }
+    
+    c0 = read_csr(mcycle);
+    
+    idx = slot_take(timeout);
+    if (idx < 0) {
+        return -1;
+    }
+    
+    slot_queue(idx, module_id, frames, n, frame_len, 1);
+    
+    account_cpu(read_csr(mcycle) - c0, n);
+    
+    return idx;
+}
+
+/**
+ * @brief Ожидание завершения пакета, поставленного asic_spi_burst_start()
+ */
+int asic_spi_burst_wait(int handle, uint8_t *rx, uint32_t timeout)
+{
+    asic_spi_slot_t *s;
+    uint64_t c2;
+    int ret;
+    
+    if (handle < 0 || handle >= ASIC_SPI_SLOTS) {
+        return -1;
+    }
+    s = &slots[handle];
+    
+    /* Ожидание - процессор свободен, пока кадры идут по DMA */
+    if (xSemaphoreTake(s->done, pdMS_TO_TICKS(timeout)) != pdTRUE) {
+        if (__atomic_exchange_n(&s->want_rx, 0, __ATOMIC_ACQ_REL)) {
+            /* Передача ещё идёт: отказываемся от ответа, слот вернёт
+             * задача asic_spi, когда DMA закончится */
+            stats.timeouts++;
+            return -1;
+        }
+    
+        /* Задача уже завершила передачу и вот-вот отдаст семафор */
+        xSemaphoreTake(s->done, portMAX_DELAY);
+    }
+    c2 = read_csr(mcycle);
+    
+    ret = s->result;
+    if (ret == 0 && rx) {
+        memcpy(rx, s->rx, s->len);
+    }
+    slot_release(handle);
+    
+    account_cpu(read_csr(mcycle) - c2, 0);
+    
+    return ret;
+}
+
+/**
+ * @brief Пакетный полнодуплексный обмен с ожиданием завершения
+ */
+int asic_spi_burst_xfer(int module_id, const uint8_t *const frames[], int n,
+                        size_t frame_len, uint8_t *rx, uint32_t timeout)
+{
+    int idx = asic_spi_burst_start(module_id, frames, n, frame_len, timeout);
+    
+    if (idx < 0) {
+        return -1;
+    }
+    
+    return asic_spi_burst_wait(idx, rx, timeout);
+}
+
+/**
+ * @brief Постановка кадра на передачу без ожидания ответа
+ */
+int asic_spi_submit(int module_id, const uint8_t *tx, size_t len, uint32_t timeout)
+{
+    const uint8_t *frames[1] = { tx };
+    
+    if (!tx) {
+        return -1;
+    }
+    
+    return asic_spi_burst_submit(module_id, frames, 1, len, timeout);
+}
+
+/**
+ * @brief Полнодуплексный обмен кадром с ожиданием завершения
+ */
+int asic_spi_xfer(int module_id, const uint8_t *tx, uint8_t *rx, size_t len, uint32_t timeout)
+{
+    const uint8_t *frames[1] = { tx };
+    
+    return asic_spi_burst_xfer(module_id, frames, 1, len, rx, timeout);
+}
+
+/**
+ * @brief Ожидание завершения всех поставленных кадров
+ */
+int asic_spi_flush(uint32_t timeout)
+{
+    int taken[ASIC_SPI_SLOTS];
+    int n = 0, ret = 0;
+    
+    /* Все слоты свободны - значит, все кадры переданы */
+    for (int i = 0; i < ASIC_SPI_SLOTS; i++) {
+        taken[n] = slot_take(timeout);
+        if (taken[n] < 0) {
+            ret = -1;
+            break;
+        }
+        n++;
+    }
+    
+    for (int i = 0; i < n; i++) {
+        slot_release(taken[i]);
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief Пересчёт передач и кадров в секунду
+ */
+void asic_spi_stats_update(void)
+{
+    uint64_t now = clint->mtime;
+    uint32_t us = mtime_to_us(now - window_t);
+    uint64_t xfers = stats.xfers;
+    uint64_t frames = stats.frames;
+    
+    if (us == 0) {
+        return;
+    }
+    
+    stats.tps = (uint32_t)((xfers - window_xfers) * 1000000ULL / us);
+    if (stats.tps > stats.tps_max) {
+        stats.tps_max = stats.tps;
+    }
+    
+    stats.fps = (uint32_t)((frames - window_frames) * 1000000ULL / us);
+    if (stats.fps > stats.fps_max) {
+        stats.fps_max = stats.fps;
+    }
+    
+    window_xfers = xfers;
+    window_frames = frames;
+    window_t = now;
+}
+
+/**
+ * @brief Снимок статистики транспорта
+ */
+void asic_spi_get_stats(asic_spi_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+    
+    memcpy(out, &stats, sizeof(*out));
+    
+    out->cycles_per_frame = stat_cycles_frames ?
+                            (uint32_t)(stat_cycles_sum / stat_cycles_frames) : 0;
+    out->cpu_cycles_per_frame = stat_cpu_frames ?
+                                (uint32_t)(stat_cpu_cycles_sum / stat_cpu_frames) : 0;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА asic_spi.c
+ * =========================================================================== */
@@ -0,0 +1,230 @@
+/**
+ * =============================================================================
+ * @file    asic_spi.h
+ * @brief   Avalon A1126pro - SPI транспорт пакетов ASIC (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Полнодуплексный обмен 40-байтными пакетами avalon10_pkg_t по SPI0 с DMA.
+ * 
+ *   вызывающая задача ──► [слот 0 | слот 1] ──► asic_spi (ядро 1) ──► DMA SPI0
+ *                     ◄── семафор слота  ◄────────────┘
+ * 
+ * 1. Кадр копируется в свободный слот (их два - двойная буферизация):
+ *    пока DMA передаёт один кадр, вызывающий готовит следующий.
+ * 2. Задача asic_spi выполняет обмен через spi_dev_transfer_full_duplex();
+ *    на время передачи она заблокирована на семафоре DMA, ядро свободно.
+ * 3. Завершение сигнализируется семафором слота.
+ * 
+ * Выбор модуля - аппаратный CS контроллера (SPI0_SS0..3), поэтому CS
+ * держится всё время DMA-передачи без участия процессора.
+ * 
+ * Ответ на запрос ASIC выдаёт в следующем кадре обмена, поэтому приём -
+ * это обмен холостым кадром (0xFF), см. avalon10.c recv_pkg().
+ * 
+ * ПАКЕТНЫЙ ОБМЕН (burst):
+ * Несколько кадров одного модуля передаются одной DMA-передачей при одном
+ * выставлении CS. Ответ на кадр i приходит в кадре i+1 той же передачи:
+ * 
+ *   tx: [STATUS][NONCE ][ 0xFF ]
+ *   rx: [  ?   ][ответ ][ответ ]
+ *                STATUS  NONCE
+ * 
+ * Разбор ответов по кадрам выполняет вызывающий (avalon10.c).
+ * 
+ * При MOCK_ASIC обмен выполняет mock_asic_spi_transfer() по той же схеме
+ * слотов, статистика считается одинаково.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __ASIC_SPI_H__
+#define __ASIC_SPI_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+#define ASIC_SPI_DEVICE_PATH    "/dev/spi0"
+#define ASIC_SPI_CLK_RATE       10000000    /* 10 MHz */
+
+/**
+ * @brief Максимальный размер кадра (байт)
+ */
+#define ASIC_SPI_FRAME_MAX      64
+
+/**
+ * @brief Максимум кадров в одной пакетной передаче
+ */
+#define ASIC_SPI_BURST_MAX      8
+
+/**
+ * @brief Размер буфера слота (байт)
+ */
+#define ASIC_SPI_XFER_MAX       (ASIC_SPI_FRAME_MAX * ASIC_SPI_BURST_MAX)
+
+/**
+ * @brief Количество буферов передач (двойная буферизация)
+ */
+#define ASIC_SPI_SLOTS          2
+
+/**
+ * @brief Байт холостого кадра (ASIC игнорирует кадр без заголовка 'CN')
+ */
+#define ASIC_SPI_IDLE_BYTE      0xFF
+
+#define ASIC_SPI_TASK_STACK     2048
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct asic_spi_stats_t
+ * @brief Статистика SPI транспорта
+ */
+typedef struct asic_spi_stats {
+    uint64_t frames;                /* Передано кадров */
+    uint64_t xfers;                 /* DMA-передач (выставлений CS) */
+    uint64_t bursts;                /* Из них пакетных (больше одного кадра) */
+    uint64_t bytes;                 /* Передано байт */
+    uint64_t errors;                /* Ошибки передачи */
+    uint64_t timeouts;              /* Таймауты ожидания слота/завершения */
+    uint32_t tps;                   /* Передач в секунду (последнее окно) */
+    uint32_t tps_max;               /* Максимум передач в секунду */
+    uint32_t fps;                   /* Кадров в секунду (последнее окно) */
+    uint32_t fps_max;               /* Максимум кадров в секунду */
+    uint32_t cycles_per_frame;      /* Тактов CPU на кадр (от постановки до завершения) */
+    uint32_t cpu_cycles_per_frame;  /* Тактов CPU вызывающей стороны на кадр */
+    uint32_t us_per_frame_max;      /* Максимальная длительность передачи (мкс) */
+    uint32_t inflight_max;          /* Максимум одновременно занятых слотов */
+} asic_spi_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Инициализация SPI0, устройств модулей и задачи asic_spi
+ * @return 0 при успехе, -1 при ошибке
+ */
+int asic_spi_init(void);
+
+/**
+ * @brief Постановка кадра на передачу без ожидания ответа
+ * 
+ * Возвращается, как только кадр скопирован в слот. Блокируется, только
+ * если оба слота заняты.
+ * 
+ * @param module_id ID модуля (0-3)
+ * @param tx        Кадр
+ * @param len       Длина кадра (до ASIC_SPI_FRAME_MAX)
+ * @param timeout   Таймаут ожидания свободного слота (мс)
+ * @return          0 при успехе, -1 при ошибке
+ */
+int asic_spi_submit(int module_id, const uint8_t *tx, size_t len, uint32_t timeout);
+
+/**
+ * @brief Полнодуплексный обмен кадром с ожиданием завершения
+ * 
+ * @param module_id ID модуля (0-3)
+ * @param tx        Передаваемый кадр (NULL - холостой кадр)
+ * @param rx        Буфер принятого кадра (NULL - не нужен)
+ * @param len       Длина кадра
+ * @param timeout   Таймаут (мс)
+ * @return          0 при успехе, -1 при ошибке или таймауте
+ */
+int asic_spi_xfer(int module_id, const uint8_t *tx, uint8_t *rx, size_t len, uint32_t timeout);
+
+/**
+ * @brief Постановка пакета кадров на передачу без ожидания ответа
+ * 
+ * Все кадры уходят одной DMA-передачей при одном выставлении CS.
+ * 
+ * @param module_id ID модуля (0-3)
+ * @param frames    Кадры (NULL в элементе - холостой кадр)
+ * @param n         Количество кадров (1..ASIC_SPI_BURST_MAX)
+ * @param frame_len Длина каждого кадра (до ASIC_SPI_FRAME_MAX)
+ * @param timeout   Таймаут ожидания свободного слота (мс)
+ * @return          0 при успехе, -1 при ошибке
+ */
+int asic_spi_burst_submit(int module_id, const uint8_t *const frames[], int n,
+                          size_t frame_len, uint32_t timeout);
+
+/**
+ * @brief Пакетный полнодуплексный обмен с ожиданием завершения
+ * 
+ * @param module_id ID модуля (0-3)
+ * @param frames    Кадры (NULL в элементе - холостой кадр)
+ * @param n         Количество кадров (1..ASIC_SPI_BURST_MAX)
+ * @param frame_len Длина каждого кадра (до ASIC_SPI_FRAME_MAX)
+ * @param rx        Буфер принятых кадров, n * frame_len байт (NULL - не нужен)
+ * @param timeout   Таймаут (мс)
+ * @return          0 при успехе, -1 при ошибке или таймауте
+ */
+int asic_spi_burst_xfer(int module_id, const uint8_t *const frames[], int n,
+                        size_t frame_len, uint8_t *rx, uint32_t timeout);
+
+/**
+ * @brief Постановка пакета кадров с последующим ожиданием ответа
+ * 
+ * Асинхронная половина asic_spi_burst_xfer(): слот остаётся занятым до
+ * вызова asic_spi_burst_wait(), который обязателен для каждого успешного
+ * start. Ожидать можно до ASIC_SPI_SLOTS пакетов сразу (так опрос
+ * avalon10_poll() ведёт два модуля, depth SPI-транспорта = ASIC_SPI_SLOTS);
+ * пока все слоты заняты, остальные передачи (asic_spi_submit() и т.п.)
+ * ждут свободный слот до своего таймаута и при его истечении возвращают
+ * ошибку.
+ * 
+ * @param module_id ID модуля (0-3)
+ * @param frames    Кадры (NULL в элементе - холостой кадр)
+ * @param n         Количество кадров (1..ASIC_SPI_BURST_MAX)
+ * @param frame_len Длина каждого кадра (до ASIC_SPI_FRAME_MAX)
+ * @param timeout   Таймаут ожидания свободного слота (мс)
+ * @return          Дескриптор для asic_spi_burst_wait(), -1 при ошибке
+ */
+int asic_spi_burst_start(int module_id, const uint8_t *const frames[], int n,
+                         size_t frame_len, uint32_t timeout);
+
+/**
+ * @brief Ожидание завершения пакета и копирование ответа
+ * 
+ * Освобождает слот в любом случае. По таймауту возвращает ошибку сразу,
+ * не дожидаясь зависшей передачи: слот освободит задача asic_spi, когда
+ * драйвер завершит DMA, до этого слот недоступен другим передачам.
+ * 
+ * @param handle    Дескриптор из asic_spi_burst_start()
+ * @param rx        Буфер принятых кадров, n * frame_len байт (NULL - не нужен)
+ * @param timeout   Таймаут (мс)
+ * @return          0 при успехе, -1 при ошибке или таймауте
+ */
+int asic_spi_burst_wait(int handle, uint8_t *rx, uint32_t timeout);
+
+/**
+ * @brief Ожидание завершения всех поставленных кадров
+ * @param timeout   Таймаут (мс)
+ * @return          0 при успехе, -1 при таймауте
+ */
+int asic_spi_flush(uint32_t timeout);
+
+/**
+ * @brief Пересчёт передач и кадров в секунду (вызывается раз в секунду)
+ */
+void asic_spi_stats_update(void);
+
+/**
+ * @brief Снимок статистики транспорта
+ * @param stats     Структура для результата
+ */
+void asic_spi_get_stats(asic_spi_stats_t *stats);
+
+#endif /* __ASIC_SPI_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА asic_spi.h
+ * =========================================================================== */
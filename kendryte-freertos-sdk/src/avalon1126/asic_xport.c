@@ -0,0 +1,721 @@
+/**
+ * =============================================================================
+ * @file    asic_xport.c
+ * @brief   Avalon A1126pro - Транспорты пакетов ASIC (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Таблица транспортов, привязка модулей к транспортам, проверка ответов,
+ * статистика и трасса обменов. Сами транспорты - тонкие обёртки:
+ * 
+ * - spi:    пакет запросов + холостой кадр одной DMA-передачей
+ *           (asic_spi_burst_start/wait), ответ i - в кадре i+1.
+ * - auc:    запросы одной записью в UART (auc_submit_batch), ответы
+ *           собираются по одному с повторами (auc_complete).
+ * - mock:   эмулятор модулей без SPI и слотов - нижняя граница стоимости
+ *           обмена для сравнения транспортов.
+ * - replay: ответы берутся из трассы по модулю и типу запроса.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
+#include "asic_xport.h"
+#include "asic_spi.h"
+#include "auc_uart.h"
+#include "cgminer.h"
+#include "mock_hardware.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Xport";
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static const asic_xport_ops_t *xport_ops[ASIC_XPORT_COUNT];
+static uint8_t xport_ready[ASIC_XPORT_COUNT];
+static uint8_t module_xport[AVALON10_DEFAULT_MODULARS];
+
+static asic_xport_stats_t xport_stats[ASIC_XPORT_COUNT];
+static uint64_t xport_us_sum[ASIC_XPORT_COUNT];
+
+/**
+ * @brief Трасса обменов
+ * Общая для записи и воспроизведения: записанную трассу replay
+ * воспроизводит без загрузки
+ */
+static asic_xport_trace_rec_t trace[ASIC_XPORT_TRACE_MAX];
+static int trace_count = 0;
+static int trace_recording = 0;
+static SemaphoreHandle_t trace_mutex = NULL;
+
+/* ===========================================================================
+ * ТРАНСПОРТ SPI
+ * =========================================================================== */
+
+static int spi_init(void)
+{
+    return asic_spi_init();
+}
+
+static int spi_submit(asic_xport_req_t *req)
+{
+    const uint8_t *frames[ASIC_SPI_BURST_MAX];
+    
+    for (int i = 0; i < req->n; i++) {
+        frames[i] = (const uint8_t *)&req->tx[i];
+    }
+    frames[req->n] = NULL;  /* Холостой кадр выталкивает ответ на последний запрос */
+    
+    req->handle[0] = asic_spi_burst_start(req->module_id, frames, req->n + 1,
+                                          AVALON10_PKG_SIZE, AVALON10_SPI_TIMEOUT_MS);
+    
+    return req->handle[0] < 0 ? -1 : 0;
+}
+
+static int spi_complete(asic_xport_req_t *req, avalon10_pkg_t *replies, int timeout)
+{
+    if (asic_spi_burst_wait(req->handle[0], (uint8_t *)req->rx, timeout) < 0) {
+        return -1;
+    }
+    
+    for (int i = 0; i < req->n; i++) {
+        replies[i] = req->rx[i + 1];
+    }
+    
+    return 0;
+}
+
+static int spi_send(int module_id, const avalon10_pkg_t *const pkgs[], int n)
+{
+    return asic_spi_burst_submit(module_id, (const uint8_t *const *)pkgs, n,
+                                 AVALON10_PKG_SIZE, AVALON10_SPI_TIMEOUT_MS);
+}
+
+static const asic_xport_ops_t spi_ops = {
+    .name = "spi",
+    .batch_max = ASIC_XPORT_BATCH_MAX,
+    .depth = ASIC_SPI_SLOTS,
+    .init = spi_init,
+    .submit = spi_submit,
+    .complete = spi_complete,
+    .send = spi_send,
+};
+
+/* ===========================================================================
+ * ТРАНСПОРТ AUC UART
+ * =========================================================================== */
+
+static int auc_xport_init(void)
+{
+    if (auc_get_stats()->initialized) {
+        return 0;
+    }
+    
+    return auc_init() == AUC_OK ? 0 : -1;
+}
+
+static int auc_xport_submit(asic_xport_req_t *req)
+{
+    return auc_submit_batch(req->module_id, req->tx, req->n, req->handle) == AUC_OK ? 0 : -1;
+}
+
+static int auc_xport_complete(asic_xport_req_t *req, avalon10_pkg_t *replies, int timeout)
+{
+    /* Ответы приходят по порядку: пока ждём первый, остальные уже в пути */
+    for (int i = 0; i < req->n; i++) {
+        if (auc_complete(req->handle[i], &replies[i], timeout) != AUC_OK) {
+            replies[i].type = 0;
+        }
+    }
+    
+    return 0;
+}
+
+static int auc_xport_send(int module_id, const avalon10_pkg_t *const pkgs[], int n)
+{
+    int ret = 0;
+    
+    for (int i = 0; i < n; i++) {
+        if (auc_send_pkg(module_id, pkgs[i]) != AUC_OK) {
+            ret = -1;
+        }
+    }
+    
+    return ret;
+}
+
+static const asic_xport_ops_t auc_ops = {
+    .name = "auc",
+    .batch_max = AUC_MAX_INFLIGHT < ASIC_XPORT_BATCH_MAX ? AUC_MAX_INFLIGHT : ASIC_XPORT_BATCH_MAX,
+    .depth = 1,     /* Линия общая, модуль переключается без запросов в полёте */
+    .init = auc_xport_init,
+    .submit = auc_xport_submit,
+    .complete = auc_xport_complete,
+    .send = auc_xport_send,
+};
+
+/* ===========================================================================
+ * ТРАНСПОРТ MOCK
+ * =========================================================================== */
+
+/**
+ * @brief Завершение для транспортов, которые отвечают сразу при отправке
+ * (mock, replay): ответы уже лежат в req->rx
+ */
+static int stash_complete(asic_xport_req_t *req, avalon10_pkg_t *replies, int timeout)
+{
+    (void)timeout;
+    
+    memcpy(replies, req->rx, req->n * sizeof(avalon10_pkg_t));
+    
+    return 0;
+}
+
+#if MOCK_ASIC
+
+static SemaphoreHandle_t mock_mutex = NULL;
+
+static int mock_init(void)
+{
+    if (!mock_mutex) {
+        mock_mutex = xSemaphoreCreateMutex();
+    }
+    
+    return mock_mutex ? 0 : -1;
+}
+
+/**
+ * @brief Отправка пакета эмулятору и снятие ответа (под mock_mutex)
+ */
+static int mock_exchange(int module_id, const avalon10_pkg_t *tx, avalon10_pkg_t *rx)
+{
+    if (mock_asic_send(module_id, (const uint8_t *)tx, AVALON10_PKG_SIZE) < 0) {
+        return -1;
+    }
+    
+    return mock_asic_recv(module_id, (uint8_t *)rx, AVALON10_PKG_SIZE, 0);
+}
+
+static int mock_submit(asic_xport_req_t *req)
+{
+    int ret = 0;
+    
+    xSemaphoreTake(mock_mutex, portMAX_DELAY);
+    for (int i = 0; i < req->n; i++) {
+        if (mock_exchange(req->module_id, &req->tx[i], &req->rx[i]) < 0) {
+            memset(&req->rx[i], 0, sizeof(req->rx[i]));
+            ret = -1;
+        }
+    }
+    xSemaphoreGive(mock_mutex);
+    
+    return ret;
+}
+
+static int mock_send(int module_id, const avalon10_pkg_t *const pkgs[], int n)
+{
+    int ret = 0;
+    
+    xSemaphoreTake(mock_mutex, portMAX_DELAY);
+    for (int i = 0; i < n; i++) {
+        if (mock_asic_send(module_id, (const uint8_t *)pkgs[i], AVALON10_PKG_SIZE) < 0) {
+            ret = -1;
+        }
+    }
+    xSemaphoreGive(mock_mutex);
+    
+    return ret;
+}
+
+static const asic_xport_ops_t mock_ops = {
+    .name = "mock",
+    .batch_max = ASIC_XPORT_BATCH_MAX,
+    .depth = AVALON10_DEFAULT_MODULARS,
+    .init = mock_init,
+    .submit = mock_submit,
+    .complete = stash_complete,
+    .send = mock_send,
+};
+
+#endif /* MOCK_ASIC */
+
+/* ===========================================================================
+ * ТРАНСПОРТ REPLAY
+ * =========================================================================== */
+
+static int replay_pos[AVALON10_DEFAULT_MODULARS];
+static uint32_t replay_misses = 0;
+
+static int replay_init(void)
+{
+    memset(replay_pos, 0, sizeof(replay_pos));
+    replay_misses = 0;
+    
+    return 0;
+}
+
+/**
+ * @brief Следующая запись трассы модуля с тем же типом запроса (под trace_mutex)
+ * 
+ * Поиск идёт от позиции модуля по кругу, поэтому короткая трасса
+ * воспроизводится бесконечно. Записи других модулей пропускаются.
+ * 
+ * @return          Индекс записи или -1
+ */
+static int replay_next(int module_id, uint8_t type)
+{
+    int pos = replay_pos[module_id];
+    
+    for (int k = 0; k < trace_count; k++) {
+        int i = (pos + k) % trace_count;
+    
+        if (trace[i].module_id == module_id && trace[i].req.type == type) {
+            replay_pos[module_id] = (i + 1) % trace_count;
+            return i;
+        }
+    }
+    
+    replay_misses++;
+    return -1;
+}
+
+static int replay_submit(asic_xport_req_t *req)
+{
+    xSemaphoreTake(trace_mutex, portMAX_DELAY);
+    for (int i = 0; i < req->n; i++) {
+        int r = replay_next(req->module_id, req->tx[i].type);
+    
+        if (r >= 0 && trace[r].replied) {
+            req->rx[i] = trace[r].reply;
+        } else {
+            memset(&req->rx[i], 0, sizeof(req->rx[i]));
+        }
+    }
+    xSemaphoreGive(trace_mutex);
+    
+    return 0;
+}
+
+static int replay_send(int module_id, const avalon10_pkg_t *const pkgs[], int n)
+{
+    xSemaphoreTake(trace_mutex, portMAX_DELAY);
+    for (int i = 0; i < n; i++) {
+        replay_next(module_id, pkgs[i]->type);
+    }
+    xSemaphoreGive(trace_mutex);
+    
+    return 0;
+}
+
+static const asic_xport_ops_t replay_ops = {
+    .name = "replay",
+    .batch_max = ASIC_XPORT_BATCH_MAX,
+    .depth = AVALON10_DEFAULT_MODULARS,
+    .init = replay_init,
+    .submit = replay_submit,
+    .complete = stash_complete,
+    .send = replay_send,
+};
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Регистрация таблицы транспортов
+ */
+static void xport_register(void)
+{
+    if (xport_ops[ASIC_XPORT_SPI]) {
+        return;
+    }
+    
+    xport_ops[ASIC_XPORT_SPI] = &spi_ops;
+    xport_ops[ASIC_XPORT_AUC] = &auc_ops;
+#if MOCK_ASIC
+    xport_ops[ASIC_XPORT_MOCK] = &mock_ops;
+#endif
+    xport_ops[ASIC_XPORT_REPLAY] = &replay_ops;
+    
+    trace_mutex = xSemaphoreCreateMutex();
+}
+
+/**
+ * @brief Транспорт модуля
+ */
+static const asic_xport_ops_t *module_ops(int module_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return NULL;
+    }
+    
+    return xport_ops[module_xport[module_id]];
+}
+
+/**
+ * @brief Индекс транспорта по таблице операций
+ */
+static int ops_type(const asic_xport_ops_t *ops)
+{
+    for (int t = 0; t < ASIC_XPORT_COUNT; t++) {
+        if (xport_ops[t] == ops) {
+            return t;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Запись обмена в трассу
+ */
+static void trace_add(int module_id, const avalon10_pkg_t *req, const avalon10_pkg_t *reply)
+{
+    asic_xport_trace_rec_t *rec;
+    
+    xSemaphoreTake(trace_mutex, portMAX_DELAY);
+    if (trace_recording && trace_count < ASIC_XPORT_TRACE_MAX) {
+        rec = &trace[trace_count++];
+        memset(rec, 0, sizeof(*rec));
+        rec->module_id = (uint8_t)module_id;
+        rec->req = *req;
+        if (reply) {
+            rec->reply = *reply;
+            rec->replied = 1;
+        }
+    }
+    xSemaphoreGive(trace_mutex);
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Назначение транспорта модулю
+ */
+int asic_xport_bind(int module_id, int type)
+{
+    const asic_xport_ops_t *ops;
+    
+    xport_register();
+    
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        type < 0 || type >= ASIC_XPORT_COUNT) {
+        return -1;
+    }
+    
+    ops = xport_ops[type];
+    if (!ops) {
+        log_message(LOG_WARNING, "%s: Транспорт %d недоступен в этой сборке", TAG, type);
+        return -1;
+    }
+    
+    if (!xport_ready[type]) {
+        if (ops->init() != 0) {
+            log_message(LOG_ERR, "%s: Не удалось запустить транспорт %s", TAG, ops->name);
+            return -1;
+        }
+        xport_ready[type] = 1;
+    }
+    
+    module_xport[module_id] = (uint8_t)type;
+    
+    log_message(LOG_DEBUG, "%s: Модуль %d -> %s", TAG, module_id, ops->name);
+    
+    return 0;
+}
+
+/**
+ * @brief Транспорт модуля
+ */
+int asic_xport_type(int module_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return ASIC_XPORT_DEFAULT;
+    }
+    
+    return module_xport[module_id];
+}
+
+/**
+ * @brief Имя транспорта
+ */
+const char *asic_xport_name(int type)
+{
+    static const char *names[ASIC_XPORT_COUNT] = { "spi", "auc", "mock", "replay" };
+    
+    if (type < 0 || type >= ASIC_XPORT_COUNT) {
+        return "?";
+    }
+    
+    return names[type];
+}
+
+/**
+ * @brief Поиск транспорта по имени
+ */
+int asic_xport_parse(const char *name)
+{
+    for (int t = 0; name && t < ASIC_XPORT_COUNT; t++) {
+        if (strcmp(name, asic_xport_name(t)) == 0) {
+            return t;
+        }
+    }
+    
+    return -1;
+}
+
+/**
+ * @brief Максимум запросов в пакете для транспорта модуля
+ */
+int asic_xport_batch_max(int module_id)
+{
+    const asic_xport_ops_t *ops = module_ops(module_id);
+    
+    return ops ? ops->batch_max : 1;
+}
+
+/**
+ * @brief Можно ли перекрыть обмены двух модулей
+ */
+int asic_xport_can_overlap(int module_a, int module_b)
+{
+    const asic_xport_ops_t *a = module_ops(module_a);
+    const asic_xport_ops_t *b = module_ops(module_b);
+    
+    if (!a || !b) {
+        return 0;
+    }
+    
+    return a != b || a->depth > 1;
+}
+
+/**
+ * @brief Отправка пакета запросов без ожидания ответов
+ */
+int asic_xport_submit(int module_id, const avalon10_pkg_t *const reqs[], int n,
+                      asic_xport_req_t *req)
+{
+    const asic_xport_ops_t *ops = module_ops(module_id);
+    
+    if (!ops || !reqs || !req || n <= 0 || n > ops->batch_max) {
+        return -1;
+    }
+    
+    req->ops = ops;
+    req->module_id = module_id;
+    req->n = n;
+    for (int i = 0; i < n; i++) {
+        req->tx[i] = *reqs[i];
+    }
+    req->t_submit = cgminer_time_us();
+    
+    if (ops->submit(req) < 0) {
+        xport_stats[ops_type(ops)].errors++;
+        req->ops = NULL;
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Ожидание ответов на пакет запросов
+ */
+int asic_xport_complete(asic_xport_req_t *req, avalon10_pkg_t *replies, int timeout)
+{
+    asic_xport_stats_t *st;
+    uint32_t us;
+    int got = 0;
+    int t;
+    
+    if (!req || !req->ops || !replies) {
+        return -1;
+    }
+    
+    t = ops_type(req->ops);
+    st = &xport_stats[t];
+    
+    if (req->ops->complete(req, replies, timeout) < 0) {
+        st->errors++;
+        req->ops = NULL;
+        return -1;
+    }
+    req->ops = NULL;
+    
+    for (int i = 0; i < req->n; i++) {
+        avalon10_pkg_t *r = &replies[i];
+    
+        if (r->type == req->tx[i].type && avalon10_pkg_valid(r)) {
+            got++;
+        } else {
+            if (r->head[0] == AVALON10_PKT_HEAD1 && r->head[1] == AVALON10_PKT_HEAD2) {
+                st->bad_replies++;
+            }
+            r->type = 0;
+        }
+    
+        if (trace_recording && t != ASIC_XPORT_REPLAY) {
+            trace_add(req->module_id, &req->tx[i], r->type ? r : NULL);
+        }
+    }
+    
+    us = (uint32_t)(cgminer_time_us() - req->t_submit);
+    st->batches++;
+    st->requests += req->n;
+    st->replies += got;
+    xport_us_sum[t] += us;
+    if (us > st->us_max) {
+        st->us_max = us;
+    }
+    
+    return got;
+}
+
+/**
+ * @brief Синхронный обмен пакетом запросов
+ */
+int asic_xport_xfer(int module_id, const avalon10_pkg_t *const reqs[], int n,
+                    avalon10_pkg_t *replies, int timeout)
+{
+    asic_xport_req_t req;
+    
+    if (asic_xport_submit(module_id, reqs, n, &req) < 0) {
+        return -1;
+    }
+    
+    return asic_xport_complete(&req, replies, timeout);
+}
+
+/**
+ * @brief Отправка пакетов без ответа
+ */
+int asic_xport_send(int module_id, const avalon10_pkg_t *const pkgs[], int n)
+{
+    const asic_xport_ops_t *ops = module_ops(module_id);
+    int t;
+    
+    if (!ops || !pkgs || n <= 0 || n > ASIC_SPI_BURST_MAX) {
+        return -1;
+    }
+    t = ops_type(ops);
+    
+    if (ops->send(module_id, pkgs, n) < 0) {
+        xport_stats[t].errors++;
+        return -1;
+    }
+    xport_stats[t].sent++;
+    
+    if (trace_recording && t != ASIC_XPORT_REPLAY) {
+        for (int i = 0; i < n; i++) {
+            trace_add(module_id, pkgs[i], NULL);
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Снимок статистики транспорта
+ */
+void asic_xport_get_stats(int type, asic_xport_stats_t *out)
+{
+    if (!out || type < 0 || type >= ASIC_XPORT_COUNT) {
+        return;
+    }
+    
+    memcpy(out, &xport_stats[type], sizeof(*out));
+    
+    out->us_avg = out->batches ? (uint32_t)(xport_us_sum[type] / out->batches) : 0;
+    out->modules = 0;
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        if (module_xport[i] == type) {
+            out->modules++;
+        }
+    }
+    if (type == ASIC_XPORT_REPLAY) {
+        out->bad_replies += replay_misses;
+    }
+}
+
+/**
+ * @brief Начало записи трассы
+ */
+void asic_xport_trace_start(void)
+{
+    xport_register();
+    
+    xSemaphoreTake(trace_mutex, portMAX_DELAY);
+    trace_count = 0;
+    trace_recording = 1;
+    memset(replay_pos, 0, sizeof(replay_pos));
+    xSemaphoreGive(trace_mutex);
+    
+    log_message(LOG_INFO, "%s: Запись трассы", TAG);
+}
+
+/**
+ * @brief Остановка записи трассы
+ */
+int asic_xport_trace_stop(void)
+{
+    trace_recording = 0;
+    
+    log_message(LOG_INFO, "%s: Трасса записана: %d обменов", TAG, trace_count);
+    
+    return trace_count;
+}
+
+/**
+ * @brief Доступ к буферу трассы
+ */
+const asic_xport_trace_rec_t *asic_xport_trace_get(int *count)
+{
+    if (count) {
+        *count = trace_count;
+    }
+    
+    return trace;
+}
+
+/**
+ * @brief Загрузка трассы для транспорта replay
+ */
+int asic_xport_trace_load(const asic_xport_trace_rec_t *recs, int count)
+{
+    if (!recs || count < 0 || count > ASIC_XPORT_TRACE_MAX) {
+        return -1;
+    }
+    
+    xport_register();
+    
+    xSemaphoreTake(trace_mutex, portMAX_DELAY);
+    trace_recording = 0;
+    memcpy(trace, recs, count * sizeof(*recs));
+    trace_count = count;
+    memset(replay_pos, 0, sizeof(replay_pos));
+    xSemaphoreGive(trace_mutex);
+    
+    return 0;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА asic_xport.c
+ * =========================================================================== */
@@ -0,0 +1,258 @@
+/**
+ * =============================================================================
+ * @file    asic_xport.h
+ * @brief   Avalon A1126pro - Транспорты пакетов ASIC (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Единый интерфейс обмена пакетами avalon10_pkg_t с модулями. Транспорт
+ * выбирается для каждого модуля отдельно во время работы:
+ * 
+ *   ASIC_XPORT_SPI     - SPI0 с DMA (asic_spi.c), по умолчанию
+ *   ASIC_XPORT_AUC     - AUC UART 3 Mbaud с конвейером запросов (auc_uart.c)
+ *   ASIC_XPORT_MOCK    - прямой вызов эмулятора модулей (только MOCK_ASIC)
+ *   ASIC_XPORT_REPLAY  - воспроизведение записанной трассы обменов
+ * 
+ * Обмен асинхронный: asic_xport_submit() отправляет пакет запросов и
+ * сразу возвращается, asic_xport_complete() ждёт ответы. Между ними
+ * вызывающий может отправить запросы другому модулю, если оба
+ * транспорта это допускают (asic_xport_can_overlap()).
+ * 
+ *   avalon10.c ──► asic_xport ──┬──► asic_spi   ──► SPI0 DMA
+ *                               ├──► auc_uart   ──► UART1
+ *                               ├──► эмулятор (MOCK_ASIC)
+ *                               └──► трасса (replay)
+ *                                    ▲
+ *                     запись трассы ─┘ (любой транспорт)
+ * 
+ * ТРАССА:
+ * Пока включена запись, каждый запрос и ответ на него сохраняются в
+ * буфер трассы. Трассу можно выгрузить, загрузить обратно и прогнать
+ * драйвер на транспорте replay без модулей.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __ASIC_XPORT_H__
+#define __ASIC_XPORT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "avalon10.h"
+#include "asic_spi.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Типы транспорта
+ */
+#define ASIC_XPORT_SPI          0
+#define ASIC_XPORT_AUC          1
+#define ASIC_XPORT_MOCK         2
+#define ASIC_XPORT_REPLAY       3
+#define ASIC_XPORT_COUNT        4
+
+/**
+ * @brief Транспорт модулей по умолчанию
+ */
+#define ASIC_XPORT_DEFAULT      ASIC_XPORT_SPI
+
+/**
+ * @brief Максимум запросов в одном пакете
+ * SPI передаёт пакет с завершающим холостым кадром
+ */
+#define ASIC_XPORT_BATCH_MAX    (ASIC_SPI_BURST_MAX - 1)
+
+/**
+ * @brief Ёмкость буфера трассы (записей)
+ */
+#define ASIC_XPORT_TRACE_MAX    256
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+struct asic_xport_ops;
+
+/**
+ * @struct asic_xport_req_t
+ * @brief Пакет запросов в полёте (память вызывающего)
+ */
+typedef struct asic_xport_req {
+    const struct asic_xport_ops *ops;       /* Транспорт, принявший пакет */
+    int module_id;                          /* Модуль */
+    int n;                                  /* Запросов в пакете */
+    int handle[ASIC_XPORT_BATCH_MAX];       /* Дескрипторы транспорта */
+    uint64_t t_submit;                      /* Время отправки (мкс) */
+    avalon10_pkg_t tx[ASIC_XPORT_BATCH_MAX];    /* Запросы (тип ответа, трасса) */
+    avalon10_pkg_t rx[ASIC_XPORT_BATCH_MAX + 1];    /* Приём транспорта (SPI - со сдвигом на кадр) */
+} asic_xport_req_t;
+
+/**
+ * @struct asic_xport_ops_t
+ * @brief Таблица операций транспорта
+ * 
+ * complete() раскладывает ответы по replies[0..n-1] без проверки:
+ * заголовок, тип и CRC проверяет asic_xport_complete().
+ */
+typedef struct asic_xport_ops {
+    const char *name;                       /* Имя для API и лога */
+    int batch_max;                          /* Максимум запросов в пакете */
+    int depth;                              /* Пакетов с ответом в полёте на транспорт */
+    int (*init)(void);
+    int (*submit)(asic_xport_req_t *req);
+    int (*complete)(asic_xport_req_t *req, avalon10_pkg_t *replies, int timeout);
+    int (*send)(int module_id, const avalon10_pkg_t *const pkgs[], int n);
+} asic_xport_ops_t;
+
+/**
+ * @struct asic_xport_stats_t
+ * @brief Статистика транспорта
+ */
+typedef struct asic_xport_stats {
+    uint64_t batches;                       /* Пакетов запросов с ответом */
+    uint64_t requests;                      /* Запросов в них */
+    uint64_t replies;                       /* Принятых верных ответов */
+    uint64_t sent;                          /* Пакетов без ответа (работа, настройки) */
+    uint32_t errors;                        /* Ошибки отправки и ожидания */
+    uint32_t bad_replies;                   /* Ответы с чужим типом или неверной CRC */
+    uint32_t us_avg;                        /* Среднее время пакета (мкс) */
+    uint32_t us_max;                        /* Максимальное время пакета (мкс) */
+    uint32_t modules;                       /* Модулей на транспорте */
+} asic_xport_stats_t;
+
+/**
+ * @struct asic_xport_trace_rec_t
+ * @brief Запись трассы: запрос и ответ на него
+ */
+typedef struct asic_xport_trace_rec {
+    uint8_t module_id;
+    uint8_t replied;                        /* 0 - запрос без ответа или ответ потерян */
+    uint8_t reserved[2];
+    avalon10_pkg_t req;
+    avalon10_pkg_t reply;
+} asic_xport_trace_rec_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Назначение транспорта модулю
+ * 
+ * Транспорт инициализируется при первом назначении.
+ * 
+ * @param module_id ID модуля (0-3)
+ * @param type      ASIC_XPORT_*
+ * @return          0 при успехе, -1 если транспорт недоступен
+ */
+int asic_xport_bind(int module_id, int type);
+
+/**
+ * @brief Транспорт модуля
+ * @return          ASIC_XPORT_*
+ */
+int asic_xport_type(int module_id);
+
+/**
+ * @brief Имя транспорта
+ */
+const char *asic_xport_name(int type);
+
+/**
+ * @brief Поиск транспорта по имени ("spi", "auc", "mock", "replay")
+ * @return          ASIC_XPORT_* или -1
+ */
+int asic_xport_parse(const char *name);
+
+/**
+ * @brief Максимум запросов в пакете для транспорта модуля
+ */
+int asic_xport_batch_max(int module_id);
+
+/**
+ * @brief Можно ли отправить пакет модулю b, не дождавшись ответа модуля a
+ * 
+ * Разные транспорты независимы; на одном транспорте - если он держит
+ * больше одного пакета в полёте. Линия AUC общая для всех модулей, и
+ * модуль переключается только без запросов в полёте.
+ */
+int asic_xport_can_overlap(int module_a, int module_b);
+
+/**
+ * @brief Отправка пакета запросов без ожидания ответов
+ * 
+ * @param module_id ID модуля (0-3)
+ * @param reqs      Запросы
+ * @param n         Количество (до asic_xport_batch_max())
+ * @param req       Состояние пакета для asic_xport_complete()
+ * @return          0 при успехе, -1 при ошибке
+ */
+int asic_xport_submit(int module_id, const avalon10_pkg_t *const reqs[], int n,
+                      asic_xport_req_t *req);
+
+/**
+ * @brief Ожидание ответов на пакет запросов
+ * 
+ * Ответ без заголовка 'CN', с чужим типом или неверной CRC считается
+ * отсутствующим (type = 0).
+ * 
+ * @param req       Пакет из asic_xport_submit()
+ * @param replies   Ответы, req->n пакетов
+ * @param timeout   Таймаут (мс)
+ * @return          Количество принятых ответов, -1 при ошибке транспорта
+ */
+int asic_xport_complete(asic_xport_req_t *req, avalon10_pkg_t *replies, int timeout);
+
+/**
+ * @brief Синхронный обмен пакетом запросов
+ * @return          Количество принятых ответов, -1 при ошибке транспорта
+ */
+int asic_xport_xfer(int module_id, const avalon10_pkg_t *const reqs[], int n,
+                    avalon10_pkg_t *replies, int timeout);
+
+/**
+ * @brief Отправка пакетов без ответа (работа, частота, напряжение)
+ * @return          0 при успехе, -1 при ошибке
+ */
+int asic_xport_send(int module_id, const avalon10_pkg_t *const pkgs[], int n);
+
+/**
+ * @brief Снимок статистики транспорта
+ */
+void asic_xport_get_stats(int type, asic_xport_stats_t *stats);
+
+/**
+ * @brief Начало записи трассы (буфер трассы очищается)
+ */
+void asic_xport_trace_start(void);
+
+/**
+ * @brief Остановка записи трассы
+ * @return          Записей в трассе
+ */
+int asic_xport_trace_stop(void);
+
+/**
+ * @brief Доступ к буферу трассы (для выгрузки)
+ * @param count     Записей в трассе
+ * @return          Первая запись
+ */
+const asic_xport_trace_rec_t *asic_xport_trace_get(int *count);
+
+/**
+ * @brief Загрузка трассы для транспорта replay
+ * @return          0 при успехе, -1 если трасса не помещается
+ */
+int asic_xport_trace_load(const asic_xport_trace_rec_t *recs, int count);
+
+#endif /* __ASIC_XPORT_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА asic_xport.h
+ * =========================================================================== */
@@ -7,8 +7,23 @@
  * =============================================================================
  * 
  * ОПИСАНИЕ:
- * Реализация драйвера для коммуникации с ASIC модулями через UART.
- * Текущая версия - stub для совместимости. Реальная коммуникация через SPI.
+ * Реализация драйвера для коммуникации с ASIC модулями через UART1 на
+ * 3 Мбод. Передача - одной записью на пакет запросов (DMA в драйвере SDK),
+ * приём - задача auc_rx, собирающая кадры из потока байт.
+ * 
+ * СЛОТЫ ЗАПРОСОВ:
+ * - FREE     - свободен
+ * - PENDING  - запрос передан, ответ ожидается
+ * - DONE     - ответ получен, auc_complete() забирает его
+ * - LOST     - модуль ответил на более поздний запрос, этот будет повторён
+ * 
+ * Слот занимает вызывающий (auc_submit) и освобождает только он же
+ * (auc_complete). Задача auc_rx меняет лишь состояние и отдаёт семафор.
+ * Все поля слотов и auc_state защищены auc_mutex.
+ * 
+ * ВЫБОР МОДУЛЯ:
+ * Модуль выбирается линиями GPIOHS, поэтому переключение возможно только
+ * без запросов в полёте: ответ не должен прийти от другого модуля.
  * 
  * =============================================================================
  */
@@ -17,16 +32,66 @@
 #include <string.h>
 
 #include "auc_uart.h"
+#include "cores.h"
 #include "cgminer.h"
 #include "mock_hardware.h"
 
 /* FreeRTOS */
 #include "FreeRTOS.h"
 #include "task.h"
+#include "queue.h"
 #include "semphr.h"
 
+#if !MOCK_ASIC
+#include <devices.h>
+#include <fpioa.h>
+#endif
+
 static const char *TAG = "AUC";
 
+#if !MOCK_ASIC
+/* Первый пин линий выбора модуля (GPIOHS AUC_MODULE_SEL_BASE..+3) */
+#define AUC_MODULE_SEL_PIN      26
+#endif
+
+/* Передач без ответа: у каждого запроса в полёте первая и все повторы */
+#define AUC_TX_LOG_LEN          (AUC_MAX_INFLIGHT * (AUC_MAX_RETRIES + 1))
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ТИПЫ
+ * =========================================================================== */
+
+/**
+ * @brief Состояние слота запроса
+ */
+typedef enum {
+    AUC_REQ_FREE = 0,
+    AUC_REQ_PENDING,
+    AUC_REQ_DONE,
+    AUC_REQ_LOST
+} auc_req_state_t;
+
+/**
+ * @brief Слот запроса в полёте
+ */
+typedef struct auc_req {
+    auc_req_state_t state;
+    uint8_t module_id;
+    uint8_t retries;                /* Выполнено повторов */
+    uint64_t t_tx;                  /* Время передачи (мкс) */
+    avalon10_pkg_t tx;              /* Запрос (для повтора) */
+    avalon10_pkg_t rx;              /* Ответ */
+    SemaphoreHandle_t done;         /* Ответ получен или запрос потерян */
+} auc_req_t;
+
+/**
+ * @brief Передача, ожидающая ответа
+ */
+typedef struct auc_tx {
+    uint8_t type;                   /* Тип запроса = тип ответа */
+    int8_t req;                     /* Слот запроса, -1 - запрос уже завершён */
+} auc_tx_t;
+
 /* ===========================================================================
  * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
  * =========================================================================== */
@@ -34,11 +99,400 @@ static const char *TAG = "AUC";
 static auc_state_t auc_state = {0};
 static SemaphoreHandle_t auc_mutex = NULL;
 
+static auc_req_t reqs[AUC_MAX_INFLIGHT];
+static auc_tx_t tx_log[AUC_TX_LOG_LEN];  /* В порядке передачи */
+static int tx_log_len = 0;
+static QueueHandle_t rx_q = NULL;       /* Пакеты без запроса */
+static TaskHandle_t rx_task = NULL;
+
+#if !MOCK_ASIC
+static handle_t uart = 0;
+static handle_t gpio = 0;
+#endif
+
 /* ===========================================================================
- * ФУНКЦИИ ИНИЦИАЛИЗАЦИИ
+ * ФИЗИЧЕСКИЙ КАНАЛ
+ * =========================================================================== */
+
+/**
+ * @brief Запись в UART (драйвер SDK передаёт запись от 8 байт по DMA)
+ */
+static int link_write(const uint8_t *data, size_t len)
+{
+#if MOCK_ASIC
+    return mock_auc_write(data, len);
+#else
+    return io_write(uart, data, len) == (int)len ? 0 : -1;
+#endif
+}
+
+/**
+ * @brief Чтение из UART
+ * @return Прочитано байт (до len), -1 если за AUC_RX_POLL_MS ничего не пришло
+ */
+static int link_read(uint8_t *buf, size_t len)
+{
+#if MOCK_ASIC
+    return mock_auc_read(buf, len, AUC_RX_POLL_MS);
+#else
+    return io_read(uart, buf, len);
+#endif
+}
+
+/**
+ * @brief Переключение линий выбора модуля
+ */
+static void link_select(int module_id)
+{
+#if MOCK_ASIC
+    mock_auc_select(module_id);
+#else
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        gpio_set_pin_value(gpio, AUC_MODULE_SEL_BASE + i,
+                           i == module_id ? GPIO_PV_HIGH : GPIO_PV_LOW);
+    }
+#endif
+}
+
+/* ===========================================================================
+ * СЛОТЫ ЗАПРОСОВ
+ * =========================================================================== */
+
+/**
+ * @brief Удаление передач [0, n) из журнала (под auc_mutex)
+ */
+static void tx_log_drop(int n)
+{
+    tx_log_len -= n;
+    memmove(tx_log, tx_log + n, tx_log_len * sizeof(tx_log[0]));
+}
+
+/**
+ * @brief Передача запроса r в журнал (под auc_mutex)
+ */
+static void tx_log_push(const auc_req_t *r)
+{
+    if (tx_log_len == AUC_TX_LOG_LEN) {
+        /* Переполнение - только из-за ответов завершённым запросам, которые
+         * так и не пришли: вытесняется самая старая такая передача */
+        int i = 0;
+    
+        while (i < tx_log_len - 1 && tx_log[i].req >= 0) {
+            i++;
+        }
+        tx_log_len--;
+        memmove(tx_log + i, tx_log + i + 1, (tx_log_len - i) * sizeof(tx_log[0]));
+    }
+    
+    tx_log[tx_log_len].type = r->tx.type;
+    tx_log[tx_log_len].req = (int8_t)(r - reqs);
+    tx_log_len++;
+}
+
+/**
+ * @brief Запрос завершён: ответы на его передачи больше не нужны (под auc_mutex)
+ */
+static void tx_log_orphan(const auc_req_t *r)
+{
+    for (int i = 0; i < tx_log_len; i++) {
+        if (tx_log[i].req == r - reqs) {
+            tx_log[i].req = -1;
+        }
+    }
+}
+
+/**
+ * @brief Есть ли у запроса r передачи без ответа (под auc_mutex)
+ */
+static int tx_log_pending(const auc_req_t *r)
+{
+    for (int i = 0; i < tx_log_len; i++) {
+        if (tx_log[i].req == r - reqs) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Количество свободных слотов
+ */
+static int req_free_count(void)
+{
+    int n = 0;
+    
+    for (int i = 0; i < AUC_MAX_INFLIGHT; i++) {
+        if (reqs[i].state == AUC_REQ_FREE) {
+            n++;
+        }
+    }
+    
+    return n;
+}
+
+/**
+ * @brief Запись передачи в журнал и перевод слота в ожидание (под auc_mutex)
+ */
+static void req_arm(auc_req_t *r)
+{
+    /* Семафор мог остаться отданным от предыдущей попытки */
+    xSemaphoreTake(r->done, 0);
+    
+    tx_log_push(r);
+    r->state = AUC_REQ_PENDING;
+    r->t_tx = cgminer_time_us();
+}
+
+/**
+ * @brief Освобождение слота (под auc_mutex)
+ */
+static void req_release(auc_req_t *r)
+{
+    tx_log_orphan(r);
+    r->state = AUC_REQ_FREE;
+    auc_state.inflight--;
+}
+
+/**
+ * @brief Захват канала к модулю
+ * 
+ * Ждёт, пока модуль можно выбрать (нет запросов к другому модулю) и
+ * есть slots свободных слотов. При успехе возвращается с захваченным
+ * auc_mutex.
+ * 
+ * @return AUC_OK или AUC_ERR_BUSY по истечении AUC_DEFAULT_TIMEOUT
+ */
+static int link_acquire(int module_id, int slots)
+{
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(AUC_DEFAULT_TIMEOUT);
+    
+    for (;;) {
+        xSemaphoreTake(auc_mutex, portMAX_DELAY);
+    
+        if (auc_state.current_module != module_id && auc_state.inflight == 0) {
+            link_select(module_id);
+            auc_state.current_module = (uint8_t)module_id;
+            /* Ответы прежнего модуля уже не придут */
+            tx_log_len = 0;
+        }
+    
+        if (auc_state.current_module == module_id && req_free_count() >= slots) {
+            return AUC_OK;
+        }
+    
+        xSemaphoreGive(auc_mutex);
+    
+        if ((int32_t)(deadline - xTaskGetTickCount()) <= 0) {
+            return AUC_ERR_BUSY;
+        }
+        vTaskDelay(1);
+    }
+}
+
+/**
+ * @brief Передача пакета запросов одной записью
+ * 
+ * @param module_id ID модуля
+ * @param pkgs      Запросы
+ * @param n         Количество (до AUC_MAX_INFLIGHT)
+ * @param ids       Дескрипторы занятых слотов
+ * @return AUC_OK при успехе, код ошибки при неудаче
+ */
+static int submit_batch(int module_id, const avalon10_pkg_t *pkgs, int n, int *ids)
+{
+    size_t len = (size_t)n * AVALON10_PKG_SIZE;
+    int k = 0;
+    int ret;
+    
+    ret = link_acquire(module_id, n);
+    if (ret != AUC_OK) {
+        return ret;
+    }
+    
+    for (int i = 0; i < AUC_MAX_INFLIGHT && k < n; i++) {
+        auc_req_t *r = &reqs[i];
+    
+        if (r->state != AUC_REQ_FREE) {
+            continue;
+        }
+    
+        r->tx = pkgs[k];
+        r->module_id = (uint8_t)module_id;
+        r->retries = 0;
+        req_arm(r);
+        memcpy(auc_state.tx_buffer + k * AVALON10_PKG_SIZE, &pkgs[k], AVALON10_PKG_SIZE);
+        ids[k++] = i;
+    }
+    
+    auc_state.inflight += n;
+    if (auc_state.inflight > auc_state.inflight_max) {
+        auc_state.inflight_max = auc_state.inflight;
+    }
+    
+    if (link_write(auc_state.tx_buffer, len) < 0) {
+        /* Пакет не ушёл - его передачи последние в журнале */
+        tx_log_len -= n;
+        for (int i = 0; i < n; i++) {
+            req_release(&reqs[ids[i]]);
+        }
+        xSemaphoreGive(auc_mutex);
+        return AUC_ERR_NO_RESPONSE;
+    }
+    
+    auc_state.tx_packets += n;
+    auc_state.tx_bytes += len;
+    
+    xSemaphoreGive(auc_mutex);
+    
+    return AUC_OK;
+}
+
+/* ===========================================================================
+ * ПРИЁМ
+ * =========================================================================== */
+
+/**
+ * @brief Сопоставление принятого пакета передаче (под auc_mutex)
+ * 
+ * Модуль отвечает в порядке передач: ответ принадлежит самой старой
+ * передаче того же типа в журнале, а передачи старше неё остались без
+ * ответа. Повтор не отменяет прежнюю попытку: ответ на любую из них
+ * завершает запрос, ответы на остальные отбрасываются (stale). Если
+ * прежняя попытка на самом деле потеряна, ответ на повтор завершит
+ * запрос, а следующий ответ того же типа уйдёт за ним в stale - его
+ * запрос повторится.
+ */
+static void rx_deliver(const avalon10_pkg_t *pkg)
+{
+    auc_req_t *m;
+    int hit = 0;
+    
+    while (hit < tx_log_len && tx_log[hit].type != pkg->type) {
+        hit++;
+    }
+    
+    if (hit == tx_log_len) {
+        /* Ответ на auc_send_pkg() */
+        auc_state.unmatched++;
+        if (xQueueSend(rx_q, pkg, 0) != pdTRUE) {
+            avalon10_pkg_t old;
+    
+            xQueueReceive(rx_q, &old, 0);
+            xQueueSend(rx_q, pkg, 0);
+        }
+        return;
+    }
+    
+    m = tx_log[hit].req >= 0 ? &reqs[tx_log[hit].req] : NULL;
+    tx_log_drop(hit + 1);
+    
+    for (int i = 0; i < AUC_MAX_INFLIGHT; i++) {
+        auc_req_t *r = &reqs[i];
+    
+        if (r != m && r->state == AUC_REQ_PENDING && !tx_log_pending(r)) {
+            r->state = AUC_REQ_LOST;
+            auc_state.lost++;
+            xSemaphoreGive(r->done);
+        }
+    }
+    
+    if (!m || m->state != AUC_REQ_PENDING) {
+        auc_state.stale++;
+        return;
+    }
+    
+    tx_log_orphan(m);
+    m->rx = *pkg;
+    m->state = AUC_REQ_DONE;
+    auc_state.rx_packets++;
+    xSemaphoreGive(m->done);
+}
+
+/**
+ * @brief Выделение кадров из накопленных байт
  * 
- * NOTE: В текущей версии используется SPI интерфейс через avalon10.c
- *       UART реализация - заготовка для будущей поддержки AUC
+ * Кадр начинается с 'CN' и занимает AVALON10_PKG_SIZE байт. Байты до
+ * заголовка пропускаются; кадр с неверной CRC16 сдвигается на один байт,
+ * чтобы найти заголовок внутри него (ресинхронизация после потери байта).
+ */
+static void rx_parse(void)
+{
+    avalon10_pkg_t pkg;
+    
+    for (;;) {
+        uint8_t *b = auc_state.rx_buffer + auc_state.rx_head;
+        int avail = auc_state.rx_tail - auc_state.rx_head;
+        int skip = 0;
+    
+        while (skip < avail && !(b[skip] == AVALON10_PKT_HEAD1 &&
+               (skip + 1 == avail || b[skip + 1] == AVALON10_PKT_HEAD2))) {
+            skip++;
+        }
+        if (skip > 0) {
+            auc_state.resync_bytes += skip;
+            auc_state.rx_head += skip;
+            continue;
+        }
+    
+        if (avail < (int)AVALON10_PKG_SIZE) {
+            break;
+        }
+    
+        memcpy(&pkg, b, AVALON10_PKG_SIZE);
+        if (!avalon10_pkg_valid(&pkg)) {
+            auc_state.crc_errors++;
+            auc_state.resync_bytes++;
+            auc_state.rx_head++;
+            continue;
+        }
+        auc_state.rx_head += AVALON10_PKG_SIZE;
+    
+        xSemaphoreTake(auc_mutex, portMAX_DELAY);
+        rx_deliver(&pkg);
+        xSemaphoreGive(auc_mutex);
+    }
+    
+    /* Незавершённый кадр - в начало буфера */
+    if (auc_state.rx_head > 0) {
+        memmove(auc_state.rx_buffer, auc_state.rx_buffer + auc_state.rx_head,
+                auc_state.rx_tail - auc_state.rx_head);
+        auc_state.rx_tail -= auc_state.rx_head;
+        auc_state.rx_head = 0;
+    }
+}
+
+/**
+ * @brief Задача приёма auc_rx
+ * 
+ * Читает ровно столько байт, сколько не хватает до кадра: полный ответ
+ * забирается одним чтением, как только его последний байт принят.
+ */
+static void auc_rx_task(void *pvParameters)
+{
+    (void)pvParameters;
+    
+    log_message(LOG_DEBUG, "TASKSTART Core %d auc_rx", (int)uxPortGetProcessorId());
+    
+    while (!g_want_quit && auc_state.initialized) {
+        int need = (int)AVALON10_PKG_SIZE - (auc_state.rx_tail - auc_state.rx_head);
+        int n;
+    
+        n = link_read(auc_state.rx_buffer + auc_state.rx_tail, need);
+        if (n <= 0) {
+            continue;
+        }
+    
+        auc_state.rx_tail += n;
+        auc_state.rx_bytes += n;
+        rx_parse();
+    }
+    
+    rx_task = NULL;
+    vTaskDelete(NULL);
+}
+
+/* ===========================================================================
+ * ФУНКЦИИ ИНИЦИАЛИЗАЦИИ
  * =========================================================================== */
 
 int auc_init(void)
@@ -47,22 +501,60 @@ int auc_init(void)
         return AUC_OK;
     }
     
-    log_message(LOG_INFO, "%s: Инициализация AUC драйвера (stub)", TAG);
+    log_message(LOG_INFO, "%s: Инициализация AUC драйвера", TAG);
+    
+    /* Очистка состояния */
+    memset(&auc_state, 0, sizeof(auc_state));
+    auc_state.baudrate = AUC_UART_BAUDRATE_HIGH;
+    auc_state.current_module = 0xFF;  /* Никакой не выбран */
     
     /* Создаём мьютекс для защиты доступа */
     auc_mutex = xSemaphoreCreateMutex();
-    if (auc_mutex == NULL) {
+    rx_q = xQueueCreate(AUC_RX_QUEUE_LEN, sizeof(avalon10_pkg_t));
+    if (auc_mutex == NULL || rx_q == NULL) {
         log_message(LOG_ERR, "%s: Не удалось создать мьютекс", TAG);
         return AUC_ERR_INIT;
     }
     
-    /* Очистка состояния */
-    memset(&auc_state, 0, sizeof(auc_state));
-    auc_state.baudrate = AUC_UART_BAUDRATE;
-    auc_state.current_module = 0xFF;  /* Никакой не выбран */
+    for (int i = 0; i < AUC_MAX_INFLIGHT; i++) {
+        memset(&reqs[i], 0, sizeof(reqs[i]));
+        reqs[i].done = xSemaphoreCreateBinary();
+        if (reqs[i].done == NULL) {
+            log_message(LOG_ERR, "%s: Не удалось создать семафор запроса", TAG);
+            return AUC_ERR_INIT;
+        }
+    }
+    
+#if MOCK_ASIC
+    mock_auc_init();
+#else
+    uart = io_open(AUC_UART_DEVICE_PATH);
+    gpio = io_open("/dev/gpio0");
+    if (!uart || !gpio) {
+        log_message(LOG_ERR, "%s: Не удалось открыть %s", TAG, AUC_UART_DEVICE_PATH);
+        return AUC_ERR_INIT;
+    }
+    
+    uart_config(uart, AUC_UART_BAUDRATE_HIGH, 8, UART_STOP_1, UART_PARITY_NONE);
+    uart_set_read_timeout(uart, AUC_RX_POLL_MS);
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        fpioa_set_function(AUC_MODULE_SEL_PIN + i, FUNC_GPIOHS0 + AUC_MODULE_SEL_BASE + i);
+        gpio_set_drive_mode(gpio, AUC_MODULE_SEL_BASE + i, GPIO_DM_OUTPUT);
+        gpio_set_pin_value(gpio, AUC_MODULE_SEL_BASE + i, GPIO_PV_LOW);
+    }
+#endif
+    
     auc_state.initialized = true;
     
-    log_message(LOG_INFO, "%s: AUC инициализирован (stub mode)", TAG);
+    if (cores_task_create(auc_rx_task, "auc_rx", AUC_RX_TASK_STACK, NULL,
+                          TASK_PRIO_AUC_RX, CORE_MINING, &rx_task) != 0) {
+        auc_state.initialized = false;
+        return AUC_ERR_INIT;
+    }
+    
+    log_message(LOG_INFO, "%s: AUC инициализирован (%u бод, %d запросов в полёте)",
+               TAG, (unsigned)auc_state.baudrate, AUC_MAX_INFLIGHT);
     
     return AUC_OK;
 }
@@ -73,13 +565,32 @@ void auc_deinit(void)
         return;
     }
     
+    /* Задача auc_rx завершается сама после следующего таймаута чтения */
+    auc_state.initialized = false;
+    while (rx_task) {
+        vTaskDelay(pdMS_TO_TICKS(AUC_RX_POLL_MS));
+    }
+    
+#if !MOCK_ASIC
+    io_close(uart);
+    io_close(gpio);
+    uart = 0;
+    gpio = 0;
+#endif
+    
+    for (int i = 0; i < AUC_MAX_INFLIGHT; i++) {
+        vSemaphoreDelete(reqs[i].done);
+        reqs[i].done = NULL;
+    }
+    vQueueDelete(rx_q);
+    rx_q = NULL;
+    
     /* Удаляем мьютекс */
     if (auc_mutex) {
         vSemaphoreDelete(auc_mutex);
         auc_mutex = NULL;
     }
     
-    auc_state.initialized = false;
     log_message(LOG_INFO, "%s: AUC деинициализирован", TAG);
 }
 
@@ -89,8 +600,24 @@ int auc_set_baudrate(uint32_t baudrate)
         return AUC_ERR_INIT;
     }
     
+    /* Смена скорости посреди кадра испортит его - ждём конца обменов */
+    for (;;) {
+        xSemaphoreTake(auc_mutex, portMAX_DELAY);
+        if (auc_state.inflight == 0) {
+            break;
+        }
+        xSemaphoreGive(auc_mutex);
+        vTaskDelay(1);
+    }
+    
+#if !MOCK_ASIC
+    uart_config(uart, baudrate, 8, UART_STOP_1, UART_PARITY_NONE);
+#endif
     auc_state.baudrate = baudrate;
-    log_message(LOG_INFO, "%s: Baudrate установлен %u (stub)", TAG, (unsigned)baudrate);
+    
+    xSemaphoreGive(auc_mutex);
+    
+    log_message(LOG_INFO, "%s: Baudrate установлен %u", TAG, (unsigned)baudrate);
     
     return AUC_OK;
 }
@@ -109,7 +636,10 @@ int auc_select_module(int module_id)
         return AUC_ERR_INVALID_PKG;
     }
     
-    auc_state.current_module = module_id;
+    if (link_acquire(module_id, 0) != AUC_OK) {
+        return AUC_ERR_BUSY;
+    }
+    xSemaphoreGive(auc_mutex);
     
     return AUC_OK;
 }
@@ -136,25 +666,35 @@ int auc_reset_all(void)
 
 /* ===========================================================================
  * ФУНКЦИИ ПЕРЕДАЧИ ДАННЫХ
- * 
- * NOTE: Заготовка - реальная передача через avalon10.c (SPI)
  * =========================================================================== */
 
 int auc_send_pkg(int module_id, const avalon10_pkg_t *pkg)
 {
+    int ret;
+    
     if (!auc_state.initialized) {
         return AUC_ERR_INIT;
     }
     
-    if (!pkg) {
+    if (!pkg || module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
         return AUC_ERR_INVALID_PKG;
     }
     
-    (void)module_id;  /* Подавление warning о неиспользуемой переменной */
+    ret = link_acquire(module_id, 0);
+    if (ret != AUC_OK) {
+        return ret;
+    }
+    
+    if (link_write((const uint8_t *)pkg, AVALON10_PKG_SIZE) < 0) {
+        ret = AUC_ERR_NO_RESPONSE;
+    } else {
+        auc_state.tx_packets++;
+        auc_state.tx_bytes += AVALON10_PKG_SIZE;
+    }
     
-    auc_state.tx_packets++;
+    xSemaphoreGive(auc_mutex);
     
-    return AUC_OK;
+    return ret;
 }
 
 int auc_recv_pkg(int module_id, avalon10_pkg_t *pkg, int timeout)
@@ -167,30 +707,161 @@ int auc_recv_pkg(int module_id, avalon10_pkg_t *pkg, int timeout)
         return AUC_ERR_INVALID_PKG;
     }
     
-    (void)module_id;
-    (void)timeout;
+    (void)module_id;    /* Ответ может прийти только от выбранного модуля */
     
-    /* В stub режиме возвращаем таймаут */
-    auc_state.timeouts++;
+    if (xQueueReceive(rx_q, pkg, pdMS_TO_TICKS(timeout)) != pdTRUE) {
+        auc_state.timeouts++;
+        return AUC_ERR_TIMEOUT;
+    }
     
-    return AUC_ERR_TIMEOUT;
+    return AUC_OK;
 }
 
-int auc_transaction(int module_id, const avalon10_pkg_t *tx_pkg, 
+int auc_submit(int module_id, const avalon10_pkg_t *pkg, int *req)
+{
+    return auc_submit_batch(module_id, pkg, 1, req);
+}
+
+int auc_submit_batch(int module_id, const avalon10_pkg_t *pkgs, int n, int *reqs_out)
+{
+    if (!auc_state.initialized) {
+        return AUC_ERR_INIT;
+    }
+    
+    if (!pkgs || !reqs_out || n <= 0 || n > AUC_MAX_INFLIGHT ||
+        module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return AUC_ERR_INVALID_PKG;
+    }
+    
+    return submit_batch(module_id, pkgs, n, reqs_out);
+}
+
+int auc_complete(int req, avalon10_pkg_t *rx_pkg, int timeout)
+{
+    auc_req_t *r;
+    
+    if (req < 0 || req >= AUC_MAX_INFLIGHT) {
+        return AUC_ERR_INVALID_PKG;
+    }
+    r = &reqs[req];
+    
+    for (;;) {
+        BaseType_t signalled = xSemaphoreTake(r->done, pdMS_TO_TICKS(timeout));
+        int lost;
+    
+        xSemaphoreTake(auc_mutex, portMAX_DELAY);
+    
+        if (r->state == AUC_REQ_DONE) {
+            uint32_t rtt = (uint32_t)(cgminer_time_us() - r->t_tx);
+    
+            if (rx_pkg) {
+                *rx_pkg = r->rx;
+            }
+            auc_state.rtt_us_last = rtt;
+            if (rtt > auc_state.rtt_us_max) {
+                auc_state.rtt_us_max = rtt;
+            }
+            req_release(r);
+            xSemaphoreGive(auc_mutex);
+            return AUC_OK;
+        }
+    
+        if (signalled && r->state == AUC_REQ_PENDING) {
+            /* Запоздалый сигнал предыдущей попытки */
+            xSemaphoreGive(auc_mutex);
+            continue;
+        }
+    
+        lost = (r->state == AUC_REQ_LOST);
+        if (!lost) {
+            auc_state.timeouts++;
+        }
+    
+        if (r->retries >= AUC_MAX_RETRIES) {
+            req_release(r);
+            xSemaphoreGive(auc_mutex);
+            return lost ? AUC_ERR_NO_RESPONSE : AUC_ERR_TIMEOUT;
+        }
+    
+        /* Повтор: прежние попытки остаются в журнале (см. rx_deliver) */
+        r->retries++;
+        auc_state.retries++;
+        req_arm(r);
+        if (link_write((const uint8_t *)&r->tx, AVALON10_PKG_SIZE) == 0) {
+            auc_state.tx_packets++;
+            auc_state.tx_bytes += AVALON10_PKG_SIZE;
+        }
+    
+        xSemaphoreGive(auc_mutex);
+    }
+}
+
+int auc_transaction(int module_id, const avalon10_pkg_t *tx_pkg,
                     avalon10_pkg_t *rx_pkg, int timeout)
 {
+    int req;
     int ret;
     
-    ret = auc_send_pkg(module_id, tx_pkg);
+    if (rx_pkg == NULL) {
+        return auc_send_pkg(module_id, tx_pkg);
+    }
+    
+    ret = auc_submit(module_id, tx_pkg, &req);
     if (ret != AUC_OK) {
         return ret;
     }
     
-    if (rx_pkg == NULL) {
-        return AUC_OK;
+    return auc_complete(req, rx_pkg, timeout);
+}
+
+int auc_transaction_batch(int module_id, const avalon10_pkg_t *tx_pkgs,
+                          avalon10_pkg_t *rx_pkgs, int n, int timeout)
+{
+    int ids[AUC_MAX_INFLIGHT];
+    int ok = 0;
+    int ret;
+    
+    ret = auc_submit_batch(module_id, tx_pkgs, n, ids);
+    if (ret != AUC_OK) {
+        return ret;
     }
     
-    return auc_recv_pkg(module_id, rx_pkg, timeout);
+    /* Ответы приходят по порядку: пока ждём первый, остальные уже в пути */
+    for (int i = 0; i < n; i++) {
+        if (auc_complete(ids[i], rx_pkgs ? &rx_pkgs[i] : NULL, timeout) == AUC_OK) {
+            ok++;
+        }
+    }
+    
+    return ok;
+}
+
+int auc_loopback_test(int module_id, int rounds)
+{
+    avalon10_pkg_t tx[AUC_MAX_INFLIGHT];
+    avalon10_pkg_t rx[AUC_MAX_INFLIGHT];
+    uint64_t t0 = cgminer_time_us();
+    uint64_t us;
+    int ok = 0;
+    
+    for (int i = 0; i < AUC_MAX_INFLIGHT; i++) {
+        avalon10_pkg_request(&tx[i], AVALON10_P_STATUS);
+    }
+    
+    for (int r = 0; r < rounds; r++) {
+        int n = auc_transaction_batch(module_id, tx, rx, AUC_MAX_INFLIGHT,
+                                      AUC_DEFAULT_TIMEOUT);
+    
+        if (n > 0) {
+            ok += n;
+        }
+    }
+    
+    us = cgminer_time_us() - t0;
+    log_message(LOG_INFO, "%s: Проверка канала модуля %d: %d/%d ответов за %llu мкс",
+               TAG, module_id, ok, rounds * AUC_MAX_INFLIGHT, (unsigned long long)us);
+    
+    return ok;
 }
 
 /* ===========================================================================
@@ -213,6 +884,14 @@ void auc_reset_stats(void)
     auc_state.crc_errors = 0;
     auc_state.timeouts = 0;
     auc_state.retries = 0;
+    auc_state.lost = 0;
+    auc_state.unmatched = 0;
+    auc_state.resync_bytes = 0;
+    auc_state.tx_bytes = 0;
+    auc_state.rx_bytes = 0;
+    auc_state.inflight_max = auc_state.inflight;
+    auc_state.rtt_us_last = 0;
+    auc_state.rtt_us_max = 0;
     
     if (auc_mutex) {
         xSemaphoreGive(auc_mutex);
@@ -229,6 +908,6 @@ bool auc_module_ready(int module_id)
         return false;
     }
     
-    /* В stub режиме всегда возвращаем true */
+    /* Отдельной линии готовности у модуля нет */
     return true;
 }
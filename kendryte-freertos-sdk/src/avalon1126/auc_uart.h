@@ -11,10 +11,26 @@
  * Реализует протокол Avalon AUC для передачи пакетов.
  * 
  * ПРОТОКОЛ AUC:
- * - Baudrate: 115200 (можно изменить до 3M)
+ * - Baudrate: 3M (AUC_UART_BAUDRATE_HIGH), 115200 - запасная скорость
  * - Формат: 8N1
  * - Пакеты: 40 байт (head[2] + type + opt + idx + cnt + data[32] + crc[2])
  * 
+ * ТРАНСПОРТ:
+ * - Передача: пакеты нескольких запросов собираются в tx_buffer и уходят
+ *   одной записью в UART; драйвер SDK передаёт её по DMA.
+ * - Приём: драйвер SDK складывает байты в кольцевой буфер из прерывания
+ *   (аппаратный FIFO + таймаут символа). Задача auc_rx собирает кадры
+ *   в rx_buffer: ищет заголовок 'CN', проверяет CRC16, при ошибке сдвигается
+ *   на байт и ищет заголовок заново (ресинхронизация).
+ * - Конвейер: до AUC_MAX_INFLIGHT запросов в полёте. Каждая передача
+ *   (первая и повторы) записывается в журнал; модуль отвечает в порядке
+ *   передач, поэтому ответ сопоставляется самой старой передаче того же
+ *   типа, а более старые передачи без ответа считаются потерянными и
+ *   повторяются (до AUC_MAX_RETRIES раз). Ответ на прежнюю попытку
+ *   завершает запрос, ответ на лишнюю попытку отбрасывается (stale).
+ * - При MOCK_ASIC вместо UART1 используется петля mock_auc_* с эмулятором
+ *   модулей, вносящая шум в поток байт.
+ * 
  * АППАРАТНОЕ ПОДКЛЮЧЕНИЕ (K210):
  * - UART1: основной канал к ASIC (GPIO 4/5)
  * - UART2: резервный/debug (GPIO 6/7)
@@ -39,6 +55,11 @@
  */
 #define AUC_UART_NUM            1
 
+/**
+ * @brief Устройство UART в SDK
+ */
+#define AUC_UART_DEVICE_PATH    "/dev/uart1"
+
 /**
  * @brief Скорость UART по умолчанию (115200 baud)
  */
@@ -69,6 +90,23 @@
  */
 #define AUC_MAX_RETRIES         3
 
+/**
+ * @brief Максимум запросов в полёте
+ */
+#define AUC_MAX_INFLIGHT        4
+
+/**
+ * @brief Таймаут чтения UART задачей приёма (мс)
+ */
+#define AUC_RX_POLL_MS          10
+
+/**
+ * @brief Глубина очереди пакетов без запроса (для auc_recv_pkg)
+ */
+#define AUC_RX_QUEUE_LEN        4
+
+#define AUC_RX_TASK_STACK       2048
+
 /* ---------------------------------------------------------------------------
  * GPIO пины для управления модулями
  * --------------------------------------------------------------------------- */
@@ -99,6 +137,7 @@
 #define AUC_ERR_INVALID_PKG     -3
 #define AUC_ERR_NO_RESPONSE     -4
 #define AUC_ERR_INIT            -5
+#define AUC_ERR_BUSY            -6
 
 /* ===========================================================================
  * СТРУКТУРЫ ДАННЫХ
@@ -118,12 +157,22 @@ typedef struct {
     uint32_t crc_errors;        /**< Ошибки CRC */
     uint32_t timeouts;          /**< Таймауты */
     uint32_t retries;           /**< Повторные передачи */
+    uint32_t lost;              /**< Запросы, обойдённые ответом на более поздний */
+    uint32_t unmatched;         /**< Ответы без ожидающего запроса */
+    uint32_t stale;             /**< Отброшенные ответы на завершённые запросы */
+    uint32_t resync_bytes;      /**< Байты, пропущенные при поиске заголовка */
+    uint64_t tx_bytes;          /**< Передано байт */
+    uint64_t rx_bytes;          /**< Принято байт */
+    uint32_t inflight;          /**< Запросов в полёте */
+    uint32_t inflight_max;      /**< Максимум запросов в полёте */
+    uint32_t rtt_us_last;       /**< Время запрос-ответ последней транзакции */
+    uint32_t rtt_us_max;        /**< Максимальное время запрос-ответ */
     
     /* Буферы */
-    uint8_t rx_buffer[AUC_RX_BUFFER_SIZE];
-    uint8_t tx_buffer[AUC_TX_BUFFER_SIZE];
-    volatile int rx_head;
-    volatile int rx_tail;
+    uint8_t rx_buffer[AUC_RX_BUFFER_SIZE];  /**< Сборка кадров приёма */
+    uint8_t tx_buffer[AUC_TX_BUFFER_SIZE];  /**< Пакеты одной записи в UART */
+    volatile int rx_head;       /**< Начало несобранных данных в rx_buffer */
+    volatile int rx_tail;       /**< Конец данных в rx_buffer */
 } auc_state_t;
 
 /* ===========================================================================
@@ -161,7 +210,10 @@ int auc_set_baudrate(uint32_t baudrate);
 int auc_select_module(int module_id);
 
 /**
- * @brief Отправка пакета через AUC
+ * @brief Отправка пакета через AUC без ожидания ответа
+ * 
+ * Ответ на такой пакет (если модуль его пришлёт) попадает в очередь
+ * пакетов без запроса и читается auc_recv_pkg().
  * 
  * @param module_id ID модуля (0-3)
  * @param pkg       Указатель на пакет для отправки
@@ -170,7 +222,7 @@ int auc_select_module(int module_id);
 int auc_send_pkg(int module_id, const avalon10_pkg_t *pkg);
 
 /**
- * @brief Приём пакета через AUC
+ * @brief Приём пакета, не сопоставленного ни одному запросу
  * 
  * @param module_id ID модуля (0-3)
  * @param pkg       Указатель для записи принятого пакета
@@ -228,4 +280,68 @@ bool auc_module_ready(int module_id);
 int auc_transaction(int module_id, const avalon10_pkg_t *tx_pkg, 
                     avalon10_pkg_t *rx_pkg, int timeout);
 
+/**
+ * @brief Отправка запроса без ожидания ответа (конвейер)
+ * 
+ * @param module_id ID модуля (0-3)
+ * @param pkg       Запрос
+ * @param req       Дескриптор запроса для auc_complete()
+ * @return AUC_OK, AUC_ERR_BUSY если заняты все AUC_MAX_INFLIGHT слотов
+ */
+int auc_submit(int module_id, const avalon10_pkg_t *pkg, int *req);
+
+/**
+ * @brief Отправка нескольких запросов одной записью без ожидания ответов
+ * 
+ * @param module_id ID модуля (0-3)
+ * @param pkgs      Запросы
+ * @param n         Количество (до AUC_MAX_INFLIGHT)
+ * @param reqs      Дескрипторы запросов для auc_complete(), n штук
+ * @return AUC_OK, AUC_ERR_BUSY если нет n свободных слотов
+ */
+int auc_submit_batch(int module_id, const avalon10_pkg_t *pkgs, int n, int *reqs);
+
+/**
+ * @brief Ожидание ответа на запрос с повторами
+ * 
+ * Если ответ не пришёл за timeout мс или модуль ответил на более поздний
+ * запрос, запрос передаётся повторно (до AUC_MAX_RETRIES раз).
+ * Освобождает слот запроса в любом случае.
+ * 
+ * @param req       Дескриптор из auc_submit()
+ * @param rx_pkg    Буфер для ответа (может быть NULL)
+ * @param timeout   Таймаут одной попытки в мс
+ * @return AUC_OK при успехе, код ошибки при неудаче
+ */
+int auc_complete(int req, avalon10_pkg_t *rx_pkg, int timeout);
+
+/**
+ * @brief Пакет транзакций одной записью в UART
+ * 
+ * Запросы (не более AUC_MAX_INFLIGHT) уходят подряд без ожидания
+ * ответов, затем ответы собираются по порядку.
+ * 
+ * @param module_id ID модуля
+ * @param tx_pkgs   Запросы
+ * @param rx_pkgs   Ответы (может быть NULL)
+ * @param n         Количество запросов
+ * @param timeout   Таймаут одной попытки в мс
+ * @return Количество успешных транзакций, код ошибки при неудаче
+ */
+int auc_transaction_batch(int module_id, const avalon10_pkg_t *tx_pkgs,
+                          avalon10_pkg_t *rx_pkgs, int n, int timeout);
+
+/**
+ * @brief Проверка канала: серия пакетов STATUS
+ * 
+ * Ответ сопоставляется запросу по типу, поэтому с перемычкой TX-RX
+ * вместо модуля каждый запрос возвращается своим же ответом: так
+ * проверяются передача по DMA и приём по прерыванию без модуля.
+ * 
+ * @param module_id ID модуля
+ * @param rounds    Количество пакетов по AUC_MAX_INFLIGHT запросов
+ * @return Количество успешных транзакций
+ */
+int auc_loopback_test(int module_id, int rounds);
+
 #endif /* __AUC_UART_H__ */
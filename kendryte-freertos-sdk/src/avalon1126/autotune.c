@@ -0,0 +1,285 @@
+/**
+ * =============================================================================
+ * @file    autotune.c
+ * @brief   Avalon A1126pro - Автонастройка частоты чипов (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Подбор частоты каждого чипа по доле HW ошибок. Счётчики nonce и
+ * ошибок ведёт validator (avalon10_chip_account), здесь только окна
+ * оценки и шаги частоты.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include "autotune.h"
+#include "throttle.h"
+#include "yieldmon.h"
+#include "cgminer.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Autotune";
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static autotune_chip_t tune[AVALON10_DEFAULT_MODULARS][AVALON10_DEFAULT_MINER_CNT];
+static autotune_stats_t stats;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Начало нового окна оценки
+ */
+static void window_start(autotune_chip_t *at, const avalon10_chip_t *chip, uint32_t now)
+{
+    cgminer_window_start(&at->win, now, chip->nonces, chip->hw_errors);
+}
+
+/**
+ * @brief Смена частоты чипа
+ */
+static void chip_set(avalon10_info_t *info, int m, int c, int freq, uint32_t now)
+{
+    if (avalon10_set_chip_freq(info, m, c, freq) == 0) {
+        stats.changed_at = now;
+    }
+}
+
+/**
+ * @brief Шаг подбора одного чипа
+ */
+static void chip_step(avalon10_info_t *info, int m, int c, uint32_t now)
+{
+    avalon10_chip_t *chip = &info->modules[m].chips[c];
+    autotune_chip_t *at = &tune[m][c];
+    int fmin = info->default_freq[0];
+    int fmax = info->default_freq[1];
+    uint32_t nonces, hw, rate;
+    int burst, limit;
+    
+    if (!cgminer_window_check(&at->win, now, chip->nonces, chip->hw_errors)) {
+        return;
+    }
+    
+    /* Потолок истёк: частоту выше снова можно пробовать */
+    if (at->ceiling) {
+        int shift = at->backoffs ? MIN(at->backoffs - 1, AUTOTUNE_CEILING_MAX_SHIFT) : 0;
+        uint32_t hold = (uint32_t)AUTOTUNE_CEILING_HOLD_S << shift;
+    
+        if (now - at->ceiling_at >= hold) {
+            at->ceiling = 0;
+            at->state = AUTOTUNE_CHIP_PROBE;
+        }
+    }
+    
+    /* Недобор nonce без HW ошибок на этой частоте (yieldmon) - как превышение бюджета */
+    limit = yieldmon_freq_limit(m, c);
+    if (limit && chip->freq >= limit) {
+        at->clean = 0;
+        at->ceiling = limit;
+        at->ceiling_at = now;
+        if (at->backoffs < 0xFF) {
+            at->backoffs++;
+        }
+        if (limit - AVALON10_FREQ_STEP >= fmin) {
+            chip_set(info, m, c, limit - AVALON10_FREQ_STEP, now);
+            stats.steps_down++;
+        }
+        at->state = AUTOTUNE_CHIP_SETTLED;
+        window_start(at, chip, now);
+        return;
+    }
+    
+    nonces = chip->nonces - (uint32_t)at->win.count0;
+    hw = chip->hw_errors - at->win.hw0;
+    burst = chip->error_count >= AUTOTUNE_BURST_ERRORS;
+    
+    if (!burst && nonces < AUTOTUNE_WINDOW_NONCES) {
+        /* Чип почти не находит nonce - это не вопрос частоты */
+        if (now - at->win.at >= AUTOTUNE_WINDOW_MAX_S) {
+            window_start(at, chip, now);
+        }
+        return;
+    }
+    
+    rate = nonces ? hw * 1000 / nonces : 1000;
+    
+    if (burst || rate > stats.budget) {
+        /* Бюджет превышен: шаг вниз, эта частота - потолок */
+        at->clean = 0;
+        if (chip->freq - AVALON10_FREQ_STEP >= fmin) {
+            at->ceiling = chip->freq;
+            at->ceiling_at = now;
+            if (at->backoffs < 0xFF) {
+                at->backoffs++;
+            }
+            chip_set(info, m, c, chip->freq - AVALON10_FREQ_STEP, now);
+            stats.steps_down++;
+        }
+        at->state = AUTOTUNE_CHIP_SETTLED;
+    } else if (rate * 2 <= stats.budget) {
+        /* Чисто: после нескольких окон подряд - шаг вверх */
+        int next = chip->freq + AVALON10_FREQ_STEP;
+    
+        if (next > fmax || (at->ceiling && next >= at->ceiling)) {
+            at->state = AUTOTUNE_CHIP_SETTLED;
+        } else if (++at->clean >= AUTOTUNE_CLEAN_WINDOWS) {
+            at->clean = 0;
+            at->state = AUTOTUNE_CHIP_PROBE;
+            chip_set(info, m, c, next, now);
+            stats.steps_up++;
+        }
+    } else {
+        /* В пределах бюджета, но не чисто - частоту не трогаем */
+        at->clean = 0;
+        at->state = AUTOTUNE_CHIP_SETTLED;
+    }
+    
+    window_start(at, chip, now);
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг автонастройки
+ */
+void autotune_poll(avalon10_info_t *info)
+{
+    uint32_t now = cgminer_time_s();
+    int budget = g_config.autotune_hw_budget;
+    int probing = 0, settled = 0;
+    
+    if (!info || !info->initialized) {
+        return;
+    }
+    
+    if (budget <= 0 || budget > 500) {
+        budget = AUTOTUNE_HW_BUDGET_DEFAULT;
+    }
+    stats.budget = budget;
+    stats.enabled = g_config.autotune != 0;
+    
+    if (!stats.enabled) {
+        return;
+    }
+    
+    /* Частотами при перегреве управляет avalon10_check_overheat() */
+    if (!info->mining_enabled || info->overheat) {
+        if (!stats.paused) {
+            log_message(LOG_INFO, "%s: Пауза", TAG);
+        }
+        stats.paused = 1;
+        return;
+    }
+    
+    /* После паузы окна начинаются заново - ошибки перегрева не в счёт */
+    if (stats.paused) {
+        stats.paused = 0;
+        for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+            for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+                tune[m][c].win.at = 0;
+            }
+        }
+    }
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        if (info->modules[m].state != AVALON10_MODULE_STATE_MINING) {
+            continue;
+        }
+    
+        /* Частоты снижены по температуре - окна после снятия заново */
+        if (throttle_active(m)) {
+            for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+                tune[m][c].win.at = 0;
+            }
+            continue;
+        }
+    
+        for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            if (!info->modules[m].chips[c].enabled) {
+                continue;
+            }
+    
+            chip_step(info, m, c, now);
+    
+            if (tune[m][c].state == AUTOTUNE_CHIP_SETTLED) {
+                settled++;
+            } else {
+                probing++;
+            }
+        }
+    }
+    
+    stats.probing = probing;
+    stats.settled = settled;
+}
+
+/**
+ * @brief Сброс состояния подбора
+ */
+void autotune_reset(int module_id)
+{
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        if (module_id >= 0 && m != module_id) {
+            continue;
+        }
+        memset(tune[m], 0, sizeof(tune[m]));
+    }
+    
+    log_message(LOG_INFO, "%s: Сброс подбора (модуль %d)", TAG, module_id);
+}
+
+/**
+ * @brief Сброс подбора одного чипа
+ */
+void autotune_reset_chip(int module_id, int chip_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        chip_id < 0 || chip_id >= AVALON10_DEFAULT_MINER_CNT) {
+        return;
+    }
+    
+    memset(&tune[module_id][chip_id], 0, sizeof(tune[module_id][chip_id]));
+}
+
+/**
+ * @brief Состояние подбора чипа
+ */
+const autotune_chip_t *autotune_get_chip(int module_id, int chip_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        chip_id < 0 || chip_id >= AVALON10_DEFAULT_MINER_CNT) {
+        return NULL;
+    }
+    
+    return &tune[module_id][chip_id];
+}
+
+/**
+ * @brief Состояние автонастройки
+ */
+const autotune_stats_t *autotune_get_stats(void)
+{
+    return &stats;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА autotune.c
+ * =========================================================================== */
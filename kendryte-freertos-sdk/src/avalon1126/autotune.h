@@ -0,0 +1,157 @@
+/**
+ * =============================================================================
+ * @file    autotune.h
+ * @brief   Avalon A1126pro - Автонастройка частоты чипов (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Фоновый подбор частоты каждого чипа в диапазоне
+ * info->default_freq[0..1] под заданный бюджет HW ошибок. Чипы одного
+ * модуля сильно различаются: общая частота упирается в самый слабый чип,
+ * а отдельная частота позволяет каждому работать на своём пределе.
+ * 
+ * АЛГОРИТМ (для каждого чипа):
+ * - Окно оценки - AUTOTUNE_WINDOW_NONCES проверенных nonce.
+ * - Доля HW ошибок выше бюджета - частота на шаг вниз, прежняя частота
+ *   запоминается как потолок.
+ * - Доля не выше половины бюджета AUTOTUNE_CLEAN_WINDOWS окон подряд -
+ *   шаг вверх, но не до потолка.
+ * - Между половиной бюджета и бюджетом - частота не меняется
+ *   (гистерезис).
+ * - Потолок снимается через AUTOTUNE_CEILING_HOLD_S и каждое повторное
+ *   снижение удваивает это время: при смене температуры чип может
+ *   попробовать частоту выше, но не колеблется между двумя соседними.
+ * - Чип с недобором nonce без HW ошибок (yieldmon_freq_limit) снижается
+ *   на шаг ниже частоты недобора, она становится потолком.
+ * 
+ * Перегрев и остановка майнинга приостанавливают подбор. Результат
+ * (частоты чипов) сохраняет во flash tune_store.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __AUTOTUNE_H__
+#define __AUTOTUNE_H__
+
+#include <stdint.h>
+
+#include "avalon10.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Бюджет HW ошибок по умолчанию (‰ от проверенных nonce)
+ */
+#define AUTOTUNE_HW_BUDGET_DEFAULT  10
+
+/**
+ * @brief Проверенных nonce в окне оценки (~8 с на чип)
+ */
+#define AUTOTUNE_WINDOW_NONCES      256
+
+/**
+ * @brief Окно без достаточного числа nonce начинается заново (секунды)
+ */
+#define AUTOTUNE_WINDOW_MAX_S       300
+
+/**
+ * @brief Чистых окон подряд перед шагом вверх
+ */
+#define AUTOTUNE_CLEAN_WINDOWS      2
+
+/**
+ * @brief HW ошибок подряд - снижение, не дожидаясь конца окна
+ */
+#define AUTOTUNE_BURST_ERRORS       8
+
+/**
+ * @brief Время жизни потолка частоты (секунды)
+ */
+#define AUTOTUNE_CEILING_HOLD_S     3600
+
+/**
+ * @brief Предел удвоений времени жизни потолка (до 8 ч)
+ */
+#define AUTOTUNE_CEILING_MAX_SHIFT  3
+
+/**
+ * @brief Состояния чипа
+ */
+#define AUTOTUNE_CHIP_PROBE         0   /* Подъём частоты */
+#define AUTOTUNE_CHIP_SETTLED       1   /* Частота найдена */
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct autotune_chip_t
+ * @brief Состояние подбора частоты чипа
+ */
+typedef struct autotune_chip {
+    uint8_t state;                  /* AUTOTUNE_CHIP_* */
+    uint8_t clean;                  /* Чистых окон подряд */
+    uint8_t backoffs;               /* Снижений частоты (до 255) */
+    uint16_t ceiling;               /* Частота, превысившая бюджет (0 = нет) */
+    uint32_t ceiling_at;            /* Когда установлен потолок (с) */
+    cgminer_window_t win;           /* Окно chip->nonces / chip->hw_errors */
+} autotune_chip_t;
+
+/**
+ * @struct autotune_stats_t
+ * @brief Состояние автонастройки (для API)
+ */
+typedef struct autotune_stats {
+    uint8_t enabled;                /* 1 = подбор идёт */
+    uint8_t paused;                 /* 1 = пауза (перегрев, нет майнинга) */
+    uint16_t budget;                /* Бюджет HW ошибок (‰) */
+    uint16_t probing;               /* Чипов в подъёме */
+    uint16_t settled;               /* Чипов с найденной частотой */
+    uint32_t steps_up;              /* Шагов вверх */
+    uint32_t steps_down;            /* Шагов вниз */
+    uint32_t changed_at;            /* uptime последнего изменения (с) */
+} autotune_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг автонастройки (раз в секунду, задача monitor)
+ * 
+ * @param info      Указатель на структуру информации
+ */
+void autotune_poll(avalon10_info_t *info);
+
+/**
+ * @brief Сброс состояния подбора (все чипы снова в подъёме)
+ * 
+ * @param module_id ID модуля (-1 = все)
+ */
+void autotune_reset(int module_id);
+
+/**
+ * @brief Сброс подбора одного чипа (чип снова включён после выключения)
+ */
+void autotune_reset_chip(int module_id, int chip_id);
+
+/**
+ * @brief Состояние подбора чипа
+ * @return          NULL при неверных номерах
+ */
+const autotune_chip_t *autotune_get_chip(int module_id, int chip_id);
+
+/**
+ * @brief Состояние автонастройки
+ */
+const autotune_stats_t *autotune_get_stats(void);
+
+#endif /* __AUTOTUNE_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА autotune.h
+ * =========================================================================== */
@@ -17,7 +17,8 @@
  * - FUN_ram_80004f14 @ 0x80004f14 - avalon10_parse_pkg (парсинг пакетов)
  * 
  * ПРОТОКОЛ СВЯЗИ:
- * Связь с ASIC осуществляется через SPI интерфейс.
+ * Связь с ASIC - через транспорт модуля (asic_xport.c): SPI, AUC UART,
+ * эмулятор или трасса. Транспорт выбирается для каждого модуля.
  * Формат пакета: [MAGIC:2][TYPE:1][LEN:1][DATA:N][CRC32:4]
  * 
  * =============================================================================
@@ -30,24 +31,25 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include <FreeRTOS.h>
 #include <task.h>
+#include <semphr.h>
+#include <devices.h>
 
 #include "avalon10.h"
 #include "cgminer.h"
 #include "pool.h"
 #include "work.h"
 #include "stratum.h"
+#include "validator.h"
+#include "hasher.h"
 #include "mock_hardware.h"
-
-/* SDK заголовки для SPI */
-#ifndef MOCK_ASIC
-#include <spi.h>
-#include <fpioa.h>
-#include <gpiohs.h>
-#include <pwm.h>
-#endif
+#include "asic_xport.h"
+#include "tune_store.h"
+#include "fan.h"
+#include "throttle.h"
 
 /* ===========================================================================
  * ЛОКАЛЬНЫЕ КОНСТАНТЫ
@@ -73,111 +75,42 @@ static const char *state_strings[] = {
 };
 
 /* ===========================================================================
- * КОНФИГУРАЦИЯ SPI ДЛЯ ASIC
+ * КОНФИГУРАЦИЯ ПЕРИФЕРИИ
+ * SPI0, UART1 и линии выбора модулей настраивают транспорты (asic_xport.c),
+ * ШИМ и тахометры вентиляторов - fan.c
  * =========================================================================== */
 
-#ifndef MOCK_ASIC
-/* SPI устройство для ASIC */
-#define ASIC_SPI_DEVICE     SPI_DEVICE_0
-#define ASIC_SPI_CLK_RATE   10000000   /* 10 MHz */
-
-/* GPIO для выбора модулей (CS lines) */
-#define ASIC_CS_PIN_BASE    20  /* GPIO20-23 для 4 модулей */
-
-/* PWM для вентиляторов */
-#define FAN_PWM_DEVICE      PWM_DEVICE_0
-#define FAN_PWM_CHANNEL_0   PWM_CHANNEL_0
-#define FAN_PWM_CHANNEL_1   PWM_CHANNEL_1
-#define FAN_PWM_FREQ        25000   /* 25 kHz */
-#endif
-
 /* ===========================================================================
  * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
  * =========================================================================== */
 
 /**
- * @brief Буфер для отправки пакетов (40 байт = размер avalon10_pkg_t)
+ * @brief Аппаратный таймер опроса и задача, которую он будит
  */
-static uint8_t tx_buffer[AVALON10_PKT_TOTAL_LEN];
-
-/**
- * @brief Буфер для приёма пакетов
- */
-static uint8_t rx_buffer[AVALON10_PKT_TOTAL_LEN];
-
-/* ===========================================================================
- * НИЗКОУРОВНЕВЫЕ SPI ФУНКЦИИ
- * =========================================================================== */
-
-#ifndef MOCK_ASIC
-/**
- * @brief Флаг инициализации SPI (только для реального железа)
- */
-static int spi_initialized = 0;
-/**
- * @brief Инициализация SPI для связи с ASIC
- */
-static int asic_spi_init(void)
-{
-    if (spi_initialized) return 0;
-    
-    /* Настройка FPIOA для SPI */
-    fpioa_set_function(ASIC_SPI_CLK_PIN, FUNC_SPI0_SCLK);
-    fpioa_set_function(ASIC_SPI_MOSI_PIN, FUNC_SPI0_D0);
-    fpioa_set_function(ASIC_SPI_MISO_PIN, FUNC_SPI0_D1);
-    
-    /* Настройка GPIO для CS */
-    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
-        gpiohs_set_drive_mode(ASIC_CS_PIN_BASE + i, GPIO_DM_OUTPUT);
-        gpiohs_set_pin(ASIC_CS_PIN_BASE + i, GPIO_PV_HIGH);  /* CS high (deselect) */
-    }
-    
-    /* Инициализация SPI */
-    spi_init(ASIC_SPI_DEVICE, SPI_WORK_MODE_0, SPI_FF_STANDARD, 8, 0);
-    spi_set_clk_rate(ASIC_SPI_DEVICE, ASIC_SPI_CLK_RATE);
-    
-    spi_initialized = 1;
-    log_message(LOG_INFO, "%s: SPI инициализирован @ %d MHz", TAG, ASIC_SPI_CLK_RATE / 1000000);
-    
-    return 0;
-}
+static handle_t poll_timer = 0;
+static TaskHandle_t poll_task = NULL;
 
 /**
- * @brief Выбор модуля (CS low)
+ * @brief Готовые пакеты запросов опроса
+ * Данные запросов STATUS и NONCE нулевые, поэтому пакеты и их CRC
+ * формируются один раз в avalon10_init(), а не на каждом опросе
  */
-static void asic_select(int module_id)
-{
-    if (module_id >= 0 && module_id < AVALON10_DEFAULT_MODULARS) {
-        gpiohs_set_pin(ASIC_CS_PIN_BASE + module_id, GPIO_PV_LOW);
-    }
-}
+static avalon10_pkg_t status_req;
+static avalon10_pkg_t nonce_req;
 
 /**
- * @brief Снятие выбора модуля (CS high)
+ * @brief Сохранённые топология и настройки (tune_store.c)
+ * Читаются в avalon10_init() до обнаружения модулей
  */
-static void asic_deselect(int module_id)
-{
-    if (module_id >= 0 && module_id < AVALON10_DEFAULT_MODULARS) {
-        gpiohs_set_pin(ASIC_CS_PIN_BASE + module_id, GPIO_PV_HIGH);
-    }
-}
+static tune_record_t tune_rec;
+static int tune_loaded = 0;
 
 /**
- * @brief SPI передача данных
+ * @brief Шаблон текущего задания для заголовков очередей модулей
+ * Пишет только задача mining (под g_work_mutex)
  */
-static int asic_spi_transfer(int module_id, const uint8_t *tx, uint8_t *rx, size_t len)
-{
-    asic_select(module_id);
-    
-    /* Full-duplex SPI transfer */
-    spi_send_data_standard(ASIC_SPI_DEVICE, 0, NULL, 0, tx, len);
-    spi_receive_data_standard(ASIC_SPI_DEVICE, 0, NULL, 0, rx, len);
-    
-    asic_deselect(module_id);
-    
-    return 0;
-}
-#endif /* !MOCK_ASIC */
+static work_t queue_work;
+static int queue_work_valid = 0;
 
 /* ===========================================================================
  * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
@@ -277,10 +210,10 @@ static void build_pkg(avalon10_pkg_t *pkg, uint8_t type, uint8_t idx, uint8_t cn
 }
 
 /**
- * @brief Отправка пакета на модуль
+ * @brief Отправка пакета на модуль без ожидания ответа
  * 
- * Использует SPI для связи с ASIC или mock функции для тестирования.
- * Размер пакета фиксирован: 40 байт (AVALON10_PKG_SIZE)
+ * Пакет уходит через транспорт модуля; SPI ставит кадр в очередь DMA и не
+ * ждёт конца передачи, если свободен второй буфер.
  * 
  * @param module_id ID модуля (0-3)
  * @param pkg       Указатель на пакет
@@ -288,119 +221,34 @@ static void build_pkg(avalon10_pkg_t *pkg, uint8_t type, uint8_t idx, uint8_t cn
  */
 static int send_pkg(int module_id, const avalon10_pkg_t *pkg)
 {
-    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
-        return -1;
-    }
+    const avalon10_pkg_t *pkgs[1] = { pkg };
     
-    /* Копируем пакет в буфер передачи */
-    memcpy(tx_buffer, pkg, AVALON10_PKG_SIZE);
-    
-#if MOCK_ASIC
-    /* Используем mock функции для тестирования */
-    return mock_asic_send(module_id, tx_buffer, AVALON10_PKG_SIZE);
-#else
-    /* Реальная отправка через SPI */
-    /* TODO: Реализовать для реального железа */
-    (void)module_id;
-    log_message(LOG_WARNING, "%s: SPI send not implemented", TAG);
-    return -1;
-#endif
+    return asic_xport_send(module_id, pkgs, 1);
 }
 
 /**
- * @brief Приём пакета от модуля
+ * @brief Обмен пакетом запросов с модулем и разбор ответов
+ * 
+ * Запросы уходят одной передачей транспорта модуля (для SPI - одна
+ * DMA-передача с холостым кадром в конце). Ответ без заголовка 'CN',
+ * с чужим типом или неверной CRC считается отсутствующим (type = 0).
  * 
  * @param module_id ID модуля (0-3)
- * @param pkg       Указатель для записи пакета
- * @param timeout   Таймаут в мс
- * @return          0 при успехе, -1 при ошибке или таймауте
+ * @param reqs      Запросы
+ * @param n         Количество запросов (до asic_xport_batch_max())
+ * @param replies   Ответы, n пакетов
+ * @return          Количество принятых ответов, -1 при ошибке передачи
  */
-static int recv_pkg(int module_id, avalon10_pkg_t *pkg, int timeout)
+static int burst_pkgs(int module_id, const avalon10_pkg_t *const reqs[], int n,
+                      avalon10_pkg_t *replies)
 {
-    uint16_t crc_expected, crc_actual;
-    
-    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
-        return -1;
-    }
-    
-#if MOCK_ASIC
-    /* Используем mock функции для тестирования */
-    int ret = mock_asic_recv(module_id, rx_buffer, AVALON10_PKG_SIZE, timeout);
-    if (ret < 0) {
-        return -1;
-    }
-    memcpy(pkg, rx_buffer, AVALON10_PKG_SIZE);
-#else
-    /* Реальный приём через SPI */
-    /* TODO: Реализовать для реального железа */
-    (void)timeout;
-    log_message(LOG_WARNING, "%s: SPI recv not implemented", TAG);
-    return -1;
-#endif
-    
-    /* Проверяем заголовок пакета */
-    if (pkg->head[0] != AVALON10_PKT_HEAD1 || pkg->head[1] != AVALON10_PKT_HEAD2) {
-        return -1;
-    }
-    
-    /* Проверяем CRC16 */
-    crc_expected = calc_crc16(pkg->data, AVALON10_PKG_DATA_LEN);
-    crc_actual = ((uint16_t)pkg->crc[0] << 8) | pkg->crc[1];
-    
-    if (crc_expected != crc_actual) {
-        log_message(LOG_WARNING, "%s: CRC16 error module %d (expected %04x, got %04x)", 
-                    TAG, module_id, crc_expected, crc_actual);
-        return -1;
-    }
-    
-    return 0;
+    return asic_xport_xfer(module_id, reqs, n, replies, AVALON10_XPORT_TIMEOUT_MS);
 }
 
 /* ===========================================================================
  * ФУНКЦИИ ИНИЦИАЛИЗАЦИИ
  * =========================================================================== */
 
-/**
- * @brief Обнаружение и инициализация одного модуля
- * 
- * Отправляет команду DETECT и ждёт ответа.
- * При успехе модуль переходит в состояние INIT.
- * 
- * @param info      Указатель на структуру информации
- * @param module_id ID модуля (0-3)
- * @return          1 если модуль найден, 0 если нет
- */
-static int detect_module(avalon10_info_t *info, int module_id)
-{
-    avalon10_pkg_t pkg;
-    avalon10_module_t *module = &info->modules[module_id];
-    
-    log_message(LOG_DEBUG, "%s: Поиск модуля %d...", TAG, module_id);
-    
-    /* Подготавливаем пакет обнаружения */
-    memset(&pkg, 0, sizeof(pkg));
-    build_pkg(&pkg, AVALON10_P_DETECT, 1, 1);
-    
-    if (send_pkg(module_id, &pkg) < 0) {
-        return 0;
-    }
-    
-    /* Ожидаем ответ */
-    if (recv_pkg(module_id, &pkg, AVALON10_RESET_TIMEOUT_MS) < 0) {
-        module->state = AVALON10_MODULE_STATE_NONE;
-        return 0;
-    }
-    
-    /* Модуль найден */
-    module->module_id = module_id;
-    module->state = AVALON10_MODULE_STATE_INIT;
-    module->enabled = 1;
-    
-    log_message(LOG_INFO, "%s: Модуль %d обнаружен", TAG, module_id);
-    
-    return 1;
-}
-
 /**
  * @brief Инициализация чипов на модуле
  * 
@@ -423,7 +271,12 @@ static int init_chips(avalon10_info_t *info, int module_id)
         chip->freq = info->default_freq[0];
         chip->nonces = 0;
         chip->hw_errors = 0;
+        chip->diff1 = 0;
+        chip->shares = 0;
         chip->error_count = 0;
+        chip->diff1_seen = 0;
+        memset(chip->ghs, 0, sizeof(chip->ghs));
+        memset(chip->core_seen, 0, sizeof(chip->core_seen));
         
         active_chips++;
     }
@@ -437,15 +290,236 @@ static int init_chips(avalon10_info_t *info, int module_id)
     return active_chips;
 }
 
+/**
+ * @brief Модуль ответил на DETECT: инициализация чипов и настроек
+ * 
+ * @param info      Указатель на структуру информации
+ * @param module_id ID модуля
+ * @param t0        Время начала обнаружения (мкс)
+ */
+static void detect_found(avalon10_info_t *info, int module_id, uint64_t t0)
+{
+    avalon10_module_t *module = &info->modules[module_id];
+    
+    module->module_id = module_id;
+    module->state = AVALON10_MODULE_STATE_INIT;
+    module->enabled = 1;
+    
+    log_message(LOG_INFO, "%s: Модуль %d обнаружен (%s, %lu мс)", 
+               TAG, module_id, asic_xport_name(asic_xport_type(module_id)),
+               (unsigned long)((cgminer_time_us() - t0) / 1000));
+    
+    /* Инициализация чипов модуля - пока остальные модули ещё опрашиваются */
+    init_chips(info, module_id);
+    
+    /* Установка частоты */
+    for (int j = 0; j < AVALON10_FREQ_SLOTS; j++) {
+        module->freq[j] = info->default_freq[0];
+    }
+    
+    /* Установка напряжения */
+    module->voltage = info->default_voltage;
+    
+    /* Тёплый старт: настройки чипов из flash вместо повторной настройки */
+    if (tune_loaded && tune_store_restore_module(info, &tune_rec, module_id)) {
+        avalon10_set_voltage(info, module_id, module->voltage);
+        
+        /* Частоты подобраны автонастройкой для каждого чипа отдельно,
+         * выключенные чипы модуль не должен загружать работой */
+        for (int j = 0; j < AVALON10_DEFAULT_MINER_CNT; j++) {
+            if (module->chips[j].enabled) {
+                avalon10_set_chip_freq(info, module_id, j, module->chips[j].freq);
+            } else {
+                avalon10_set_chip_enable(info, module_id, j, 0);
+            }
+        }
+    }
+    
+    /* Модуль готов */
+    module->state = AVALON10_MODULE_STATE_READY;
+}
+
+/**
+ * @brief Разбор ответа на DETECT одного модуля
+ * 
+ * @return          1 если модуль больше не нужно опрашивать
+ */
+static int detect_finish(avalon10_info_t *info, int module_id, asic_xport_req_t *req,
+                         uint8_t *errors, int probing, uint64_t t0)
+{
+    avalon10_pkg_t reply;
+    int got = asic_xport_complete(req, &reply, AVALON10_XPORT_TIMEOUT_MS);
+    
+    if (got > 0) {
+        detect_found(info, module_id, t0);
+        return 1;
+    }
+    
+    if (got < 0 && ++errors[module_id] >= AVALON10_DETECT_FAIL_PROBES && probing) {
+        log_message(LOG_DEBUG, "%s: Модуль %d: транспорт не видит модуль", TAG, module_id);
+        return 1;
+    }
+    if (got == 0) {
+        errors[module_id] = 0;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Найдены ровно модули сохранённой топологии
+ * 
+ * @param expected  Модулей в записи, -1 - записи нет
+ */
+static int detect_matches(const avalon10_info_t *info, int expected)
+{
+    if (expected <= 0) {
+        return 0;
+    }
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        int present = info->modules[i].state != AVALON10_MODULE_STATE_NONE;
+    
+        if (present != tune_rec.module[i].present) {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+/**
+ * @brief Параллельное обнаружение модулей
+ * 
+ * Раз в тик DETECT уходит всем ещё не найденным модулям конвейером, как
+ * при опросе (запрос следующего модуля - до ответа предыдущего, если
+ * транспорты допускают перекрытие). Ответивший модуль сразу
+ * инициализируется.
+ * 
+ * 1. Короткие пробы (AVALON10_DETECT_PROBE_MS): модуль, по которому
+ *    транспорт стабильно возвращает ошибку, исключается сразу.
+ * 2. Подтверждение: молчащие модули опрашиваются до общего срока
+ *    AVALON10_DETECT_CONFIRM_MS - отсутствующий модуль стоит одно окно
+ *    на всех, а не AVALON10_RESET_TIMEOUT_MS на каждый.
+ * 
+ * Если есть сохранённая топология и после проб нашлись ровно записанные
+ * в ней модули, подтверждение не ждётся: остальных не было и раньше.
+ * 
+ * @param info      Указатель на структуру информации
+ * @return          Количество найденных модулей
+ */
+static int detect_modules(avalon10_info_t *info)
+{
+    static asic_xport_req_t reqs[2];
+    uint8_t pending[AVALON10_DEFAULT_MODULARS];
+    uint8_t errors[AVALON10_DEFAULT_MODULARS];
+    const avalon10_pkg_t *detect[1];
+    avalon10_pkg_t pkg;
+    uint64_t t0 = cgminer_time_us();
+    TickType_t start = xTaskGetTickCount();
+    int left = AVALON10_DEFAULT_MODULARS;
+    int probing = 1;
+    int expected = -1;
+    int found = 0;
+    
+    /* Ожидаемые модули - из сохранённой топологии */
+    if (tune_loaded) {
+        expected = 0;
+        for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+            expected += tune_rec.module[i].present;
+        }
+    }
+    
+    memset(&pkg, 0, sizeof(pkg));
+    build_pkg(&pkg, AVALON10_P_DETECT, 1, 1);
+    detect[0] = &pkg;
+    
+    memset(pending, 1, sizeof(pending));
+    memset(errors, 0, sizeof(errors));
+    
+    while (left > 0) {
+        TickType_t elapsed;
+        int prev = -1;
+        int cur = 0;
+    
+        for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+            if (!pending[i]) {
+                continue;
+            }
+    
+            if (prev >= 0 && !asic_xport_can_overlap(prev, i)) {
+                if (detect_finish(info, prev, &reqs[cur ^ 1], errors, probing, t0)) {
+                    pending[prev] = 0;
+                    left--;
+                }
+                prev = -1;
+            }
+    
+            if (asic_xport_submit(i, detect, 1, &reqs[cur]) < 0) {
+                if (++errors[i] >= AVALON10_DETECT_FAIL_PROBES && probing) {
+                    pending[i] = 0;
+                    left--;
+                }
+                continue;
+            }
+    
+            if (prev >= 0 && detect_finish(info, prev, &reqs[cur ^ 1], errors, probing, t0)) {
+                pending[prev] = 0;
+                left--;
+            }
+            prev = i;
+            cur ^= 1;
+        }
+    
+        if (prev >= 0 && detect_finish(info, prev, &reqs[cur ^ 1], errors, probing, t0)) {
+            pending[prev] = 0;
+            left--;
+        }
+    
+        elapsed = xTaskGetTickCount() - start;
+        if (probing && elapsed >= pdMS_TO_TICKS(AVALON10_DETECT_PROBE_MS)) {
+            probing = 0;
+            cgminer_boot_mark("ASIC: пробы");
+            if (left > 0 && !detect_matches(info, expected)) {
+                log_message(LOG_INFO, "%s: %d модулей молчат, ожидание до %d мс", 
+                           TAG, left, AVALON10_DETECT_CONFIRM_MS);
+            }
+        }
+        if (!probing && left > 0 && detect_matches(info, expected)) {
+            log_message(LOG_INFO, "%s: Топология совпадает с сохранённой", TAG);
+            break;
+        }
+        if (left == 0 || elapsed >= pdMS_TO_TICKS(AVALON10_DETECT_CONFIRM_MS)) {
+            break;
+        }
+    
+        vTaskDelay(1);
+    }
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        if (info->modules[i].state == AVALON10_MODULE_STATE_NONE) {
+            log_message(LOG_DEBUG, "%s: Модуль %d не найден", TAG, i);
+        } else {
+            found++;
+        }
+    }
+    
+    log_message(LOG_INFO, "%s: Обнаружение: %d модулей за %lu мс", 
+               TAG, found, (unsigned long)((cgminer_time_us() - t0) / 1000));
+    
+    return found;
+}
+
 /**
  * @brief Инициализация драйвера Avalon10
  * 
  * Последовательность инициализации:
  * 1. Очистка структуры
  * 2. Установка значений по умолчанию
- * 3. Обнаружение модулей
- * 4. Инициализация чипов
- * 5. Применение настроек
+ * 3. Чтение сохранённых настроек (tune_store.c)
+ * 4. Обнаружение модулей
+ * 5. Инициализация чипов
+ * 6. Применение настроек (сохранённых или по умолчанию)
  * 
  * Оригинальная функция: FUN_ram_80004e86
  * 
@@ -471,27 +545,48 @@ int avalon10_init(avalon10_info_t *info)
     info->temp_overheat = AVALON10_DEFAULT_TEMP_OVERHEAT;
     info->temp_cutoff = AVALON10_DEFAULT_TEMP_CUTOFF;
     
-    /* Обнаружение модулей */
+    /* Вентиляторы на полный обдув до первого шага регулятора */
+    if (fan_init() == 0) {
+        for (int i = 0; i < AVALON10_FAN_COUNT; i++) {
+            info->fan_pwm[i] = AVALON10_DEFAULT_FAN_MAX;
+        }
+    }
+    
+    /* Глубина очереди заданий модуля - из конфигурации */
+    info->work_depth = AVALON10_WORK_QUEUE_DEFAULT;
+    if (g_config.work_queue_depth > 0) {
+        info->work_depth = MIN(g_config.work_queue_depth, AVALON10_WORK_QUEUE_MAX);
+    }
+    
+    /* Транспорт каждого модуля - из конфигурации; недоступный заменяется SPI */
     for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
-        if (detect_module(info, i)) {
-            modules_found++;
-            
-            /* Инициализация чипов модуля */
-            init_chips(info, i);
-            
-            /* Установка частоты */
-            for (int j = 0; j < AVALON10_FREQ_SLOTS; j++) {
-                info->modules[i].freq[j] = info->default_freq[0];
+        int type = g_config.asic_xport[i];
+    
+        if (asic_xport_bind(i, type) != 0) {
+            log_message(LOG_WARNING, "%s: Модуль %d: транспорт %s недоступен, используется %s",
+                       TAG, i, asic_xport_name(type), asic_xport_name(ASIC_XPORT_DEFAULT));
+            if (asic_xport_bind(i, ASIC_XPORT_DEFAULT) != 0) {
+                log_message(LOG_ERR, "%s: Не удалось запустить транспорт", TAG);
+                return -1;
             }
-            
-            /* Установка напряжения */
-            info->modules[i].voltage = info->default_voltage;
-            
-            /* Модуль готов */
-            info->modules[i].state = AVALON10_MODULE_STATE_READY;
         }
+        info->modules[i].xport = (uint8_t)asic_xport_type(i);
     }
     
+    /* Запросы опроса не меняются - CRC считается один раз */
+    avalon10_pkg_request(&status_req, AVALON10_P_STATUS);
+    avalon10_pkg_request(&nonce_req, AVALON10_P_NONCE);
+    
+    /* Сохранённые топология и настройки (последнее рабочее состояние) */
+    tune_loaded = tune_store_load(&tune_rec) == 0;
+    if (tune_loaded) {
+        tune_store_restore_fans(info, &tune_rec);
+    }
+    
+    /* Обнаружение модулей и инициализация чипов - параллельно по модулям */
+    modules_found = detect_modules(info);
+    cgminer_boot_mark("ASIC: модули");
+    
     info->module_count = modules_found;
     info->active_modules = modules_found;
     info->initialized = 1;
@@ -508,6 +603,39 @@ int avalon10_init(avalon10_info_t *info)
     return 0;
 }
 
+/**
+ * @brief Запуск майнинга на всех готовых модулях
+ * 
+ * Отправляет AVALON10_P_SET_MINING и переводит модули READY в MINING.
+ * 
+ * @param info      Указатель на структуру информации
+ * @return          Количество модулей, перешедших в майнинг
+ */
+int avalon10_start_mining(avalon10_info_t *info)
+{
+    avalon10_pkg_t pkg;
+    int started = 0;
+    
+    memset(&pkg, 0, sizeof(pkg));
+    pkg.data[0] = 1;    /* 1 = старт */
+    build_pkg(&pkg, AVALON10_P_SET_MINING, 1, 1);
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        avalon10_module_t *module = &info->modules[i];
+        
+        if (module->state == AVALON10_MODULE_STATE_READY) {
+            send_pkg(i, &pkg);
+            module->state = AVALON10_MODULE_STATE_MINING;
+            started++;
+        }
+    }
+    
+    info->mining_enabled = 1;
+    log_message(LOG_INFO, "%s: Майнинг запущен на %d модулях", TAG, started);
+    
+    return started;
+}
+
 /**
  * @brief Деинициализация драйвера
  * 
@@ -537,7 +665,6 @@ void avalon10_exit(avalon10_info_t *info)
  */
 int avalon10_reset(avalon10_info_t *info, int module_id)
 {
-    avalon10_pkg_t pkg;
     int start, end;
     
     if (module_id < 0) {
@@ -548,18 +675,97 @@ int avalon10_reset(avalon10_info_t *info, int module_id)
         end = module_id + 1;
     }
     
+    for (int i = start; i < end; i++) {
+        avalon10_reset_module(info, i);
+    }
+    
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    
+    return 0;
+}
+
+/**
+ * @brief Сброс одного модуля без ожидания загрузки
+ * 
+ * @param info      Указатель на структуру информации
+ * @param module_id ID модуля
+ * @return          0 при успехе, -1 при ошибке
+ */
+int avalon10_reset_module(avalon10_info_t *info, int module_id)
+{
+    avalon10_pkg_t pkg;
+    
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        info->modules[module_id].state == AVALON10_MODULE_STATE_NONE) {
+        return -1;
+    }
+    
     memset(&pkg, 0, sizeof(pkg));
     build_pkg(&pkg, AVALON10_P_RESET, 1, 1);
     
-    for (int i = start; i < end; i++) {
-        if (info->modules[i].state != AVALON10_MODULE_STATE_NONE) {
-            log_message(LOG_INFO, "%s: Сброс модуля %d", TAG, i);
-            send_pkg(i, &pkg);
-            info->modules[i].state = AVALON10_MODULE_STATE_INIT;
+    log_message(LOG_INFO, "%s: Сброс модуля %d", TAG, module_id);
+    send_pkg(module_id, &pkg);
+    info->modules[module_id].state = AVALON10_MODULE_STATE_INIT;
+    
+    return 0;
+}
+
+/**
+ * @brief Возврат модуля в майнинг после сброса
+ * 
+ * Сброс возвращает чипы модуля к частоте и напряжению по умолчанию и
+ * очищает очередь заданий; подобранные настройки остаются в структуре
+ * модуля и отправляются заново. Счётчики чипов не обнуляются.
+ * 
+ * @param info      Указатель на структуру информации
+ * @param module_id ID модуля
+ * @return          0 - модуль в майнинге, -1 - модуль ещё не ответил
+ */
+int avalon10_restore_module(avalon10_info_t *info, int module_id)
+{
+    const avalon10_pkg_t *detect[1];
+    avalon10_module_t *module;
+    avalon10_pkg_t pkg, reply;
+    
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        info->modules[module_id].state == AVALON10_MODULE_STATE_NONE) {
+        return -1;
+    }
+    module = &info->modules[module_id];
+    
+    /* Загрузка закончена, когда модуль отвечает на DETECT */
+    memset(&pkg, 0, sizeof(pkg));
+    build_pkg(&pkg, AVALON10_P_DETECT, 1, 1);
+    detect[0] = &pkg;
+    if (asic_xport_xfer(module_id, detect, 1, &reply, AVALON10_XPORT_TIMEOUT_MS) <= 0) {
+        return -1;
+    }
+    
+    avalon10_set_voltage(info, module_id, module->voltage);
+    for (int j = 0; j < AVALON10_DEFAULT_MINER_CNT; j++) {
+        if (module->chips[j].enabled) {
+            avalon10_set_chip_freq(info, module_id, j, module->chips[j].freq);
+        } else {
+            avalon10_set_chip_enable(info, module_id, j, 0);
         }
     }
     
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    memset(&pkg, 0, sizeof(pkg));
+    pkg.data[0] = 1;    /* 1 = старт */
+    build_pkg(&pkg, AVALON10_P_SET_MINING, 1, 1);
+    if (send_pkg(module_id, &pkg) != 0) {
+        return -1;
+    }
+    
+    /* Очередь заданий пуста - пополнение по следующим STATUS */
+    module->work_queued = 0;
+    module->nonce_backlog = 0;
+    module->poll_errors = 0;
+    module->last_poll = xTaskGetTickCount();
+    module->state = AVALON10_MODULE_STATE_MINING;
+    
+    log_message(LOG_INFO, "%s: Модуль %d снова в майнинге (%d mV, %d чипов)",
+               TAG, module_id, module->voltage, module->active_chips);
     
     return 0;
 }
@@ -569,88 +775,276 @@ int avalon10_reset(avalon10_info_t *info, int module_id)
  * =========================================================================== */
 
 /**
- * @brief Опрос одного модуля
+ * @brief Разбор nonce-записи из поля data пакета AVALON10_P_NONCE
+ * 
+ * @param p         Указатель на запись (AVALON10_NONCE_REC_LEN байт)
+ * @param rec       Структура для результата
+ */
+static void parse_nonce_rec(const uint8_t *p, avalon10_nonce_rec_t *rec)
+{
+    rec->nonce = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                 ((uint32_t)p[2] << 8) | p[3];
+    rec->chip_id = p[4];
+    rec->core_id = p[5];
+    rec->job_idx = p[6];
+    rec->flags = p[7];
+}
+
+/**
+ * @brief Передача nonce в конвейер проверки
+ * 
+ * Опрос не проверяет nonce сам: запись уходит в кольцо validator,
+ * SHA256d и отправка на пул выполняются на другом ядре.
  * 
- * Запрашивает статус и nonce от модуля.
+ * @param module_id ID модуля, приславшего nonce
+ * @param rec       Nonce-запись
+ */
+static void handle_nonce(int module_id, const avalon10_nonce_rec_t *rec)
+{
+    validator_nonce_t vn;
+    
+    vn.nonce = rec->nonce;
+    vn.module_id = (uint8_t)module_id;
+    vn.chip_id = rec->chip_id;
+    vn.core_id = rec->core_id;
+    vn.job_idx = rec->job_idx;
+    vn.t_rx = cgminer_time_us();
+    
+    if (validator_push(&vn) < 0) {
+        log_message(LOG_DEBUG, "%s: Кольцо nonce заполнено, nonce 0x%08X потерян", 
+                   TAG, rec->nonce);
+    }
+}
+
+/**
+ * @brief Разбор ответа AVALON10_P_NONCE
+ * 
+ * @param module_id ID модуля
+ * @param pkg       Ответ
+ * @return          Количество переданных в validator nonce
+ */
+static int take_nonces(int module_id, const avalon10_pkg_t *pkg)
+{
+    avalon10_nonce_rec_t rec;
+    int count = MIN(pkg->opt, AVALON10_NONCE_PER_PKG);
+    int nonces = 0;
+    
+    for (int i = 0; i < count; i++) {
+        parse_nonce_rec(pkg->data + i * AVALON10_NONCE_REC_LEN, &rec);
+        if (!(rec.flags & AVALON10_NONCE_FLAG_VALID)) {
+            continue;
+        }
+        handle_nonce(module_id, &rec);
+        nonces++;
+    }
+    
+    return nonces;
+}
+
+/**
+ * @brief Учёт проверенного nonce в статистике чипа
+ * 
+ * Пишет только задача validator; читатели (API, мониторинг) видят
+ * 32-битные счётчики без блокировки.
+ */
+void avalon10_chip_account(avalon10_info_t *info, int module_id, int chip_id, int core_id,
+                           int result)
+{
+    avalon10_module_t *module;
+    avalon10_chip_t *chip;
+    
+    if (!info || module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return;
+    }
+    module = &info->modules[module_id];
+    
+    /* Хэшрейт модуля считается и по nonce с неверным номером чипа */
+    if (result != AVALON10_NONCE_HW_ERROR) {
+        module->diff1++;
+        info->total_diff1++;
+    }
+    
+    if (chip_id < 0 || chip_id >= AVALON10_DEFAULT_MINER_CNT) {
+        module->bad_chip_ids++;
+        return;
+    }
+    chip = &module->chips[chip_id];
+    
+    chip->nonces++;
+    
+    if (result == AVALON10_NONCE_HW_ERROR) {
+        chip->hw_errors++;
+        if (chip->error_count < 0xFF) {
+            chip->error_count++;
+        }
+        return;
+    }
+    
+    chip->error_count = 0;
+    chip->diff1++;
+    if (result == AVALON10_NONCE_SHARE) {
+        chip->shares++;
+    }
+    
+    /* Маску забирает и обнуляет задача monitor (yieldmon) */
+    if (core_id >= 0 && core_id < AVALON10_DEFAULT_ASIC_CORE) {
+        __atomic_fetch_or(&chip->core_seen[core_id / 32], 1u << (core_id % 32), __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Слабый чип: доля HW ошибок выше AVALON10_CHIP_WEAK_HW_PCT
+ */
+int avalon10_chip_weak(const avalon10_chip_t *chip)
+{
+    if (chip->nonces < AVALON10_CHIP_WEAK_MIN_NONCES) {
+        return 0;
+    }
+    
+    return (uint64_t)chip->hw_errors * 100 > (uint64_t)chip->nonces * AVALON10_CHIP_WEAK_HW_PCT;
+}
+
+/**
+ * @brief Ожидаемое число nonce сложности 1 модуля в секунду
+ */
+float avalon10_expected_diff1(const avalon10_module_t *module)
+{
+    uint32_t mhz = 0;
+    
+    for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+        if (module->chips[c].enabled) {
+            mhz += module->chips[c].freq;
+        }
+    }
+    
+#if MOCK_ASIC
+    /* Эмулятор: MOCK_NONCE_RATE_HZ nonce на модуль при MOCK_NONCE_RATE_FREQ */
+    return (float)mhz * MOCK_NONCE_RATE_HZ /
+           ((float)MOCK_NONCE_RATE_FREQ * MOCK_ASIC_CHIPS_PER_MODULE);
+#else
+    /* Nonce сложности 1 в среднем стоит 2^32 хэшей */
+    return (float)mhz * 1e6f * AVALON10_DEFAULT_ASIC_CORE * AVALON10_CORE_HASHES_PER_CLK /
+           4294967296.0f;
+#endif
+}
+
+/**
+ * @brief Начало опроса модуля
+ * 
+ * Первый пакет запросов - [STATUS][NONCE]: статус и первая порция FIFO
+ * за одну передачу (для SPI - за одно выставление CS). Функция не ждёт
+ * ответов - их забирает poll_finish().
+ * 
+ * @param module_id ID модуля
+ * @param req       Состояние пакета в полёте
+ * @return          0 при успехе, -1 при ошибке отправки
+ */
+static int poll_start(int module_id, asic_xport_req_t *req)
+{
+    const avalon10_pkg_t *reqs[2] = { &status_req, &nonce_req };
+    
+    return asic_xport_submit(module_id, reqs, 2, req);
+}
+
+/**
+ * @brief Завершение опроса модуля
+ * 
+ * Разбирает ответ на [STATUS][NONCE]. Если в FIFO остались nonce,
+ * следующие пакеты несут столько запросов NONCE, сколько нужно для
+ * остатка (поле cnt ответа), но не более asic_xport_batch_max().
+ * Всего за проход - не более AVALON10_NONCE_DRAIN_MAX запросов NONCE,
+ * остаток FIFO публикуется в module->nonce_backlog.
  * 
  * @param info      Указатель на структуру информации
  * @param module_id ID модуля
+ * @param req       Пакет из poll_start()
  * @return          Количество найденных nonce
  */
-static int poll_module(avalon10_info_t *info, int module_id)
+static int poll_finish(avalon10_info_t *info, int module_id, asic_xport_req_t *req)
 {
-    avalon10_pkg_t pkg;
+    const avalon10_pkg_t *reqs[ASIC_XPORT_BATCH_MAX];
+    avalon10_pkg_t replies[ASIC_XPORT_BATCH_MAX];
     avalon10_module_t *module = &info->modules[module_id];
+    int batch_max = asic_xport_batch_max(module_id);
     int nonces = 0;
+    int pkts = 1;
+    int more = 0;
+    int n;
     
-    /* Запрос статуса */
-    memset(&pkg, 0, sizeof(pkg));
-    build_pkg(&pkg, AVALON10_P_STATUS, 1, 1);
-    
-    if (send_pkg(module_id, &pkg) < 0) {
-        module->poll_errors++;
+    if (asic_xport_complete(req, replies, AVALON10_XPORT_TIMEOUT_MS) <= 0) {
+        if (module->poll_errors < 0xFF) {
+            module->poll_errors++;
+        }
         return 0;
     }
     
-    if (recv_pkg(module_id, &pkg, AVALON10_POLL_TIMEOUT_MS) < 0) {
-        module->poll_errors++;
-        return 0;
+    module->poll_errors = 0;
+    
+    /* Ответ с неверной CRC или заголовком транспорт отдаёт как type = 0 */
+    if (replies[0].type != AVALON10_P_STATUS) {
+        module->bad_replies++;
+    }
+    
+    /* Парсинг ответа - температура и заполненность очереди заданий */
+    if (replies[0].type == AVALON10_P_STATUS) {
+        uint8_t queued = replies[0].data[AVALON10_STATUS_WORK_QUEUED];
+    
+        module->temp_in = (int16_t)((replies[0].data[0] << 8) | replies[0].data[1]);
+        module->temp_out = (int16_t)((replies[0].data[2] << 8) | replies[0].data[3]);
+    
+        /* Событие - переход в пустую очередь: чипы простаивают до пополнения
+         * (простой по скважности снижения хэшрейта не в счёт) */
+        if (queued == 0 && module->work_queued > 0 &&
+            module->state == AVALON10_MODULE_STATE_MINING && !throttle_active(module_id)) {
+            module->work_starved++;
+        }
+        module->work_queued = queued;
+        module->idle_chips = replies[0].data[AVALON10_STATUS_IDLE_CHIPS];
+        module->power = (uint16_t)((replies[0].data[AVALON10_STATUS_POWER] << 8) |
+                                   replies[0].data[AVALON10_STATUS_POWER + 1]);
+        module->status_seq++;
+    }
+    
+    if (replies[1].type == AVALON10_P_NONCE) {
+        nonces += take_nonces(module_id, &replies[1]);
+        module->nonce_backlog = replies[1].cnt;
+        more = replies[1].cnt > 0;
     }
     
-    module->poll_errors = 0;
+    /* Остаток FIFO - пакетами запросов NONCE */
+    while (more && pkts < AVALON10_NONCE_DRAIN_MAX) {
+        n = (module->nonce_backlog + AVALON10_NONCE_PER_PKG - 1) / AVALON10_NONCE_PER_PKG;
+        n = MIN(n, batch_max);
+        n = MIN(n, AVALON10_NONCE_DRAIN_MAX - pkts);
     
-    /* Парсинг ответа - обновление температуры */
-    if (pkg.type == AVALON10_P_STATUS) {
-        module->temp_in = (int16_t)((pkg.data[0] << 8) | pkg.data[1]);
-        module->temp_out = (int16_t)((pkg.data[2] << 8) | pkg.data[3]);
-    }
+        for (int i = 0; i < n; i++) {
+            reqs[i] = &nonce_req;
+        }
     
-    /* Проверяем nonce */
-    memset(&pkg, 0, sizeof(pkg));
-    build_pkg(&pkg, AVALON10_P_NONCE, 1, 1);
+        if (burst_pkgs(module_id, reqs, n, replies) <= 0) {
+            break;
+        }
+        pkts += n;
     
-    if (send_pkg(module_id, &pkg) == 0 &&
-        recv_pkg(module_id, &pkg, AVALON10_NONCE_TIMEOUT_MS) == 0) {
-        
-        if (pkg.type == AVALON10_P_NONCE) {
-            /* Найден nonce от ASIC */
-            uint32_t nonce = (pkg.data[0] << 24) | (pkg.data[1] << 16) |
-                            (pkg.data[2] << 8) | pkg.data[3];
-            
-            /* Получаем текущую работу через stratum модуль */
-            work_t *current_work = stratum_get_current_work();
-            
-            if (current_work && g_work_mutex) {
-                if (xSemaphoreTake(g_work_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                    /* Проверяем nonce через SHA256d */
-                    if (work_check_nonce(current_work, nonce)) {
-                        /* Nonce валиден - отправляем на пул */
-                        current_work->nonce = nonce;
-                        
-                        /* Вызываем отправку через stratum */
-                        if (g_current_pool && g_current_pool->stratum_active) {
-                            if (stratum_submit_nonce(g_current_pool, current_work) == 0) {
-                                module->accepted++;
-                                log_message(LOG_INFO, "%s: Nonce 0x%08X отправлен на пул", 
-                                           TAG, nonce);
-                            } else {
-                                log_message(LOG_WARNING, "%s: Ошибка отправки nonce", TAG);
-                            }
-                        }
-                    } else {
-                        /* Hardware error - nonce не прошёл проверку */
-                        module->hw_errors++;
-                        info->total_hw_errors++;
-                        log_message(LOG_WARNING, "%s: HW Error: nonce 0x%08X не валиден", 
-                                   TAG, nonce);
-                    }
-                    xSemaphoreGive(g_work_mutex);
-                }
+        more = 0;
+        for (int i = 0; i < n; i++) {
+            if (replies[i].type != AVALON10_P_NONCE) {
+                continue;
             }
-            nonces++;
+            nonces += take_nonces(module_id, &replies[i]);
+            module->nonce_backlog = replies[i].cnt;
+            more = replies[i].cnt > 0;
         }
     }
     
+    if (more && pkts >= AVALON10_NONCE_DRAIN_MAX) {
+        module->drain_overruns++;
+    }
+    if (module->nonce_backlog > module->nonce_backlog_max) {
+        module->nonce_backlog_max = module->nonce_backlog;
+    }
+    module->nonce_drained += nonces;
+    
     module->last_poll = xTaskGetTickCount();
     
     return nonces;
@@ -659,7 +1053,12 @@ static int poll_module(avalon10_info_t *info, int module_id)
 /**
  * @brief Опрос всех модулей
  * 
- * Вызывается в основном цикле майнинга.
+ * Вызывается задачей опроса ASIC по тику аппаратного таймера.
+ * Опрос конвейерный: запросы следующего модуля отправляются до разбора
+ * ответов предыдущего, если их транспорты это допускают
+ * (asic_xport_can_overlap) - например, модули на SPI и на AUC
+ * опрашиваются одновременно.
+ * 
  * Оригинальная функция: FUN_ram_800051ca
  * 
  * @param info      Указатель на структуру информации
@@ -667,7 +1066,11 @@ static int poll_module(avalon10_info_t *info, int module_id)
  */
 int avalon10_poll(avalon10_info_t *info)
 {
+    /* Два пакета в полёте: текущий модуль и предыдущий */
+    static asic_xport_req_t reqs[2];
     int total_nonces = 0;
+    int prev = -1;
+    int cur = 0;
     
     if (!info->initialized || !info->mining_enabled) {
         return 0;
@@ -676,9 +1079,36 @@ int avalon10_poll(avalon10_info_t *info)
     for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
         avalon10_module_t *module = &info->modules[i];
         
-        if (module->state == AVALON10_MODULE_STATE_MINING) {
-            total_nonces += poll_module(info, i);
+        if (module->state != AVALON10_MODULE_STATE_MINING) {
+            continue;
         }
+    
+        if (prev >= 0 && !asic_xport_can_overlap(prev, i)) {
+            total_nonces += poll_finish(info, prev, &reqs[cur ^ 1]);
+            prev = -1;
+        }
+    
+        if (poll_start(i, &reqs[cur]) < 0) {
+            if (module->poll_errors < 0xFF) {
+                module->poll_errors++;
+            }
+            continue;
+        }
+    
+        if (prev >= 0) {
+            total_nonces += poll_finish(info, prev, &reqs[cur ^ 1]);
+        }
+        prev = i;
+        cur ^= 1;
+    }
+    
+    if (prev >= 0) {
+        total_nonces += poll_finish(info, prev, &reqs[cur ^ 1]);
+    }
+    
+    /* Будим validator на другом ядре */
+    if (total_nonces > 0) {
+        validator_kick();
     }
     
     /* Обновляем общую статистику */
@@ -689,6 +1119,78 @@ int avalon10_poll(avalon10_info_t *info)
     return total_nonces;
 }
 
+/**
+ * @brief Обработчик прерывания таймера опроса
+ * 
+ * Вызывается из ISR драйвера таймера, только будит задачу опроса.
+ */
+static void poll_timer_on_tick(void *userdata)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    
+    (void)userdata;
+    
+    if (poll_task) {
+        vTaskNotifyGiveFromISR(poll_task, &xHigherPriorityTaskWoken);
+        if (xHigherPriorityTaskWoken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+/**
+ * @brief Запуск аппаратного таймера опроса
+ * 
+ * @param task          Задача опроса ASIC
+ * @param interval_us   Период таймера (мкс)
+ * @return              0 при успехе, -1 если таймер недоступен
+ */
+int avalon10_poll_timer_start(TaskHandle_t task, uint32_t interval_us)
+{
+    poll_task = task;
+    
+    if (!poll_timer) {
+        poll_timer = io_open(AVALON10_POLL_TIMER_DEV);
+        if (!poll_timer) {
+            log_message(LOG_WARNING, "%s: Таймер опроса недоступен, опрос по тику", TAG);
+            return -1;
+        }
+    }
+    
+    timer_set_interval(poll_timer, (size_t)interval_us * 1000);
+    timer_set_on_tick(poll_timer, poll_timer_on_tick, NULL);
+    timer_set_enable(poll_timer, true);
+    
+    log_message(LOG_INFO, "%s: Таймер опроса запущен (%lu мкс)", 
+                TAG, (unsigned long)interval_us);
+    
+    return 0;
+}
+
+/**
+ * @brief Остановка аппаратного таймера опроса
+ */
+void avalon10_poll_timer_stop(void)
+{
+    if (poll_timer) {
+        timer_set_enable(poll_timer, false);
+    }
+}
+
+/**
+ * @brief Ожидание следующего тика таймера опроса
+ * 
+ * Несколько тиков, пришедших за время опроса, сливаются в одно пробуждение:
+ * следующий проход всё равно выгрузит весь FIFO.
+ * 
+ * @param timeout_ms    Максимальное время ожидания (мс)
+ * @return              1 если разбужены таймером, 0 по таймауту
+ */
+int avalon10_poll_wait(uint32_t timeout_ms)
+{
+    return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) ? 1 : 0;
+}
+
 /**
  * @brief Чтение температуры со всех датчиков
  * 
@@ -703,13 +1205,9 @@ int avalon10_read_temperature(avalon10_info_t *info)
         avalon10_module_t *module = &info->modules[i];
         
         if (module->state != AVALON10_MODULE_STATE_NONE) {
-            /* Обновляем максимальную температуру */
-            if (module->temp_in > module->temp_max) {
-                module->temp_max = module->temp_in;
-            }
-            if (module->temp_out > module->temp_max) {
-                module->temp_max = module->temp_out;
-            }
+            /* Текущий максимум датчиков: по нему работают ПИД вентиляторов
+             * и защита от перегрева, поэтому он обязан и снижаться */
+            module->temp_max = MAX(module->temp_in, module->temp_out);
             
             /* Средняя температура */
             module->temp_avg = (module->temp_in + module->temp_out) / 2;
@@ -726,13 +1224,16 @@ int avalon10_read_temperature(avalon10_info_t *info)
 /**
  * @brief Проверка перегрева
  * 
- * При превышении temp_overheat - снижаем частоту.
- * При превышении temp_cutoff - останавливаем майнинг.
+ * Ниже temp_cutoff хэшрейт снижает throttle_poll(). При temp_cutoff
+ * модуль останавливается и возвращается в майнинг, остыв ниже
+ * temp_overheat - THROTTLE_BAND_C.
  * 
  * @param info      Указатель на структуру информации
  */
 void avalon10_check_overheat(avalon10_info_t *info)
 {
+    int overheat = 0;
+    
     for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
         avalon10_module_t *module = &info->modules[i];
         
@@ -742,111 +1243,133 @@ void avalon10_check_overheat(avalon10_info_t *info)
         
         int temp = module->temp_max / 10;  /* Преобразуем из °C×10 в °C */
         
-        if (temp >= info->temp_cutoff) {
+        if (temp >= info->temp_cutoff && module->state == AVALON10_MODULE_STATE_MINING) {
             /* Критический перегрев - останавливаем */
             log_message(LOG_ERR, "%s: Модуль %d: КРИТИЧЕСКИЙ ПЕРЕГРЕВ %d°C!", 
                        TAG, i, temp);
             module->state = AVALON10_MODULE_STATE_OVERHEAT;
-            info->overheat = 1;
-        }
-        else if (temp >= info->temp_overheat) {
-            /* Перегрев - снижаем частоту */
-            log_message(LOG_WARNING, "%s: Модуль %d: перегрев %d°C, снижение частоты", 
-                       TAG, i, temp);
-            
-            for (int j = 0; j < AVALON10_FREQ_SLOTS; j++) {
-                if (module->freq[j] > AVALON10_DEFAULT_FREQ_MIN) {
-                    module->freq[j] -= AVALON10_FREQ_STEP;
-                }
-            }
+            throttle_note_cutoff(i);
         }
-        else if (temp < info->temp_target && module->state == AVALON10_MODULE_STATE_OVERHEAT) {
-            /* Температура в норме - возобновляем */
+        else if (temp < info->temp_overheat - THROTTLE_BAND_C &&
+                 module->state == AVALON10_MODULE_STATE_OVERHEAT) {
+            /* Остыл - возобновляем со сниженной частотой */
             log_message(LOG_INFO, "%s: Модуль %d: температура в норме %d°C", 
                        TAG, i, temp);
             module->state = AVALON10_MODULE_STATE_MINING;
-            info->overheat = 0;
+        }
+        
+        if (module->state == AVALON10_MODULE_STATE_OVERHEAT) {
+            overheat = 1;
         }
     }
+    
+    info->overheat = overheat;
 }
 
 /**
- * @brief Расчёт и обновление хэшрейта
+ * @brief Шаг EWMA всех окон
  * 
- * Хэшрейт рассчитывается по количеству nonce за единицу времени.
- * Формула: hashrate = nonces × difficulty × 2^32 / time
- * 
- * @param info      Указатель на структуру информации
+ * @param ghs       EWMA окон (GH/s)
+ * @param diff1     Nonce сложности 1 за интервал
+ * @param dt        Интервал (с)
+ * @param alpha     Вес нового замера для каждого окна
  */
-void avalon10_update_hashrate(avalon10_info_t *info)
+static void hashrate_ewma(float *ghs, uint64_t diff1, float dt, const float *alpha)
 {
-    uint64_t total = 0;
+    /* Nonce сложности 1 в среднем стоит 2^32 хэшей */
+    float ghs_now = (float)diff1 * 4.294967296f / dt;
     
-    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
-        avalon10_module_t *module = &info->modules[i];
-        
-        if (module->state == AVALON10_MODULE_STATE_MINING) {
-            /* Приблизительный хэшрейт на основе активных чипов и частоты */
-            /* Каждое ядро выдаёт около 10 GH/s на 500 MHz */
-            uint64_t cores = module->active_chips * AVALON10_DEFAULT_ASIC_CORE;
-            uint64_t freq = module->freq[0];
-            module->hashrate = (cores * freq * 20000000ULL);  /* H/s */
-            
-            total += module->hashrate;
-        }
+    for (int w = 0; w < AVALON10_HASHRATE_WINDOWS; w++) {
+        ghs[w] += alpha[w] * (ghs_now - ghs[w]);
     }
-    
-    info->total_hashrate = total;
 }
 
-/* ===========================================================================
- * УПРАВЛЕНИЕ ВЕНТИЛЯТОРАМИ
- * =========================================================================== */
-
 /**
- * @brief Регулировка скорости вентиляторов
+ * @brief Замер хэшрейта по проверенным nonce
  * 
- * Простой пропорциональный регулятор.
- * При температуре ниже целевой - минимальные обороты.
- * При температуре выше целевой - увеличиваем пропорционально.
+ * Хэшрейт считается по nonce сложности 1, прошедшим проверку
+ * validator: каждый стоит в среднем 2^32 хэшей. Частота и число ядер
+ * дают только теоретическое значение, которое не видит HW ошибок и
+ * простоя чипов.
+ * 
+ * Вес замера в окне с постоянной времени tau: 1 - exp(-dt / tau). Пока
+ * с первого замера прошло меньше tau, вес не ниже dt / elapsed - окно
+ * равно среднему с начала и не стартует с нуля.
  * 
  * @param info      Указатель на структуру информации
  */
-void avalon10_adjust_fan(avalon10_info_t *info)
+void avalon10_update_hashrate(avalon10_info_t *info)
 {
-    int max_temp = 0;
+    static const float tau_s[AVALON10_HASHRATE_WINDOWS] = { 5.0f, 60.0f, 300.0f, 900.0f };
+    uint64_t now = cgminer_time_us();
+    uint64_t total = 0;
+    float alpha[AVALON10_HASHRATE_WINDOWS];
+    float dt, elapsed;
     
-    /* Находим максимальную температуру */
-    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
-        if (info->modules[i].temp_max > max_temp) {
-            max_temp = info->modules[i].temp_max;
+    /* Первый замер - только точка отсчёта */
+    if (!info->hashrate_at_us) {
+        for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+            avalon10_module_t *module = &info->modules[i];
+    
+            module->diff1_seen = module->diff1;
+            for (int j = 0; j < AVALON10_DEFAULT_MINER_CNT; j++) {
+                module->chips[j].diff1_seen = module->chips[j].diff1;
+            }
         }
+        info->hashrate_start_us = now;
+        info->hashrate_at_us = now;
+        return;
     }
     
-    int temp = max_temp / 10;  /* °C */
-    int speed;
-    
-    if (temp <= info->temp_target - 10) {
-        speed = info->fan_min;
-    }
-    else if (temp >= info->temp_overheat) {
-        speed = info->fan_max;
+    if (now <= info->hashrate_at_us) {
+        return;
     }
-    else {
-        /* Линейная интерполяция */
-        int range = info->temp_overheat - (info->temp_target - 10);
-        int delta = temp - (info->temp_target - 10);
-        speed = info->fan_min + 
-                ((info->fan_max - info->fan_min) * delta) / range;
+    
+    dt = (now - info->hashrate_at_us) / 1e6f;
+    elapsed = (now - info->hashrate_start_us) / 1e6f;
+    info->hashrate_at_us = now;
+    
+    for (int w = 0; w < AVALON10_HASHRATE_WINDOWS; w++) {
+        alpha[w] = 1.0f - expf(-dt / tau_s[w]);
+        if (elapsed < tau_s[w] && dt / elapsed > alpha[w]) {
+            alpha[w] = dt / elapsed;
+        }
     }
     
-    /* Применяем ко всем вентиляторам */
-    for (int i = 0; i < AVALON10_FAN_COUNT; i++) {
-        info->fan_pwm[i] = speed;
-        avalon10_set_fan_speed(info, i, speed);
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        avalon10_module_t *module = &info->modules[i];
+        uint64_t diff1 = module->diff1;
+        uint64_t delta;
+    
+        /* Счётчики модуля и чипов обнуляются при повторном обнаружении модуля */
+        delta = diff1 >= module->diff1_seen ? diff1 - module->diff1_seen : diff1;
+        module->diff1_seen = diff1;
+        total += delta;
+    
+        hashrate_ewma(module->ghs, delta, dt, alpha);
+        module->hashrate = (uint64_t)(module->ghs[AVALON10_HASHRATE_5S] * 1e9f);
+        module->hashrate_avg = (uint64_t)(diff1 * 4294967296.0 / elapsed);
+    
+        for (int j = 0; j < AVALON10_DEFAULT_MINER_CNT; j++) {
+            avalon10_chip_t *chip = &module->chips[j];
+            uint32_t chip_diff1 = chip->diff1;
+    
+            delta = chip_diff1 >= chip->diff1_seen ? chip_diff1 - chip->diff1_seen : chip_diff1;
+            chip->diff1_seen = chip_diff1;
+    
+            hashrate_ewma(chip->ghs, delta, dt, alpha);
+        }
     }
+    
+    hashrate_ewma(info->total_ghs, total, dt, alpha);
+    info->total_hashrate = (uint64_t)(info->total_ghs[AVALON10_HASHRATE_5S] * 1e9f);
+    info->total_hashrate_avg = (uint64_t)(info->total_diff1 * 4294967296.0 / elapsed);
 }
 
+/* ===========================================================================
+ * УПРАВЛЕНИЕ ВЕНТИЛЯТОРАМИ
+ * =========================================================================== */
+
 /**
  * @brief Установка скорости вентилятора
  * 
@@ -864,16 +1387,11 @@ int avalon10_set_fan_speed(avalon10_info_t *info, int fan_id, int speed)
     if (speed < 0) speed = 0;
     if (speed > 100) speed = 100;
     
-#if MOCK_ASIC
-    /* В режиме эмуляции просто сохраняем значение */
+    if (fan_set_pwm(fan_id, speed) != 0) {
+        return -1;
+    }
+    
     log_message(LOG_DEBUG, "%s: Вентилятор %d: %d%%", TAG, fan_id, speed);
-#else
-    /* Реальная установка PWM */
-    /* TODO: Реализовать для реального железа */
-    /* Duty cycle = speed (0-100%) -> PWM (0-1.0) */
-    /* double duty = speed / 100.0; */
-    log_message(LOG_DEBUG, "%s: Вентилятор %d: %d%% (PWM not implemented)", TAG, fan_id, speed);
-#endif
     
     info->fan_pwm[fan_id] = speed;
     
@@ -928,6 +1446,11 @@ int avalon10_set_freq(avalon10_info_t *info, int module_id, int freq)
                 info->modules[i].freq[j] = freq;
             }
             
+            /* Пакет с opt = 0 меняет частоту всех чипов модуля */
+            for (int j = 0; j < AVALON10_DEFAULT_MINER_CNT; j++) {
+                info->modules[i].chips[j].freq = freq;
+            }
+            
             log_message(LOG_INFO, "%s: Модуль %d: частота %d MHz", TAG, i, freq);
         }
     }
@@ -935,6 +1458,92 @@ int avalon10_set_freq(avalon10_info_t *info, int module_id, int freq)
     return 0;
 }
 
+/**
+ * @brief Установка частоты одного чипа
+ * 
+ * @param info      Указатель на структуру информации
+ * @param module_id ID модуля
+ * @param chip_id   Номер чипа
+ * @param freq      Частота (MHz)
+ * @return          0 при успехе, -1 при ошибке
+ */
+int avalon10_set_chip_freq(avalon10_info_t *info, int module_id, int chip_id, int freq)
+{
+    avalon10_pkg_t pkg;
+    uint32_t tmp;
+    
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        chip_id < 0 || chip_id >= AVALON10_DEFAULT_MINER_CNT ||
+        info->modules[module_id].state == AVALON10_MODULE_STATE_NONE) {
+        return -1;
+    }
+    
+    if (freq < AVALON10_DEFAULT_FREQ_MIN) freq = AVALON10_DEFAULT_FREQ_MIN;
+    if (freq > AVALON10_DEFAULT_FREQ_MAX) freq = AVALON10_DEFAULT_FREQ_MAX;
+    
+    memset(&pkg, 0, sizeof(pkg));
+    tmp = freq;  /* Big-endian формат */
+    pkg.data[0] = (tmp >> 24) & 0xFF;
+    pkg.data[1] = (tmp >> 16) & 0xFF;
+    pkg.data[2] = (tmp >> 8) & 0xFF;
+    pkg.data[3] = tmp & 0xFF;
+    
+    build_pkg(&pkg, AVALON10_P_SET_FREQ, 1, 1);
+    pkg.opt = chip_id + 1;  /* CRC считается только по data */
+    
+    if (send_pkg(module_id, &pkg) != 0) {
+        return -1;
+    }
+    
+    info->modules[module_id].chips[chip_id].freq = freq;
+    
+    log_message(LOG_DEBUG, "%s: Модуль %d чип %d: частота %d MHz", TAG, module_id, chip_id, freq);
+    
+    return 0;
+}
+
+/**
+ * @brief Включение или выключение чипа
+ * 
+ * Выключенный чип модуль не получает заданий; счётчики чипа сохраняются.
+ */
+int avalon10_set_chip_enable(avalon10_info_t *info, int module_id, int chip_id, int enable)
+{
+    avalon10_module_t *module;
+    avalon10_pkg_t pkg;
+    int active = 0;
+    
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        chip_id < 0 || chip_id >= AVALON10_DEFAULT_MINER_CNT ||
+        info->modules[module_id].state == AVALON10_MODULE_STATE_NONE) {
+        return -1;
+    }
+    module = &info->modules[module_id];
+    
+    memset(&pkg, 0, sizeof(pkg));
+    pkg.data[0] = enable ? 1 : 0;
+    build_pkg(&pkg, AVALON10_P_SET_MINING, 1, 1);
+    pkg.opt = chip_id + 1;  /* CRC считается только по data */
+    
+    if (send_pkg(module_id, &pkg) != 0) {
+        return -1;
+    }
+    
+    module->chips[chip_id].enabled = enable ? 1 : 0;
+    module->chips[chip_id].error_count = 0;
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MINER_CNT; i++) {
+        active += module->chips[i].enabled;
+    }
+    module->active_chips = active;
+    module->failed_chips = AVALON10_DEFAULT_MINER_CNT - active;
+    
+    log_message(LOG_DEBUG, "%s: Модуль %d чип %d: %s", TAG, module_id, chip_id,
+               enable ? "включён" : "выключен");
+    
+    return 0;
+}
+
 /**
  * @brief Установка напряжения модуля
  * 
@@ -987,12 +1596,51 @@ int avalon10_set_voltage(avalon10_info_t *info, int module_id, int voltage)
  * РАБОТА С ЗАДАНИЯМИ
  * =========================================================================== */
 
+/**
+ * @brief Следующий заголовок текущего задания
+ * 
+ * Каждый заголовок очереди - тот же шаблон задания со следующим
+ * ExtraNonce2 (свой корень Меркла), поэтому модули и чипы не повторяют
+ * перебор друг друга. Снимок публикуется в validator до отправки, чтобы
+ * первые же nonce нашли задание.
+ * 
+ * @param info      Указатель на структуру информации
+ * @param type      AVALON10_P_WORK (очистить очередь) или AVALON10_P_WORK_TO_CHIP
+ * @param pkgs      Пакеты заголовка (AVALON10_WORK_PKTS)
+ * @param pkgp      Указатели на пакеты для транспорта
+ */
+static void next_header(avalon10_info_t *info, uint8_t type,
+                        avalon10_pkg_t *pkgs, const avalon10_pkg_t **pkgp)
+{
+    uint8_t job_idx = (uint8_t)(info->work_id + 1);
+    
+    work_increment_nonce2(&queue_work);
+    work_to_header(&queue_work);
+    validator_job_publish(job_idx, &queue_work);
+    
+    /* Байты 0-31, 32-63 и 64-79 (+ нулевое дополнение) заголовка */
+    memset(pkgs, 0, AVALON10_WORK_PKTS * sizeof(*pkgs));
+    for (int p = 0; p < AVALON10_WORK_PKTS; p++) {
+        int off = p * AVALON10_PKG_DATA_LEN;
+    
+        memcpy(pkgs[p].data, queue_work.header + off,
+               MIN(AVALON10_PKG_DATA_LEN, AVALON10_WORK_HEADER_LEN - off));
+        build_pkg(&pkgs[p], type, p + 1, AVALON10_WORK_PKTS);
+        pkgs[p].opt = job_idx;
+        pkgp[p] = &pkgs[p];
+    }
+    
+    info->work_id++;
+}
+
 /**
  * @brief Отправка работы на все модули
  * 
- * Формирует пакеты с заголовком блока и отправляет на все активные модули.
- * Так как заголовок блока = 80 байт, а data в пакете = 32 байта,
- * заголовок разбивается на 3 пакета (32 + 32 + 16).
+ * Новое задание сбрасывает очереди модулей: первый заголовок уходит
+ * пакетами AVALON10_P_WORK, остальные до info->work_depth - пакетами
+ * AVALON10_P_WORK_TO_CHIP. Так как заголовок блока = 80 байт, а data в
+ * пакете = 32 байта, заголовок разбивается на 3 пакета (32 + 32 + 16),
+ * которые уходят одной передачей транспорта.
  * 
  * @param info      Указатель на структуру информации
  * @param work      Указатель на рабочее задание
@@ -1000,42 +1648,95 @@ int avalon10_set_voltage(avalon10_info_t *info, int module_id, int voltage)
  */
 int avalon10_send_work(avalon10_info_t *info, work_t *work)
 {
-    avalon10_pkg_t pkg;
-    int pkt_count = 3;  /* 80 байт / 32 = 3 пакета (32+32+16) */
+    avalon10_pkg_t pkgs[AVALON10_WORK_PKTS];
+    const avalon10_pkg_t *pkgp[AVALON10_WORK_PKTS];
     
     if (!work) {
         return -1;
     }
     
+    if (info->work_id == 0) {
+        cgminer_boot_mark("первое задание");
+    }
+    
+    /* Шаблон для заголовков очереди - копия: задание пула освобождается
+     * при смене задания независимо от драйвера */
+    memcpy(&queue_work, work, sizeof(queue_work));
+    queue_work.next = NULL;
+    queue_work_valid = 1;
+    
     for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
-        if (info->modules[i].state == AVALON10_MODULE_STATE_MINING) {
-            
-            /* Пакет 1: байты 0-31 заголовка */
-            memset(&pkg, 0, sizeof(pkg));
-            memcpy(pkg.data, work->header, 32);
-            build_pkg(&pkg, AVALON10_P_WORK, 1, pkt_count);
-            send_pkg(i, &pkg);
-            
-            /* Пакет 2: байты 32-63 заголовка */
-            memset(&pkg, 0, sizeof(pkg));
-            memcpy(pkg.data, work->header + 32, 32);
-            build_pkg(&pkg, AVALON10_P_WORK, 2, pkt_count);
-            send_pkg(i, &pkg);
-            
-            /* Пакет 3: байты 64-79 заголовка (16 байт) + padding */
-            memset(&pkg, 0, sizeof(pkg));
-            memcpy(pkg.data, work->header + 64, 16);
-            build_pkg(&pkg, AVALON10_P_WORK, 3, pkt_count);
-            send_pkg(i, &pkg);
+        avalon10_module_t *module = &info->modules[i];
+    
+        if (module->state != AVALON10_MODULE_STATE_MINING) {
+            continue;
+        }
+    
+        for (int d = 0; d < info->work_depth; d++) {
+            next_header(info, d ? AVALON10_P_WORK_TO_CHIP : AVALON10_P_WORK, pkgs, pkgp);
+            asic_xport_send(i, pkgp, AVALON10_WORK_PKTS);
         }
+    
+        module->work_queued = info->work_depth;
+        module->refill_seq = module->status_seq;
     }
     
     info->current_work = work;
-    info->work_id++;
     
     return 0;
 }
 
+/**
+ * @brief Пополнение очередей заданий модулей
+ */
+int avalon10_refill_work(avalon10_info_t *info)
+{
+    avalon10_pkg_t pkgs[AVALON10_WORK_PKTS];
+    const avalon10_pkg_t *pkgp[AVALON10_WORK_PKTS];
+    int sent = 0;
+    
+    if (!queue_work_valid) {
+        return 0;
+    }
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        avalon10_module_t *module = &info->modules[i];
+        int need;
+    
+        if (module->state != AVALON10_MODULE_STATE_MINING) {
+            continue;
+        }
+    
+        /* Заполненность берётся из STATUS, запрошенного уже после прошлого
+         * пополнения: STATUS в полёте мог не застать досланные заголовки */
+        if (module->status_seq - module->refill_seq < 2) {
+            continue;
+        }
+    
+        /* Скважность снижения по температуре: вне окна очередь пустеет */
+        if (!throttle_work_allowed(i)) {
+            continue;
+        }
+    
+        need = info->work_depth - module->work_queued;
+        if (need <= 0) {
+            continue;
+        }
+    
+        for (int d = 0; d < need; d++) {
+            next_header(info, AVALON10_P_WORK_TO_CHIP, pkgs, pkgp);
+            asic_xport_send(i, pkgp, AVALON10_WORK_PKTS);
+        }
+    
+        module->work_queued += need;
+        module->work_refills += need;
+        module->refill_seq = module->status_seq;
+        sent += need;
+    }
+    
+    return sent;
+}
+
 /**
  * @brief Проверка nonce
  * 
@@ -1063,8 +1764,7 @@ int avalon10_check_nonce(work_t *work, uint32_t nonce)
     header[79] = (nonce >> 24) & 0xFF;
     
     /* 3. Вычисляем SHA256d (двойной SHA256) */
-    extern void mock_sha256d(const uint8_t *data, size_t len, uint8_t *hash);
-    mock_sha256d(header, 80, hash);
+    hasher_sha256d(header, 80, hash);
     
     /* 4. Сравниваем с target (hash должен быть меньше target)
      * Bitcoin хэши сравниваются как big-endian числа,
@@ -1112,6 +1812,39 @@ void avalon10_print_stats(avalon10_info_t *info, int module_id)
                (unsigned long)module->hw_errors);
 }
 
+/**
+ * @brief Формирование пакета запроса с нулевыми данными
+ * 
+ * @param pkg       Пакет
+ * @param type      Тип пакета (AVALON10_P_*)
+ */
+void avalon10_pkg_request(avalon10_pkg_t *pkg, uint8_t type)
+{
+    memset(pkg, 0, sizeof(*pkg));
+    build_pkg(pkg, type, 1, 1);
+}
+
+/**
+ * @brief Проверка заголовка и CRC16 принятого пакета
+ * 
+ * Используется транспортами, собирающими пакеты из потока байт (auc_uart.c).
+ * 
+ * @param pkg       Пакет
+ * @return          1 если заголовок 'CN' и CRC16 по data[32] верны
+ */
+int avalon10_pkg_valid(const avalon10_pkg_t *pkg)
+{
+    uint16_t crc;
+    
+    if (pkg->head[0] != AVALON10_PKT_HEAD1 || pkg->head[1] != AVALON10_PKT_HEAD2) {
+        return 0;
+    }
+    
+    crc = calc_crc16(pkg->data, AVALON10_PKG_DATA_LEN);
+    
+    return pkg->crc[0] == ((crc >> 8) & 0xff) && pkg->crc[1] == (crc & 0xff);
+}
+
 /**
  * @brief Получение строки состояния модуля
  * 
@@ -35,6 +35,8 @@
 
 #include <stdint.h>         /* Типы данных фиксированного размера */
 #include <stdbool.h>        /* Булевы типы */
+#include <FreeRTOS.h>
+#include <task.h>           /* TaskHandle_t для задачи опроса */
 #include "cgminer.h"        /* Общие определения CGMiner */
 
 /* ===========================================================================
@@ -80,6 +82,17 @@
  */
 #define AVALON10_TOTAL_CORES            (AVALON10_DEFAULT_MODULARS * AVALON10_CORES_PER_MODULE)
 
+/**
+ * @brief Хэшей за такт на ядро
+ * 456 чипов × 72 ядра × 4 × 500 MHz ≈ 66 TH/s (паспорт A1126pro - 68 TH/s)
+ */
+#define AVALON10_CORE_HASHES_PER_CLK    4
+
+/**
+ * @brief Слов в маске ядер чипа (бит на ядро)
+ */
+#define AVALON10_CORE_MASK_WORDS        ((AVALON10_DEFAULT_ASIC_CORE + 31) / 32)
+
 /* ---------------------------------------------------------------------------
  * Настройки частоты (в MHz)
  * --------------------------------------------------------------------------- */
@@ -259,6 +272,7 @@
 
 /**
  * @brief Установка частоты чипа
+ * opt = 0 - все чипы модуля, opt = N - только чип N - 1
  */
 #define AVALON10_P_SET_FREQ             0x20
 
@@ -274,6 +288,8 @@
 
 /**
  * @brief Запуск/остановка майнинга
+ * opt = 0 - весь модуль, opt = N - только чип N - 1: выключенный чип
+ * модуль исключает из раздачи заданий
  */
 #define AVALON10_P_SET_MINING           0x23
 
@@ -355,11 +371,140 @@
  */
 #define AVALON10_RESET_TIMEOUT_MS       5000
 
+/**
+ * @brief Окно коротких проб обнаружения модулей
+ * Модули опрашиваются параллельно раз в тик; модуль, по которому
+ * транспорт AVALON10_DETECT_FAIL_PROBES раз подряд вернул ошибку,
+ * считается отсутствующим уже в этом окне
+ */
+#define AVALON10_DETECT_PROBE_MS        200
+#define AVALON10_DETECT_FAIL_PROBES     3
+
+/**
+ * @brief Общее окно подтверждения для молчащих модулей (от начала обнаружения)
+ * Одно на все модули, а не на каждый
+ */
+#define AVALON10_DETECT_CONFIRM_MS      AVALON10_RESET_TIMEOUT_MS
+
+/**
+ * @brief Таймаут ожидания буфера и завершения кадра SPI
+ * Кадр 40 байт на 10 МГц занимает 32 мкс, запас - на очередь кадров
+ */
+#define AVALON10_SPI_TIMEOUT_MS         20
+
+/**
+ * @brief Таймаут ответов на пакет запросов (любой транспорт)
+ * Пакет AUC на 3 Mbaud идёт 133 мкс, запас - на очередь и повторы
+ */
+#define AVALON10_XPORT_TIMEOUT_MS       20
+
 /**
  * @brief Интервал обновления статистики
  */
 #define AVALON10_STATS_INTERVAL_MS      1000
 
+/* ---------------------------------------------------------------------------
+ * Отправка работы
+ * --------------------------------------------------------------------------- */
+
+/**
+ * @brief Длина заголовка блока в задании (байт)
+ */
+#define AVALON10_WORK_HEADER_LEN        80
+
+/**
+ * @brief Пакетов AVALON10_P_WORK на задание (32 + 32 + 16 байт заголовка)
+ */
+#define AVALON10_WORK_PKTS              3
+
+/**
+ * @brief Очередь заданий модуля (заголовков)
+ * AVALON10_P_WORK очищает очередь и ставит первый заголовок,
+ * AVALON10_P_WORK_TO_CHIP добавляет заголовок в конец. Перебрав nonce
+ * заголовка, чип берёт следующий из очереди без участия контроллера.
+ */
+#define AVALON10_WORK_QUEUE_MAX         4
+#define AVALON10_WORK_QUEUE_DEFAULT     2
+
+/**
+ * @brief Поля ответа AVALON10_P_STATUS об очереди заданий (индексы data[])
+ */
+#define AVALON10_STATUS_WORK_QUEUED     8   /* Заголовков в очереди (минимум по чипам) */
+#define AVALON10_STATUS_IDLE_CHIPS      9   /* Чипов без задания */
+#define AVALON10_STATUS_POWER           10  /* Мощность модуля, Вт (2 байта BE, 0 = нет телеметрии) */
+
+/* ---------------------------------------------------------------------------
+ * Выгрузка nonce из FIFO модуля
+ * --------------------------------------------------------------------------- */
+
+/**
+ * @brief Количество nonce-записей в одном пакете AVALON10_P_NONCE
+ * Поле data[32] содержит 4 записи по 8 байт
+ */
+#define AVALON10_NONCE_PER_PKG          4
+
+/**
+ * @brief Размер одной nonce-записи в поле data
+ * [0-3] nonce (big-endian), [4] chip_id, [5] core_id, [6] job_idx, [7] flags
+ */
+#define AVALON10_NONCE_REC_LEN          8
+
+/**
+ * @brief Флаг записи: запись содержит действительный nonce
+ */
+#define AVALON10_NONCE_FLAG_VALID       0x01
+
+/**
+ * @brief Максимум пакетов NONCE за один проход выгрузки модуля
+ * Ограничивает время удержания шины одним модулем (64 × 4 = 256 nonce)
+ */
+#define AVALON10_NONCE_DRAIN_MAX        64
+
+/**
+ * @brief Период аппаратного таймера опроса (мкс)
+ * Таймер будит задачу опроса ASIC вместо тика планировщика (10 мс)
+ */
+#define AVALON10_POLL_INTERVAL_US       2000
+
+/**
+ * @brief Аппаратный таймер опроса
+ * timer0..3 занят ШИМ вентиляторов, используем первый канал TIMER1
+ */
+#define AVALON10_POLL_TIMER_DEV         "/dev/timer4"
+
+/* ---------------------------------------------------------------------------
+ * Статистика чипов
+ * --------------------------------------------------------------------------- */
+
+/**
+ * @brief Чип считается слабым, если доля HW ошибок выше порога (%)
+ * при не менее AVALON10_CHIP_WEAK_MIN_NONCES nonce
+ */
+#define AVALON10_CHIP_WEAK_HW_PCT       5
+#define AVALON10_CHIP_WEAK_MIN_NONCES   32
+
+/**
+ * @brief Результат проверки nonce для avalon10_chip_account()
+ */
+#define AVALON10_NONCE_HW_ERROR         -1  /* Не прошёл сложность 1 */
+#define AVALON10_NONCE_DIFF1            0   /* Прошёл сложность 1 */
+#define AVALON10_NONCE_SHARE            1   /* Прошёл цель пула */
+
+/* ---------------------------------------------------------------------------
+ * Хэшрейт
+ * --------------------------------------------------------------------------- */
+
+/**
+ * @brief Окна EWMA хэшрейта (индексы массивов ghs[])
+ * 
+ * Постоянные времени: 5 с, 1 мин, 5 мин, 15 мин.
+ */
+#define AVALON10_HASHRATE_WINDOWS       4
+#define AVALON10_HASHRATE_5S            0
+#define AVALON10_HASHRATE_1M            1
+#define AVALON10_HASHRATE_5M            2
+#define AVALON10_HASHRATE_15M           3
+
 /* ===========================================================================
  * СТРУКТУРЫ ДАННЫХ
  * =========================================================================== */
@@ -373,13 +518,20 @@
 typedef struct avalon10_chip {
     uint8_t chip_id;            /* ID чипа (0-113) */
     uint8_t enabled;            /* 1 = чип активен */
-    uint8_t error_count;        /* Счётчик ошибок */
+    uint8_t error_count;        /* HW ошибок подряд (до 255) */
     
     uint16_t freq;              /* Текущая частота (MHz) */
     int16_t temp;               /* Температура чипа (°C × 10) */
     
-    uint32_t nonces;            /* Количество найденных nonce */
+    uint32_t nonces;            /* Проверено nonce от чипа */
     uint32_t hw_errors;         /* Аппаратные ошибки */
+    uint32_t diff1;             /* Nonce сложности 1 (единицы работы 2^32 хэшей) */
+    uint32_t shares;            /* Nonce, прошедшие цель пула */
+    
+    uint32_t diff1_seen;        /* diff1 на прошлом замере хэшрейта */
+    float ghs[AVALON10_HASHRATE_WINDOWS];   /* EWMA хэшрейта (GH/s) */
+    
+    uint32_t core_seen[AVALON10_CORE_MASK_WORDS];   /* Ядра с nonce сложности 1 (окно yieldmon) */
 } avalon10_chip_t;
 
 /**
@@ -396,6 +548,7 @@ typedef struct avalon10_module {
     uint8_t module_id;              /* ID модуля (0-3) */
     uint8_t state;                  /* Состояние (AVALON10_MODULE_STATE_*) */
     uint8_t enabled;                /* 1 = модуль активен */
+    uint8_t xport;                  /* Транспорт пакетов (ASIC_XPORT_*) */
     
     /* ------------------------------------------
      * Настройки
@@ -412,11 +565,19 @@ typedef struct avalon10_module {
     int16_t temp_max;               /* Максимальная температура */
     int16_t temp_avg;               /* Средняя температура */
     
+    /* ------------------------------------------
+     * Питание
+     * ------------------------------------------ */
+    uint16_t power;                 /* Мощность по телеметрии (Вт, 0 = нет) */
+    
     /* ------------------------------------------
      * Статистика
      * ------------------------------------------ */
-    uint64_t hashrate;              /* Текущий хэшрейт (H/s) */
-    uint64_t hashrate_avg;          /* Средний хэшрейт */
+    uint64_t hashrate;              /* Хэшрейт за 5 с (H/s) */
+    uint64_t hashrate_avg;          /* Средний хэшрейт с начала работы (H/s) */
+    uint64_t diff1;                 /* Nonce сложности 1 (все чипы) */
+    uint64_t diff1_seen;            /* diff1 на прошлом замере хэшрейта */
+    float ghs[AVALON10_HASHRATE_WINDOWS];   /* EWMA хэшрейта (GH/s) */
     uint32_t accepted;              /* Принятые шары */
     uint32_t rejected;              /* Отклонённые шары */
     uint32_t hw_errors;             /* Аппаратные ошибки */
@@ -433,7 +594,27 @@ typedef struct avalon10_module {
      * Служебные данные
      * ------------------------------------------ */
     uint32_t last_poll;             /* Время последнего опроса */
-    uint8_t poll_errors;            /* Ошибки опроса подряд */
+    uint8_t poll_errors;            /* Ошибки опроса подряд (до 255) */
+    uint32_t bad_replies;           /* Опросов без STATUS в ответе (CRC, заголовок) */
+    
+    /* ------------------------------------------
+     * Очередь nonce модуля
+     * ------------------------------------------ */
+    uint16_t nonce_backlog;         /* Nonce в FIFO модуля после опроса */
+    uint16_t nonce_backlog_max;     /* Максимум nonce_backlog */
+    uint32_t nonce_drained;         /* Всего выгружено nonce */
+    uint32_t drain_overruns;        /* Проходы, упёршиеся в AVALON10_NONCE_DRAIN_MAX */
+    uint32_t bad_chip_ids;          /* Nonce с номером чипа вне модуля */
+    
+    /* ------------------------------------------
+     * Очередь заданий модуля
+     * ------------------------------------------ */
+    uint8_t work_queued;            /* Заголовков в очереди (по STATUS) */
+    uint8_t idle_chips;             /* Чипов без задания (по STATUS) */
+    uint32_t status_seq;            /* Принятых ответов STATUS */
+    uint32_t refill_seq;            /* status_seq при последнем пополнении */
+    uint32_t work_refills;          /* Заголовков, добавленных в очередь */
+    uint32_t work_starved;          /* Опустошений очереди во время майнинга */
 } avalon10_module_t;
 
 /**
@@ -471,7 +652,12 @@ typedef struct avalon10_info {
     /* ------------------------------------------
      * Глобальная статистика
      * ------------------------------------------ */
-    uint64_t total_hashrate;        /* Общий хэшрейт (H/s) */
+    uint64_t total_hashrate;        /* Общий хэшрейт за 5 с (H/s) */
+    uint64_t total_hashrate_avg;    /* Средний с начала работы (H/s) */
+    uint64_t total_diff1;           /* Nonce сложности 1 (все модули) */
+    float total_ghs[AVALON10_HASHRATE_WINDOWS];     /* EWMA хэшрейта (GH/s) */
+    uint64_t hashrate_start_us;     /* Первый замер хэшрейта */
+    uint64_t hashrate_at_us;        /* Последний замер хэшрейта */
     uint64_t total_accepted;        /* Всего принято */
     uint64_t total_rejected;        /* Всего отклонено */
     uint64_t total_hw_errors;       /* Всего HW ошибок */
@@ -494,6 +680,7 @@ typedef struct avalon10_info {
      * ------------------------------------------ */
     work_t *current_work;           /* Текущее задание */
     uint32_t work_id;               /* ID текущей работы */
+    uint8_t work_depth;             /* Глубина очереди заданий модуля */
 } avalon10_info_t;
 
 /**
@@ -527,6 +714,23 @@ typedef struct avalon10_pkg {
 /* Размер данных в пакете */
 #define AVALON10_PKG_DATA_LEN   32
 
+/**
+ * @struct avalon10_nonce_rec_t
+ * @brief Одна nonce-запись из пакета AVALON10_P_NONCE
+ * 
+ * Ответ на AVALON10_P_NONCE:
+ * opt  - количество записей в data (0..AVALON10_NONCE_PER_PKG)
+ * cnt  - сколько nonce ещё осталось в FIFO модуля (насыщение 255)
+ * data - AVALON10_NONCE_PER_PKG записей по AVALON10_NONCE_REC_LEN байт
+ */
+typedef struct avalon10_nonce_rec {
+    uint32_t nonce;                 /* Найденный nonce */
+    uint8_t chip_id;                /* Чип, нашедший nonce */
+    uint8_t core_id;                /* Ядро чипа */
+    uint8_t job_idx;                /* Младшие 8 бит work_id задания */
+    uint8_t flags;                  /* AVALON10_NONCE_FLAG_* */
+} avalon10_nonce_rec_t;
+
 /* ===========================================================================
  * ПРОТОТИПЫ ФУНКЦИЙ
  * =========================================================================== */
@@ -545,6 +749,14 @@ typedef struct avalon10_pkg {
  */
 int avalon10_init(avalon10_info_t *info);
 
+/**
+ * @brief Запуск майнинга на всех готовых модулях
+ * 
+ * @param info      Указатель на структуру информации
+ * @return          Количество модулей, перешедших в майнинг
+ */
+int avalon10_start_mining(avalon10_info_t *info);
+
 /**
  * @brief Деинициализация драйвера
  * 
@@ -563,6 +775,39 @@ void avalon10_exit(avalon10_info_t *info);
  */
 int avalon10_reset(avalon10_info_t *info, int module_id);
 
+/**
+ * @brief Сброс одного модуля без ожидания загрузки
+ * 
+ * Модуль переходит в AVALON10_MODULE_STATE_INIT и не опрашивается,
+ * настройки чипов в структуре модуля сохраняются.
+ * 
+ * @param info      Указатель на структуру информации
+ * @param module_id ID модуля
+ * @return          0 при успехе, -1 при ошибке
+ */
+int avalon10_reset_module(avalon10_info_t *info, int module_id);
+
+/**
+ * @brief Возврат модуля в майнинг после сброса
+ * 
+ * Если модуль отвечает на DETECT, ему заново отправляются напряжение,
+ * частоты и выключенные чипы из структуры модуля и AVALON10_P_SET_MINING.
+ * 
+ * @param info      Указатель на структуру информации
+ * @param module_id ID модуля
+ * @return          0 - модуль в майнинге, -1 - модуль ещё не ответил
+ */
+int avalon10_restore_module(avalon10_info_t *info, int module_id);
+
+/**
+ * @brief Ожидаемое число nonce сложности 1 модуля в секунду
+ * 
+ * По частотам включённых чипов: f · ядра · AVALON10_CORE_HASHES_PER_CLK / 2^32.
+ * 
+ * @param module    Модуль
+ */
+float avalon10_expected_diff1(const avalon10_module_t *module);
+
 /* ---------------------------------------------------------------------------
  * Опрос и статистика
  * --------------------------------------------------------------------------- */
@@ -578,6 +823,33 @@ int avalon10_reset(avalon10_info_t *info, int module_id);
  */
 int avalon10_poll(avalon10_info_t *info);
 
+/**
+ * @brief Запуск аппаратного таймера опроса
+ * 
+ * Таймер AVALON10_POLL_TIMER_DEV из прерывания будит задачу task
+ * (task notification). Задача ждёт пробуждения в avalon10_poll_wait().
+ * 
+ * @param task          Задача опроса ASIC
+ * @param interval_us   Период таймера (мкс)
+ * @return              0 при успехе, -1 если таймер недоступен
+ */
+int avalon10_poll_timer_start(TaskHandle_t task, uint32_t interval_us);
+
+/**
+ * @brief Остановка аппаратного таймера опроса
+ */
+void avalon10_poll_timer_stop(void);
+
+/**
+ * @brief Ожидание следующего тика таймера опроса
+ * 
+ * Без запущенного таймера работает как обычная задержка.
+ * 
+ * @param timeout_ms    Максимальное время ожидания (мс)
+ * @return              1 если разбужены таймером, 0 по таймауту
+ */
+int avalon10_poll_wait(uint32_t timeout_ms);
+
 /**
  * @brief Чтение температуры со всех датчиков
  * 
@@ -596,7 +868,11 @@ int avalon10_read_temperature(avalon10_info_t *info);
 void avalon10_check_overheat(avalon10_info_t *info);
 
 /**
- * @brief Расчёт и обновление хэшрейта
+ * @brief Замер хэшрейта по проверенным nonce (раз в секунду, задача monitor)
+ * 
+ * Обновляет EWMA чипов, модулей и общий хэшрейт. Пишет только задача
+ * monitor; каждое значение - одно выровненное слово, читатели (API)
+ * обходятся без блокировки.
  * 
  * @param info      Указатель на структуру информации
  */
@@ -606,15 +882,6 @@ void avalon10_update_hashrate(avalon10_info_t *info);
  * Управление вентиляторами
  * --------------------------------------------------------------------------- */
 
-/**
- * @brief Регулировка скорости вентиляторов
- * 
- * Использует PID-регулятор для поддержания целевой температуры.
- * 
- * @param info      Указатель на структуру информации
- */
-void avalon10_adjust_fan(avalon10_info_t *info);
-
 /**
  * @brief Установка скорости вентилятора
  * 
@@ -639,6 +906,28 @@ int avalon10_set_fan_speed(avalon10_info_t *info, int fan_id, int speed);
  */
 int avalon10_set_freq(avalon10_info_t *info, int module_id, int freq);
 
+/**
+ * @brief Установка частоты одного чипа
+ * 
+ * @param info      Указатель на структуру информации
+ * @param module_id ID модуля
+ * @param chip_id   Номер чипа
+ * @param freq      Частота (MHz)
+ * @return          0 при успехе, -1 при ошибке
+ */
+int avalon10_set_chip_freq(avalon10_info_t *info, int module_id, int chip_id, int freq);
+
+/**
+ * @brief Включение или выключение чипа (раздача заданий модулем)
+ * 
+ * @param info      Указатель на структуру информации
+ * @param module_id ID модуля
+ * @param chip_id   Номер чипа
+ * @param enable    1 - включить, 0 - выключить
+ * @return          0 при успехе, -1 при ошибке
+ */
+int avalon10_set_chip_enable(avalon10_info_t *info, int module_id, int chip_id, int enable);
+
 /**
  * @brief Установка напряжения модуля
  * 
@@ -662,6 +951,19 @@ int avalon10_set_voltage(avalon10_info_t *info, int module_id, int voltage);
  */
 int avalon10_send_work(avalon10_info_t *info, work_t *work);
 
+/**
+ * @brief Пополнение очередей заданий модулей
+ * 
+ * Модулю, у которого по последнему STATUS в очереди меньше
+ * info->work_depth заголовков, досылаются новые заголовки текущего
+ * задания (следующий ExtraNonce2) пакетами AVALON10_P_WORK_TO_CHIP.
+ * Вызывается из задачи mining под g_work_mutex.
+ * 
+ * @param info      Указатель на структуру информации
+ * @return          Количество отправленных заголовков
+ */
+int avalon10_refill_work(avalon10_info_t *info);
+
 /**
  * @brief Проверка nonce
  * 
@@ -673,6 +975,30 @@ int avalon10_send_work(avalon10_info_t *info, work_t *work);
  */
 int avalon10_check_nonce(work_t *work, uint32_t nonce);
 
+/* ---------------------------------------------------------------------------
+ * Статистика чипов
+ * --------------------------------------------------------------------------- */
+
+/**
+ * @brief Учёт проверенного nonce в статистике чипа
+ * 
+ * Вызывается задачей validator для каждого nonce с найденным заданием.
+ * 
+ * @param info      Указатель на структуру информации
+ * @param module_id ID модуля
+ * @param chip_id   Номер чипа из nonce-записи
+ * @param core_id   Номер ядра из nonce-записи
+ * @param result    AVALON10_NONCE_HW_ERROR / _DIFF1 / _SHARE
+ */
+void avalon10_chip_account(avalon10_info_t *info, int module_id, int chip_id, int core_id,
+                           int result);
+
+/**
+ * @brief Слабый чип: доля HW ошибок выше AVALON10_CHIP_WEAK_HW_PCT
+ * @return          1 если чип слабый
+ */
+int avalon10_chip_weak(const avalon10_chip_t *chip);
+
 /* ---------------------------------------------------------------------------
  * Отладка
  * --------------------------------------------------------------------------- */
@@ -693,6 +1019,22 @@ void avalon10_print_stats(avalon10_info_t *info, int module_id);
  */
 const char *avalon10_state_str(int state);
 
+/**
+ * @brief Формирование пакета запроса с нулевыми данными
+ * 
+ * @param pkg       Пакет
+ * @param type      Тип пакета (AVALON10_P_*)
+ */
+void avalon10_pkg_request(avalon10_pkg_t *pkg, uint8_t type);
+
+/**
+ * @brief Проверка заголовка и CRC16 принятого пакета
+ * 
+ * @param pkg       Пакет
+ * @return          1 если заголовок 'CN' и CRC16 по data[32] верны
+ */
+int avalon10_pkg_valid(const avalon10_pkg_t *pkg);
+
 #endif /* __AVALON10_H__ */
 
 /* ===========================================================================
@@ -0,0 +1,277 @@
+/**
+ * =============================================================================
+ * @file    balance.c
+ * @brief   Avalon A1126pro - Тепловая балансировка модулей (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Распределение общего бюджета хэшрейта или мощности между модулями по
+ * температуре. Доли исполняет throttle (лимит доли модуля).
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <math.h>
+#include <string.h>
+
+#include "balance.h"
+#include "cgminer.h"
+#include "efficiency.h"
+#include "throttle.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Balance";
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static balance_module_t bal[AVALON10_DEFAULT_MODULARS];
+static balance_stats_t stats;
+static float auto_budget;               /* Бюджет при g_config.balance_budget = 0 */
+static uint32_t round_at;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Доля в пределах исполнения throttle
+ */
+static float share_clamp(float s)
+{
+    if (s > 100.0f) return 100.0f;
+    if (s < THROTTLE_MIN_PCT) return THROTTLE_MIN_PCT;
+    return s;
+}
+
+/**
+ * @brief Вывод модуля из балансировки
+ */
+static void module_drop(int m)
+{
+    if (bal[m].active) {
+        throttle_set_limit(m, THROTTLE_LIMIT_BALANCE, 0.0f);
+    }
+    memset(&bal[m], 0, sizeof(bal[m]));
+}
+
+/**
+ * @brief Замер модуля в единицах бюджета при текущей доле
+ */
+static float module_measure(const avalon10_module_t *module, int mode)
+{
+    if (mode == BALANCE_MODE_POWER) {
+        return (float)efficiency_module_power(module);
+    }
+    return module->ghs[AVALON10_HASHRATE_1M];
+}
+
+/**
+ * @brief Пересчёт долей
+ */
+static void round_run(avalon10_info_t *info, int mode, uint32_t now)
+{
+    float csum = 0.0f, tsum = 0.0f, osum = 0.0f;
+    float tmin = 0.0f, tmax = 0.0f;
+    float mean, budget, u;
+    int n = 0;
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        const avalon10_module_t *module = &info->modules[m];
+        const throttle_module_t *tm = throttle_get_module(m);
+        balance_module_t *bm = &bal[m];
+        float scale = tm->engaged ? tm->applied : 100.0f;
+        float x;
+    
+        if (module->state != AVALON10_MODULE_STATE_MINING) {
+            module_drop(m);
+            continue;
+        }
+    
+        /* Оценка хэшрейта ещё не набрала данных - модуль пока вне расчёта */
+        x = module_measure(module, mode);
+        if (x <= 0.0f) {
+            continue;
+        }
+    
+        bm->active = 1;
+        bm->capacity = x * 100.0f / scale;
+        bm->temp = module->temp_max / 10.0f;
+    
+        if (!n || bm->temp < tmin) tmin = bm->temp;
+        if (!n || bm->temp > tmax) tmax = bm->temp;
+        csum += bm->capacity;
+        tsum += bm->temp * bm->capacity;
+        n++;
+    }
+    
+    if (!n) {
+        return;
+    }
+    
+    mean = tsum / csum;
+    stats.spread = tmax - tmin;
+    stats.capacity = csum;
+    
+    budget = (float)g_config.balance_budget;
+    if (budget <= 0.0f) {
+        if (auto_budget <= 0.0f) {
+            auto_budget = csum * BALANCE_BUDGET_DEFAULT_PCT / 100.0f;
+        }
+        budget = auto_budget;
+    }
+    stats.budget = budget;
+    
+    /* Поправки: горячим меньше, холодным больше, в сумме ноль */
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        balance_module_t *bm = &bal[m];
+    
+        if (!bm->active) {
+            continue;
+        }
+        if (fabsf(mean - bm->temp) > BALANCE_DEADBAND_C) {
+            bm->offset += BALANCE_GAIN * (mean - bm->temp);
+        }
+        osum += bm->offset * bm->capacity;
+    }
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        if (bal[m].active) {
+            bal[m].offset -= osum / csum;
+        }
+    }
+    
+    /* Базовая доля: то, что срезали границы, достаётся остальным */
+    u = budget * 100.0f / csum;
+    for (int iter = 0; iter < AVALON10_DEFAULT_MODULARS; iter++) {
+        float total = 0.0f, free_cap = 0.0f;
+    
+        for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+            const balance_module_t *bm = &bal[m];
+            float s;
+    
+            if (!bm->active) {
+                continue;
+            }
+            s = share_clamp(u + bm->offset);
+            total += s * bm->capacity;
+            if (s > THROTTLE_MIN_PCT && s < 100.0f) {
+                free_cap += bm->capacity;
+            }
+        }
+    
+        if (free_cap <= 0.0f || fabsf(budget * 100.0f - total) < budget * 0.01f) {
+            break;
+        }
+        u += (budget * 100.0f - total) / free_cap;
+    }
+    stats.base = u;
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        balance_module_t *bm = &bal[m];
+    
+        if (!bm->active) {
+            continue;
+        }
+    
+        /* Поправка за границами доли только накапливала бы ошибку */
+        if (u + bm->offset > 100.0f) bm->offset = 100.0f - u;
+        if (u + bm->offset < THROTTLE_MIN_PCT) bm->offset = THROTTLE_MIN_PCT - u;
+    
+        bm->share = share_clamp(u + bm->offset);
+        throttle_set_limit(m, THROTTLE_LIMIT_BALANCE, bm->share);
+    
+        log_message(LOG_DEBUG, "%s: Модуль %d: %.1f°C (средняя %.1f°C), доля %.1f%%",
+                   TAG, m, (double)bm->temp, (double)mean, (double)bm->share);
+    }
+    
+    stats.rounds++;
+    stats.at = now;
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг балансировки
+ */
+void balance_poll(avalon10_info_t *info)
+{
+    uint32_t now = cgminer_time_s();
+    int mode = g_config.balance;
+    
+    if (!info || !info->initialized) {
+        return;
+    }
+    
+    if (mode < BALANCE_MODE_OFF || mode > BALANCE_MODE_POWER) {
+        mode = BALANCE_MODE_OFF;
+    }
+    
+    /* Смена режима: бюджет и поправки в других единицах */
+    if (mode != stats.mode) {
+        balance_reset();
+        stats.mode = mode;
+        log_message(LOG_INFO, "%s: Режим %d", TAG, mode);
+    }
+    
+    if (mode == BALANCE_MODE_OFF || !info->mining_enabled) {
+        return;
+    }
+    
+    if (round_at && now - round_at < BALANCE_PERIOD_S) {
+        return;
+    }
+    round_at = now;
+    
+    round_run(info, mode, now);
+}
+
+/**
+ * @brief Сброс поправок и бюджета по умолчанию
+ */
+void balance_reset(void)
+{
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        module_drop(m);
+    }
+    auto_budget = 0.0f;
+    round_at = 0;
+    stats.budget = 0.0f;
+    stats.base = 0.0f;
+}
+
+/**
+ * @brief Доля модуля
+ */
+const balance_module_t *balance_get_module(int module_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return NULL;
+    }
+    
+    return &bal[module_id];
+}
+
+/**
+ * @brief Состояние балансировки
+ */
+const balance_stats_t *balance_get_stats(void)
+{
+    return &stats;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА balance.c
+ * =========================================================================== */
@@ -0,0 +1,139 @@
+/**
+ * =============================================================================
+ * @file    balance.h
+ * @brief   Avalon A1126pro - Тепловая балансировка модулей (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Модули настраиваются независимо, поэтому модуль с худшим обдувом
+ * упирается в снижение по температуре, пока у остальных есть запас.
+ * Балансировка держит общий бюджет - хэшрейт (GH/s) или мощность (Вт) - и
+ * перераспределяет его между модулями по температуре: доля горячих
+ * модулей уменьшается, холодных - растёт на столько же в единицах
+ * бюджета.
+ * 
+ * АЛГОРИТМ (раз в BALANCE_PERIOD_S):
+ * - Ёмкость модуля C - хэшрейт (окно 1 мин по оценке avalon10) или
+ *   мощность при 100% доли: замер, делённый на текущую долю.
+ * - Базовая доля u = бюджет / ΣC, одинаковая для всех модулей.
+ * - Поправка модуля копится: o += BALANCE_GAIN · (T̄ - T), где T̄ -
+ *   средняя по ёмкости температура, и центрируется: Σ o·C = 0.
+ * - Доля s = u + o в пределах [THROTTLE_MIN_PCT, 100]; то, что срезали
+ *   границы, раздаётся остальным модулям через u.
+ * - Доля передаётся в throttle_set_limit(): исполнение (частоты и
+ *   скважность) общее со снижением по температуре.
+ * 
+ * Расчёт не использует случайных величин и идёт по модулям в порядке
+ * номеров: при одних и тех же температурах, хэшрейте и мощности
+ * результат один и тот же.
+ * 
+ * Модуль с долей ниже 100% для autotune и efficiency выглядит как модуль в
+ * снижении: частоты чипов не подбираются, пока балансировка включена.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __BALANCE_H__
+#define __BALANCE_H__
+
+#include <stdint.h>
+
+#include "avalon10.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Режимы (g_config.balance)
+ */
+#define BALANCE_MODE_OFF            0   /* Доли не ограничиваются */
+#define BALANCE_MODE_HASHRATE       1   /* Бюджет - общий хэшрейт (GH/s) */
+#define BALANCE_MODE_POWER          2   /* Бюджет - общая мощность (Вт) */
+
+/**
+ * @brief Период пересчёта долей (секунды)
+ * Больше постоянной времени нагрева модуля, меньше окна 5 мин хэшрейта
+ */
+#define BALANCE_PERIOD_S            30
+
+/**
+ * @brief Бюджет по умолчанию - доля ёмкости при первом расчёте (%)
+ */
+#define BALANCE_BUDGET_DEFAULT_PCT  90
+
+/**
+ * @brief Накопление поправки (% доли на °C отклонения за период)
+ */
+#define BALANCE_GAIN                0.5f
+
+/**
+ * @brief Отклонение от средней, которое не исправляется (°C)
+ */
+#define BALANCE_DEADBAND_C          0.5f
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct balance_module_t
+ * @brief Доля модуля
+ */
+typedef struct balance_module {
+    uint8_t active;                 /* 1 = модуль участвует */
+    float temp;                     /* Температура при расчёте (°C) */
+    float capacity;                 /* Ёмкость при 100% доли (GH/s или Вт) */
+    float offset;                   /* Накопленная поправка (%) */
+    float share;                    /* Доля (%) */
+} balance_module_t;
+
+/**
+ * @struct balance_stats_t
+ * @brief Состояние балансировки (для API)
+ */
+typedef struct balance_stats {
+    uint8_t mode;                   /* BALANCE_MODE_* */
+    float budget;                   /* Бюджет (GH/s или Вт) */
+    float capacity;                 /* Ёмкость модулей (GH/s или Вт) */
+    float base;                     /* Базовая доля u (%) */
+    float spread;                   /* Разброс температур модулей (°C) */
+    uint32_t rounds;                /* Пересчётов */
+    uint32_t at;                    /* uptime последнего пересчёта (с) */
+} balance_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг балансировки (раз в секунду, задача monitor, после
+ *        avalon10_update_hashrate)
+ * 
+ * @param info      Указатель на структуру информации
+ */
+void balance_poll(avalon10_info_t *info);
+
+/**
+ * @brief Сброс поправок и бюджета по умолчанию
+ */
+void balance_reset(void);
+
+/**
+ * @brief Доля модуля
+ * @return          NULL при неверном номере
+ */
+const balance_module_t *balance_get_module(int module_id);
+
+/**
+ * @brief Состояние балансировки
+ */
+const balance_stats_t *balance_get_stats(void);
+
+#endif /* __BALANCE_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА balance.h
+ * =========================================================================== */
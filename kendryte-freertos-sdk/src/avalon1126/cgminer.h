@@ -254,6 +254,16 @@ typedef struct cgminer_config {
     int temp_target;                        /* Целевая температура (°C) */
     int temp_overheat;                      /* Температура перегрева (°C) */
     int temp_cutoff;                        /* Температура отключения (°C) */
+    int asic_xport[4];                      /* Транспорт модулей (ASIC_XPORT_*, 0 = SPI) */
+    int work_queue_depth;                   /* Заголовков в очереди модуля (0 = по умолчанию) */
+    int autotune;                           /* 1 = автонастройка частоты чипов */
+    int autotune_hw_budget;                 /* Бюджет HW ошибок автонастройки (‰) */
+    int efficiency;                         /* Подбор напряжения (EFFICIENCY_MODE_*) */
+    int efficiency_vmax;                    /* Верхняя граница подбора напряжения (mV) */
+    int power_cap;                          /* Лимит мощности: powercap и режим CAP (Вт, весь майнер, 0 = нет) */
+    int balance;                            /* Тепловая балансировка (BALANCE_MODE_*) */
+    int balance_budget;                     /* Бюджет балансировки (GH/s или Вт, 0 = 90% ёмкости) */
+    int hasher;                             /* Бэкенд SHA256 (HASHER_*, 0 = самый быстрый) */
     
     /* ------------------------------------------
      * Системные настройки
@@ -372,6 +382,96 @@ extern const char *pool_strategy_names[];
  */
 void log_message(int level, const char *fmt, ...);
 
+/**
+ * @brief Монотонное время в микросекундах
+ * 
+ * Источник - счётчик CLINT mtime, общий для обоих ядер K210,
+ * поэтому отметки времени сравнимы между задачами на разных ядрах.
+ * 
+ * @return Микросекунды с момента сброса
+ */
+uint64_t cgminer_time_us(void);
+
+/**
+ * @brief Монотонное время в секундах
+ * @return Секунды с момента сброса (по cgminer_time_us())
+ */
+uint32_t cgminer_time_s(void);
+
+/**
+ * @brief Верхняя граница шага циклов управления (с)
+ */
+#define CGMINER_POLL_DT_MAX     5.0f
+
+/**
+ * @brief Шаг цикла управления с прошлого вызова
+ * 
+ * Первый вызов (*at_us == 0) - номинальный шаг 1 с. Шаг ограничен
+ * [dt_min, CGMINER_POLL_DT_MAX]: после паузы задачи регулятор не делает
+ * скачка. *at_us обновляется.
+ * 
+ * @param at_us     Время прошлого вызова (мкс), 0 - не было
+ * @param now_us    Текущее время (мкс)
+ * @param dt_min    Нижняя граница шага (с)
+ * @return          Шаг (с)
+ */
+float cgminer_poll_dt(uint64_t *at_us, uint64_t now_us, float dt_min);
+
+/**
+ * @struct cgminer_window_t
+ * @brief Окно счётчиков цикла управления (autotune, health, yieldmon)
+ */
+typedef struct cgminer_window {
+    uint32_t at;                    /* Начало окна (с, 0 = окна нет) */
+    uint64_t count0;                /* Счётчик nonce в начале окна */
+    uint32_t hw0;                   /* Счётчик HW ошибок в начале окна */
+} cgminer_window_t;
+
+/**
+ * @brief Начало нового окна с текущих значений счётчиков
+ */
+void cgminer_window_start(cgminer_window_t *w, uint32_t now, uint64_t count, uint32_t hw);
+
+/**
+ * @brief Окно продолжается или начато заново
+ * 
+ * Окна нет (w->at == 0, регулятор его сбросил) или счётчик nonce меньше
+ * начального - окно начинается заново. Счётчики модуля и его чипов
+ * обнуляет повторное обнаружение модуля, разность за такое окно - мусор.
+ * 
+ * @return          1 - окно продолжается, 0 - начато заново (данных нет)
+ */
+int cgminer_window_check(cgminer_window_t *w, uint32_t now, uint64_t count, uint32_t hw);
+
+/**
+ * @brief Максимум отметок этапов загрузки
+ */
+#define CGMINER_BOOT_MARKS_MAX  16
+
+/**
+ * @brief Отметка этапа загрузки
+ */
+typedef struct cgminer_boot_mark {
+    const char *phase;          /* Название этапа (строковая константа) */
+    uint32_t ms;                /* Миллисекунд от сброса */
+} cgminer_boot_mark_t;
+
+/**
+ * @brief Отметка завершения этапа загрузки
+ * 
+ * Пишет в лог время от сброса и длительность этапа. Последняя отметка -
+ * первое задание, отправленное на ASIC.
+ * 
+ * @param phase Название этапа (строковая константа)
+ */
+void cgminer_boot_mark(const char *phase);
+
+/**
+ * @brief Отметка этапа загрузки по номеру
+ * @return Отметка или NULL, если idx за последней
+ */
+const cgminer_boot_mark_t *cgminer_boot_get(int idx);
+
 /* ===========================================================================
  * МАКРОСЫ ЛОГИРОВАНИЯ
  * 
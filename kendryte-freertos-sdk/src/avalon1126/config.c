@@ -40,6 +40,15 @@ void config_set_defaults(cgminer_config_t *cfg)
     cfg->temp_target = 75;
     cfg->temp_overheat = 95;
     cfg->temp_cutoff = 105;
+    cfg->work_queue_depth = 2;      /* AVALON10_WORK_QUEUE_DEFAULT */
+    cfg->autotune = 1;
+    cfg->autotune_hw_budget = 10;   /* AUTOTUNE_HW_BUDGET_DEFAULT */
+    cfg->efficiency = 0;            /* EFFICIENCY_MODE_OFF */
+    cfg->efficiency_vmax = 850;
+    cfg->power_cap = 0;
+    cfg->balance = 0;               /* BALANCE_MODE_OFF */
+    cfg->balance_budget = 0;
+    cfg->hasher = 0;                /* HASHER_AUTO */
     cfg->config_version = 1;
 }
 
@@ -0,0 +1,301 @@
+/**
+ * =============================================================================
+ * @file    cores.c
+ * @brief   Avalon A1126pro - Раскладка задач по ядрам K210 (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Создание задач с привязкой к ядру, реестр задач и учёт загрузки ядер.
+ * 
+ * УЧЁТ ЗАГРУЗКИ:
+ * Ядро FreeRTOS вызывает vApplicationTaskSwitchedIn() при каждом
+ * переключении контекста (traceTASK_SWITCHED_IN в FreeRTOSConfig.h).
+ * Обработчик на своём ядре прибавляет время, прошедшее с предыдущего
+ * переключения, к простою или к работе - в зависимости от того, была ли
+ * вытесненная задача задачей IDLE. Каждое ядро пишет только свой слот,
+ * поэтому блокировки не нужны; 64-битные поля на RV64 читаются атомарно.
+ * 
+ * РЕЕСТР ЗАДАЧ:
+ * Задачи создаются с обоих ядер. vTaskSuspendAll() в этом порте
+ * останавливает планировщик только своего ядра, поэтому реестр защищён
+ * taskENTER_CRITICAL(): он берёт и межъядерную блокировку порта. Записи
+ * только добавляются и не меняются, поэтому читатель берёт под
+ * блокировкой лишь их количество.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <clint.h>
+
+#include "cores.h"
+#include "cgminer.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Cores";
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ТИПЫ
+ * =========================================================================== */
+
+/**
+ * @brief Счётчики ядра (пишет только обработчик переключения своего ядра)
+ */
+typedef struct core_acct {
+    uint64_t since;                 /* mtime последнего переключения */
+    uint64_t idle_ticks;            /* Простой (такты mtime) */
+    uint64_t busy_ticks;            /* Работа (такты mtime) */
+    uint64_t switches;              /* Переключений контекста */
+    int in_idle;                    /* Сейчас выполняется IDLE */
+} core_acct_t;
+
+/**
+ * @brief Состояние окна усреднения (пишет только cores_load_update)
+ */
+typedef struct core_window {
+    uint64_t idle_ticks;            /* Простой на начало окна */
+    uint64_t busy_ticks;            /* Работа на начало окна */
+    uint32_t util;                  /* Загрузка за окно (% × 100) */
+    uint32_t util_max;              /* Максимум по окнам (% × 100) */
+} core_window_t;
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static volatile core_acct_t acct[CORES_NUM];
+static core_window_t window[CORES_NUM];
+
+static cores_task_t tasks[CORES_MAX_TASKS];
+static int task_count = 0;             /* Под taskENTER_CRITICAL() */
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Количество записей реестра
+ */
+static int task_count_get(void)
+{
+    int n;
+    
+    taskENTER_CRITICAL();
+    n = task_count;
+    taskEXIT_CRITICAL();
+    
+    return n;
+}
+
+/**
+ * @brief Перевод тактов mtime в микросекунды
+ */
+static uint64_t ticks_to_us(uint64_t ticks)
+{
+    uint64_t ticks_per_us = uxPortGetCPUClock() / CLINT_CLOCK_DIV / 1000000UL;
+    
+    if (ticks_per_us == 0) {
+        ticks_per_us = 1;
+    }
+    
+    return ticks / ticks_per_us;
+}
+
+/**
+ * @brief Снимок счётчиков ядра с учётом текущего незавершённого интервала
+ */
+static void acct_snapshot(int core, uint64_t *idle, uint64_t *busy)
+{
+    uint64_t since, now;
+    int in_idle;
+    
+    /* Повторяем, если на ядре произошло переключение во время чтения */
+    do {
+        since = acct[core].since;
+        *idle = acct[core].idle_ticks;
+        *busy = acct[core].busy_ticks;
+        in_idle = acct[core].in_idle;
+    } while (since != acct[core].since);
+    
+    now = clint->mtime;
+    if (since != 0 && now > since) {
+        if (in_idle) {
+            *idle += now - since;
+        } else {
+            *busy += now - since;
+        }
+    }
+}
+
+/* ===========================================================================
+ * ОБРАБОТЧИК ПЕРЕКЛЮЧЕНИЯ КОНТЕКСТА
+ * =========================================================================== */
+
+/**
+ * @brief Вызывается ядром FreeRTOS при переключении на новую задачу
+ * 
+ * Переопределяет слабую заглушку из os_entry.c. Выполняется в контексте
+ * планировщика - только арифметика, без вызовов API.
+ * 
+ * @param core      Ядро, на котором произошло переключение
+ * @param is_idle   1 если включается задача IDLE
+ */
+void vApplicationTaskSwitchedIn(uint32_t core, int is_idle)
+{
+    volatile core_acct_t *a;
+    uint64_t now;
+    
+    if (core >= CORES_NUM) {
+        return;
+    }
+    
+    a = &acct[core];
+    now = clint->mtime;
+    
+    if (a->since != 0 && now > a->since) {
+        if (a->in_idle) {
+            a->idle_ticks += now - a->since;
+        } else {
+            a->busy_ticks += now - a->since;
+        }
+    }
+    
+    a->in_idle = is_idle;
+    a->switches++;
+    a->since = now;
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Создание задачи, закреплённой за ядром
+ */
+int cores_task_create(TaskFunction_t fn, const char *name, uint32_t stack,
+                      void *param, UBaseType_t prio, int core,
+                      TaskHandle_t *handle)
+{
+    TaskHandle_t h = NULL;
+    
+    if (!fn || core < 0 || core >= CORES_NUM) {
+        log_message(LOG_ERR, "%s: %s: неверное ядро %d", TAG, name, core);
+        return -1;
+    }
+    
+    if (prio == 0 || prio >= configMAX_PRIORITIES) {
+        log_message(LOG_ERR, "%s: %s: приоритет %lu вне 1..%d",
+                   TAG, name, (unsigned long)prio, configMAX_PRIORITIES - 1);
+        return -1;
+    }
+    
+    if (xTaskCreateAtProcessor(core, fn, name, stack, param, prio, &h) != pdPASS) {
+        log_message(LOG_ERR, "%s: Не удалось создать задачу %s", TAG, name);
+        return -1;
+    }
+    
+    if (handle) {
+        *handle = h;
+    }
+    
+    taskENTER_CRITICAL();
+    if (task_count < CORES_MAX_TASKS) {
+        tasks[task_count].name = name;
+        tasks[task_count].handle = h;
+        tasks[task_count].core = (uint8_t)core;
+        tasks[task_count].prio = (uint8_t)prio;
+        tasks[task_count].stack = (uint16_t)stack;
+        task_count++;
+    }
+    taskEXIT_CRITICAL();
+    
+    log_message(LOG_DEBUG, "%s: %s -> ядро %d, приоритет %lu",
+               TAG, name, core, (unsigned long)prio);
+    
+    return 0;
+}
+
+/**
+ * @brief Пересчёт загрузки ядер за прошедшее окно
+ */
+void cores_load_update(void)
+{
+    for (int c = 0; c < CORES_NUM; c++) {
+        uint64_t idle, busy, d_idle, d_busy;
+    
+        acct_snapshot(c, &idle, &busy);
+    
+        d_idle = idle - window[c].idle_ticks;
+        d_busy = busy - window[c].busy_ticks;
+        window[c].idle_ticks = idle;
+        window[c].busy_ticks = busy;
+    
+        if (d_idle + d_busy == 0) {
+            continue;
+        }
+    
+        window[c].util = (uint32_t)(d_busy * 10000 / (d_idle + d_busy));
+        if (window[c].util > window[c].util_max) {
+            window[c].util_max = window[c].util;
+        }
+    }
+}
+
+/**
+ * @brief Загрузка ядра
+ */
+int cores_get_load(int core, cores_load_t *out)
+{
+    uint64_t idle, busy;
+    int n;
+    
+    if (!out || core < 0 || core >= CORES_NUM) {
+        return -1;
+    }
+    
+    acct_snapshot(core, &idle, &busy);
+    
+    memset(out, 0, sizeof(*out));
+    out->util = window[core].util;
+    out->util_max = window[core].util_max;
+    out->busy_us = ticks_to_us(busy);
+    out->idle_us = ticks_to_us(idle);
+    out->switches = acct[core].switches;
+    
+    n = task_count_get();
+    for (int i = 0; i < n; i++) {
+        if (tasks[i].core == core) {
+            out->tasks++;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Доступ к реестру задач
+ */
+const cores_task_t *cores_get_task(int index)
+{
+    if (index < 0 || index >= task_count_get()) {
+        return NULL;
+    }
+    
+    return &tasks[index];
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА cores.c
+ * =========================================================================== */
@@ -0,0 +1,158 @@
+/**
+ * =============================================================================
+ * @file    cores.h
+ * @brief   Avalon A1126pro - Раскладка задач по ядрам K210 (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * K210 имеет два ядра RV64 с отдельными планировщиками FreeRTOS: задача
+ * никогда не мигрирует и работает на том ядре, где была создана.
+ * Задачи разделены по назначению:
+ * 
+ *   Ядро 0 (CORE_NET)     - tcpip (lwIP), net_rx, stratum, api, http, watchdog
+ *   Ядро 1 (CORE_MINING)  - asic_spi, auc_rx, asic_poll, validator, mining,
+ *                           monitor, led
+ * 
+ * Тракт ASIC -> validator не делит ядро с сетью, поэтому всплеск трафика
+ * или блокирующий connect() не задерживает выгрузку nonce.
+ * 
+ * Загрузка каждого ядра считается по переключениям контекста: время,
+ * проведённое в задаче IDLE данного ядра, - простой, остальное - работа.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __CORES_H__
+#define __CORES_H__
+
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+/* ===========================================================================
+ * ЯДРА
+ * =========================================================================== */
+
+#define CORE_NET                0       /* Сеть, Stratum, API */
+#define CORE_MINING             1       /* ASIC, проверка nonce */
+#define CORES_NUM               2
+
+/* ===========================================================================
+ * ТАБЛИЦА ПРИОРИТЕТОВ
+ * 
+ * configMAX_PRIORITIES = 5: допустимы 0..4, 0 занимает IDLE.
+ * Приоритеты сравниваются только между задачами одного ядра.
+ * =========================================================================== */
+
+/* Ядро 0 */
+#define TASK_PRIO_WATCHDOG      4       /* Должен срабатывать при любой нагрузке */
+#define TASK_PRIO_STRATUM       3       /* stratum_recv / stratum_send */
+#define TASK_PRIO_NET_RX        3       /* Приём кадров Ethernet */
+#define TASK_PRIO_API           2       /* API сервер (порт 4028) */
+#define TASK_PRIO_HTTP          1       /* Веб-интерфейс */
+
+/* Ядро 1 */
+#define TASK_PRIO_ASIC_SPI      4       /* Обмен кадрами по DMA - вытесняет постановщиков */
+#define TASK_PRIO_AUC_RX        4       /* Сборка кадров AUC UART - до переполнения кольца */
+#define TASK_PRIO_ASIC_POLL     3       /* Выгрузка FIFO по таймеру */
+#define TASK_PRIO_MINING        3       /* Раздача работы на ASIC */
+#define TASK_PRIO_VALIDATOR     2       /* Проверка nonce */
+#define TASK_PRIO_MONITOR       2       /* Температура и вентиляторы */
+#define TASK_PRIO_LED           1       /* Индикация */
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Максимум задач в реестре
+ */
+#define CORES_MAX_TASKS         16
+
+/**
+ * @brief Окно усреднения загрузки ядер (мс)
+ */
+#define CORES_LOAD_WINDOW_MS    1000
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct cores_task_t
+ * @brief Запись реестра задач
+ */
+typedef struct cores_task {
+    const char *name;               /* Имя задачи */
+    TaskHandle_t handle;            /* Дескриптор */
+    uint8_t core;                   /* Ядро */
+    uint8_t prio;                   /* Приоритет */
+    uint16_t stack;                 /* Размер стека */
+} cores_task_t;
+
+/**
+ * @struct cores_load_t
+ * @brief Загрузка одного ядра
+ */
+typedef struct cores_load {
+    uint32_t util;                  /* Загрузка за последнее окно (% × 100) */
+    uint32_t util_max;              /* Максимальная загрузка за окно (% × 100) */
+    uint64_t busy_us;               /* Суммарное время работы (мкс) */
+    uint64_t idle_us;               /* Суммарное время простоя (мкс) */
+    uint64_t switches;              /* Переключений контекста */
+    uint32_t tasks;                 /* Задач из реестра на ядре */
+} cores_load_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Создание задачи, закреплённой за ядром
+ * 
+ * Приоритет вне 1..configMAX_PRIORITIES-1 считается ошибкой конфигурации:
+ * задача не создаётся.
+ * 
+ * @param fn        Функция задачи
+ * @param name      Имя задачи
+ * @param stack     Размер стека (слов)
+ * @param param     Параметр задачи
+ * @param prio      Приоритет (TASK_PRIO_*)
+ * @param core      Ядро (CORE_NET / CORE_MINING)
+ * @param handle    Дескриптор созданной задачи (может быть NULL)
+ * @return          0 при успехе, -1 при ошибке
+ */
+int cores_task_create(TaskFunction_t fn, const char *name, uint32_t stack,
+                      void *param, UBaseType_t prio, int core,
+                      TaskHandle_t *handle);
+
+/**
+ * @brief Пересчёт загрузки ядер за прошедшее окно
+ * 
+ * Вызывается периодически (раз в CORES_LOAD_WINDOW_MS) одной задачей.
+ */
+void cores_load_update(void);
+
+/**
+ * @brief Загрузка ядра
+ * @param core      Номер ядра
+ * @param out       Структура для результата
+ * @return          0 при успехе, -1 при неверном ядре
+ */
+int cores_get_load(int core, cores_load_t *out);
+
+/**
+ * @brief Доступ к реестру задач
+ * @param index     Индекс записи
+ * @return          Запись или NULL за пределами реестра
+ */
+const cores_task_t *cores_get_task(int index);
+
+#endif /* __CORES_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА cores.h
+ * =========================================================================== */
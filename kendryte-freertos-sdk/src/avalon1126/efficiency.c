@@ -0,0 +1,415 @@
+/**
+ * =============================================================================
+ * @file    efficiency.c
+ * @brief   Avalon A1126pro - Подбор напряжения по эффективности (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Шаги напряжения модуля и измерение рабочих точек. Частоты чипов на
+ * каждом шаге подбирает autotune, хэшрейт берётся из счётчика diff1
+ * модуля (его ведёт validator), мощность - из телеметрии или модели.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include "efficiency.h"
+#include "throttle.h"
+#include "autotune.h"
+#include "cgminer.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Efficiency";
+
+/* J/TH точки без хэшрейта - хуже любой измеренной */
+#define JTH_NONE    1e9f
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static efficiency_module_t eff[AVALON10_DEFAULT_MODULARS];
+static efficiency_stats_t stats;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Верхняя граница поиска (mV)
+ */
+static int voltage_max(void)
+{
+    int vmax = g_config.efficiency_vmax;
+    
+    if (vmax < AVALON10_VOLTAGE_MIN || vmax > AVALON10_VOLTAGE_MAX) {
+        vmax = AVALON10_VOLTAGE_MAX;
+    }
+    return vmax;
+}
+
+/**
+ * @brief Точка a лучше точки b
+ * 
+ * В режиме CAP точка под лимитом лучше точки над лимитом; из двух точек
+ * над лимитом лучше та, что потребляет меньше.
+ */
+static int point_better(const efficiency_point_t *a, const efficiency_point_t *b)
+{
+    int fa, fb;
+    
+    if (!b->voltage) {
+        return 1;
+    }
+    
+    if (stats.mode != EFFICIENCY_MODE_CAP || !stats.power_cap) {
+        return a->jth < b->jth;
+    }
+    
+    fa = a->power <= stats.power_cap;
+    fb = b->power <= stats.power_cap;
+    if (fa != fb) {
+        return fa;
+    }
+    return fa ? a->ghs > b->ghs : a->power < b->power;
+}
+
+/**
+ * @brief Переход к измерению точки: напряжение и подбор частот заново
+ */
+static void point_start(avalon10_info_t *info, int m, int voltage, uint32_t now)
+{
+    efficiency_module_t *em = &eff[m];
+    
+    if (info->modules[m].voltage != voltage) {
+        avalon10_set_voltage(info, m, voltage);
+        stats.changed_at = now;
+    }
+    
+    /* Потолки частот прежнего напряжения больше не действуют */
+    autotune_reset(m);
+    
+    em->voltage = voltage;
+    em->phase = EFFICIENCY_PHASE_SETTLE;
+    em->phase_at = now;
+}
+
+/**
+ * @brief Установка лучшей точки и завершение поиска
+ */
+static void search_finish(avalon10_info_t *info, int m, uint32_t now)
+{
+    efficiency_module_t *em = &eff[m];
+    avalon10_module_t *module = &info->modules[m];
+    
+    if (em->best.voltage) {
+        if (module->voltage != em->best.voltage) {
+            avalon10_set_voltage(info, m, em->best.voltage);
+            stats.changed_at = now;
+        }
+    
+        for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            if (module->chips[c].enabled && module->chips[c].freq != em->best_freq[c]) {
+                avalon10_set_chip_freq(info, m, c, em->best_freq[c]);
+            }
+        }
+        autotune_reset(m);
+    
+        log_message(LOG_INFO, "%s: Модуль %d: %d mV, %u Вт, %.1f GH/s, %.1f J/TH (%d точек)",
+                   TAG, m, em->best.voltage, em->best.power,
+                   (double)em->best.ghs, (double)em->best.jth, em->points);
+    }
+    
+    em->phase = EFFICIENCY_PHASE_DONE;
+    em->phase_at = now;
+    stats.searches++;
+}
+
+/**
+ * @brief Итог измерения точки и выбор следующей
+ */
+static void point_done(avalon10_info_t *info, int m, uint32_t now)
+{
+    efficiency_module_t *em = &eff[m];
+    avalon10_module_t *module = &info->modules[m];
+    efficiency_point_t *pt = &em->last;
+    float dt = (float)(now - em->phase_at);
+    int next;
+    
+    pt->voltage = em->voltage;
+    pt->power = em->power_n ? em->power_sum / em->power_n : 0;
+    pt->ghs = (float)(module->diff1 - em->diff1_0) * 4.294967296f / dt;
+    pt->jth = pt->ghs > 0.0f ? (float)pt->power * 1000.0f / pt->ghs : JTH_NONE;
+    em->points++;
+    
+    log_message(LOG_DEBUG, "%s: Модуль %d: %d mV, %u Вт, %.1f GH/s, %.1f J/TH",
+               TAG, m, pt->voltage, pt->power, (double)pt->ghs, (double)pt->jth);
+    
+    if (point_better(pt, &em->best)) {
+        em->best = *pt;
+        for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            em->best_freq[c] = module->chips[c].freq;
+        }
+        em->worse = 0;
+    } else {
+        em->worse++;
+    }
+    
+    next = em->voltage + em->dir * AVALON10_VOLTAGE_STEP;
+    
+    if (em->worse >= EFFICIENCY_WORSE_POINTS ||
+        next < AVALON10_VOLTAGE_MIN || next > voltage_max()) {
+        /* Вниз лучше не стало - пробуем вверх от начальной точки */
+        next = em->start_voltage + AVALON10_VOLTAGE_STEP;
+        if (em->dir < 0 && em->best.voltage == em->start_voltage && next <= voltage_max()) {
+            em->dir = 1;
+            em->worse = 0;
+        } else {
+            search_finish(info, m, now);
+            return;
+        }
+    }
+    
+    point_start(info, m, next, now);
+}
+
+/**
+ * @brief Шаг поиска одного модуля
+ */
+static void module_step(avalon10_info_t *info, int m, uint32_t power, uint32_t now)
+{
+    efficiency_module_t *em = &eff[m];
+    avalon10_module_t *module = &info->modules[m];
+    int chips = 0, settled = 0;
+    
+    switch (em->phase) {
+    case EFFICIENCY_PHASE_IDLE:
+        em->start_voltage = module->voltage;
+        em->dir = -1;
+        em->worse = 0;
+        em->points = 0;
+        memset(&em->best, 0, sizeof(em->best));
+        memset(&em->last, 0, sizeof(em->last));
+        point_start(info, m, module->voltage, now);
+        break;
+    
+    case EFFICIENCY_PHASE_SETTLE:
+        for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            if (module->chips[c].enabled) {
+                chips++;
+                settled += autotune_get_chip(m, c)->state == AUTOTUNE_CHIP_SETTLED;
+            }
+        }
+    
+        if (settled * 100 >= chips * EFFICIENCY_SETTLED_PCT ||
+            now - em->phase_at >= EFFICIENCY_SETTLE_MAX_S) {
+            em->phase = EFFICIENCY_PHASE_MEASURE;
+            em->phase_at = now;
+            em->diff1_0 = module->diff1;
+            em->power_sum = 0;
+            em->power_n = 0;
+        }
+        break;
+    
+    case EFFICIENCY_PHASE_MEASURE:
+        em->power_sum += power;
+        em->power_n++;
+    
+        if (now - em->phase_at >= EFFICIENCY_MEASURE_S) {
+            point_done(info, m, now);
+        }
+        break;
+    
+    case EFFICIENCY_PHASE_DONE:
+        if (now - em->phase_at >= EFFICIENCY_RESEARCH_S) {
+            em->phase = EFFICIENCY_PHASE_IDLE;
+        }
+        break;
+    }
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Мощность чипа по модели
+ */
+float efficiency_chip_mw(uint16_t voltage, int freq, float activity)
+{
+    float v = voltage / 1000.0f;
+    float mw;
+    
+    mw = EFFICIENCY_MODEL_DYN * v * v * freq * activity;
+    mw += (float)EFFICIENCY_MODEL_LEAK_MW * voltage / AVALON10_DEFAULT_VOLTAGE;
+    
+    return mw * 100.0f / EFFICIENCY_PSU_EFF;
+}
+
+/**
+ * @brief Мощность модуля по модели
+ */
+uint32_t efficiency_model_power(const avalon10_module_t *module)
+{
+    float mw = 0.0f;
+    
+    for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+        if (module->chips[c].enabled) {
+            mw += efficiency_chip_mw(module->voltage, module->chips[c].freq, 1.0f);
+        }
+    }
+    
+    return (uint32_t)(mw / 1000.0f);
+}
+
+/**
+ * @brief Мощность модуля: телеметрия или модель
+ */
+uint32_t efficiency_module_power(const avalon10_module_t *module)
+{
+    if (module->power && module->power <= EFFICIENCY_POWER_MAX_W) {
+        return module->power;
+    }
+    return efficiency_model_power(module);
+}
+
+/**
+ * @brief Шаг подбора
+ */
+void efficiency_poll(avalon10_info_t *info)
+{
+    uint32_t now = cgminer_time_s();
+    uint32_t power[AVALON10_DEFAULT_MODULARS];
+    uint32_t total = 0;
+    int mode = g_config.efficiency;
+    int mining = 0;
+    
+    if (!info || !info->initialized) {
+        return;
+    }
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        power[m] = 0;
+        if (info->modules[m].state == AVALON10_MODULE_STATE_MINING) {
+            power[m] = efficiency_module_power(&info->modules[m]);
+            total += power[m];
+            mining++;
+        }
+    }
+    stats.power = total;
+    
+    if (mode < EFFICIENCY_MODE_OFF || mode > EFFICIENCY_MODE_CAP) {
+        mode = EFFICIENCY_MODE_OFF;
+    }
+    
+    /* Смена режима: незаконченный поиск оставляет лучшую точку */
+    if (mode != stats.mode) {
+        for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+            if (eff[m].phase == EFFICIENCY_PHASE_SETTLE ||
+                eff[m].phase == EFFICIENCY_PHASE_MEASURE) {
+                search_finish(info, m, now);
+            }
+            eff[m].phase = EFFICIENCY_PHASE_IDLE;
+        }
+        stats.mode = mode;
+        log_message(LOG_INFO, "%s: Режим %d", TAG, mode);
+    }
+    
+    stats.power_cap = (mode == EFFICIENCY_MODE_CAP && mining && g_config.power_cap > 0) ?
+                      g_config.power_cap / mining : 0;
+    
+    if (mode == EFFICIENCY_MODE_OFF) {
+        return;
+    }
+    
+    /* Без autotune частоты на новом напряжении никто не подберёт */
+    if (!info->mining_enabled || info->overheat || !g_config.autotune) {
+        if (!stats.paused) {
+            log_message(LOG_INFO, "%s: Пауза", TAG);
+        }
+        stats.paused = 1;
+        return;
+    }
+    
+    /* После паузы прерванная точка измеряется заново */
+    if (stats.paused) {
+        stats.paused = 0;
+        for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+            if (eff[m].phase == EFFICIENCY_PHASE_SETTLE ||
+                eff[m].phase == EFFICIENCY_PHASE_MEASURE) {
+                point_start(info, m, eff[m].voltage, now);
+            }
+        }
+    }
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        if (info->modules[m].state != AVALON10_MODULE_STATE_MINING) {
+            /* Модуль пропал посреди поиска - после обнаружения начнёт заново */
+            if (eff[m].phase != EFFICIENCY_PHASE_DONE) {
+                eff[m].phase = EFFICIENCY_PHASE_IDLE;
+            }
+            continue;
+        }
+    
+        /* Снижение по температуре искажает точку - она измеряется заново */
+        if (throttle_active(m)) {
+            if (eff[m].phase == EFFICIENCY_PHASE_SETTLE ||
+                eff[m].phase == EFFICIENCY_PHASE_MEASURE) {
+                eff[m].phase = EFFICIENCY_PHASE_SETTLE;
+                eff[m].phase_at = now;
+            }
+            continue;
+        }
+    
+        module_step(info, m, power[m], now);
+    }
+}
+
+/**
+ * @brief Начать поиск заново
+ */
+void efficiency_restart(int module_id)
+{
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        if (module_id >= 0 && m != module_id) {
+            continue;
+        }
+        eff[m].phase = EFFICIENCY_PHASE_IDLE;
+    }
+    
+    log_message(LOG_INFO, "%s: Новый поиск (модуль %d)", TAG, module_id);
+}
+
+/**
+ * @brief Состояние поиска модуля
+ */
+const efficiency_module_t *efficiency_get_module(int module_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return NULL;
+    }
+    
+    return &eff[module_id];
+}
+
+/**
+ * @brief Состояние подбора
+ */
+const efficiency_stats_t *efficiency_get_stats(void)
+{
+    return &stats;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА efficiency.c
+ * =========================================================================== */
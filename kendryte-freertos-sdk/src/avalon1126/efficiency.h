@@ -0,0 +1,209 @@
+/**
+ * =============================================================================
+ * @file    efficiency.h
+ * @brief   Avalon A1126pro - Подбор напряжения по эффективности (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Совместный подбор напряжения и частоты модуля. Напряжение меняется
+ * шагами AVALON10_VOLTAGE_STEP, на каждом шаге autotune заново подбирает
+ * частоты чипов, затем измеряются хэшрейт и мощность. Модуль остаётся в
+ * лучшей точке:
+ * - EFFICIENCY_MODE_JTH - минимум J/TH;
+ * - EFFICIENCY_MODE_CAP - максимум TH/s при мощности не выше лимита
+ *   (g_config.power_cap делится поровну между модулями в майнинге; тот же
+ *   лимит powercap держит за секунды).
+ * 
+ * ПОИСК (для каждого модуля независимо):
+ * - Первая точка - текущее напряжение модуля.
+ * - Шаги вниз, пока EFFICIENCY_WORSE_POINTS точек подряд не окажутся хуже
+ *   лучшей или не будет достигнут AVALON10_VOLTAGE_MIN.
+ * - Если вниз лучше не стало - так же шаги вверх от начальной точки
+ *   (до g_config.efficiency_vmax).
+ * - Лучшая точка восстанавливается вместе с частотами чипов. Поиск
+ *   повторяется через EFFICIENCY_RESEARCH_S.
+ * 
+ * МОЩНОСТЬ:
+ * Телеметрия модуля (поле AVALON10_STATUS_POWER ответа STATUS), а если
+ * модуль её не отдаёт - модель P = Σ(k·V²·f + утечка) / КПД БП.
+ * 
+ * Перегрев, остановка майнинга и выключенная автонастройка
+ * приостанавливают поиск, прерванная точка измеряется заново.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __EFFICIENCY_H__
+#define __EFFICIENCY_H__
+
+#include <stdint.h>
+
+#include "avalon10.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Режимы (g_config.efficiency)
+ */
+#define EFFICIENCY_MODE_OFF         0   /* Напряжение не меняется */
+#define EFFICIENCY_MODE_JTH         1   /* Минимум J/TH */
+#define EFFICIENCY_MODE_CAP         2   /* Максимум TH/s под лимитом мощности */
+
+/**
+ * @brief Максимальное время подбора частот после смены напряжения (секунды)
+ */
+#define EFFICIENCY_SETTLE_MAX_S     900
+
+/**
+ * @brief Доля чипов с найденной частотой для начала измерения (%)
+ */
+#define EFFICIENCY_SETTLED_PCT      90
+
+/**
+ * @brief Длительность измерения точки (секунды)
+ */
+#define EFFICIENCY_MEASURE_S        120
+
+/**
+ * @brief Худших точек подряд до смены направления
+ */
+#define EFFICIENCY_WORSE_POINTS     2
+
+/**
+ * @brief Повторный поиск после завершения (секунды)
+ */
+#define EFFICIENCY_RESEARCH_S       (24 * 3600)
+
+/**
+ * @brief Модель мощности чипа
+ * 
+ * Динамическая часть - EFFICIENCY_MODEL_DYN мВт на (В² · МГц),
+ * утечка - EFFICIENCY_MODEL_LEAK_MW при 780 mV (линейно по напряжению).
+ * 780 mV / 500 MHz: ~7.6 Вт на чип, ~870 Вт на модуль.
+ */
+#define EFFICIENCY_MODEL_DYN        23
+#define EFFICIENCY_MODEL_LEAK_MW    600
+
+/**
+ * @brief КПД блока питания (%) - модель считает мощность от розетки
+ */
+#define EFFICIENCY_PSU_EFF          94
+
+/**
+ * @brief Телеметрия выше этого значения считается недостоверной (Вт)
+ */
+#define EFFICIENCY_POWER_MAX_W      2000
+
+/**
+ * @brief Фазы поиска модуля
+ */
+#define EFFICIENCY_PHASE_IDLE       0   /* Поиск не начат */
+#define EFFICIENCY_PHASE_SETTLE     1   /* autotune подбирает частоты */
+#define EFFICIENCY_PHASE_MEASURE    2   /* Измерение точки */
+#define EFFICIENCY_PHASE_DONE       3   /* Лучшая точка установлена */
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct efficiency_point_t
+ * @brief Измеренная рабочая точка
+ */
+typedef struct efficiency_point {
+    uint16_t voltage;               /* Напряжение (mV, 0 = точки нет) */
+    uint16_t power;                 /* Средняя мощность (Вт) */
+    float ghs;                      /* Средний хэшрейт (GH/s) */
+    float jth;                      /* Эффективность (J/TH) */
+} efficiency_point_t;
+
+/**
+ * @struct efficiency_module_t
+ * @brief Состояние поиска модуля
+ */
+typedef struct efficiency_module {
+    uint8_t phase;                  /* EFFICIENCY_PHASE_* */
+    int8_t dir;                     /* -1 вниз, +1 вверх */
+    uint8_t worse;                  /* Худших точек подряд */
+    uint8_t points;                 /* Измерено точек в этом поиске */
+    uint16_t start_voltage;         /* Начальная точка поиска (mV) */
+    uint16_t voltage;               /* Точка под измерением (mV) */
+    uint32_t phase_at;              /* Начало фазы (с) */
+    uint64_t diff1_0;               /* module->diff1 в начале измерения */
+    uint32_t power_sum;             /* Сумма замеров мощности (Вт) */
+    uint16_t power_n;               /* Замеров мощности */
+    efficiency_point_t last;        /* Последняя измеренная точка */
+    efficiency_point_t best;        /* Лучшая точка */
+    uint16_t best_freq[AVALON10_DEFAULT_MINER_CNT];  /* Частоты чипов лучшей точки */
+} efficiency_module_t;
+
+/**
+ * @struct efficiency_stats_t
+ * @brief Состояние подбора (для API)
+ */
+typedef struct efficiency_stats {
+    uint8_t mode;                   /* EFFICIENCY_MODE_* */
+    uint8_t paused;                 /* 1 = пауза */
+    uint16_t power_cap;             /* Лимит модуля в режиме CAP (Вт) */
+    uint32_t power;                 /* Мощность всех модулей (Вт) */
+    uint32_t searches;              /* Завершённых поисков (по модулям) */
+    uint32_t changed_at;            /* uptime последней смены напряжения (с) */
+} efficiency_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг подбора (раз в секунду, задача monitor, после autotune_poll)
+ * 
+ * @param info      Указатель на структуру информации
+ */
+void efficiency_poll(avalon10_info_t *info);
+
+/**
+ * @brief Начать поиск заново
+ * 
+ * @param module_id ID модуля (-1 = все)
+ */
+void efficiency_restart(int module_id);
+
+/**
+ * @brief Мощность чипа по модели (мВт от розетки) - общая с powercap
+ * 
+ * @param voltage   Напряжение модуля (mV)
+ * @param freq      Частота (MHz)
+ * @param activity  Доля времени с заданиями (0-1)
+ */
+float efficiency_chip_mw(uint16_t voltage, int freq, float activity);
+
+/**
+ * @brief Мощность модуля по модели (Вт от розетки)
+ */
+uint32_t efficiency_model_power(const avalon10_module_t *module);
+
+/**
+ * @brief Мощность модуля: телеметрия, а без неё - модель (Вт)
+ */
+uint32_t efficiency_module_power(const avalon10_module_t *module);
+
+/**
+ * @brief Состояние поиска модуля
+ * @return          NULL при неверном номере
+ */
+const efficiency_module_t *efficiency_get_module(int module_id);
+
+/**
+ * @brief Состояние подбора
+ */
+const efficiency_stats_t *efficiency_get_stats(void);
+
+#endif /* __EFFICIENCY_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА efficiency.h
+ * =========================================================================== */
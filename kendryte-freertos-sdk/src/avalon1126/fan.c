@@ -0,0 +1,338 @@
+/**
+ * =============================================================================
+ * @file    fan.c
+ * @brief   Avalon A1126pro - Управление вентиляторами (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * ШИМ вентиляторов, тахометры и ПИД-регулятор температуры. В режиме
+ * эмуляции ШИМ и тахометр подключены к модели вентилятора mock_hardware,
+ * а нагрев модулей зависит от её оборотов.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <devices.h>
+
+#include "fan.h"
+#include "cgminer.h"
+#include "mock_hardware.h"
+
+#if !MOCK_ASIC
+#include <fpioa.h>
+#endif
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Fan";
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static fan_state_t fans[AVALON10_FAN_COUNT];
+static fan_pid_t pid = { FAN_KP_DEFAULT, FAN_KI_DEFAULT, FAN_KD_DEFAULT, 0.0f, 0.0f, 0 };
+
+#if !MOCK_ASIC
+static handle_t pwm_dev = 0;
+static handle_t gpio = 0;
+
+/* Пишет обработчик прерывания тахометра */
+static volatile uint32_t tach_pulses[AVALON10_FAN_COUNT];
+static volatile uint64_t tach_edge_us[AVALON10_FAN_COUNT];
+#endif
+
+/* ===========================================================================
+ * ТАХОМЕТР
+ * =========================================================================== */
+
+#if !MOCK_ASIC
+/**
+ * @brief Прерывание по спаду тахо-выхода
+ */
+static void tach_on_edge(uint32_t pin, void *userdata)
+{
+    int i = (int)(uintptr_t)userdata;
+    
+    (void)pin;
+    
+    tach_edge_us[i] = cgminer_time_us();
+    __atomic_store_n(&tach_pulses[i], tach_pulses[i] + 1, __ATOMIC_RELEASE);
+}
+#endif
+
+/**
+ * @brief Снимок счётчика импульсов и времени последнего фронта
+ */
+static void tach_read(int i, uint32_t *pulses, uint64_t *edge_us)
+{
+#if MOCK_ASIC
+    mock_fan_tach(i, pulses, edge_us);
+#else
+    /* Фронт между двумя чтениями меняет счётчик - читаем заново */
+    do {
+        *pulses = __atomic_load_n(&tach_pulses[i], __ATOMIC_ACQUIRE);
+        *edge_us = tach_edge_us[i];
+    } while (*pulses != __atomic_load_n(&tach_pulses[i], __ATOMIC_ACQUIRE));
+#endif
+}
+
+/**
+ * @brief Обороты по импульсам с прошлого опроса
+ */
+static void tach_update(fan_state_t *st, int i)
+{
+    uint32_t pulses;
+    uint64_t edge_us;
+    
+    tach_read(i, &pulses, &edge_us);
+    
+    if (pulses == st->pulses_seen || edge_us <= st->edge_seen_us) {
+        /* Ни одного фронта за период опроса */
+        st->rpm = 0;
+        return;
+    }
+    
+    st->rpm = (uint16_t)((uint64_t)(pulses - st->pulses_seen) * 60000000ULL /
+                         (FAN_TACH_PULSES_PER_REV * (edge_us - st->edge_seen_us)));
+    st->pulses_seen = pulses;
+    st->edge_seen_us = edge_us;
+}
+
+/**
+ * @brief Признаки останова
+ */
+static void stall_check(fan_state_t *st, int i)
+{
+    if (st->pwm >= FAN_STALL_PWM && st->rpm < FAN_STALL_RPM) {
+        if (st->stall_s < 0xFF) {
+            st->stall_s++;
+        }
+        if (st->stall_s >= FAN_STALL_S && !st->stalled) {
+            st->stalled = 1;
+            st->stalls++;
+            log_message(LOG_ERR, "%s: Вентилятор %d остановился (ШИМ %d%%, %d об/мин)",
+                       TAG, i, st->pwm, st->rpm);
+        }
+        return;
+    }
+    
+    st->stall_s = 0;
+    if (st->stalled && st->rpm >= FAN_STALL_RPM) {
+        st->stalled = 0;
+        log_message(LOG_INFO, "%s: Вентилятор %d снова вращается (%d об/мин)", TAG, i, st->rpm);
+    }
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Инициализация ШИМ и тахометров
+ */
+int fan_init(void)
+{
+#if MOCK_ASIC
+    mock_fan_init();
+#else
+    pwm_dev = io_open(FAN_PWM_DEVICE);
+    gpio = io_open("/dev/gpio0");
+    if (!pwm_dev || !gpio) {
+        log_message(LOG_ERR, "%s: Не удалось открыть %s", TAG, FAN_PWM_DEVICE);
+        return -1;
+    }
+    
+    pwm_set_frequency(pwm_dev, FAN_PWM_FREQ);
+    
+    for (int i = 0; i < AVALON10_FAN_COUNT; i++) {
+        pwm_set_active_duty_cycle_percentage(pwm_dev, i, AVALON10_DEFAULT_FAN_MAX / 100.0);
+        pwm_set_enable(pwm_dev, i, true);
+    
+        fpioa_set_function(FAN_TACH_PIN_BASE + i, FUNC_GPIOHS0 + FAN_TACH_GPIO_BASE + i);
+        gpio_set_drive_mode(gpio, FAN_TACH_GPIO_BASE + i, GPIO_DM_INPUT_PULL_UP);
+        gpio_set_pin_edge(gpio, FAN_TACH_GPIO_BASE + i, GPIO_PE_FALLING);
+        gpio_set_on_changed(gpio, FAN_TACH_GPIO_BASE + i, tach_on_edge, (void *)(uintptr_t)i);
+    }
+#endif
+    
+    memset(fans, 0, sizeof(fans));
+    for (int i = 0; i < AVALON10_FAN_COUNT; i++) {
+        fans[i].pwm = AVALON10_DEFAULT_FAN_MAX;
+        fans[i].out = AVALON10_DEFAULT_FAN_MAX;
+        tach_read(i, &fans[i].pulses_seen, &fans[i].edge_seen_us);
+    }
+    pid.at_us = 0;
+    
+    log_message(LOG_INFO, "%s: ШИМ %d Гц, ПИД %.2f/%.3f/%.2f",
+               TAG, FAN_PWM_FREQ, (double)pid.kp, (double)pid.ki, (double)pid.kd);
+    
+    return 0;
+}
+
+/**
+ * @brief Запись ШИМ вентилятора в аппаратуру
+ */
+int fan_set_pwm(int fan_id, int pwm)
+{
+    if (fan_id < 0 || fan_id >= AVALON10_FAN_COUNT) {
+        return -1;
+    }
+    
+    if (pwm < 0) pwm = 0;
+    if (pwm > 100) pwm = 100;
+    
+#if MOCK_ASIC
+    mock_fan_set_pwm(fan_id, pwm);
+#else
+    if (!pwm_dev) {
+        return -1;
+    }
+    pwm_set_active_duty_cycle_percentage(pwm_dev, fan_id, pwm / 100.0);
+#endif
+    
+    fans[fan_id].pwm = pwm;
+    
+    return 0;
+}
+
+/**
+ * @brief Шаг регулятора
+ */
+void fan_poll(avalon10_info_t *info)
+{
+    uint64_t now = cgminer_time_us();
+    float fmin = info->fan_min;
+    float fmax = info->fan_max;
+    float range = fmax - fmin;
+    float temp = 0.0f, err, dtemp, dt;
+    int modules = 0, stalled = 0;
+    
+    for (int i = 0; i < AVALON10_FAN_COUNT; i++) {
+        tach_update(&fans[i], i);
+        stall_check(&fans[i], i);
+        stalled += fans[i].stalled;
+        info->fan_rpm[i] = fans[i].rpm;
+    }
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        if (info->modules[m].state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+        if (!modules++ || info->modules[m].temp_max / 10.0f > temp) {
+            temp = info->modules[m].temp_max / 10.0f;
+        }
+    }
+    
+    /* Без модулей регулировать нечего - ШИМ остаётся прежним */
+    if (!modules) {
+        pid.at_us = 0;
+        return;
+    }
+    
+    err = temp - info->temp_target;
+    
+    /* Первый шаг: выход продолжает текущий ШИМ без скачка */
+    if (!pid.at_us) {
+        for (int i = 0; i < AVALON10_FAN_COUNT; i++) {
+            fans[i].out = fans[i].pwm;
+            fans[i].integ = fans[i].out - fmin - pid.kp * err;
+            fans[i].dtemp = 0.0f;
+        }
+        pid.temp_prev = temp;
+        pid.at_us = now;
+    }
+    
+    dt = cgminer_poll_dt(&pid.at_us, now, 0.1f);
+    dtemp = (temp - pid.temp_prev) / dt;
+    pid.temp_prev = temp;
+    pid.temp = temp;
+    
+    for (int i = 0; i < AVALON10_FAN_COUNT; i++) {
+        fan_state_t *st = &fans[i];
+        int force = temp >= info->temp_overheat || stalled;
+        float u;
+        int pwm;
+    
+        st->dtemp += FAN_D_FILTER * (dtemp - st->dtemp);
+        u = fmin + pid.kp * err + st->integ + pid.kd * st->dtemp;
+    
+        /* Anti-windup: интеграл стоит, пока выход в насыщении по ошибке */
+        if (!force && !((u >= fmax && err > 0.0f) || (u <= fmin && err < 0.0f))) {
+            st->integ += pid.ki * err * dt;
+            if (st->integ > range) st->integ = range;
+            if (st->integ < -range) st->integ = -range;
+            u = fmin + pid.kp * err + st->integ + pid.kd * st->dtemp;
+        }
+    
+        if (u > fmax) u = fmax;
+        if (u < fmin) u = fmin;
+    
+        if (force) {
+            /* Перегрев или останов: полный обдув сразу, вставшему - для перезапуска */
+            u = fmax;
+        } else if (u > st->out + FAN_SLEW_UP * dt) {
+            u = st->out + FAN_SLEW_UP * dt;
+        } else if (u < st->out - FAN_SLEW_DOWN * dt) {
+            u = st->out - FAN_SLEW_DOWN * dt;
+        }
+    
+        st->out = u;
+        pwm = (int)(u + 0.5f);
+        if (pwm != st->pwm) {
+            fan_set_pwm(i, pwm);
+        }
+        info->fan_pwm[i] = st->pwm;
+    }
+    
+    log_message(LOG_DEBUG, "%s: T %.1f°C (цель %d), ШИМ %d/%d%%, %d/%d об/мин",
+               TAG, (double)temp, info->temp_target, fans[0].pwm, fans[1].pwm,
+               fans[0].rpm, fans[1].rpm);
+}
+
+/**
+ * @brief Смена коэффициентов ПИД
+ */
+void fan_set_gains(float kp, float ki, float kd)
+{
+    pid.kp = kp;
+    pid.ki = ki;
+    pid.kd = kd;
+    
+    log_message(LOG_INFO, "%s: ПИД %.2f/%.3f/%.2f", TAG, (double)kp, (double)ki, (double)kd);
+}
+
+/**
+ * @brief Состояние вентилятора
+ */
+const fan_state_t *fan_get_state(int fan_id)
+{
+    if (fan_id < 0 || fan_id >= AVALON10_FAN_COUNT) {
+        return NULL;
+    }
+    
+    return &fans[fan_id];
+}
+
+/**
+ * @brief Коэффициенты и вход регулятора
+ */
+const fan_pid_t *fan_get_pid(void)
+{
+    return &pid;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА fan.c
+ * =========================================================================== */
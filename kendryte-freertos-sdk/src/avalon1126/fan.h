@@ -0,0 +1,184 @@
+/**
+ * =============================================================================
+ * @file    fan.h
+ * @brief   Avalon A1126pro - Управление вентиляторами (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * ПИД-регулятор для каждого вентилятора держит максимальную температуру
+ * модулей на temp_target. Вход - температура (°C), выход - ШИМ (%).
+ * 
+ * РЕГУЛЯТОР (раз в секунду, задача monitor):
+ *   u = fan_min + Kp·e + I + Kd·dT/dt,   e = T - temp_target
+ * - Дифференциальная часть считается по измерению (без броска при смене
+ *   цели) и сглажена: датчик шагает по 0.1°C.
+ * - Anti-windup: интеграл не растёт, пока выход упирается в границу в
+ *   сторону ошибки, и ограничен диапазоном [fan_min, fan_max].
+ * - Скорость изменения ШИМ ограничена: вверх FAN_SLEW_UP, вниз
+ *   FAN_SLEW_DOWN (% в секунду). Температура не ниже temp_overheat
+ *   сразу даёт fan_max.
+ * 
+ * ТАХОМЕТР:
+ * У K210 нет захвата таймера на входе, поэтому тахо-выход заведён на
+ * GPIOHS с прерыванием по спаду: обработчик считает импульсы и запоминает
+ * время последнего по CLINT mtime. Обороты - по числу импульсов между
+ * последними фронтами двух опросов (метод периода), а не по числу
+ * импульсов за секунду.
+ * 
+ * ОСТАНОВ:
+ * ШИМ не ниже FAN_STALL_PWM и обороты ниже FAN_STALL_RPM
+ * FAN_STALL_S секунд подряд - вентилятор встал. Пока он стоит, все
+ * вентиляторы работают на fan_max (вставший - для попытки перезапуска),
+ * интегралы регуляторов заморожены.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __FAN_H__
+#define __FAN_H__
+
+#include <stdint.h>
+
+#include "avalon10.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Коэффициенты ПИД по умолчанию
+ * Kp - % на °C, Ki - % на °C·с, Kd - % на °C/с
+ */
+#define FAN_KP_DEFAULT          4.0f
+#define FAN_KI_DEFAULT          0.15f
+#define FAN_KD_DEFAULT          8.0f
+
+/**
+ * @brief Сглаживание производной температуры (доля нового замера)
+ */
+#define FAN_D_FILTER            0.3f
+
+/**
+ * @brief Ограничение скорости изменения ШИМ (% в секунду)
+ * Вверх быстро - против перегрева, вниз медленно - без качания оборотов
+ */
+#define FAN_SLEW_UP             10.0f
+#define FAN_SLEW_DOWN           3.0f
+
+/**
+ * @brief Импульсов тахометра на оборот (стандарт для 4-pin вентиляторов)
+ */
+#define FAN_TACH_PULSES_PER_REV 2
+
+/**
+ * @brief Признаки останова вентилятора
+ */
+#define FAN_STALL_PWM           20      /* ШИМ, при котором вентилятор обязан крутиться (%) */
+#define FAN_STALL_RPM           300     /* Обороты ниже - вентилятор стоит */
+#define FAN_STALL_S             5       /* Секунд подряд (с запасом на раскрутку) */
+
+/* ---------------------------------------------------------------------------
+ * Подключение (плата управления)
+ * --------------------------------------------------------------------------- */
+
+/**
+ * @brief ШИМ вентиляторов: /dev/pwm0 (TIMER0), канал = номер вентилятора
+ * Выводы IO16, IO17 назначает init_hardware() в main.c
+ */
+#define FAN_PWM_DEVICE          "/dev/pwm0"
+#define FAN_PWM_FREQ            25000   /* 25 kHz */
+
+/**
+ * @brief Тахометры: IO18, IO19 на GPIOHS 19, 20
+ */
+#define FAN_TACH_PIN_BASE       18
+#define FAN_TACH_GPIO_BASE      19
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct fan_state_t
+ * @brief Состояние вентилятора и его регулятора
+ */
+typedef struct fan_state {
+    uint8_t pwm;                    /* Текущий ШИМ (%) */
+    uint8_t stalled;                /* 1 = вентилятор стоит */
+    uint8_t stall_s;                /* Секунд подряд с признаками останова */
+    uint16_t rpm;                   /* Обороты */
+    uint32_t stalls;                /* Остановов с начала работы */
+    
+    /* Регулятор */
+    float out;                      /* Выход до округления (%) */
+    float integ;                    /* Интегральная часть (%) */
+    float dtemp;                    /* Сглаженная dT/dt (°C/с) */
+    
+    /* Тахометр: снимок прошлого опроса */
+    uint32_t pulses_seen;
+    uint64_t edge_seen_us;
+} fan_state_t;
+
+/**
+ * @struct fan_pid_t
+ * @brief Коэффициенты и вход регулятора (для API)
+ */
+typedef struct fan_pid {
+    float kp;
+    float ki;
+    float kd;
+    float temp;                     /* Последний вход (°C) */
+    float temp_prev;                /* Вход прошлого шага (°C) */
+    uint64_t at_us;                 /* Время прошлого шага */
+} fan_pid_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Инициализация ШИМ и тахометров
+ * 
+ * @return          0 при успехе, -1 при ошибке
+ */
+int fan_init(void);
+
+/**
+ * @brief Шаг регулятора (раз в секунду, задача monitor)
+ * 
+ * @param info      Указатель на структуру информации
+ */
+void fan_poll(avalon10_info_t *info);
+
+/**
+ * @brief Запись ШИМ вентилятора в аппаратуру
+ * 
+ * @param fan_id    Номер вентилятора
+ * @param pwm       ШИМ (0-100%)
+ * @return          0 при успехе, -1 при ошибке
+ */
+int fan_set_pwm(int fan_id, int pwm);
+
+/**
+ * @brief Смена коэффициентов ПИД (интегралы сохраняются)
+ */
+void fan_set_gains(float kp, float ki, float kd);
+
+/**
+ * @brief Состояние вентилятора
+ * @return          NULL при неверном номере
+ */
+const fan_state_t *fan_get_state(int fan_id);
+
+/**
+ * @brief Коэффициенты и вход регулятора
+ */
+const fan_pid_t *fan_get_pid(void);
+
+#endif /* __FAN_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА fan.h
+ * =========================================================================== */
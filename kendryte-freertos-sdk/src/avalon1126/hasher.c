@@ -0,0 +1,557 @@
+/**
+ * =============================================================================
+ * @file    hasher.c
+ * @brief   Avalon A1126pro - Бэкенды SHA256 (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Таблица бэкендов SHA256, проверка известным ответом (заголовок
+ * genesis-блока), замер и выбор самого быстрого.
+ * 
+ * Эталон для проверки - sha256_soft.c: бэкенд, чей ответ расходится с
+ * ним, не регистрируется.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include "hasher.h"
+#include "cgminer.h"
+#include "sha256_soft.h"
+#include "sha256_swar.h"
+#include "mock_hardware.h"
+
+#if !MOCK_HARDWARE
+#include <devices.h>
+#endif
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Hasher";
+
+/**
+ * @brief Заголовок genesis-блока и его SHA256d (порядок байт хэша - как считает SHA256)
+ */
+static const uint8_t kat_header[80] = {
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x3b, 0xa3, 0xed, 0xfd, 0x7a, 0x7b, 0x12, 0xb2, 0x7a, 0xc7, 0x2c, 0x3e,
+    0x67, 0x76, 0x8f, 0x61, 0x7f, 0xc8, 0x1b, 0xc3, 0x88, 0x8a, 0x51, 0x32, 0x3a, 0x9f, 0xb8, 0xaa,
+    0x4b, 0x1e, 0x5e, 0x4a, 0x29, 0xab, 0x5f, 0x49, 0xff, 0xff, 0x00, 0x1d, 0x1d, 0xac, 0x2b, 0x7c,
+};
+
+static const uint8_t kat_hash[32] = {
+    0x6f, 0xe2, 0x8c, 0x0a, 0xb6, 0xf1, 0xb3, 0x72, 0xc1, 0xa6, 0xa2, 0x46, 0xae, 0x63, 0xf7, 0x4f,
+    0x93, 0x1e, 0x83, 0x65, 0xe1, 0x5a, 0x08, 0x9c, 0x68, 0xd6, 0x19, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static const char *const names[HASHER_COUNT] = { "auto", "soft", "hard", "swar" };
+
+static const hasher_ops_t *backends[HASHER_COUNT];
+static hasher_stats_t stats[HASHER_COUNT];
+static volatile int active = HASHER_SOFT;
+
+/* Сообщения замера и проверки: заголовки с разными nonce */
+static uint8_t bench_data[HASHER_BATCH_MAX * 80];
+static uint8_t bench_hash[HASHER_BATCH_MAX * 32];
+static uint32_t bench_nonces[HASHER_BATCH_MAX];
+
+/* ===========================================================================
+ * БЭКЕНД SOFT
+ * =========================================================================== */
+
+static int soft_init(void)
+{
+    return 0;
+}
+
+static void soft_sha256d_batch(const uint8_t *data, size_t len, int n, uint8_t *hash)
+{
+    for (int i = 0; i < n; i++) {
+        sha256d_soft(data + i * len, len, hash + i * 32);
+    }
+}
+
+/**
+ * @brief Состояние после первых 64 байт заголовка и байты 64-75
+ */
+static void header_midstate(const uint8_t *header, uint32_t midstate[8], uint8_t tail[16])
+{
+    memcpy(midstate, sha256_soft_iv, 8 * sizeof(uint32_t));
+    sha256_soft_transform(midstate, header);
+    memcpy(tail, header + 64, 12);
+}
+
+/**
+ * @brief Nonce в байты 76-79 (little-endian)
+ */
+static void tail_nonce(uint8_t tail[16], uint32_t nonce)
+{
+    tail[12] = nonce & 0xFF;
+    tail[13] = (nonce >> 8) & 0xFF;
+    tail[14] = (nonce >> 16) & 0xFF;
+    tail[15] = (nonce >> 24) & 0xFF;
+}
+
+static void soft_sha256d_nonces(const uint8_t *header, const uint32_t *nonces, int n, uint8_t *hash)
+{
+    uint32_t mid[8];
+    uint8_t tail[16];
+    
+    header_midstate(header, mid, tail);
+    for (int i = 0; i < n; i++) {
+        tail_nonce(tail, nonces[i]);
+        sha256d_soft_header(mid, tail, hash + i * 32);
+    }
+}
+
+static const hasher_ops_t soft_ops = {
+    .name = "soft",
+    .init = soft_init,
+    .sha256 = sha256_soft,
+    .sha256d_batch = soft_sha256d_batch,
+    .sha256d_nonces = soft_sha256d_nonces,
+};
+
+/* ===========================================================================
+ * БЭКЕНД SWAR (два сообщения в 64-битных регистрах)
+ * =========================================================================== */
+
+/**
+ * @brief Парами, нечётное последнее - программным
+ */
+static void swar_sha256d_batch(const uint8_t *data, size_t len, int n, uint8_t *hash)
+{
+    int i;
+    
+    for (i = 0; i + 1 < n; i += 2) {
+        sha256d_swar2(data + i * len, data + (i + 1) * len, len,
+                      hash + i * 32, hash + (i + 1) * 32);
+    }
+    if (i < n) {
+        sha256d_soft(data + i * len, len, hash + i * 32);
+    }
+}
+
+static void swar_sha256d_nonces(const uint8_t *header, const uint32_t *nonces, int n, uint8_t *hash)
+{
+    uint32_t mid[8];
+    uint8_t tail_a[16], tail_b[16];
+    int i;
+    
+    header_midstate(header, mid, tail_a);
+    memcpy(tail_b, tail_a, 12);
+    
+    for (i = 0; i + 1 < n; i += 2) {
+        tail_nonce(tail_a, nonces[i]);
+        tail_nonce(tail_b, nonces[i + 1]);
+        sha256d_swar2_header(mid, tail_a, tail_b, hash + i * 32, hash + (i + 1) * 32);
+    }
+    if (i < n) {
+        tail_nonce(tail_a, nonces[i]);
+        sha256d_soft_header(mid, tail_a, hash + i * 32);
+    }
+}
+
+static const hasher_ops_t swar_ops = {
+    .name = "swar",
+    .init = soft_init,
+    .sha256 = sha256_soft,
+    .sha256d_batch = swar_sha256d_batch,
+    .sha256d_nonces = swar_sha256d_nonces,
+};
+
+/* ===========================================================================
+ * БЭКЕНД HARD (ускоритель K210)
+ * =========================================================================== */
+
+#if !MOCK_HARDWARE
+
+static int hard_init(void)
+{
+    return 0;
+}
+
+static void hard_sha256(const uint8_t *data, size_t len, uint8_t *hash)
+{
+    sha256_hard_calculate(data, len, hash);
+}
+
+/**
+ * @brief По сообщению: блок SHA256 выдаёт один дайджест за запуск DMA
+ */
+static void hard_sha256d_batch(const uint8_t *data, size_t len, int n, uint8_t *hash)
+{
+    uint8_t first[32];
+    
+    for (int i = 0; i < n; i++) {
+        sha256_hard_calculate(data + i * len, len, first);
+        sha256_hard_calculate(first, 32, hash + i * 32);
+    }
+}
+
+static const hasher_ops_t hard_ops = {
+    .name = "hard",
+    .init = hard_init,
+    .sha256 = hard_sha256,
+    .sha256d_batch = hard_sha256d_batch,
+    .sha256d_nonces = NULL,             /* Заголовки целиком пакетом */
+};
+
+#endif /* !MOCK_HARDWARE */
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Регистрация бэкендов сборки
+ */
+static void backends_register(void)
+{
+    backends[HASHER_SOFT] = &soft_ops;
+    backends[HASHER_SWAR] = &swar_ops;
+#if !MOCK_HARDWARE
+    backends[HASHER_HARD] = &hard_ops;
+#endif
+}
+
+/**
+ * @brief Заголовки с разными nonce для проверки и замера
+ */
+static void bench_fill(void)
+{
+    for (int i = 0; i < HASHER_BATCH_MAX; i++) {
+        uint8_t *h = bench_data + i * 80;
+        uint32_t nonce = 0x9E3779B9u * (i + 1);
+    
+        bench_nonces[i] = nonce;
+        memcpy(h, kat_header, 80);
+        h[76] = nonce & 0xFF;
+        h[77] = (nonce >> 8) & 0xFF;
+        h[78] = (nonce >> 16) & 0xFF;
+        h[79] = (nonce >> 24) & 0xFF;
+    }
+}
+
+/**
+ * @brief SHA256d заголовков одного задания бэкендом
+ * 
+ * Без своей операции - заголовки собираются целиком и идут пакетом.
+ */
+static void backend_nonces(const hasher_ops_t *ops, const uint8_t *header,
+                           const uint32_t *nonces, int n, uint8_t *hash)
+{
+    uint8_t headers[HASHER_BATCH_MAX * 80];
+    
+    if (ops->sha256d_nonces) {
+        ops->sha256d_nonces(header, nonces, n, hash);
+        return;
+    }
+    
+    for (int i = 0; i < n; i++) {
+        uint8_t *h = headers + i * 80;
+    
+        memcpy(h, header, 76);
+        h[76] = nonces[i] & 0xFF;
+        h[77] = (nonces[i] >> 8) & 0xFF;
+        h[78] = (nonces[i] >> 16) & 0xFF;
+        h[79] = (nonces[i] >> 24) & 0xFF;
+    }
+    ops->sha256d_batch(headers, 80, n, hash);
+}
+
+/**
+ * @brief Сверка n хэшей bench_hash с программным SHA256d сообщений bench_data
+ */
+static int bench_compare(size_t len, int n)
+{
+    uint8_t ref[32];
+    
+    for (int i = 0; i < n; i++) {
+        sha256d_soft(bench_data + i * len, len, ref);
+        if (memcmp(bench_hash + i * 32, ref, 32) != 0) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Проверка бэкенда: genesis-блок, пакеты и заголовки по nonce
+ *        против программного
+ * 
+ * Нечётные n проверяют хвост пакета у бэкендов, считающих парами.
+ * 
+ * @return          0 - ответы верны
+ */
+static int backend_check(const hasher_ops_t *ops)
+{
+    uint8_t hash[32], ref[32];
+    
+    ops->sha256d_batch(kat_header, 80, 1, hash);
+    if (memcmp(hash, kat_hash, 32) != 0) {
+        return -1;
+    }
+    
+    for (int n = HASHER_BATCH_MAX - 1; n <= HASHER_BATCH_MAX; n++) {
+        ops->sha256d_batch(bench_data, 80, n, bench_hash);
+        if (bench_compare(80, n) != 0) {
+            return -1;
+        }
+        ops->sha256d_batch(bench_data, 64, n, bench_hash);
+        if (bench_compare(64, n) != 0) {
+            return -1;
+        }
+        backend_nonces(ops, bench_data, bench_nonces, n, bench_hash);
+        if (bench_compare(80, n) != 0) {
+            return -1;
+        }
+    }
+    
+    ops->sha256(kat_header, 80, hash);
+    sha256_soft(kat_header, 80, ref);
+    
+    return memcmp(hash, ref, 32) == 0 ? 0 : -1;
+}
+
+/**
+ * @brief Время SHA256d сообщения длины len (нс)
+ * 
+ * 80 байт замеряются путём проверки nonce - заголовки одного задания
+ * (hasher_sha256d_nonces), 64 байта - пакетом сообщений.
+ * 
+ * @param len       До 80 байт: сообщения берутся подряд из bench_data
+ */
+static uint32_t backend_time(const hasher_ops_t *ops, size_t len)
+{
+    uint64_t t0 = cgminer_time_us();
+    uint64_t us;
+    
+    for (int r = 0; r < HASHER_BENCH_ROUNDS; r++) {
+        if (len == 80) {
+            backend_nonces(ops, bench_data, bench_nonces, HASHER_BATCH_MAX, bench_hash);
+        } else {
+            ops->sha256d_batch(bench_data, len, HASHER_BATCH_MAX, bench_hash);
+        }
+    }
+    us = cgminer_time_us() - t0;
+    
+    return (uint32_t)(us * 1000 / (HASHER_BENCH_ROUNDS * HASHER_BATCH_MAX));
+}
+
+/**
+ * @brief Самый быстрый доступный бэкенд на 80 байтах
+ */
+static int fastest(void)
+{
+    int best = HASHER_SOFT;
+    
+    for (int t = HASHER_SOFT; t < HASHER_COUNT; t++) {
+        if (stats[t].available && stats[t].ns80 && stats[t].ns80 < stats[best].ns80) {
+            best = t;
+        }
+    }
+    
+    return best;
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Проверка и замер бэкендов
+ */
+void hasher_init(void)
+{
+    backends_register();
+    bench_fill();
+    
+    for (int t = HASHER_SOFT; t < HASHER_COUNT; t++) {
+        const hasher_ops_t *ops = backends[t];
+    
+        if (!ops || ops->init() != 0) {
+            continue;
+        }
+        if (backend_check(ops) != 0) {
+            log_message(LOG_ERR, "%s: Бэкенд %s считает неверно - не используется", TAG, ops->name);
+            continue;
+        }
+        stats[t].available = 1;
+    }
+    
+    hasher_bench();
+    
+    if (g_config.hasher != HASHER_AUTO && hasher_select(g_config.hasher) != 0) {
+        log_message(LOG_WARNING, "%s: Бэкенд %s недоступен, выбран %s",
+                   TAG, hasher_name(g_config.hasher), hasher_name(active));
+    }
+}
+
+/**
+ * @brief Выбор бэкенда
+ */
+int hasher_select(int type)
+{
+    if (type == HASHER_AUTO) {
+        active = fastest();
+        return 0;
+    }
+    if (type < 0 || type >= HASHER_COUNT || !stats[type].available) {
+        return -1;
+    }
+    
+    active = type;
+    log_message(LOG_INFO, "%s: Бэкенд %s", TAG, hasher_name(type));
+    
+    return 0;
+}
+
+/**
+ * @brief Бэкенд, который считает сейчас
+ */
+int hasher_active(void)
+{
+    return active;
+}
+
+/**
+ * @brief Замер всех доступных бэкендов
+ */
+void hasher_bench(void)
+{
+    for (int t = HASHER_SOFT; t < HASHER_COUNT; t++) {
+        if (!stats[t].available) {
+            continue;
+        }
+        stats[t].ns80 = backend_time(backends[t], 80);
+        stats[t].ns64 = backend_time(backends[t], 64);
+        log_message(LOG_INFO, "%s: %s: SHA256d 80 байт %lu нс, 64 байта %lu нс",
+                   TAG, backends[t]->name, (unsigned long)stats[t].ns80,
+                   (unsigned long)stats[t].ns64);
+    }
+    
+    if (g_config.hasher == HASHER_AUTO) {
+        active = fastest();
+        log_message(LOG_INFO, "%s: Бэкенд %s (самый быстрый)", TAG, hasher_name(active));
+    }
+}
+
+/**
+ * @brief Имя бэкенда
+ */
+const char *hasher_name(int type)
+{
+    if (type < 0 || type >= HASHER_COUNT) {
+        return "unknown";
+    }
+    
+    return names[type];
+}
+
+/**
+ * @brief Поиск бэкенда по имени
+ */
+int hasher_parse(const char *name)
+{
+    for (int t = HASHER_AUTO; t < HASHER_COUNT; t++) {
+        if (strcmp(name, hasher_name(t)) == 0) {
+            return t;
+        }
+    }
+    
+    return -1;
+}
+
+/**
+ * @brief SHA256
+ */
+void hasher_sha256(const uint8_t *data, size_t len, uint8_t *hash)
+{
+    const hasher_ops_t *ops = backends[active];
+    
+    /* До hasher_init() - программный */
+    if (!ops) {
+        sha256_soft(data, len, hash);
+        return;
+    }
+    
+    ops->sha256(data, len, hash);
+}
+
+/**
+ * @brief SHA256d
+ */
+void hasher_sha256d(const uint8_t *data, size_t len, uint8_t *hash)
+{
+    hasher_sha256d_batch(data, len, 1, hash);
+}
+
+/**
+ * @brief SHA256d n сообщений одной длины
+ */
+void hasher_sha256d_batch(const uint8_t *data, size_t len, int n, uint8_t *hash)
+{
+    int type = active;
+    
+    if (!backends[type]) {
+        soft_sha256d_batch(data, len, n, hash);
+        return;
+    }
+    
+    for (int i = 0; i < n; i += HASHER_BATCH_MAX) {
+        int k = MIN(n - i, HASHER_BATCH_MAX);
+    
+        backends[type]->sha256d_batch(data + i * len, len, k, hash + i * 32);
+    }
+    __atomic_fetch_add(&stats[type].hashes, (uint64_t)n, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief SHA256d заголовков одного задания с разными nonce
+ */
+void hasher_sha256d_nonces(const uint8_t *header, const uint32_t *nonces, int n, uint8_t *hash)
+{
+    int type = active;
+    const hasher_ops_t *ops = backends[type] ? backends[type] : &soft_ops;
+    
+    for (int i = 0; i < n; i += HASHER_BATCH_MAX) {
+        int k = MIN(n - i, HASHER_BATCH_MAX);
+    
+        backend_nonces(ops, header, nonces + i, k, hash + i * 32);
+    }
+    if (backends[type]) {
+        __atomic_fetch_add(&stats[type].hashes, (uint64_t)n, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Состояние бэкенда
+ */
+const hasher_stats_t *hasher_get_stats(int type)
+{
+    if (type <= HASHER_AUTO || type >= HASHER_COUNT) {
+        return NULL;
+    }
+    
+    return &stats[type];
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА hasher.c
+ * =========================================================================== */
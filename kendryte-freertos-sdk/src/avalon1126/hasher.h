@@ -0,0 +1,180 @@
+/**
+ * =============================================================================
+ * @file    hasher.h
+ * @brief   Avalon A1126pro - Бэкенды SHA256 (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Единый интерфейс SHA256 для work.c (coinbase, дерево Меркла, заголовок)
+ * и проверки nonce (validator, avalon10_check_nonce). Бэкенд выбирается во
+ * время работы:
+ * 
+ *   HASHER_SOFT    - программный SHA256 (sha256_soft.c), есть всегда
+ *   HASHER_HARD    - ускоритель SHA256 K210 через DMA (не MOCK_HARDWARE)
+ *   HASHER_SWAR    - два сообщения в 64-битных регистрах (sha256_swar.c)
+ * 
+ * ВЫБОР:
+ * hasher_init() проверяет каждый бэкенд по программному (известный ответ)
+ * и замеряет SHA256d 80 байт (заголовок) и 64 байт (узел Меркла).
+ * HASHER_AUTO берёт самый быстрый на 80 байтах - это путь проверки
+ * nonce. Команда API hash показывает замеры и меняет бэкенд.
+ * 
+ * ПАКЕТЫ:
+ * hasher_sha256d_batch() считает n сообщений одной длины. Ускоритель
+ * держит канал DMA и буфер между вызовами, но выдаёт один дайджест за
+ * запуск DMA, поэтому его пакет - цикл по сообщениям; выигрыш пакета -
+ * у программных бэкендов (swar - два сообщения за проход).
+ * 
+ * ПРОВЕРКА NONCE:
+ * hasher_sha256d_nonces() - заголовки одного задания, отличающиеся только
+ * nonce. Программные бэкенды считают состояние первых 64 байт (midstate)
+ * один раз: на nonce два сжатия вместо трёх. Ускоритель получает
+ * заголовки целиком.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __HASHER_H__
+#define __HASHER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Бэкенды
+ */
+#define HASHER_AUTO             0   /* Самый быстрый по замеру */
+#define HASHER_SOFT             1
+#define HASHER_HARD             2
+#define HASHER_SWAR             3
+#define HASHER_COUNT            4
+
+/**
+ * @brief Сообщений в одном пакете бэкенда (больше - частями)
+ */
+#define HASHER_BATCH_MAX        16
+
+/**
+ * @brief Пакетов в замере одной длины
+ */
+#define HASHER_BENCH_ROUNDS     16
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct hasher_ops_t
+ * @brief Таблица операций бэкенда
+ */
+typedef struct hasher_ops {
+    const char *name;                       /* Имя для API и лога */
+    int (*init)(void);                      /* 0 - бэкенд доступен */
+    void (*sha256)(const uint8_t *data, size_t len, uint8_t *hash);
+    /* n сообщений по len байт подряд, n хэшей по 32 байта */
+    void (*sha256d_batch)(const uint8_t *data, size_t len, int n, uint8_t *hash);
+    /* n заголовков (80 байт) с nonces[i] в байтах 76-79; NULL - через sha256d_batch */
+    void (*sha256d_nonces)(const uint8_t *header, const uint32_t *nonces, int n, uint8_t *hash);
+} hasher_ops_t;
+
+/**
+ * @struct hasher_stats_t
+ * @brief Состояние бэкенда (для API)
+ */
+typedef struct hasher_stats {
+    uint8_t available;                      /* Прошёл проверку известным ответом */
+    uint32_t ns80;                          /* SHA256d заголовка по nonce (нс, 0 = нет замера) */
+    uint32_t ns64;                          /* SHA256d 64 байт (нс) */
+    uint64_t hashes;                        /* Посчитано SHA256d */
+} hasher_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Проверка и замер бэкендов, выбор по g_config.hasher
+ * 
+ * До первого хэша задачи validator.
+ */
+void hasher_init(void);
+
+/**
+ * @brief Выбор бэкенда
+ * 
+ * @param type      HASHER_*
+ * @return          0 при успехе, -1 если бэкенд недоступен
+ */
+int hasher_select(int type);
+
+/**
+ * @brief Бэкенд, который считает сейчас
+ * @return          HASHER_SOFT / HASHER_HARD / HASHER_SWAR
+ */
+int hasher_active(void);
+
+/**
+ * @brief Замер всех доступных бэкендов заново
+ * 
+ * При HASHER_AUTO выбор по новому замеру.
+ */
+void hasher_bench(void);
+
+/**
+ * @brief Имя бэкенда ("auto", "soft", "hard", "swar")
+ */
+const char *hasher_name(int type);
+
+/**
+ * @brief Поиск бэкенда по имени
+ * @return          HASHER_* или -1
+ */
+int hasher_parse(const char *name);
+
+/**
+ * @brief SHA256
+ */
+void hasher_sha256(const uint8_t *data, size_t len, uint8_t *hash);
+
+/**
+ * @brief SHA256d (SHA256(SHA256(data)))
+ */
+void hasher_sha256d(const uint8_t *data, size_t len, uint8_t *hash);
+
+/**
+ * @brief SHA256d n сообщений одной длины
+ * 
+ * @param data      Сообщения по len байт подряд
+ * @param len       Длина сообщения
+ * @param n         Количество
+ * @param hash      n хэшей по 32 байта
+ */
+void hasher_sha256d_batch(const uint8_t *data, size_t len, int n, uint8_t *hash);
+
+/**
+ * @brief SHA256d заголовков одного задания с разными nonce
+ * 
+ * @param header    Заголовок (80 байт), байты 76-79 не используются
+ * @param nonces    n nonce (в заголовок little-endian)
+ * @param n         Количество
+ * @param hash      n хэшей по 32 байта
+ */
+void hasher_sha256d_nonces(const uint8_t *header, const uint32_t *nonces, int n, uint8_t *hash);
+
+/**
+ * @brief Состояние бэкенда
+ * @return          NULL при неверном типе
+ */
+const hasher_stats_t *hasher_get_stats(int type);
+
+#endif /* __HASHER_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА hasher.h
+ * =========================================================================== */
@@ -0,0 +1,331 @@
+/**
+ * =============================================================================
+ * @file    health.c
+ * @brief   Avalon A1126pro - Выключение сбойных чипов (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Окна HW ошибок по чипам и модулям, выключение чипов из раздачи
+ * заданий и пробы с отступом по времени.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include "health.h"
+#include "cgminer.h"
+#include "autotune.h"
+#include "throttle.h"
+#include "recovery.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Health";
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static health_chip_t chips[AVALON10_DEFAULT_MODULARS][AVALON10_DEFAULT_MINER_CNT];
+static health_module_t mods[AVALON10_DEFAULT_MODULARS];
+static health_stats_t stats;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Начало нового окна чипа
+ */
+static void window_start(health_chip_t *hc, const avalon10_chip_t *chip, uint32_t now)
+{
+    cgminer_window_start(&hc->win, now, chip->nonces, chip->hw_errors);
+}
+
+/**
+ * @brief Окно модуля: доля HW ошибок всех чипов за HEALTH_MODULE_WINDOW_S
+ */
+static void module_window(const avalon10_module_t *module, health_module_t *hm, uint32_t now)
+{
+    uint64_t total = module->diff1 + module->hw_errors;
+    
+    if (!cgminer_window_check(&hm->win, now, total, module->hw_errors)) {
+        hm->rate = 1000;
+        return;
+    }
+    
+    if (now - hm->win.at < HEALTH_MODULE_WINDOW_S) {
+        return;
+    }
+    
+    hm->rate = total > hm->win.count0 ?
+               (uint16_t)((uint64_t)(module->hw_errors - hm->win.hw0) * 1000 /
+                          (total - hm->win.count0)) :
+               1000;
+    cgminer_window_start(&hm->win, now, total, module->hw_errors);
+}
+
+/**
+ * @brief Выключение чипа
+ */
+static void chip_isolate(avalon10_info_t *info, int m, int c, uint32_t now)
+{
+    health_chip_t *hc = &chips[m][c];
+    
+    if (avalon10_set_chip_enable(info, m, c, 0) != 0) {
+        return;
+    }
+    
+    if (hc->state == HEALTH_CHIP_PROBE && hc->probes < 0xFF) {
+        hc->probes++;
+    }
+    hc->state = HEALTH_CHIP_ISOLATED;
+    hc->isolated_at = now;
+    hc->win.at = 0;
+    hc->isolations++;
+    stats.isolations++;
+    stats.changed_at = now;
+    
+    log_message(LOG_WARNING, "%s: Модуль %d чип %d выключен: HW ошибок %u‰, проба через %lu с",
+               TAG, m, c, hc->rate,
+               (unsigned long)HEALTH_REPROBE_S << MIN(hc->probes, HEALTH_REPROBE_MAX_SHIFT));
+}
+
+/**
+ * @brief Проба выключенного чипа на минимальной частоте
+ */
+static void chip_probe(avalon10_info_t *info, int m, int c, uint32_t now)
+{
+    health_chip_t *hc = &chips[m][c];
+    
+    avalon10_set_chip_freq(info, m, c, info->default_freq[0]);
+    if (avalon10_set_chip_enable(info, m, c, 1) != 0) {
+        return;
+    }
+    
+    autotune_reset_chip(m, c);
+    hc->state = HEALTH_CHIP_PROBE;
+    window_start(hc, &info->modules[m].chips[c], now);
+    stats.changed_at = now;
+    
+    log_message(LOG_INFO, "%s: Модуль %d чип %d: проба на %d MHz",
+               TAG, m, c, info->default_freq[0]);
+}
+
+/**
+ * @brief Шаг оценки одного чипа
+ * 
+ * @param blame     1 = остальной модуль исправен, чип можно выключать
+ */
+static void chip_step(avalon10_info_t *info, int m, int c, int blame, uint32_t now)
+{
+    avalon10_chip_t *chip = &info->modules[m].chips[c];
+    health_chip_t *hc = &chips[m][c];
+    uint32_t nonces, hw;
+    int burst;
+    
+    /* Выключен не здесь (запись tune_store) - в общее расписание проб */
+    if (!chip->enabled && hc->state != HEALTH_CHIP_ISOLATED) {
+        hc->state = HEALTH_CHIP_ISOLATED;
+        hc->isolated_at = now;
+        hc->win.at = 0;
+    }
+    
+    if (hc->state == HEALTH_CHIP_ISOLATED) {
+        uint32_t wait = (uint32_t)HEALTH_REPROBE_S << MIN(hc->probes, HEALTH_REPROBE_MAX_SHIFT);
+    
+        if (now - hc->isolated_at >= wait && !throttle_active(m)) {
+            chip_probe(info, m, c, now);
+        }
+        return;
+    }
+    
+    if (!cgminer_window_check(&hc->win, now, chip->nonces, chip->hw_errors)) {
+        return;
+    }
+    
+    nonces = chip->nonces - (uint32_t)hc->win.count0;
+    hw = chip->hw_errors - hc->win.hw0;
+    burst = chip->error_count >= HEALTH_BURST_ERRORS;
+    
+    if (!burst && nonces < HEALTH_WINDOW_NONCES) {
+        if (now - hc->win.at < HEALTH_WINDOW_MAX_S) {
+            return;
+        }
+        /* Проба без nonce не пройдена, рабочий чип просто медленный */
+        if (hc->state == HEALTH_CHIP_PROBE) {
+            hc->rate = 1000;
+            chip_isolate(info, m, c, now);
+            return;
+        }
+        window_start(hc, chip, now);
+        return;
+    }
+    
+    hc->rate = nonces ? (uint16_t)(hw * 1000 / nonces) : 1000;
+    
+    if ((burst || hc->rate >= HEALTH_BAD_PCT * 10) && blame) {
+        chip_isolate(info, m, c, now);
+        return;
+    }
+    
+    if (hc->state == HEALTH_CHIP_PROBE) {
+        if (hc->rate < HEALTH_OK_PCT * 10) {
+            hc->state = HEALTH_CHIP_OK;
+            hc->probes = 0;
+            stats.recoveries++;
+            stats.changed_at = now;
+            log_message(LOG_INFO, "%s: Модуль %d чип %d снова в работе (HW ошибок %u‰)",
+                       TAG, m, c, hc->rate);
+        } else if (blame) {
+            chip_isolate(info, m, c, now);
+            return;
+        }
+    }
+    
+    window_start(hc, chip, now);
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг оценки
+ */
+void health_poll(avalon10_info_t *info)
+{
+    uint32_t now = cgminer_time_s();
+    int isolated = 0, probing = 0;
+    
+    if (!info || !info->initialized || !info->mining_enabled) {
+        return;
+    }
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        avalon10_module_t *module = &info->modules[m];
+        health_module_t *hm = &mods[m];
+        int blame;
+    
+        if (module->state != AVALON10_MODULE_STATE_MINING) {
+            hm->win.at = 0;
+            continue;
+        }
+    
+        module_window(module, hm, now);
+        blame = hm->rate < HEALTH_MODULE_OK_PCT * 10;
+    
+        for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            chip_step(info, m, c, blame, now);
+            isolated += chips[m][c].state == HEALTH_CHIP_ISOLATED;
+            probing += chips[m][c].state == HEALTH_CHIP_PROBE;
+        }
+    
+        /* Сбойных чипов слишком много - неисправен модуль: сброс, паузы
+         * и возврат ведёт recovery, сам модуль из MINING здесь не выводится */
+        if (module->failed_chips * 100 >= AVALON10_DEFAULT_MINER_CNT * HEALTH_MODULE_FAIL_PCT &&
+            recovery_get_module(m)->state == RECOVERY_WATCH &&
+            recovery_request(m, RECOVERY_REASON_CHIPS) == 0) {
+            stats.module_errors++;
+            stats.changed_at = now;
+            log_message(LOG_ERR, "%s: Модуль %d: выключено %d чипов из %d, модуль неисправен",
+                       TAG, m, module->failed_chips, AVALON10_DEFAULT_MINER_CNT);
+        }
+    }
+    
+    stats.isolated = (uint16_t)isolated;
+    stats.probing = (uint16_t)probing;
+}
+
+/**
+ * @brief Проба всех выключенных чипов на следующем шаге
+ */
+void health_reprobe(int module_id)
+{
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        if (module_id >= 0 && m != module_id) {
+            continue;
+        }
+        for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            if (chips[m][c].state == HEALTH_CHIP_ISOLATED) {
+                chips[m][c].isolated_at = 0;
+                chips[m][c].probes = 0;
+            }
+        }
+    }
+    
+    log_message(LOG_INFO, "%s: Проба выключенных чипов (модуль %d)", TAG, module_id);
+}
+
+/**
+ * @brief Проба всех выключенных чипов модуля сейчас (после сброса)
+ */
+void health_release(avalon10_info_t *info, int module_id)
+{
+    uint32_t now = cgminer_time_s();
+    int n = 0;
+    
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return;
+    }
+    
+    for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+        health_chip_t *hc = &chips[module_id][c];
+    
+        if (hc->state == HEALTH_CHIP_ISOLATED || !info->modules[module_id].chips[c].enabled) {
+            hc->probes = 0;
+            chip_probe(info, module_id, c, now);
+            n++;
+        }
+    }
+    mods[module_id].win.at = 0;
+    
+    log_message(LOG_INFO, "%s: Модуль %d после сброса: %d чипов на пробу (выключено %d)",
+               TAG, module_id, n, info->modules[module_id].failed_chips);
+}
+
+/**
+ * @brief Состояние чипа
+ */
+const health_chip_t *health_get_chip(int module_id, int chip_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        chip_id < 0 || chip_id >= AVALON10_DEFAULT_MINER_CNT) {
+        return NULL;
+    }
+    
+    return &chips[module_id][chip_id];
+}
+
+/**
+ * @brief Окно оценки модуля
+ */
+const health_module_t *health_get_module(int module_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return NULL;
+    }
+    
+    return &mods[module_id];
+}
+
+/**
+ * @brief Состояние
+ */
+const health_stats_t *health_get_stats(void)
+{
+    return &stats;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА health.c
+ * =========================================================================== */
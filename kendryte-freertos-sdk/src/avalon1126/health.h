@@ -0,0 +1,192 @@
+/**
+ * =============================================================================
+ * @file    health.h
+ * @brief   Avalon A1126pro - Выключение сбойных чипов (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Чип, который отдаёт почти одни HW ошибки, занимает очередь модуля, шину
+ * и validator, не давая хэшрейта. Модуль выключает его из раздачи заданий
+ * (avalon10_set_chip_enable), и сбойный чип стоит только своего хэшрейта.
+ * 
+ * АЛГОРИТМ (раз в секунду, для каждого включённого чипа):
+ * - Окно - HEALTH_WINDOW_NONCES проверенных nonce чипа. Доля HW ошибок от
+ *   HEALTH_BAD_PCT или HEALTH_BURST_ERRORS ошибок подряд - чип
+ *   выключается.
+ * - Только если остальной модуль исправен: доля HW ошибок модуля за
+ *   прошлое окно HEALTH_MODULE_WINDOW_S ниже HEALTH_MODULE_OK_PCT. Если
+ *   ошибаются все чипы, причина в задании, напряжении или транспорте, а
+ *   не в чипах.
+ * - Через HEALTH_REPROBE_S (удваивается после каждой неудачной пробы, до
+ *   2^HEALTH_REPROBE_MAX_SHIFT раз) чип включается на минимальной частоте.
+ *   Окно пробы с долей ошибок ниже HEALTH_OK_PCT возвращает чип в работу
+ *   (дальше частоту поднимает autotune), иначе чип выключается снова.
+ * - Выключено HEALTH_MODULE_FAIL_PCT % чипов модуля и больше - модуль
+ *   неисправен: сброс через recovery (RECOVERY_REASON_CHIPS) с его
+ *   паузами между попытками. Ответивший после сброса модуль включает все
+ *   выключенные чипы на пробу (health_release).
+ * 
+ * Чипы, выключенные в записи tune_store, после загрузки считаются
+ * выключенными сейчас и проходят пробу по тому же расписанию.
+ * Пока модуль в снижении (throttle), пробы не начинаются: частотами
+ * управляет throttle.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __HEALTH_H__
+#define __HEALTH_H__
+
+#include <stdint.h>
+
+#include "avalon10.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Проверенных nonce в окне оценки чипа
+ */
+#define HEALTH_WINDOW_NONCES        64
+
+/**
+ * @brief Окно без достаточного числа nonce начинается заново (секунды)
+ * Для пробы - проба не пройдена
+ */
+#define HEALTH_WINDOW_MAX_S         600
+
+/**
+ * @brief Доля HW ошибок, при которой чип выключается (%)
+ */
+#define HEALTH_BAD_PCT              50
+
+/**
+ * @brief Доля HW ошибок, при которой проба пройдена (%)
+ */
+#define HEALTH_OK_PCT               10
+
+/**
+ * @brief HW ошибок подряд - выключение, не дожидаясь конца окна
+ * Выше AUTOTUNE_BURST_ERRORS: сначала частоту снижает autotune
+ */
+#define HEALTH_BURST_ERRORS         64
+
+/**
+ * @brief Окно оценки модуля целиком (секунды) и доля HW ошибок
+ *        остального модуля, при которой чип можно винить (%)
+ */
+#define HEALTH_MODULE_WINDOW_S      60
+#define HEALTH_MODULE_OK_PCT        10
+
+/**
+ * @brief Доля выключенных чипов, при которой модуль неисправен (%)
+ */
+#define HEALTH_MODULE_FAIL_PCT      25
+
+/**
+ * @brief Пауза до пробы выключенного чипа (секунды) и предел удвоений
+ * 15 мин, 30 мин, ... 4 ч
+ */
+#define HEALTH_REPROBE_S            900
+#define HEALTH_REPROBE_MAX_SHIFT    4
+
+/**
+ * @brief Состояния чипа
+ */
+#define HEALTH_CHIP_OK              0   /* Работает */
+#define HEALTH_CHIP_ISOLATED        1   /* Выключен */
+#define HEALTH_CHIP_PROBE           2   /* Включён для пробы */
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct health_chip_t
+ * @brief Состояние чипа
+ */
+typedef struct health_chip {
+    uint8_t state;                  /* HEALTH_CHIP_* */
+    uint8_t probes;                 /* Неудачных проб подряд */
+    uint16_t rate;                  /* Доля HW ошибок прошлого окна (‰) */
+    cgminer_window_t win;           /* Окно chip->nonces / chip->hw_errors */
+    uint32_t isolated_at;           /* Когда выключен (с) */
+    uint32_t isolations;            /* Выключений с начала работы */
+} health_chip_t;
+
+/**
+ * @struct health_module_t
+ * @brief Окно оценки модуля
+ */
+typedef struct health_module {
+    cgminer_window_t win;           /* Окно diff1 + hw_errors / hw_errors модуля */
+    uint16_t rate;                  /* Доля HW ошибок прошлого окна (‰, 1000 = нет данных) */
+} health_module_t;
+
+/**
+ * @struct health_stats_t
+ * @brief Состояние (для API)
+ */
+typedef struct health_stats {
+    uint16_t isolated;              /* Чипов выключено */
+    uint16_t probing;               /* Чипов в пробе */
+    uint32_t isolations;            /* Выключений */
+    uint32_t recoveries;            /* Проб, вернувших чип в работу */
+    uint32_t module_errors;         /* Модулей, признанных неисправными */
+    uint32_t changed_at;            /* uptime последнего выключения/включения (с) */
+} health_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг оценки (раз в секунду, задача monitor, перед autotune_poll)
+ * 
+ * @param info      Указатель на структуру информации
+ */
+void health_poll(avalon10_info_t *info);
+
+/**
+ * @brief Проба всех выключенных чипов на следующем шаге
+ * 
+ * @param module_id ID модуля (-1 = все)
+ */
+void health_reprobe(int module_id);
+
+/**
+ * @brief Проба всех выключенных чипов модуля сейчас (после сброса)
+ * 
+ * Чипы включаются на минимальной частоте и считаются выключенными
+ * заново, только если не пройдут пробу.
+ * 
+ * @param info      Указатель на структуру информации
+ * @param module_id ID модуля
+ */
+void health_release(avalon10_info_t *info, int module_id);
+
+/**
+ * @brief Состояние чипа
+ * @return          NULL при неверных номерах
+ */
+const health_chip_t *health_get_chip(int module_id, int chip_id);
+
+/**
+ * @brief Окно оценки модуля
+ * @return          NULL при неверном номере
+ */
+const health_module_t *health_get_module(int module_id);
+
+/**
+ * @brief Состояние
+ */
+const health_stats_t *health_get_stats(void);
+
+#endif /* __HEALTH_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА health.h
+ * =========================================================================== */
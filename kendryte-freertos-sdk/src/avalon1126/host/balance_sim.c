@@ -0,0 +1,357 @@
+/**
+ * =============================================================================
+ * @file    balance_sim.c
+ * @brief   Avalon A1126pro - Тепловая балансировка на модели (хост)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * balance.c прошивки без изменений на модели питания и нагрева
+ * (mock_thermal.c): четыре модуля на 780 mV / 500 МГц с разным обдувом
+ * (MOCK_AIRFLOW_PCT), вентиляторы на постоянных SIM_FAN_PCT. Доля из
+ * throttle_set_limit() исполняется сразу - частотой всех чипов модуля;
+ * balance_poll() зовётся раз в секунду, как в monitor_task. Бюджет -
+ * SIM_BUDGET_OF_CAP ёмкости: доли не упираются в границы, где поправка
+ * обрезается и нулевая сумма не обязана держаться.
+ * Для режимов power и hashrate проверяется:
+ * - в каждом пересчёте поправки в сумме (с весом ёмкости) равны нулю;
+ * - доли устанавливаются: за последние SIM_SETTLE_ROUNDS пересчётов
+ *   меняются не больше SIM_SETTLE_PCT;
+ * - общий бюджет выдержан, а разброс температур меньше, чем без
+ *   балансировки.
+ * Ключ -v печатает доли и температуры каждого пересчёта. Не входит в
+ * прошивку.
+ * 
+ * СБОРКА (из каталога host):
+ *   cc -O2 -DMOCK_HARDWARE=1 -DMOCK_ASIC=1 -Ishim -I.. ../balance.c \
+ *      ../mock_thermal.c balance_sim.c -lm -o balance_sim
+ * 
+ * Код возврата 1 - проверка не прошла.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+
+#include "balance.h"
+#include "efficiency.h"
+#include "throttle.h"
+#include "mock_hardware.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+#define SIM_MODULES         AVALON10_DEFAULT_MODULARS
+#define SIM_CHIPS           AVALON10_DEFAULT_MINER_CNT
+#define SIM_FREQ            500     /* Частота чипов при 100% доли (МГц) */
+#define SIM_GHS_PER_MHZ     0.28f   /* Хэшрейт чипа на МГц, как efficiency_sim */
+#define SIM_FAN_PCT         60      /* Обороты вентиляторов (%) */
+#define SIM_BASELINE_S      1800    /* Прогон без балансировки */
+#define SIM_RUN_S           7200    /* Прогон режима */
+#define SIM_BUDGET_OF_CAP   80      /* Бюджет от ёмкости при 100% доли (%) */
+
+/* Допуски */
+#define SIM_ZERO_PCT        0.01f   /* |Σ o·C| / ΣC (% доли) */
+#define SIM_SETTLE_ROUNDS   10      /* Пересчётов в окне установления */
+#define SIM_SETTLE_PCT      0.5f    /* Изменение доли за окно (%) */
+#define SIM_BUDGET_PCT      1.0f    /* Σ s·C против бюджета (%) */
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static avalon10_info_t info;
+static throttle_module_t thr[SIM_MODULES];
+static float temp_model[SIM_MODULES];
+static uint32_t sim_s;
+static int verbose;
+
+/* ===========================================================================
+ * ЗАМЕНЫ ФУНКЦИЙ ПРОШИВКИ
+ * =========================================================================== */
+
+cgminer_config_t g_config;
+
+void log_message(int level, const char *fmt, ...)
+{
+    va_list ap;
+    
+    if (!verbose && level > LOG_WARNING) {
+        return;
+    }
+    
+    printf("[%6u] ", sim_s);
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+}
+
+uint64_t cgminer_time_us(void)
+{
+    return sim_s * 1000000ULL;
+}
+
+uint32_t cgminer_time_s(void)
+{
+    return sim_s;
+}
+
+/* Как в efficiency.c при достоверной телеметрии */
+uint32_t efficiency_module_power(const avalon10_module_t *module)
+{
+    return module->power;
+}
+
+/* Лимит исполняется сразу: частоты всех чипов по доле */
+void throttle_set_limit(int module_id, int source, float pct)
+{
+    throttle_module_t *tm = &thr[module_id];
+    float share = pct > 0.0f ? pct : 100.0f;
+    
+    tm->limit[source] = pct;
+    tm->engaged = share < 100.0f;
+    tm->applied = share;
+    tm->duty = 100;
+    
+    for (int c = 0; c < SIM_CHIPS; c++) {
+        info.modules[module_id].chips[c].freq = (uint16_t)(SIM_FREQ * share / 100.0f + 0.5f);
+    }
+}
+
+const throttle_module_t *throttle_get_module(int module_id)
+{
+    return &thr[module_id];
+}
+
+/* ===========================================================================
+ * МОДЕЛЬ
+ * =========================================================================== */
+
+/**
+ * @brief Секунда работы модулей
+ */
+static void sim_step(void)
+{
+    static const uint8_t airflow_pct[MOCK_ASIC_MODULES] = MOCK_AIRFLOW_PCT;
+    static const uint8_t chip_off[SIM_CHIPS];
+    
+    for (int m = 0; m < SIM_MODULES; m++) {
+        avalon10_module_t *module = &info.modules[m];
+        uint16_t freq[SIM_CHIPS];
+        float ghs = 0.0f;
+    
+        for (int c = 0; c < SIM_CHIPS; c++) {
+            freq[c] = module->chips[c].freq;
+            ghs += freq[c] * SIM_GHS_PER_MHZ;
+        }
+    
+        module->power = mock_thermal_power(m, module->voltage, module->temp_out,
+                                           freq, chip_off, 1);
+        temp_model[m] = mock_thermal_temp(temp_model[m], module->temp_in, module->power,
+                                          SIM_FAN_PCT * airflow_pct[m] / 100, 1000);
+        module->temp_out = (int16_t)(temp_model[m] + 0.5f);
+        module->temp_max = module->temp_out;
+        module->ghs[AVALON10_HASHRATE_1M] = ghs;
+    }
+}
+
+/**
+ * @brief Разброс температур модулей (°C)
+ */
+static float temp_spread(void)
+{
+    int16_t lo = info.modules[0].temp_max, hi = lo;
+    
+    for (int m = 1; m < SIM_MODULES; m++) {
+        if (info.modules[m].temp_max < lo) lo = info.modules[m].temp_max;
+        if (info.modules[m].temp_max > hi) hi = info.modules[m].temp_max;
+    }
+    return (hi - lo) / 10.0f;
+}
+
+/**
+ * @brief Сумма поправок с весом ёмкости (% доли)
+ */
+static float offset_sum(void)
+{
+    float osum = 0.0f, csum = 0.0f;
+    
+    for (int m = 0; m < SIM_MODULES; m++) {
+        const balance_module_t *bm = balance_get_module(m);
+    
+        osum += bm->offset * bm->capacity;
+        csum += bm->capacity;
+    }
+    return csum > 0.0f ? osum / csum : 0.0f;
+}
+
+/**
+ * @brief Прогон без балансировки
+ * 
+ * @return          Разброс температур в конце (°C)
+ */
+static float run_off(int seconds)
+{
+    g_config.balance = BALANCE_MODE_OFF;
+    for (int s = 0; s < seconds; s++) {
+        sim_s++;
+        sim_step();
+        balance_poll(&info);
+    }
+    return temp_spread();
+}
+
+/**
+ * @brief Прогон режима и проверки
+ * 
+ * @param mode      BALANCE_MODE_*
+ * @param name      Имя режима для вывода
+ * @param spread0   Разброс температур без балансировки (°C)
+ * @return          Число непройденных проверок
+ */
+static int run_mode(int mode, const char *name, float spread0)
+{
+    float hist[SIM_SETTLE_ROUNDS][SIM_MODULES];
+    float zero = 0.0f, drift = 0.0f, used = 0.0f, capacity = 0.0f, spread;
+    const balance_stats_t *st = balance_get_stats();
+    uint32_t rounds;
+    int n = 0, bad = 0;
+    
+    /* Ёмкость при 100% доли - после прогона без балансировки */
+    run_off(60);
+    for (int m = 0; m < SIM_MODULES; m++) {
+        capacity += mode == BALANCE_MODE_POWER ? info.modules[m].power :
+                    info.modules[m].ghs[AVALON10_HASHRATE_1M];
+    }
+    g_config.balance_budget = (int)(capacity * SIM_BUDGET_OF_CAP / 100.0f);
+    g_config.balance = mode;
+    rounds = st->rounds;
+    
+    for (uint32_t end = sim_s + SIM_RUN_S; sim_s < end; ) {
+        sim_s++;
+        sim_step();
+        balance_poll(&info);
+    
+        if (st->rounds == rounds) {
+            continue;
+        }
+        rounds = st->rounds;
+    
+        if (fabsf(offset_sum()) > zero) {
+            zero = fabsf(offset_sum());
+        }
+        for (int m = 0; m < SIM_MODULES; m++) {
+            hist[n % SIM_SETTLE_ROUNDS][m] = balance_get_module(m)->share;
+        }
+        n++;
+    
+        if (verbose) {
+            printf("  %5u с  u %5.1f%%", sim_s, (double)st->base);
+            for (int m = 0; m < SIM_MODULES; m++) {
+                printf("  %5.1f%% %4.1f°C", (double)balance_get_module(m)->share,
+                       info.modules[m].temp_max / 10.0);
+            }
+            printf("\n");
+        }
+    }
+    
+    for (int m = 0; m < SIM_MODULES; m++) {
+        float lo = hist[0][m], hi = lo;
+    
+        for (int i = 1; i < SIM_SETTLE_ROUNDS; i++) {
+            if (hist[i][m] < lo) lo = hist[i][m];
+            if (hist[i][m] > hi) hi = hist[i][m];
+        }
+        if (hi - lo > drift) {
+            drift = hi - lo;
+        }
+        used += balance_get_module(m)->share * balance_get_module(m)->capacity / 100.0f;
+    }
+    spread = temp_spread();
+    
+    printf("%s: бюджет %.0f из %.0f, израсходовано %.0f, разброс %.1f°C (без балансировки %.1f°C)\n",
+           name, (double)st->budget, (double)st->capacity, (double)used,
+           (double)spread, (double)spread0);
+    printf("  доли");
+    for (int m = 0; m < SIM_MODULES; m++) {
+        printf(" %.1f%%", (double)balance_get_module(m)->share);
+    }
+    printf(", Σ поправок %.4f%%, дрейф за %d пересчётов %.2f%%\n",
+           (double)zero, SIM_SETTLE_ROUNDS, (double)drift);
+    
+    if (n < SIM_SETTLE_ROUNDS) {
+        printf("FAIL: %s: %d пересчётов\n", name, n);
+        return 1;
+    }
+    if (zero > SIM_ZERO_PCT) {
+        printf("FAIL: %s: сумма поправок не ноль\n", name);
+        bad++;
+    }
+    if (drift > SIM_SETTLE_PCT) {
+        printf("FAIL: %s: доли не установились\n", name);
+        bad++;
+    }
+    if (fabsf(used - st->budget) > st->budget * SIM_BUDGET_PCT / 100.0f) {
+        printf("FAIL: %s: бюджет не выдержан\n", name);
+        bad++;
+    }
+    if (spread >= spread0) {
+        printf("FAIL: %s: разброс температур не уменьшился\n", name);
+        bad++;
+    }
+    
+    return bad;
+}
+
+/* ===========================================================================
+ * ТОЧКА ВХОДА
+ * =========================================================================== */
+
+int main(int argc, char **argv)
+{
+    float spread0;
+    int bad = 0;
+    
+    verbose = argc > 1 && !strcmp(argv[1], "-v");
+    
+    info.initialized = 1;
+    info.mining_enabled = 1;
+    for (int m = 0; m < SIM_MODULES; m++) {
+        avalon10_module_t *module = &info.modules[m];
+    
+        module->module_id = (uint8_t)m;
+        module->state = AVALON10_MODULE_STATE_MINING;
+        module->voltage = AVALON10_DEFAULT_VOLTAGE;
+        module->temp_in = MOCK_TEMP_IN;
+        module->temp_out = MOCK_TEMP_IN;
+        temp_model[m] = MOCK_TEMP_IN;
+        for (int c = 0; c < SIM_CHIPS; c++) {
+            module->chips[c].enabled = 1;
+            module->chips[c].freq = SIM_FREQ;
+        }
+    }
+    
+    /* Без балансировки: разброс от разного обдува */
+    spread0 = run_off(SIM_BASELINE_S);
+    
+    bad += run_mode(BALANCE_MODE_POWER, "power", spread0);
+    bad += run_mode(BALANCE_MODE_HASHRATE, "hashrate", spread0);
+    
+    printf("Итог: %s\n", bad ? "ОШИБКИ" : "OK");
+    
+    return bad ? 1 : 0;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА balance_sim.c
+ * =========================================================================== */
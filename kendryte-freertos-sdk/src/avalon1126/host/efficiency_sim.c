@@ -0,0 +1,377 @@
+/**
+ * =============================================================================
+ * @file    efficiency_sim.c
+ * @brief   Avalon A1126pro - Подбор напряжения на модели (хост)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * efficiency.c прошивки без изменений на модели питания и нагрева
+ * эмулятора (mock_thermal.c): четыре модуля, шаг - секунда, как у
+ * monitor_task. Вместо autotune - потолок частоты чипа, растущий с
+ * напряжением (SIM_VTH), выставляется через SIM_TUNE_S после сброса.
+ * Итог поиска сверяется с перебором установившихся точек той же модели:
+ * - JTH: J/TH выбранной точки не хуже минимума больше чем на SIM_TOL_PCT;
+ * - CAP: мощность под лимитом, хэшрейт не ниже лучшей точки под лимитом.
+ * Не входит в прошивку.
+ * 
+ * СБОРКА (из каталога host):
+ *   cc -O2 -DMOCK_HARDWARE=1 -DMOCK_ASIC=1 -Ishim -I.. ../efficiency.c \
+ *      ../mock_thermal.c efficiency_sim.c -o efficiency_sim
+ * 
+ * Ключ -v - журнал efficiency.c. Код возврата 1 - поиск не сошёлся или
+ * точка хуже перебора.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "efficiency.h"
+#include "autotune.h"
+#include "throttle.h"
+#include "mock_hardware.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+#define SIM_MODULES         AVALON10_DEFAULT_MODULARS
+#define SIM_CHIPS           AVALON10_DEFAULT_MINER_CNT
+#define SIM_FREQ_780        500     /* Потолок частоты при 780 mV (МГц) */
+#define SIM_VTH             680     /* Напряжение, при котором потолок 0 (mV) */
+#define SIM_FREQ_MIN        100     /* Нижняя граница потолка (МГц) */
+#define SIM_GHS_PER_MHZ     0.28f   /* Хэшрейт чипа на МГц (~64 TH/s при 500 МГц) */
+#define SIM_TUNE_S          60      /* Подбор частот после autotune_reset() */
+#define SIM_FAN_PCT         60      /* Обороты вентиляторов (%) */
+#define SIM_RUN_MAX_S       (12 * 3600)
+#define SIM_TOL_PCT         1.0f    /* Допуск сверки с перебором */
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static avalon10_info_t info;
+static autotune_chip_t tune[SIM_MODULES][SIM_CHIPS];
+static uint32_t tune_at[SIM_MODULES];
+static double diff1_acc[SIM_MODULES];
+static float temp_model[SIM_MODULES];
+static uint32_t sim_s;
+static int verbose;
+
+/* ===========================================================================
+ * ЗАМЕНЫ ФУНКЦИЙ ПРОШИВКИ
+ * =========================================================================== */
+
+cgminer_config_t g_config;
+
+void log_message(int level, const char *fmt, ...)
+{
+    va_list ap;
+    
+    if (!verbose && level > LOG_WARNING) {
+        return;
+    }
+    
+    printf("[%6u] ", sim_s);
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+}
+
+uint64_t cgminer_time_us(void)
+{
+    return sim_s * 1000000ULL;
+}
+
+uint32_t cgminer_time_s(void)
+{
+    return sim_s;
+}
+
+int avalon10_set_voltage(avalon10_info_t *inf, int module_id, int voltage)
+{
+    inf->modules[module_id].voltage = (uint16_t)voltage;
+    return 0;
+}
+
+int avalon10_set_chip_freq(avalon10_info_t *inf, int module_id, int chip_id, int freq)
+{
+    inf->modules[module_id].chips[chip_id].freq = (uint16_t)freq;
+    return 0;
+}
+
+void autotune_reset(int module_id)
+{
+    for (int c = 0; c < SIM_CHIPS; c++) {
+        tune[module_id][c].state = AUTOTUNE_CHIP_PROBE;
+    }
+    tune_at[module_id] = sim_s;
+}
+
+const autotune_chip_t *autotune_get_chip(int module_id, int chip_id)
+{
+    return &tune[module_id][chip_id];
+}
+
+int throttle_active(int module_id)
+{
+    (void)module_id;
+    return 0;
+}
+
+/* ===========================================================================
+ * МОДЕЛЬ
+ * =========================================================================== */
+
+/**
+ * @brief Потолок частоты чипа: линейно от SIM_VTH, разброс чипов ±5%
+ */
+static uint16_t freq_max(int c, int voltage)
+{
+    int f = SIM_FREQ_780 * (voltage - SIM_VTH) / (780 - SIM_VTH);
+    
+    f = f * (100 + (c * 37) % 11 - 5) / 100;
+    return (uint16_t)(f < SIM_FREQ_MIN ? SIM_FREQ_MIN : f);
+}
+
+/**
+ * @brief Обдув модуля (%)
+ */
+static int airflow(int m)
+{
+    static const uint8_t airflow_pct[MOCK_ASIC_MODULES] = MOCK_AIRFLOW_PCT;
+    
+    return SIM_FAN_PCT * airflow_pct[m] / 100;
+}
+
+/**
+ * @brief Установившаяся точка модуля при напряжении voltage
+ */
+static void steady_point(int m, int voltage, uint16_t *power, float *ghs)
+{
+    static const uint8_t chip_off[SIM_CHIPS];
+    uint16_t freq[SIM_CHIPS];
+    float temp = MOCK_TEMP_IN;
+    
+    *ghs = 0.0f;
+    for (int c = 0; c < SIM_CHIPS; c++) {
+        freq[c] = freq_max(c, voltage);
+        *ghs += freq[c] * SIM_GHS_PER_MHZ;
+    }
+    
+    /* Утечка зависит от температуры - шаги по 10 постоянных времени */
+    for (int i = 0; i < 100; i++) {
+        *power = mock_thermal_power(m, (uint16_t)voltage, (int16_t)temp, freq, chip_off, 1);
+        temp = mock_thermal_temp(temp, MOCK_TEMP_IN, *power, airflow(m),
+                                 10 * MOCK_THERMAL_TAU_MS);
+    }
+}
+
+/**
+ * @brief Секунда работы модулей и подбора частот
+ */
+static void sim_step(void)
+{
+    static const uint8_t chip_off[SIM_CHIPS];
+    
+    for (int m = 0; m < SIM_MODULES; m++) {
+        avalon10_module_t *module = &info.modules[m];
+        uint16_t freq[SIM_CHIPS];
+        float ghs = 0.0f;
+    
+        /* autotune: частоты на потолок через SIM_TUNE_S после сброса */
+        if (tune[m][0].state == AUTOTUNE_CHIP_PROBE && sim_s - tune_at[m] >= SIM_TUNE_S) {
+            for (int c = 0; c < SIM_CHIPS; c++) {
+                module->chips[c].freq = freq_max(c, module->voltage);
+                tune[m][c].state = AUTOTUNE_CHIP_SETTLED;
+            }
+        }
+    
+        for (int c = 0; c < SIM_CHIPS; c++) {
+            freq[c] = module->chips[c].freq;
+            ghs += freq[c] * SIM_GHS_PER_MHZ;
+        }
+    
+        module->power = mock_thermal_power(m, module->voltage, module->temp_out,
+                                           freq, chip_off, 1);
+        temp_model[m] = mock_thermal_temp(temp_model[m], module->temp_in,
+                                          module->power, airflow(m), 1000);
+        module->temp_out = (int16_t)(temp_model[m] + 0.5f);
+        module->temp_max = module->temp_out;
+    
+        /* Nonce сложности 1: 2^32 хэшей */
+        diff1_acc[m] += ghs / 4.294967296;
+        module->diff1 = (uint64_t)diff1_acc[m];
+    }
+}
+
+/**
+ * @brief Прогон до завершения поиска всеми модулями
+ * 
+ * @return          0 - поиск завершён, -1 - не уложился в SIM_RUN_MAX_S
+ */
+static int run(void)
+{
+    uint32_t searches = efficiency_get_stats()->searches;
+    uint32_t end = sim_s + SIM_RUN_MAX_S;
+    
+    while (sim_s < end) {
+        sim_s++;
+        sim_step();
+        efficiency_poll(&info);
+    
+        if (efficiency_get_stats()->searches >= searches + SIM_MODULES) {
+            return 0;
+        }
+    }
+    
+    printf("FAIL: поиск не завершился за %d с\n", SIM_RUN_MAX_S);
+    return -1;
+}
+
+/**
+ * @brief Сверка режима JTH с перебором
+ * 
+ * @return          Число расхождений
+ */
+static int check_jth(void)
+{
+    int bad = 0;
+    
+    printf("JTH:\n");
+    for (int m = 0; m < SIM_MODULES; m++) {
+        const efficiency_module_t *em = efficiency_get_module(m);
+        float best = 0.0f, got = 0.0f, ghs;
+        int best_v = 0;
+        uint16_t power;
+    
+        for (int v = AVALON10_VOLTAGE_MIN; v <= g_config.efficiency_vmax; v += AVALON10_VOLTAGE_STEP) {
+            float jth;
+    
+            steady_point(m, v, &power, &ghs);
+            jth = power * 1000.0f / ghs;
+            if (!best_v || jth < best) {
+                best = jth;
+                best_v = v;
+            }
+            if (v == em->best.voltage) {
+                got = jth;
+            }
+        }
+    
+        printf("  модуль %d: %d mV, %.2f J/TH (%d точек), перебор %d mV, %.2f J/TH\n",
+               m, em->best.voltage, (double)got, em->points, best_v, (double)best);
+    
+        if (!got || got > best * (1.0f + SIM_TOL_PCT / 100.0f) ||
+            info.modules[m].voltage != em->best.voltage) {
+            printf("FAIL: модуль %d\n", m);
+            bad++;
+        }
+    }
+    
+    return bad;
+}
+
+/**
+ * @brief Сверка режима CAP с перебором
+ * 
+ * @return          Число расхождений
+ */
+static int check_cap(void)
+{
+    int cap = efficiency_get_stats()->power_cap;
+    int bad = 0;
+    
+    printf("CAP (%d Вт на модуль):\n", cap);
+    for (int m = 0; m < SIM_MODULES; m++) {
+        const efficiency_module_t *em = efficiency_get_module(m);
+        float best = 0.0f, got = 0.0f, ghs;
+        uint16_t power, got_power = 0;
+        int best_v = 0;
+    
+        for (int v = AVALON10_VOLTAGE_MIN; v <= g_config.efficiency_vmax; v += AVALON10_VOLTAGE_STEP) {
+            steady_point(m, v, &power, &ghs);
+            if (power <= cap && ghs > best) {
+                best = ghs;
+                best_v = v;
+            }
+            if (v == em->best.voltage) {
+                got = ghs;
+                got_power = power;
+            }
+        }
+    
+        printf("  модуль %d: %d mV, %u Вт, %.0f GH/s, перебор %d mV, %.0f GH/s\n",
+               m, em->best.voltage, got_power, (double)got, best_v, (double)best);
+    
+        if (got_power > cap * (1.0f + SIM_TOL_PCT / 100.0f) ||
+            got < best * (1.0f - SIM_TOL_PCT / 100.0f) ||
+            info.modules[m].voltage != em->best.voltage) {
+            printf("FAIL: модуль %d\n", m);
+            bad++;
+        }
+    }
+    
+    return bad;
+}
+
+/* ===========================================================================
+ * ТОЧКА ВХОДА
+ * =========================================================================== */
+
+int main(int argc, char **argv)
+{
+    uint16_t power;
+    float ghs;
+    int bad = 0;
+    
+    verbose = argc > 1 && !strcmp(argv[1], "-v");
+    
+    g_config.autotune = 1;
+    g_config.efficiency_vmax = 850;
+    
+    info.initialized = 1;
+    info.mining_enabled = 1;
+    for (int m = 0; m < SIM_MODULES; m++) {
+        avalon10_module_t *module = &info.modules[m];
+    
+        module->module_id = (uint8_t)m;
+        module->state = AVALON10_MODULE_STATE_MINING;
+        module->voltage = AVALON10_DEFAULT_VOLTAGE;
+        module->temp_in = MOCK_TEMP_IN;
+        module->temp_out = MOCK_TEMP_IN;
+        temp_model[m] = MOCK_TEMP_IN;
+        for (int c = 0; c < SIM_CHIPS; c++) {
+            module->chips[c].enabled = 1;
+            module->chips[c].freq = freq_max(c, module->voltage);
+            tune[m][c].state = AUTOTUNE_CHIP_SETTLED;
+        }
+    }
+    
+    /* Минимум J/TH от напряжения по умолчанию */
+    g_config.efficiency = EFFICIENCY_MODE_JTH;
+    bad += run() ? 1 : check_jth();
+    
+    /* Лимит, который модуль 0 проходит на 760 mV: поиск идёт вверх */
+    steady_point(0, 760, &power, &ghs);
+    g_config.power_cap = SIM_MODULES * power;
+    g_config.efficiency = EFFICIENCY_MODE_CAP;
+    bad += run() ? 1 : check_cap();
+    
+    printf("Итог: %s (%u с модели)\n", bad ? "ОШИБКИ" : "OK", sim_s);
+    
+    return bad ? 1 : 0;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА efficiency_sim.c
+ * =========================================================================== */
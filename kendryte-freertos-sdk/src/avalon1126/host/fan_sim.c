@@ -0,0 +1,284 @@
+/**
+ * =============================================================================
+ * @file    fan_sim.c
+ * @brief   Avalon A1126pro - Переходные процессы ПИД вентиляторов (хост)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * fan.c прошивки без изменений на эмуляторе вентиляторов и RC-модели
+ * нагрева (mock_thermal.c): четыре модуля на 780 mV / 500 МГц, модель
+ * шагает по SIM_STEP_MS, fan_poll() - раз в секунду, как monitor_task.
+ * Сценарии и проверки:
+ * - пуск с ШИМ 100% от холодного модуля: перерегулирование, время
+ *   установления в ±SIM_BAND °C, средний ШИМ после установления;
+ * - скачок температуры на входе на SIM_AMBIENT_STEP: отклонение и время
+ *   возврата в полосу;
+ * - блокировка вентилятора 0: обнаружение, полный обдув, возврат.
+ * Ключ -v печатает отклик каждые 10 с - по нему подбираются
+ * коэффициенты (fan_set_gains()). Не входит в прошивку.
+ * 
+ * СБОРКА (из каталога host):
+ *   cc -O2 -DMOCK_HARDWARE=1 -DMOCK_ASIC=1 -Ishim -I.. ../fan.c \
+ *      ../mock_thermal.c fan_sim.c -o fan_sim
+ * 
+ * Код возврата 1 - отклик вне допусков.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "fan.h"
+#include "mock_hardware.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+#define SIM_MODULES         AVALON10_DEFAULT_MODULARS
+#define SIM_STEP_MS         100     /* Шаг модели */
+#define SIM_FREQ            500     /* Частота чипов (МГц) */
+#define SIM_BAND            1.0f    /* Полоса установления (°C) */
+#define SIM_AMBIENT_STEP    30      /* Скачок температуры на входе (°C × 10) */
+#define SIM_STALL_HOLD_S    30      /* Блокировка вентилятора */
+
+/* Допуски */
+#define SIM_OVERSHOOT_MAX   2.0f    /* Перерегулирование при пуске (°C) */
+#define SIM_SETTLE_MAX_S    300     /* Время установления */
+#define SIM_STEP_DEV_MAX    4.0f    /* Отклонение после скачка на входе (°C) */
+#define SIM_STALL_DETECT_S  (FAN_STALL_S + 2)
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static avalon10_info_t info;
+static float temp_model[SIM_MODULES];
+static uint64_t sim_us;
+static int verbose;
+
+/* ===========================================================================
+ * ЗАМЕНЫ ФУНКЦИЙ ПРОШИВКИ
+ * =========================================================================== */
+
+void log_message(int level, const char *fmt, ...)
+{
+    va_list ap;
+    
+    if (!verbose && level > LOG_WARNING) {
+        return;
+    }
+    
+    printf("[%6.1f] ", sim_us / 1e6);
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+}
+
+uint64_t cgminer_time_us(void)
+{
+    return sim_us;
+}
+
+/* Как в main.c */
+float cgminer_poll_dt(uint64_t *at_us, uint64_t now_us, float dt_min)
+{
+    float dt = *at_us ? (now_us - *at_us) / 1e6f : 1.0f;
+    
+    if (dt < dt_min) dt = dt_min;
+    if (dt > CGMINER_POLL_DT_MAX) dt = CGMINER_POLL_DT_MAX;
+    *at_us = now_us;
+    
+    return dt;
+}
+
+/* ===========================================================================
+ * МОДЕЛЬ
+ * =========================================================================== */
+
+/**
+ * @brief Вход регулятора: максимальная температура модулей (°C)
+ */
+static float temp_max(void)
+{
+    int16_t t = info.modules[0].temp_out;
+    
+    for (int m = 1; m < SIM_MODULES; m++) {
+        if (info.modules[m].temp_out > t) {
+            t = info.modules[m].temp_out;
+        }
+    }
+    return t / 10.0f;
+}
+
+/**
+ * @brief Секунда работы: нагрев по SIM_STEP_MS, затем шаг регулятора
+ */
+static void sim_second(void)
+{
+    static const uint8_t airflow_pct[MOCK_ASIC_MODULES] = MOCK_AIRFLOW_PCT;
+    static const uint8_t chip_off[MOCK_ASIC_CHIPS_PER_MODULE];
+    static uint16_t freq[MOCK_ASIC_CHIPS_PER_MODULE];
+    
+    if (!freq[0]) {
+        for (int c = 0; c < MOCK_ASIC_CHIPS_PER_MODULE; c++) {
+            freq[c] = SIM_FREQ;
+        }
+    }
+    
+    for (int i = 0; i < 1000 / SIM_STEP_MS; i++) {
+        int air;
+    
+        sim_us += SIM_STEP_MS * 1000;
+        air = mock_fan_airflow();
+    
+        for (int m = 0; m < SIM_MODULES; m++) {
+            avalon10_module_t *module = &info.modules[m];
+    
+            module->power = mock_thermal_power(m, module->voltage, module->temp_out,
+                                               freq, chip_off, 1);
+            temp_model[m] = mock_thermal_temp(temp_model[m], module->temp_in, module->power,
+                                              air * airflow_pct[m] / 100, SIM_STEP_MS);
+            module->temp_out = (int16_t)(temp_model[m] + 0.5f);
+        }
+    }
+    
+    for (int m = 0; m < SIM_MODULES; m++) {
+        info.modules[m].temp_max = info.modules[m].temp_out;
+    }
+    fan_poll(&info);
+    
+    if (verbose && (sim_us / 1000000) % 10 == 0) {
+        printf("  %5u с  T %5.1f°C  ШИМ %3d/%3d%%  %4d/%4d об/мин\n",
+               (unsigned)(sim_us / 1000000), (double)temp_max(),
+               info.fan_pwm[0], info.fan_pwm[1], info.fan_rpm[0], info.fan_rpm[1]);
+    }
+}
+
+/**
+ * @brief Отклик за seconds секунд
+ * 
+ * @param peak      Максимальное отклонение от цели вверх (°C)
+ * @param settle    Секунд до последнего выхода из полосы SIM_BAND
+ * @param pwm_avg   Средний ШИМ вентилятора 0 после установления (%)
+ */
+static void respond(int seconds, float *peak, int *settle, float *pwm_avg)
+{
+    float pwm_sum = 0.0f;
+    int pwm_n = 0;
+    
+    *peak = -100.0f;
+    *settle = 0;
+    
+    for (int s = 1; s <= seconds; s++) {
+        float err;
+    
+        sim_second();
+        err = temp_max() - info.temp_target;
+    
+        if (err > *peak) {
+            *peak = err;
+        }
+        if (err > SIM_BAND || err < -SIM_BAND) {
+            *settle = s;
+            pwm_sum = 0.0f;
+            pwm_n = 0;
+        } else {
+            pwm_sum += info.fan_pwm[0];
+            pwm_n++;
+        }
+    }
+    
+    *pwm_avg = pwm_n ? pwm_sum / pwm_n : 0.0f;
+}
+
+/* ===========================================================================
+ * ТОЧКА ВХОДА
+ * =========================================================================== */
+
+int main(int argc, char **argv)
+{
+    float peak, pwm;
+    int settle, bad = 0;
+    int detect = 0, full = 1, resume = 0;
+    
+    verbose = argc > 1 && !strcmp(argv[1], "-v");
+    
+    info.fan_min = AVALON10_DEFAULT_FAN_MIN;
+    info.fan_max = AVALON10_DEFAULT_FAN_MAX;
+    info.temp_target = AVALON10_DEFAULT_TEMP_TARGET;
+    info.temp_overheat = AVALON10_DEFAULT_TEMP_OVERHEAT;
+    for (int m = 0; m < SIM_MODULES; m++) {
+        info.modules[m].state = AVALON10_MODULE_STATE_MINING;
+        info.modules[m].voltage = AVALON10_DEFAULT_VOLTAGE;
+        info.modules[m].temp_in = MOCK_TEMP_IN;
+        info.modules[m].temp_out = MOCK_TEMP_IN;
+        temp_model[m] = MOCK_TEMP_IN;
+    }
+    
+    mock_fan_init();
+    fan_init();
+    
+    /* Пуск: холодные модули, ШИМ 100% */
+    respond(900, &peak, &settle, &pwm);
+    printf("Пуск: перерегулирование %.1f°C, установление %d с, ШИМ %.0f%%\n",
+           (double)(peak > 0.0f ? peak : 0.0f), settle, (double)pwm);
+    if (peak > SIM_OVERSHOOT_MAX || settle > SIM_SETTLE_MAX_S) {
+        printf("FAIL: пуск\n");
+        bad++;
+    }
+    
+    /* Скачок температуры воздуха на входе */
+    for (int m = 0; m < SIM_MODULES; m++) {
+        info.modules[m].temp_in += SIM_AMBIENT_STEP;
+    }
+    respond(900, &peak, &settle, &pwm);
+    printf("Вход +%.1f°C: отклонение %.1f°C, установление %d с, ШИМ %.0f%%\n",
+           SIM_AMBIENT_STEP / 10.0, (double)peak, settle, (double)pwm);
+    if (peak > SIM_STEP_DEV_MAX || settle > SIM_SETTLE_MAX_S) {
+        printf("FAIL: скачок на входе\n");
+        bad++;
+    }
+    
+    /* Останов вентилятора 0: обнаружение и полный обдув */
+    mock_fan_set_stalled(0, 1);
+    for (int s = 1; s <= SIM_STALL_HOLD_S; s++) {
+        sim_second();
+        if (!detect && fan_get_state(0)->stalled) {
+            detect = s;
+        }
+        if (detect && info.fan_pwm[1] != info.fan_max) {
+            full = 0;
+        }
+    }
+    mock_fan_set_stalled(0, 0);
+    for (int s = 1; s <= SIM_STALL_DETECT_S; s++) {
+        sim_second();
+        if (!resume && !fan_get_state(0)->stalled) {
+            resume = s;
+        }
+    }
+    printf("Останов: обнаружен через %d с, полный обдув %s, возврат через %d с\n",
+           detect, full ? "да" : "нет", resume);
+    if (!detect || detect > SIM_STALL_DETECT_S || !full || !resume) {
+        printf("FAIL: останов вентилятора\n");
+        bad++;
+    }
+    
+    printf("Итог: %s\n", bad ? "ОШИБКИ" : "OK");
+    
+    return bad ? 1 : 0;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА fan_sim.c
+ * =========================================================================== */
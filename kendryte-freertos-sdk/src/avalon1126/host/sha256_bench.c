@@ -0,0 +1,285 @@
+/**
+ * =============================================================================
+ * @file    sha256_bench.c
+ * @brief   Avalon A1126pro - Замер SHA256 на хосте
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Сверка SWAR-ядра и вариантов sha256_x86.c с программным SHA256
+ * (эталон) и замер SHA256d 80 и 64 байт: скалярный, две пары в 64-битных
+ * регистрах, заголовки по midstate, SSE4.1/AVX2/SHA-NI. Не входит в
+ * прошивку.
+ * 
+ * СБОРКА (из каталога host):
+ *   cc -O2 -I.. ../sha256_soft.c ../sha256_swar.c sha256_x86.c sha256_bench.c -o sha256_bench
+ * 
+ * Для цифр RV64 - кросс-компилятор и запуск на плате или в qemu-user:
+ *   riscv64-linux-gnu-gcc -O2 -march=rv64imafc -mabi=lp64f -static ...
+ * 
+ * Код возврата 1 - расхождение с эталоном.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sha256_soft.h"
+#include "sha256_swar.h"
+#include "sha256_x86.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+#define BENCH_MSGS          1024    /* Сообщений в замере */
+#define BENCH_ROUNDS        64      /* Проходов по сообщениям */
+#define CHECK_MAX_LEN       200     /* Длины сверки: 0..CHECK_MAX_LEN */
+#define CHECK_BATCH         11      /* Сообщений в пакете сверки (не кратно дорожкам) */
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static uint8_t msgs[BENCH_MSGS][80];
+static uint8_t hashes[BENCH_MSGS][32];
+static uint32_t nonces[BENCH_MSGS];
+static uint32_t rng_state = 0x12345678;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief xorshift32 - одинаковые данные при каждом запуске
+ */
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Сверка с эталоном
+ * 
+ * @return          Число расхождений
+ */
+static int check(void)
+{
+    uint8_t a[CHECK_MAX_LEN], b[CHECK_MAX_LEN];
+    uint8_t ha[32], hb[32], ra[32], rb[32];
+    uint32_t mid[8];
+    int bad = 0;
+    
+    /* Все длины: 0, 55/56 (граница дополнения), 64, 80, ... */
+    for (size_t len = 0; len <= CHECK_MAX_LEN; len++) {
+        for (size_t i = 0; i < len; i++) {
+            a[i] = (uint8_t)rng();
+            b[i] = (uint8_t)rng();
+        }
+        sha256d_swar2(a, b, len, ha, hb);
+        sha256d_soft(a, len, ra);
+        sha256d_soft(b, len, rb);
+        if (memcmp(ha, ra, 32) || memcmp(hb, rb, 32)) {
+            printf("FAIL: sha256d_swar2, длина %zu\n", len);
+            bad++;
+        }
+    }
+    
+    /* Заголовки одного задания: общие 64 байта, разные хвосты */
+    for (int n = 0; n < BENCH_MSGS; n += 2) {
+        memcpy(mid, sha256_soft_iv, sizeof(mid));
+        memcpy(msgs[n + 1], msgs[n], 64);
+        sha256_soft_transform(mid, msgs[n]);
+    
+        sha256d_swar2_header(mid, msgs[n] + 64, msgs[n + 1] + 64, ha, hb);
+        sha256d_soft(msgs[n], 80, ra);
+        sha256d_soft(msgs[n + 1], 80, rb);
+        if (memcmp(ha, ra, 32) || memcmp(hb, rb, 32)) {
+            printf("FAIL: sha256d_swar2_header, заголовок %d\n", n);
+            bad++;
+        }
+    
+        sha256d_soft_header(mid, msgs[n + 1] + 64, ha);
+        if (memcmp(ha, rb, 32)) {
+            printf("FAIL: sha256d_soft_header, заголовок %d\n", n + 1);
+            bad++;
+        }
+    }
+    
+    return bad;
+}
+
+/**
+ * @brief Сверка варианта sha256_x86 с эталоном
+ * 
+ * @return          Число расхождений
+ */
+static int check_ops(const hasher_ops_t *ops)
+{
+    static uint8_t data[CHECK_BATCH * CHECK_MAX_LEN];
+    uint8_t out[CHECK_BATCH * 32], ref[32];
+    int bad = 0;
+    
+    for (size_t len = 0; len <= CHECK_MAX_LEN; len++) {
+        for (size_t i = 0; i < CHECK_BATCH * len; i++) {
+            data[i] = (uint8_t)rng();
+        }
+        ops->sha256d_batch(data, len, CHECK_BATCH, out);
+        for (int i = 0; i < CHECK_BATCH; i++) {
+            sha256d_soft(data + i * len, len, ref);
+            if (memcmp(out + i * 32, ref, 32)) {
+                printf("FAIL: %s sha256d_batch, длина %zu, сообщение %d\n", ops->name, len, i);
+                bad++;
+            }
+        }
+        ops->sha256(data, len, out);
+        sha256_soft(data, len, ref);
+        if (memcmp(out, ref, 32)) {
+            printf("FAIL: %s sha256, длина %zu\n", ops->name, len);
+            bad++;
+        }
+    }
+    
+    /* Заголовки одного задания: msgs[0] с nonces[i] */
+    ops->sha256d_nonces(msgs[0], nonces, CHECK_BATCH, out);
+    for (int i = 0; i < CHECK_BATCH; i++) {
+        uint8_t h[80];
+    
+        memcpy(h, msgs[0], 76);
+        h[76] = nonces[i] & 0xFF;
+        h[77] = (nonces[i] >> 8) & 0xFF;
+        h[78] = (nonces[i] >> 16) & 0xFF;
+        h[79] = (nonces[i] >> 24) & 0xFF;
+        sha256d_soft(h, 80, ref);
+        if (memcmp(out + i * 32, ref, 32)) {
+            printf("FAIL: %s sha256d_nonces, nonce %d\n", ops->name, i);
+            bad++;
+        }
+    }
+    
+    return bad;
+}
+
+/**
+ * @brief Печать замера (нс на хэш)
+ */
+static void report(const char *name, double t0, double t1)
+{
+    printf("  %8.1f нс  %s\n", (t1 - t0) / ((double)BENCH_ROUNDS * BENCH_MSGS), name);
+}
+
+/* ===========================================================================
+ * ТОЧКА ВХОДА
+ * =========================================================================== */
+
+int main(void)
+{
+    uint32_t mid[8];
+    double t0;
+    int bad;
+    
+    for (int n = 0; n < BENCH_MSGS; n++) {
+        for (int i = 0; i < 80; i++) {
+            msgs[n][i] = (uint8_t)rng();
+        }
+        nonces[n] = rng();
+    }
+    
+    bad = check();
+    printf("Сверка с эталоном: %s\n", bad ? "ОШИБКИ" : "OK");
+    
+    for (size_t len = 80; len >= 64; len -= 16) {
+        printf("SHA256d %zu байт:\n", len);
+    
+        t0 = now_ns();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            for (int n = 0; n < BENCH_MSGS; n++) {
+                sha256d_soft(msgs[n], len, hashes[n]);
+            }
+        }
+        report("скалярный", t0, now_ns());
+    
+        t0 = now_ns();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            for (int n = 0; n < BENCH_MSGS; n += 2) {
+                sha256d_swar2(msgs[n], msgs[n + 1], len, hashes[n], hashes[n + 1]);
+            }
+        }
+        report("SWAR 2x32", t0, now_ns());
+    }
+    
+    /* Проверка nonce: заголовки одного задания */
+    printf("SHA256d заголовка по midstate:\n");
+    memcpy(mid, sha256_soft_iv, sizeof(mid));
+    sha256_soft_transform(mid, msgs[0]);
+    
+    t0 = now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int n = 0; n < BENCH_MSGS; n++) {
+            sha256d_soft_header(mid, msgs[n] + 64, hashes[n]);
+        }
+    }
+    report("скалярный", t0, now_ns());
+    
+    t0 = now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int n = 0; n < BENCH_MSGS; n += 2) {
+            sha256d_swar2_header(mid, msgs[n] + 64, msgs[n + 1] + 64, hashes[n], hashes[n + 1]);
+        }
+    }
+    report("SWAR 2x32", t0, now_ns());
+    
+    /* Варианты хоста: тот же hasher_ops_t, что у прошивки */
+    printf("sha256_x86 (nonce / 80 байт пакетом):\n");
+    for (int t = 0; t < SHA256_X86_COUNT; t++) {
+        const hasher_ops_t *ops = sha256_x86_ops(t);
+        double t1;
+    
+        if (!ops) {
+            continue;
+        }
+        if (check_ops(ops)) {
+            bad++;
+            continue;
+        }
+    
+        t0 = now_ns();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            ops->sha256d_nonces(msgs[0], nonces, BENCH_MSGS, hashes[0]);
+        }
+        t1 = now_ns();
+        report(ops->name, t0, t1);
+    
+        t0 = now_ns();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            ops->sha256d_batch(msgs[0], 80, BENCH_MSGS, hashes[0]);
+        }
+        report(ops->name, t0, now_ns());
+    }
+    printf("sha256_x86_best(): %s\n", sha256_x86_best()->name);
+    
+    return bad ? 1 : 0;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА sha256_bench.c
+ * =========================================================================== */
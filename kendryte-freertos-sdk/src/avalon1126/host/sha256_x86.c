@@ -0,0 +1,442 @@
+/**
+ * =============================================================================
+ * @file    sha256_x86.c
+ * @brief   Avalon A1126pro - Многопоточный SHA256d для x86-64 (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Варианты SSE4.1 и AVX2 - шаблон sha256_x86_lanes.h, SHA-NI - раунды
+ * _mm_sha256rnds2_epu32 по одному сообщению. Только для хоста.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+#include <time.h>
+
+#include "sha256_x86.h"
+#include "sha256_soft.h"
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+#define BEST_NONCES         4096    /* Nonce в замере sha256_x86_best() */
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+static uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* ===========================================================================
+ * ВАРИАНТ SCALAR
+ * =========================================================================== */
+
+static int scalar_init(void)
+{
+    return 0;
+}
+
+static void scalar_sha256d_batch(const uint8_t *data, size_t len, int n, uint8_t *hash)
+{
+    for (int i = 0; i < n; i++) {
+        sha256d_soft(data + (size_t)i * len, len, hash + (size_t)i * 32);
+    }
+}
+
+static void scalar_sha256d_nonces(const uint8_t *header, const uint32_t *nonces, int n, uint8_t *hash)
+{
+    uint32_t mid[8];
+    uint8_t tail[16];
+    
+    memcpy(mid, sha256_soft_iv, sizeof(mid));
+    sha256_soft_transform(mid, header);
+    memcpy(tail, header + 64, 12);
+    
+    for (int i = 0; i < n; i++) {
+        tail[12] = nonces[i] & 0xFF;
+        tail[13] = (nonces[i] >> 8) & 0xFF;
+        tail[14] = (nonces[i] >> 16) & 0xFF;
+        tail[15] = (nonces[i] >> 24) & 0xFF;
+        sha256d_soft_header(mid, tail, hash + (size_t)i * 32);
+    }
+}
+
+static const hasher_ops_t scalar_ops = {
+    .name = "scalar",
+    .init = scalar_init,
+    .sha256 = sha256_soft,
+    .sha256d_batch = scalar_sha256d_batch,
+    .sha256d_nonces = scalar_sha256d_nonces,
+};
+
+#if defined(__x86_64__)
+
+/* ===========================================================================
+ * ПОДДЕРЖКА ПРОЦЕССОРОМ
+ * =========================================================================== */
+
+/**
+ * @brief Регистры AVX сохраняются ОС (XCR0: XMM и YMM)
+ */
+static int os_avx(void)
+{
+    uint32_t lo, hi;
+    
+    __asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    (void)hi;
+    
+    return (lo & 6) == 6;
+}
+
+static int cpu_sse41(void)
+{
+    unsigned int a, b, c, d;
+    
+    return __get_cpuid(1, &a, &b, &c, &d) && (c & bit_SSE4_1);
+}
+
+static int cpu_avx2(void)
+{
+    unsigned int a, b, c, d;
+    
+    if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_OSXSAVE) || !(c & bit_AVX) || !os_avx()) {
+        return 0;
+    }
+    
+    return __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & bit_AVX2);
+}
+
+static int cpu_shani(void)
+{
+    unsigned int a, b, c, d;
+    
+    if (!cpu_sse41()) {
+        return 0;
+    }
+    
+    return __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & bit_SHA);
+}
+
+/* ===========================================================================
+ * ВАРИАНТ SSE4.1 (4 дорожки)
+ * =========================================================================== */
+
+#define LANES               4
+#define VEC                 __m128i
+#define TGT                 __attribute__((target("sse4.1")))
+#define LANE_FN(name)       sse41_##name
+#define V_ADD(x, y)         _mm_add_epi32(x, y)
+#define V_XOR(x, y)         _mm_xor_si128(x, y)
+#define V_AND(x, y)         _mm_and_si128(x, y)
+#define V_OR(x, y)          _mm_or_si128(x, y)
+#define V_ANDNOT(x, y)      _mm_andnot_si128(x, y)
+#define V_SRL(x, n)         _mm_srli_epi32(x, n)
+#define V_SLL(x, n)         _mm_slli_epi32(x, n)
+#define V_SET1(x)           _mm_set1_epi32((int)(x))
+#define V_ZERO              _mm_setzero_si128()
+#define V_LOAD(p)           _mm_loadu_si128((const __m128i *)(p))
+#define V_STORE(p, v)       _mm_storeu_si128((__m128i *)(p), v)
+#include "sha256_x86_lanes.h"
+
+static int sse41_init(void)
+{
+    return cpu_sse41() ? 0 : -1;
+}
+
+static const hasher_ops_t sse41_ops = {
+    .name = "sse41",
+    .init = sse41_init,
+    .sha256 = sha256_soft,
+    .sha256d_batch = sse41_sha256d_batch,
+    .sha256d_nonces = sse41_sha256d_nonces,
+};
+
+/* ===========================================================================
+ * ВАРИАНТ AVX2 (8 дорожек)
+ * =========================================================================== */
+
+#define LANES               8
+#define VEC                 __m256i
+#define TGT                 __attribute__((target("avx2")))
+#define LANE_FN(name)       avx2_##name
+#define V_ADD(x, y)         _mm256_add_epi32(x, y)
+#define V_XOR(x, y)         _mm256_xor_si256(x, y)
+#define V_AND(x, y)         _mm256_and_si256(x, y)
+#define V_OR(x, y)          _mm256_or_si256(x, y)
+#define V_ANDNOT(x, y)      _mm256_andnot_si256(x, y)
+#define V_SRL(x, n)         _mm256_srli_epi32(x, n)
+#define V_SLL(x, n)         _mm256_slli_epi32(x, n)
+#define V_SET1(x)           _mm256_set1_epi32((int)(x))
+#define V_ZERO              _mm256_setzero_si256()
+#define V_LOAD(p)           _mm256_loadu_si256((const __m256i *)(p))
+#define V_STORE(p, v)       _mm256_storeu_si256((__m256i *)(p), v)
+#include "sha256_x86_lanes.h"
+
+static int avx2_init(void)
+{
+    return cpu_avx2() ? 0 : -1;
+}
+
+static const hasher_ops_t avx2_ops = {
+    .name = "avx2",
+    .init = avx2_init,
+    .sha256 = sha256_soft,
+    .sha256d_batch = avx2_sha256d_batch,
+    .sha256d_nonces = avx2_sha256d_nonces,
+};
+
+/* ===========================================================================
+ * ВАРИАНТ SHA-NI
+ * =========================================================================== */
+
+#define SHANI_TGT           __attribute__((target("sha,sse4.1")))
+
+/**
+ * @brief Сжатие блоков инструкциями SHA
+ * 
+ * Состояние в регистрах - ABEF и CDGH; раунды по 4: sha256rnds2 дважды,
+ * расписание - sha256msg1/msg2 по группам из 4 слов.
+ */
+SHANI_TGT static void shani_transform(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i s0, s1, tmp, save0, save1, mk;
+    __m128i m[4];
+    
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);   /* CDAB */
+    s1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);    /* EFGH */
+    s0 = _mm_alignr_epi8(tmp, s1, 8);                                             /* ABEF */
+    s1 = _mm_blend_epi16(s1, tmp, 0xF0);                                          /* CDGH */
+    
+    for (; blocks > 0; blocks--, data += 64) {
+        save0 = s0;
+        save1 = s1;
+    
+        for (int i = 0; i < 4; i++) {
+            m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + i * 16)), bswap);
+        }
+    
+        for (int g = 0; g < 16; g++) {
+            mk = _mm_add_epi32(m[g & 3], _mm_loadu_si128((const __m128i *)&sha256_soft_k[g * 4]));
+            s1 = _mm_sha256rnds2_epu32(s1, s0, mk);
+            s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(mk, 0x0E));
+    
+            /* Слова группы g + 4: W[t-16] + s0(W[t-15]) + W[t-7] + s1(W[t-2]) */
+            if (g < 12) {
+                tmp = _mm_alignr_epi8(m[(g + 3) & 3], m[(g + 2) & 3], 4);
+                tmp = _mm_add_epi32(_mm_sha256msg1_epu32(m[g & 3], m[(g + 1) & 3]), tmp);
+                m[g & 3] = _mm_sha256msg2_epu32(tmp, m[(g + 3) & 3]);
+            }
+        }
+    
+        s0 = _mm_add_epi32(s0, save0);
+        s1 = _mm_add_epi32(s1, save1);
+    }
+    
+    tmp = _mm_shuffle_epi32(s0, 0x1B);                                            /* FEBA */
+    s1 = _mm_shuffle_epi32(s1, 0xB1);                                             /* DCHG */
+    _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, s1, 0xF0));       /* DCBA */
+    _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(s1, tmp, 8));          /* HGFE */
+}
+
+static void shani_sha256(const uint8_t *data, size_t len, uint8_t *hash)
+{
+    uint32_t state[8];
+    uint8_t pad[128];
+    uint64_t bits = (uint64_t)len * 8;
+    size_t full = len / 64, rem = len % 64;
+    size_t blocks = (rem >= 56) ? 2 : 1;
+    
+    memcpy(state, sha256_soft_iv, sizeof(state));
+    shani_transform(state, data, full);
+    
+    memset(pad, 0, sizeof(pad));
+    memcpy(pad, data + full * 64, rem);
+    pad[rem] = 0x80;
+    for (int i = 0; i < 8; i++) {
+        pad[blocks * 64 - 1 - i] = (uint8_t)(bits >> (i * 8));
+    }
+    shani_transform(state, pad, blocks);
+    
+    for (int i = 0; i < 8; i++) {
+        put_be32(hash + i * 4, state[i]);
+    }
+}
+
+/**
+ * @brief Второй SHA256: 32 байта дайджеста, дополнение - готовый блок
+ */
+static void shani_second(const uint32_t digest[8], uint8_t *hash)
+{
+    uint32_t state[8];
+    uint8_t block[64];
+    
+    for (int i = 0; i < 8; i++) {
+        put_be32(block + i * 4, digest[i]);
+    }
+    memset(block + 32, 0, 32);
+    block[32] = 0x80;
+    block[62] = 0x01;                   /* 256 бит */
+    
+    memcpy(state, sha256_soft_iv, sizeof(state));
+    shani_transform(state, block, 1);
+    
+    for (int i = 0; i < 8; i++) {
+        put_be32(hash + i * 4, state[i]);
+    }
+}
+
+static void shani_sha256d_batch(const uint8_t *data, size_t len, int n, uint8_t *hash)
+{
+    uint8_t first[32];
+    
+    for (int i = 0; i < n; i++) {
+        shani_sha256(data + (size_t)i * len, len, first);
+        shani_sha256(first, 32, hash + (size_t)i * 32);
+    }
+}
+
+static void shani_sha256d_nonces(const uint8_t *header, const uint32_t *nonces, int n, uint8_t *hash)
+{
+    uint32_t mid[8], state[8];
+    uint8_t block[64];
+    
+    memcpy(mid, sha256_soft_iv, sizeof(mid));
+    shani_transform(mid, header, 1);
+    
+    /* Второй блок: байты 64-79, 0x80, длина 640 бит */
+    memset(block, 0, sizeof(block));
+    memcpy(block, header + 64, 12);
+    block[16] = 0x80;
+    block[62] = 0x02;
+    block[63] = 0x80;
+    
+    for (int i = 0; i < n; i++) {
+        memcpy(block + 12, &nonces[i], 4);      /* x86 - little-endian, как в заголовке */
+        memcpy(state, mid, sizeof(state));
+        shani_transform(state, block, 1);
+        shani_second(state, hash + (size_t)i * 32);
+    }
+}
+
+static int shani_init(void)
+{
+    return cpu_shani() ? 0 : -1;
+}
+
+static const hasher_ops_t shani_ops = {
+    .name = "shani",
+    .init = shani_init,
+    .sha256 = shani_sha256,
+    .sha256d_batch = shani_sha256d_batch,
+    .sha256d_nonces = shani_sha256d_nonces,
+};
+
+#endif /* __x86_64__ */
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static const hasher_ops_t *const variants[SHA256_X86_COUNT] = {
+    [SHA256_X86_SCALAR] = &scalar_ops,
+#if defined(__x86_64__)
+    [SHA256_X86_SSE41] = &sse41_ops,
+    [SHA256_X86_AVX2] = &avx2_ops,
+    [SHA256_X86_SHANI] = &shani_ops,
+#endif
+};
+
+static const hasher_ops_t *best = NULL;
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Таблица операций варианта
+ */
+const hasher_ops_t *sha256_x86_ops(int type)
+{
+    if (type < 0 || type >= SHA256_X86_COUNT || !variants[type]) {
+        return NULL;
+    }
+    
+    return variants[type]->init() == 0 ? variants[type] : NULL;
+}
+
+/**
+ * @brief Самый быстрый доступный вариант
+ */
+const hasher_ops_t *sha256_x86_best(void)
+{
+    static uint32_t nonces[BEST_NONCES];
+    static uint8_t hashes[BEST_NONCES * 32];
+    uint8_t header[80];
+    double best_ns = 0;
+    
+    if (best) {
+        return best;
+    }
+    
+    memset(header, 0x5A, sizeof(header));
+    for (int i = 0; i < BEST_NONCES; i++) {
+        nonces[i] = 0x9E3779B9u * (i + 1);
+    }
+    
+    for (int t = 0; t < SHA256_X86_COUNT; t++) {
+        const hasher_ops_t *ops = sha256_x86_ops(t);
+        double t0, ns;
+    
+        if (!ops) {
+            continue;
+        }
+        t0 = now_ns();
+        ops->sha256d_nonces(header, nonces, BEST_NONCES, hashes);
+        ns = now_ns() - t0;
+    
+        if (!best || ns < best_ns) {
+            best = ops;
+            best_ns = ns;
+        }
+    }
+    
+    return best;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА sha256_x86.c
+ * =========================================================================== */
@@ -0,0 +1,71 @@
+/**
+ * =============================================================================
+ * @file    sha256_x86.h
+ * @brief   Avalon A1126pro - Многопоточный SHA256d для x86-64 (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * SHA256d для инструментов на хосте (симуляция, разбор логов, замеры):
+ * тот же hasher_ops_t, что у бэкендов прошивки (hasher.h), поэтому код
+ * проверки nonce переносится без изменений.
+ * 
+ *   SHA256_X86_SCALAR  - sha256_soft.c, есть на любом хосте
+ *   SHA256_X86_SSE41   - 4 сообщения в __m128i (по 32 бита на сообщение)
+ *   SHA256_X86_AVX2    - 8 сообщений в __m256i
+ *   SHA256_X86_SHANI   - инструкции SHA (одно сообщение, аппаратные раунды)
+ * 
+ * Варианты SIMD собираются атрибутом target, без флагов -m*: один
+ * бинарник работает на любом x86-64, доступность проверяется CPUID при
+ * вызове init(). На других архитектурах есть только SCALAR.
+ * 
+ * sha256_x86_best() один раз замеряет доступные варианты на пути
+ * проверки nonce и возвращает самый быстрый - как HASHER_AUTO.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __SHA256_X86_H__
+#define __SHA256_X86_H__
+
+#include "hasher.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Варианты
+ */
+#define SHA256_X86_SCALAR       0
+#define SHA256_X86_SSE41        1
+#define SHA256_X86_AVX2         2
+#define SHA256_X86_SHANI        3
+#define SHA256_X86_COUNT        4
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Таблица операций варианта
+ * 
+ * Пакеты любого размера: sha256d_batch и sha256d_nonces сами делят n
+ * на группы по числу дорожек.
+ * 
+ * @param type      SHA256_X86_*
+ * @return          NULL если вариант не собран или процессор его не умеет
+ */
+const hasher_ops_t *sha256_x86_ops(int type);
+
+/**
+ * @brief Самый быстрый доступный вариант (замер при первом вызове)
+ */
+const hasher_ops_t *sha256_x86_best(void);
+
+#endif /* __SHA256_X86_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА sha256_x86.h
+ * =========================================================================== */
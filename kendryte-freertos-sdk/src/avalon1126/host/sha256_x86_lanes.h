@@ -0,0 +1,237 @@
+/**
+ * =============================================================================
+ * @file    sha256_x86_lanes.h
+ * @brief   Avalon A1126pro - SHA256d по дорожкам вектора (шаблон)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Подключается sha256_x86.c по разу на набор инструкций. Перед
+ * подключением задаются:
+ * 
+ *   LANES          - сообщений в векторе
+ *   VEC            - тип вектора
+ *   TGT            - атрибут target функций
+ *   LANE_FN(name)  - имя функции с суффиксом набора
+ *   V_ADD, V_XOR, V_AND, V_OR, V_ANDNOT (~x & y), V_SRL, V_SLL,
+ *   V_SET1, V_ZERO, V_LOAD, V_STORE
+ * 
+ * Слово i состояния - вектор из слов i всех дорожек. Дорожки сверх n
+ * считают копию первого сообщения, их результат не записывается.
+ * 
+ * Макросы снимаются в конце файла.
+ * 
+ * =============================================================================
+ */
+
+#define V_ROTR(x, n)        V_OR(V_SRL(x, n), V_SLL(x, 32 - (n)))
+#define V_CH(x, y, z)       V_XOR(V_AND(x, y), V_ANDNOT(x, z))
+#define V_MAJ(x, y, z)      V_OR(V_AND(x, y), V_AND(z, V_OR(x, y)))
+#define V_EP0(x)            V_XOR(V_XOR(V_ROTR(x, 2), V_ROTR(x, 13)), V_ROTR(x, 22))
+#define V_EP1(x)            V_XOR(V_XOR(V_ROTR(x, 6), V_ROTR(x, 11)), V_ROTR(x, 25))
+#define V_SIG0(x)           V_XOR(V_XOR(V_ROTR(x, 7), V_ROTR(x, 18)), V_SRL(x, 3))
+#define V_SIG1(x)           V_XOR(V_XOR(V_ROTR(x, 17), V_ROTR(x, 19)), V_SRL(x, 10))
+
+/**
+ * @brief Сжатие блока во всех дорожках (w затирается)
+ */
+TGT static void LANE_FN(transform)(VEC state[8], VEC w[16])
+{
+    VEC a = state[0], b = state[1], c = state[2], d = state[3];
+    VEC e = state[4], f = state[5], g = state[6], h = state[7];
+    VEC t1, t2, wi;
+    
+    for (int i = 0; i < 64; i++) {
+        if (i < 16) {
+            wi = w[i];
+        } else {
+            wi = V_ADD(V_ADD(V_SIG1(w[(i - 2) & 15]), w[(i - 7) & 15]),
+                       V_ADD(V_SIG0(w[(i - 15) & 15]), w[i & 15]));
+            w[i & 15] = wi;
+        }
+    
+        t1 = V_ADD(V_ADD(h, V_EP1(e)), V_ADD(V_CH(e, f, g), V_ADD(V_SET1(sha256_soft_k[i]), wi)));
+        t2 = V_ADD(V_EP0(a), V_MAJ(a, b, c));
+        h = g; g = f; f = e; e = V_ADD(d, t1);
+        d = c; c = b; b = a; a = V_ADD(t1, t2);
+    }
+    
+    state[0] = V_ADD(state[0], a); state[1] = V_ADD(state[1], b);
+    state[2] = V_ADD(state[2], c); state[3] = V_ADD(state[3], d);
+    state[4] = V_ADD(state[4], e); state[5] = V_ADD(state[5], f);
+    state[6] = V_ADD(state[6], g); state[7] = V_ADD(state[7], h);
+}
+
+/**
+ * @brief Слова блоков всех дорожек
+ */
+TGT static void LANE_FN(gather)(VEC w[16], const uint8_t *const block[LANES])
+{
+    uint32_t t[LANES];
+    
+    for (int i = 0; i < 16; i++) {
+        for (int l = 0; l < LANES; l++) {
+            t[l] = be32(block[l] + i * 4);
+        }
+        w[i] = V_LOAD(t);
+    }
+}
+
+/**
+ * @brief Второй SHA256 дайджестов и запись результатов
+ * 
+ * @param hash      Адрес хэша дорожки, NULL - не записывать
+ */
+TGT static void LANE_FN(second)(const VEC digest[8], uint8_t *const hash[LANES])
+{
+    VEC state[8], w[16];
+    uint32_t t[LANES];
+    
+    for (int i = 0; i < 8; i++) {
+        w[i] = digest[i];
+        state[i] = V_SET1(sha256_soft_iv[i]);
+    }
+    w[8] = V_SET1(0x80000000u);
+    for (int i = 9; i < 15; i++) {
+        w[i] = V_ZERO;
+    }
+    w[15] = V_SET1(256);
+    
+    LANE_FN(transform)(state, w);
+    
+    for (int i = 0; i < 8; i++) {
+        V_STORE(t, state[i]);
+        for (int l = 0; l < LANES; l++) {
+            if (hash[l]) {
+                put_be32(hash[l] + i * 4, t[l]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief SHA256d n сообщений по len байт
+ */
+TGT static void LANE_FN(sha256d_batch)(const uint8_t *data, size_t len, int n, uint8_t *hash)
+{
+    uint8_t pad[LANES][128];
+    const uint8_t *msg[LANES];
+    const uint8_t *block[LANES];
+    uint8_t *out[LANES];
+    VEC state[8], w[16];
+    uint64_t bits = (uint64_t)len * 8;
+    
+    for (int base = 0; base < n; base += LANES) {
+        size_t off, rem;
+        int blocks;
+    
+        for (int l = 0; l < LANES; l++) {
+            int idx = (base + l < n) ? base + l : base;
+    
+            msg[l] = data + (size_t)idx * len;
+            out[l] = (base + l < n) ? hash + (size_t)idx * 32 : NULL;
+        }
+        for (int i = 0; i < 8; i++) {
+            state[i] = V_SET1(sha256_soft_iv[i]);
+        }
+    
+        for (off = 0; len - off >= 64; off += 64) {
+            for (int l = 0; l < LANES; l++) {
+                block[l] = msg[l] + off;
+            }
+            LANE_FN(gather)(w, block);
+            LANE_FN(transform)(state, w);
+        }
+    
+        /* Дополнение: длина одна - число блоков одно */
+        rem = len - off;
+        blocks = (rem >= 56) ? 2 : 1;
+        for (int l = 0; l < LANES; l++) {
+            memset(pad[l], 0, sizeof(pad[l]));
+            memcpy(pad[l], msg[l] + off, rem);
+            pad[l][rem] = 0x80;
+            for (int i = 0; i < 8; i++) {
+                pad[l][blocks * 64 - 1 - i] = (uint8_t)(bits >> (i * 8));
+            }
+        }
+        for (int b = 0; b < blocks; b++) {
+            for (int l = 0; l < LANES; l++) {
+                block[l] = pad[l] + b * 64;
+            }
+            LANE_FN(gather)(w, block);
+            LANE_FN(transform)(state, w);
+        }
+    
+        LANE_FN(second)(state, out);
+    }
+}
+
+/**
+ * @brief SHA256d заголовков одного задания с разными nonce
+ * 
+ * Первые 64 байта - общий midstate, байты 64-75 - одинаковые слова во
+ * всех дорожках, различается только слово 3 второго блока.
+ */
+TGT static void LANE_FN(sha256d_nonces)(const uint8_t *header, const uint32_t *nonces, int n, uint8_t *hash)
+{
+    uint32_t mid[8], t[LANES];
+    uint8_t *out[LANES];
+    VEC state[8], w[16];
+    
+    memcpy(mid, sha256_soft_iv, sizeof(mid));
+    sha256_soft_transform(mid, header);
+    
+    for (int base = 0; base < n; base += LANES) {
+        for (int l = 0; l < LANES; l++) {
+            int idx = (base + l < n) ? base + l : base;
+    
+            /* Nonce в заголовке little-endian, слово SHA256 - big-endian */
+            t[l] = __builtin_bswap32(nonces[idx]);
+            out[l] = (base + l < n) ? hash + (size_t)idx * 32 : NULL;
+        }
+    
+        for (int i = 0; i < 8; i++) {
+            state[i] = V_SET1(mid[i]);
+        }
+        for (int i = 0; i < 3; i++) {
+            w[i] = V_SET1(be32(header + 64 + i * 4));
+        }
+        w[3] = V_LOAD(t);
+        w[4] = V_SET1(0x80000000u);
+        for (int i = 5; i < 15; i++) {
+            w[i] = V_ZERO;
+        }
+        w[15] = V_SET1(640);
+    
+        LANE_FN(transform)(state, w);
+        LANE_FN(second)(state, out);
+    }
+}
+
+#undef V_ROTR
+#undef V_CH
+#undef V_MAJ
+#undef V_EP0
+#undef V_EP1
+#undef V_SIG0
+#undef V_SIG1
+#undef LANES
+#undef VEC
+#undef TGT
+#undef LANE_FN
+#undef V_ADD
+#undef V_XOR
+#undef V_AND
+#undef V_OR
+#undef V_ANDNOT
+#undef V_SRL
+#undef V_SLL
+#undef V_SET1
+#undef V_ZERO
+#undef V_LOAD
+#undef V_STORE
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА sha256_x86_lanes.h
+ * =========================================================================== */
@@ -0,0 +1,29 @@
+/**
+ * =============================================================================
+ * @file    FreeRTOS.h
+ * @brief   Avalon A1126pro - Заглушка FreeRTOS для сборки на хосте
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Только типы, которые нужны заголовкам прошивки (cgminer.h, avalon10.h),
+ * чтобы регуляторы без вызовов FreeRTOS собирались симуляторами host/.
+ * Вызов функции FreeRTOS из такого файла - ошибка линковки, а не
+ * молчаливая подмена. Не входит в прошивку.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __HOST_SHIM_FREERTOS_H__
+#define __HOST_SHIM_FREERTOS_H__
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef void *QueueHandle_t;
+
+#endif /* __HOST_SHIM_FREERTOS_H__ */
@@ -0,0 +1,8 @@
+/**
+ * =============================================================================
+ * @file    devices.h
+ * @brief   Avalon A1126pro - Заглушка для сборки на хосте (устройства SDK)
+ * =============================================================================
+ */
+
+#include "FreeRTOS.h"
@@ -0,0 +1,8 @@
+/**
+ * =============================================================================
+ * @file    semphr.h
+ * @brief   Avalon A1126pro - Заглушка для сборки на хосте (семафоры)
+ * =============================================================================
+ */
+
+#include "FreeRTOS.h"
@@ -0,0 +1,8 @@
+/**
+ * =============================================================================
+ * @file    task.h
+ * @brief   Avalon A1126pro - Заглушка для сборки на хосте (задачи)
+ * =============================================================================
+ */
+
+#include "FreeRTOS.h"
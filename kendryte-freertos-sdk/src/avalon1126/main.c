@@ -43,6 +43,7 @@
 /* Kendryte SDK */
 #include <devices.h>        /* Устройства K210 */
 #include <hal.h>            /* Hardware Abstraction Layer */
+#include <clint.h>          /* Счётчик mtime */
 
 /* Модули проекта Avalon1126 */
 #include "avalon10.h"       /* Драйвер ASIC Avalon10 */
@@ -55,6 +56,20 @@
 #include "mock_hardware.h"  /* Эмуляция оборудования */
 #include "auc_uart.h"       /* AUC UART драйвер */
 #include "fpga_loader.h"    /* Загрузчик FPGA bitstream */
+#include "validator.h"      /* Конвейер проверки nonce */
+#include "cores.h"          /* Раскладка задач по ядрам */
+#include "asic_spi.h"       /* SPI транспорт ASIC */
+#include "tune_store.h"     /* Сохранённые настройки ASIC */
+#include "autotune.h"       /* Автонастройка частоты чипов */
+#include "efficiency.h"     /* Подбор напряжения по эффективности */
+#include "fan.h"            /* ПИД вентиляторов */
+#include "throttle.h"       /* Снижение хэшрейта при нагреве */
+#include "balance.h"        /* Тепловая балансировка модулей */
+#include "powercap.h"       /* Жёсткий лимит мощности */
+#include "health.h"         /* Выключение сбойных чипов */
+#include "recovery.h"       /* Сброс зависших модулей */
+#include "yieldmon.h"       /* Недобор nonce: мёртвые ядра и чипы */
+#include "hasher.h"         /* Бэкенды SHA256 */
 
 /* Kendryte SDK заголовки (только для реального железа) */
 #if !defined(MOCK_HARDWARE)
@@ -84,6 +99,8 @@
 
 #define POOL_RETRY_DELAY_SEC        5
 #define STRATUM_CONNECT_RETRY_SEC   1
+#define ASIC_POLL_FALLBACK_MS       10      /* Опрос по тику, если таймер недоступен */
+#define CORES_LOAD_LOG_SEC          60      /* Период вывода загрузки ядер в лог */
 
 /**
  * @brief Название устройства
@@ -234,6 +251,7 @@ static TaskHandle_t task_monitor = NULL;       /* Мониторинг темп
 static TaskHandle_t task_http = NULL;          /* HTTP сервер */
 static TaskHandle_t task_api = NULL;           /* API сервер (порт 4028) */
 static TaskHandle_t task_led = NULL;           /* Управление LED индикаторами */
+static TaskHandle_t task_asic_poll = NULL;     /* Выгрузка nonce из ASIC */
 /* Зарезервировано для будущего использования */
 __attribute__((unused)) static TaskHandle_t task_misc = NULL;  /* Разные операции */
 __attribute__((unused)) static TaskHandle_t task_mmu = NULL;   /* Управление памятью */
@@ -280,6 +298,108 @@ void log_message(int level, const char *fmt, ...)
     printf("[%s] %s: %s\n", TAG, level_str, buf);
 }
 
+/* ===========================================================================
+ * ФУНКЦИЯ: cgminer_time_us
+ * ---------------------------------------------------------------------------
+ * Монотонное время в микросекундах по счётчику CLINT mtime.
+ * mtime тактируется частотой CPU / CLINT_CLOCK_DIV и общий для обоих ядер.
+ * =========================================================================== */
+uint64_t cgminer_time_us(void)
+{
+    uint64_t ticks_per_us = uxPortGetCPUClock() / CLINT_CLOCK_DIV / 1000000UL;
+    
+    if (ticks_per_us == 0) {
+        ticks_per_us = 1;
+    }
+    
+    return clint->mtime / ticks_per_us;
+}
+
+/* ===========================================================================
+ * ФУНКЦИЯ: cgminer_time_s
+ * ---------------------------------------------------------------------------
+ * Секунды от сброса - отметки времени в статистике циклов управления.
+ * =========================================================================== */
+uint32_t cgminer_time_s(void)
+{
+    return (uint32_t)(cgminer_time_us() / 1000000);
+}
+
+/* ===========================================================================
+ * ФУНКЦИЯ: cgminer_poll_dt
+ * ---------------------------------------------------------------------------
+ * Шаг циклов управления (fan, throttle, recovery, yieldmon) с ограничением.
+ * =========================================================================== */
+float cgminer_poll_dt(uint64_t *at_us, uint64_t now_us, float dt_min)
+{
+    float dt = *at_us ? (now_us - *at_us) / 1e6f : 1.0f;
+    
+    if (dt < dt_min) dt = dt_min;
+    if (dt > CGMINER_POLL_DT_MAX) dt = CGMINER_POLL_DT_MAX;
+    *at_us = now_us;
+    
+    return dt;
+}
+
+/* ===========================================================================
+ * ФУНКЦИЯ: cgminer_window_start / cgminer_window_check
+ * ---------------------------------------------------------------------------
+ * Окна счётчиков nonce и HW ошибок циклов управления (autotune, health,
+ * yieldmon). Время 0 означает "окна нет", поэтому начало в 0 с - 1 с.
+ * =========================================================================== */
+void cgminer_window_start(cgminer_window_t *w, uint32_t now, uint64_t count, uint32_t hw)
+{
+    w->at = now ? now : 1;
+    w->count0 = count;
+    w->hw0 = hw;
+}
+
+int cgminer_window_check(cgminer_window_t *w, uint32_t now, uint64_t count, uint32_t hw)
+{
+    if (w->at && count >= w->count0) {
+        return 1;
+    }
+    
+    cgminer_window_start(w, now, count, hw);
+    return 0;
+}
+
+/* ===========================================================================
+ * ФУНКЦИЯ: cgminer_boot_mark
+ * ---------------------------------------------------------------------------
+ * Время этапов загрузки от сброса до первого задания на ASIC.
+ * Отметки ставит одна задача за другой, кроме "первое задание" (mining),
+ * которое ставится после всех этапов cgminer_main().
+ * =========================================================================== */
+static cgminer_boot_mark_t boot_marks[CGMINER_BOOT_MARKS_MAX];
+static int boot_mark_count = 0;
+
+void cgminer_boot_mark(const char *phase)
+{
+    uint32_t ms = (uint32_t)(cgminer_time_us() / 1000);
+    uint32_t prev = boot_mark_count ? boot_marks[boot_mark_count - 1].ms : 0;
+    
+    if (boot_mark_count >= CGMINER_BOOT_MARKS_MAX) {
+        return;
+    }
+    
+    boot_marks[boot_mark_count].phase = phase;
+    boot_marks[boot_mark_count].ms = ms;
+    boot_mark_count++;
+    
+    log_message(LOG_NOTICE, "BOOT +%lu мс (%lu мс): %s", 
+               (unsigned long)ms, (unsigned long)(ms - prev), phase);
+}
+
+const cgminer_boot_mark_t *cgminer_boot_get(int idx)
+{
+    if (idx < 0 || idx >= boot_mark_count) {
+        return NULL;
+    }
+    
+    return &boot_marks[idx];
+}
+
 /* ===========================================================================
  * ФУНКЦИЯ: print_banner
  * ---------------------------------------------------------------------------
@@ -353,15 +473,15 @@ static void main_init_hardware(void)
     fpioa_set_function(14, FUNC_I2C0_SCLK);
     fpioa_set_function(15, FUNC_I2C0_SDA);
     
-    /* UART для отладки */
+    /* UART1 для AUC (канал к модулям ASIC) */
     fpioa_set_function(4, FUNC_UART1_TX);
     fpioa_set_function(5, FUNC_UART1_RX);
     
-    /* GPIO для CS линий ASIC (модули 0-3) */
-    fpioa_set_function(20, FUNC_GPIOHS0);   /* CS0 */
-    fpioa_set_function(21, FUNC_GPIOHS1);   /* CS1 */
-    fpioa_set_function(22, FUNC_GPIOHS2);   /* CS2 */
-    fpioa_set_function(23, FUNC_GPIOHS3);   /* CS3 */
+    /* Аппаратные CS SPI0 для модулей 0-3 (держатся контроллером во время DMA) */
+    fpioa_set_function(20, FUNC_SPI0_SS0);  /* CS0 */
+    fpioa_set_function(21, FUNC_SPI0_SS1);  /* CS1 */
+    fpioa_set_function(22, FUNC_SPI0_SS2);  /* CS2 */
+    fpioa_set_function(23, FUNC_SPI0_SS3);  /* CS3 */
     
     /* GPIO для Ethernet CS */
     fpioa_set_function(12, FUNC_GPIOHS4);   /* ETH_CS */
@@ -375,12 +495,6 @@ static void main_init_hardware(void)
     fpioa_set_function(24, FUNC_GPIOHS6);   /* LED_GREEN */
     fpioa_set_function(25, FUNC_GPIOHS7);   /* LED_RED */
     
-    /* Инициализация GPIO для CS */
-    for (int i = 0; i < 4; i++) {
-        gpiohs_set_drive_mode(i, GPIO_DM_OUTPUT);
-        gpiohs_set_pin(i, GPIO_PV_HIGH);    /* CS high (deselect) */
-    }
-    
     /* Ethernet CS и INT */
     gpiohs_set_drive_mode(4, GPIO_DM_OUTPUT);
     gpiohs_set_pin(4, GPIO_PV_HIGH);
@@ -392,14 +506,9 @@ static void main_init_hardware(void)
     gpiohs_set_pin(6, GPIO_PV_LOW);
     gpiohs_set_pin(7, GPIO_PV_LOW);
     
-    /* Инициализация UART */
-    uart_init(UART_DEVICE_1);
-    uart_configure(UART_DEVICE_1, 115200, UART_BITWIDTH_8BIT, 
-                   UART_STOP_1, UART_PARITY_NONE);
+    /* UART1 (3 Mbaud, FIFO + DMA передачи) настраивает auc_init() */
     
-    /* Инициализация SPI0 для ASIC */
-    spi_init(SPI_DEVICE_0, SPI_WORK_MODE_0, SPI_FF_STANDARD, 8, 0);
-    spi_set_clk_rate(SPI_DEVICE_0, 10000000);   /* 10 MHz */
+    /* SPI0 для ASIC настраивает asic_spi_init() из avalon10_init() */
     
     /* Инициализация SPI1 для Ethernet */
     spi_init(SPI_DEVICE_1, SPI_WORK_MODE_0, SPI_FF_STANDARD, 8, 0);
@@ -512,6 +621,9 @@ static void stratum_send_task(void *pvParameters)
     while (!g_want_quit) {
         pool = get_current_pool();
         if (pool && pool->stratum_active) {
+            /* Шары, прошедшие проверку в validator */
+            validator_submit_pending(pool);
+            
             /* Отправляем накопленные данные на пул */
             stratum_send_work(pool);
         }
@@ -523,6 +635,48 @@ static void stratum_send_task(void *pvParameters)
     vTaskDelete(NULL);
 }
 
+/* ---------------------------------------------------------------------------
+ * ФУНКЦИЯ: pool_maintain
+ * ---------------------------------------------------------------------------
+ * Подключение к пулу и подписка Stratum.
+ * 
+ * Блокирующие connect() и рукопожатие Stratum выполняются на ядре 0
+ * в stratum_recv_task, тракт майнинга на ядре 1 их не ждёт.
+ * --------------------------------------------------------------------------- */
+static void pool_maintain(pool_t *pool, time_t *last_connect_try)
+{
+    time_t now;
+    
+    if (!pool->enabled) {
+        vTaskDelay(pdMS_TO_TICKS(200));
+        return;
+    }
+    
+    /* Проверяем сеть */
+    if (!network_is_connected()) {
+        vTaskDelay(pdMS_TO_TICKS(500));
+        return;
+    }
+    
+    now = time(NULL);
+    if (pool->sock < 0 && (now - pool->last_fail) >= POOL_RETRY_DELAY_SEC) {
+        if (connect_pool(pool) < 0) {
+            pool->last_fail = now;
+            vTaskDelay(pdMS_TO_TICKS(500));
+            return;
+        }
+    }
+    
+    if (pool->state == POOL_STATE_CONNECTED && (now - *last_connect_try) >= STRATUM_CONNECT_RETRY_SEC) {
+        *last_connect_try = now;
+        if (stratum_connect(pool) < 0) {
+            pool->last_fail = now;
+            disconnect_pool(pool);
+            vTaskDelay(pdMS_TO_TICKS(500));
+        }
+    }
+}
+
 /* ---------------------------------------------------------------------------
  * ЗАДАЧА: stratum_recv_task
  * ---------------------------------------------------------------------------
@@ -537,13 +691,22 @@ static void stratum_recv_task(void *pvParameters)
     pool_t *pool;
     int core_id;
     char *line;
+    time_t last_connect_try = 0;
     
     core_id = (int)uxPortGetProcessorId();
     log_message(LOG_DEBUG, "TASKSTART Core %d rstratum_d", core_id);
     
     while (!g_want_quit) {
         pool = get_current_pool();
-        if (pool && pool->stratum_active) {
+        if (pool && pool->stratum_active && !network_is_connected()) {
+            pool->stratum_active = 0;
+        }
+        
+        if (pool && !pool->stratum_active) {
+            /* Подключение выполняется здесь, чтобы не занимать ядро майнинга */
+            pool_maintain(pool, &last_connect_try);
+        }
+        else if (pool) {
             /* Читаем строку от пула */
             line = stratum_recv_line(pool);
             if (line) {
@@ -567,10 +730,12 @@ static void stratum_recv_task(void *pvParameters)
  * 
  * Задача сбрасывает аппаратный watchdog для предотвращения зависания.
  * Если основной код зависнет, watchdog перезагрузит систему.
+ * Раз в секунду пересчитывает загрузку ядер и темп обменов SPI.
  * --------------------------------------------------------------------------- */
 static void watchdog_task(void *pvParameters)
 {
     int core_id;
+    int load_log_sec = 0;
     
     core_id = (int)uxPortGetProcessorId();
     log_message(LOG_DEBUG, "TASKSTART Core %d watchdog", core_id);
@@ -583,7 +748,21 @@ static void watchdog_task(void *pvParameters)
         /* Проверка состояния системы */
         // check_system_health();
         
-        vTaskDelay(pdMS_TO_TICKS(1000));  /* Каждую секунду */
+        /* Загрузка ядер и темп обменов SPI за прошедшую секунду */
+        cores_load_update();
+        asic_spi_stats_update();
+        if (++load_log_sec >= CORES_LOAD_LOG_SEC) {
+            cores_load_t l0, l1;
+            
+            load_log_sec = 0;
+            cores_get_load(CORE_NET, &l0);
+            cores_get_load(CORE_MINING, &l1);
+            log_message(LOG_INFO, "Загрузка ядер: 0 (сеть) %lu.%02lu%%, 1 (майнинг) %lu.%02lu%%",
+                       (unsigned long)(l0.util / 100), (unsigned long)(l0.util % 100),
+                       (unsigned long)(l1.util / 100), (unsigned long)(l1.util % 100));
+        }
+        
+        vTaskDelay(pdMS_TO_TICKS(CORES_LOAD_WINDOW_MS));  /* Каждую секунду */
     }
     
     vTaskDelete(NULL);
@@ -596,7 +775,7 @@ static void watchdog_task(void *pvParameters)
  * Оригинальная функция: FUN_ram_800132d4 @ 0x800132d4
  * 
  * Использует PID-регулятор для поддержания целевой температуры.
- * При перегреве снижает частоту или отключает майнинг.
+ * При нагреве плавно снижает хэшрейт, при temp_cutoff отключает модуль.
  * --------------------------------------------------------------------------- */
 static void monitor_task(void *pvParameters)
 {
@@ -610,11 +789,41 @@ static void monitor_task(void *pvParameters)
             /* Чтение температуры с датчиков */
             avalon10_read_temperature(g_avalon10_info);
             
-            /* Регулировка скорости вентиляторов */
-            avalon10_adjust_fan(g_avalon10_info);
+            /* ПИД вентиляторов (после чтения температуры) */
+            fan_poll(g_avalon10_info);
             
-            /* Проверка перегрева */
+            /* Остановка модулей по temp_cutoff */
             avalon10_check_overheat(g_avalon10_info);
+            
+            /* Сброс зависших модулей по одному */
+            recovery_poll(g_avalon10_info);
+            
+            /* Доли модулей под лимитом мощности */
+            powercap_poll(g_avalon10_info);
+            
+            /* Снижение хэшрейта по прогнозу температуры */
+            throttle_poll(g_avalon10_info);
+            
+            /* Хэшрейт по проверенным nonce */
+            avalon10_update_hashrate(g_avalon10_info);
+            
+            /* Перераспределение бюджета между модулями по температуре */
+            balance_poll(g_avalon10_info);
+            
+            /* Выключение чипов, отдающих одни HW ошибки */
+            health_poll(g_avalon10_info);
+            
+            /* Недобор nonce сложности 1: мёртвые ядра и медленные чипы */
+            yieldmon_poll(g_avalon10_info);
+            
+            /* Подбор частоты чипов по HW ошибкам */
+            autotune_poll(g_avalon10_info);
+            
+            /* Подбор напряжения по J/TH или под лимит мощности */
+            efficiency_poll(g_avalon10_info);
+            
+            /* Сохранение изменившихся настроек во flash */
+            tune_store_poll(g_avalon10_info);
         }
         
         vTaskDelay(pdMS_TO_TICKS(1000));  /* Каждую секунду */
@@ -704,18 +913,44 @@ static void led_task(void *pvParameters)
     vTaskDelete(NULL);
 }
 
+/* ---------------------------------------------------------------------------
+ * ЗАДАЧА: asic_poll_task
+ * ---------------------------------------------------------------------------
+ * Выгрузка nonce из ASIC модулей.
+ * 
+ * Задачу будит аппаратный таймер опроса (AVALON10_POLL_INTERVAL_US),
+ * на каждом пробуждении FIFO всех модулей выгружается до конца.
+ * --------------------------------------------------------------------------- */
+static void asic_poll_task(void *pvParameters)
+{
+    int core_id;
+    
+    core_id = (int)uxPortGetProcessorId();
+    log_message(LOG_DEBUG, "TASKSTART Core %d asic_poll", core_id);
+    
+    while (!g_want_quit) {
+        avalon10_poll_wait(ASIC_POLL_FALLBACK_MS);
+        
+        if (g_avalon10_info) {
+            avalon10_poll(g_avalon10_info);
+        }
+    }
+    
+    avalon10_poll_timer_stop();
+    vTaskDelete(NULL);
+}
+
 /* ---------------------------------------------------------------------------
  * ЗАДАЧА: mining_task
  * ---------------------------------------------------------------------------
- * Основная задача майнинга.
+ * Основная задача майнинга (ядро 1).
  * 
- * Отправляет работу на ASIC и собирает результаты (nonce).
- * Найденные шары отправляются на пул.
+ * Отправляет работу на ASIC. Подключением к пулу занимается
+ * stratum_recv_task на ядре 0, nonce собирает asic_poll_task.
  * --------------------------------------------------------------------------- */
 static void mining_task(void *pvParameters)
 {
     int core_id;
-    time_t last_connect_try = 0;
     char last_job_id[MAX_JOB_ID_LEN] = {0};
     
     core_id = (int)uxPortGetProcessorId();
@@ -724,59 +959,25 @@ static void mining_task(void *pvParameters)
     while (!g_want_quit) {
         pool_t *pool = get_current_pool();
         
-        if (!pool || !pool->enabled) {
-            vTaskDelay(pdMS_TO_TICKS(200));
-            continue;
-        }
-        
-        /* Проверяем сеть */
-        if (!network_is_connected()) {
-            pool->stratum_active = 0;
-            vTaskDelay(pdMS_TO_TICKS(500));
-            continue;
-        }
-        
-        /* Подключение к пулу и Stratum */
-        if (!pool->stratum_active) {
-            time_t now = time(NULL);
-            if (pool->sock < 0 && (now - pool->last_fail) >= POOL_RETRY_DELAY_SEC) {
-                if (connect_pool(pool) < 0) {
-                    pool->last_fail = now;
-                    vTaskDelay(pdMS_TO_TICKS(500));
-                    continue;
-                }
-            }
-            
-            if (pool->state == POOL_STATE_CONNECTED && (now - last_connect_try) >= STRATUM_CONNECT_RETRY_SEC) {
-                last_connect_try = now;
-                if (stratum_connect(pool) < 0) {
-                    pool->last_fail = now;
-                    disconnect_pool(pool);
-                    vTaskDelay(pdMS_TO_TICKS(500));
-                    continue;
-                }
-            }
-        }
-        
         if (g_avalon10_info && pool && pool->stratum_active) {
             work_t *work = stratum_get_current_work();
             
             if (work && g_work_mutex) {
                 if (xSemaphoreTake(g_work_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+                    if (!g_avalon10_info->mining_enabled) {
+                        avalon10_start_mining(g_avalon10_info);
+                    }
                     if (strcmp(last_job_id, work->job_id) != 0) {
                         avalon10_send_work(g_avalon10_info, work);
                         strncpy(last_job_id, work->job_id, MAX_JOB_ID_LEN - 1);
                         last_job_id[MAX_JOB_ID_LEN - 1] = '\0';
+                    } else {
+                        /* Тот же job: досылаем заголовки в опустевшие очереди модулей */
+                        avalon10_refill_work(g_avalon10_info);
                     }
                     xSemaphoreGive(g_work_mutex);
                 }
             }
-            
-            /* Опрос ASIC на предмет найденных nonce */
-            avalon10_poll(g_avalon10_info);
-            
-            /* Простая регулировка вентиляторов */
-            avalon10_adjust_fan(g_avalon10_info);
         }
         
         vTaskDelay(pdMS_TO_TICKS(20));
@@ -788,99 +989,65 @@ static void mining_task(void *pvParameters)
 /* ===========================================================================
  * ФУНКЦИЯ: main_create_tasks
  * ---------------------------------------------------------------------------
- * Создание всех задач FreeRTOS.
+ * Создание всех задач FreeRTOS с привязкой к ядрам (см. cores.h).
  * 
- * Параметры xTaskCreate:
- * - pvTaskCode: указатель на функцию задачи
- * - pcName: имя задачи (для отладки)
- * - usStackDepth: размер стека в словах (word = 4 байта)
- * - pvParameters: параметры для задачи
- * - uxPriority: приоритет (больше = выше)
- * - pxCreatedTask: указатель для сохранения дескриптора
+ * Ядро 0: сеть и Stratum. tcpip (lwIP) и net_rx уже созданы в
+ * network_init(), которая выполняется в главной задаче ядра 0.
+ * Ядро 1: выгрузка nonce, проверка, раздача работы, мониторинг ASIC.
+ * 
+ * Размер стека задаётся в словах (word = 4 байта).
  * =========================================================================== */
 static void main_create_tasks(void)
 {
     log_message(LOG_INFO, "Создание задач FreeRTOS...");
     
-    /* Задачи с высоким приоритетом (критичные для времени) */
-    
-    xTaskCreate(
-        stratum_recv_task,        /* Функция задачи */
-        "stratum_recv",           /* Имя */
-        4096,                     /* Стек 4KB */
-        NULL,                     /* Параметры */
-        5,                        /* Приоритет 5 */
-        &task_stratum_recv        /* Дескриптор */
-    );
-    
-    xTaskCreate(
-        stratum_send_task,
-        "stratum_send",
-        4096,
-        NULL,
-        5,
-        &task_stratum_send
-    );
-    
-    /* Watchdog - самый высокий приоритет */
-    xTaskCreate(
-        watchdog_task,
-        "watchdog",
-        2048,
-        NULL,
-        6,
-        &task_watchdog
-    );
-    
-    /* Мониторинг температуры */
-    xTaskCreate(
-        monitor_task,
-        "monitor",
-        4096,
-        NULL,
-        4,
-        &task_monitor
-    );
-    
-    /* API сервер */
-    xTaskCreate(
-        api_task,
-        "api",
-        8192,                     /* Большой стек для JSON */
-        NULL,
-        3,
-        &task_api
-    );
+    /* ---------------- Ядро 1: тракт майнинга ---------------- */
     
-    /* HTTP сервер */
-    xTaskCreate(
-        http_task,
-        "http",
-        8192,
-        NULL,
-        3,
-        &task_http
-    );
+    /* Бэкенд SHA256: проверка и замер до первого nonce */
+    hasher_init();
+    
+    /* Конвейер проверки nonce - задача validator */
+    if (validator_init() != 0) {
+        log_message(LOG_ERR, "Не удалось запустить конвейер проверки nonce");
+    }
+    
+    /* Выгрузка nonce - будится аппаратным таймером */
+    if (cores_task_create(asic_poll_task, "asic_poll", 4096, NULL,
+                          TASK_PRIO_ASIC_POLL, CORE_MINING, &task_asic_poll) == 0) {
+        avalon10_poll_timer_start(task_asic_poll, AVALON10_POLL_INTERVAL_US);
+    }
+    
+    /* Основная задача майнинга - раздача работы на ASIC */
+    cores_task_create(mining_task, "mining", 4096, NULL,
+                      TASK_PRIO_MINING, CORE_MINING, NULL);
+    
+    /* Мониторинг температуры - обращается к шине ASIC */
+    cores_task_create(monitor_task, "monitor", 4096, NULL,
+                      TASK_PRIO_MONITOR, CORE_MINING, &task_monitor);
     
     /* LED индикация */
-    xTaskCreate(
-        led_task,
-        "led",
-        1024,
-        NULL,
-        2,
-        &task_led
-    );
-    
-    /* Основная задача майнинга */
-    xTaskCreate(
-        mining_task,
-        "mining",
-        4096,
-        NULL,
-        4,
-        NULL
-    );
+    cores_task_create(led_task, "led", 1024, NULL,
+                      TASK_PRIO_LED, CORE_MINING, &task_led);
+    
+    /* ---------------- Ядро 0: сеть ---------------- */
+    
+    /* Watchdog - самый высокий приоритет на ядре */
+    cores_task_create(watchdog_task, "watchdog", 2048, NULL,
+                      TASK_PRIO_WATCHDOG, CORE_NET, &task_watchdog);
+    
+    cores_task_create(stratum_recv_task, "stratum_recv", 4096, NULL,
+                      TASK_PRIO_STRATUM, CORE_NET, &task_stratum_recv);
+    
+    cores_task_create(stratum_send_task, "stratum_send", 4096, NULL,
+                      TASK_PRIO_STRATUM, CORE_NET, &task_stratum_send);
+    
+    /* API сервер - большой стек для JSON */
+    cores_task_create(api_task, "api", 8192, NULL,
+                      TASK_PRIO_API, CORE_NET, &task_api);
+    
+    /* HTTP сервер */
+    cores_task_create(http_task, "http", 8192, NULL,
+                      TASK_PRIO_HTTP, CORE_NET, &task_http);
     
     log_message(LOG_INFO, "Задачи созданы");
 }
@@ -908,16 +1075,19 @@ int cgminer_main(void)
     
     /* Приветственный баннер */
     print_banner();
+    cgminer_boot_mark("старт");
     
     /* ------------------------------------------
      * Этап 1: Инициализация оборудования
      * ------------------------------------------ */
     main_init_hardware();
+    cgminer_boot_mark("оборудование");
     
     /* ------------------------------------------
      * Этап 2: Загрузка конфигурации
      * ------------------------------------------ */
     main_init_config();
+    cgminer_boot_mark("конфигурация");
     
     /* ------------------------------------------
      * Этап 3: Создание объектов синхронизации
@@ -933,6 +1103,7 @@ int cgminer_main(void)
      * ------------------------------------------ */
     log_message(LOG_INFO, "Инициализация сети...");
     network_init();
+    cgminer_boot_mark("сеть");
     
     /* ------------------------------------------
      * Этап 5: Инициализация пулов
@@ -964,11 +1135,13 @@ int cgminer_main(void)
     g_avalon10_info = &g_avalon10;
     avalon10_init(g_avalon10_info);
     g_asc_count = 1;
+    cgminer_boot_mark("ASIC");
     
     /* ------------------------------------------
      * Этап 7: Создание задач
      * ------------------------------------------ */
     main_create_tasks();
+    cgminer_boot_mark("задачи");
     
     /* ------------------------------------------
      * Этап 8: Запуск майнинга
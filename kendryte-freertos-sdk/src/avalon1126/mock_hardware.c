@@ -17,8 +17,14 @@
 #include <string.h>
 #include <time.h>
 
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
 #include "mock_hardware.h"
+#include "sha256_soft.h"
 #include "cgminer.h"
+#include "avalon10.h"
 
 static const char *TAG = "Mock";
 
@@ -184,11 +190,12 @@ int mock_socket_send(int sock, const void *data, size_t len)
                              strlen(mock_stratum_notify));
     }
     else if (strstr(str, "mining.submit")) {
-        /* Принимаем шару с 90% вероятностью */
+        /* Принимаем 9 шар из 10 (каждая 10-я - stale) */
         static const char *accept = "{\"id\":3,\"result\":true,\"error\":null}\n";
         static const char *reject = "{\"id\":3,\"result\":false,\"error\":[21,\"stale\",null]}\n";
-        
-        if ((rand() % 100) < 90) {
+        static uint32_t submits = 0;
+    
+        if (++submits % 10 != 0) {
             mock_socket_inject_rx(sock, accept, strlen(accept));
         } else {
             mock_socket_inject_rx(sock, reject, strlen(reject));
@@ -266,6 +273,21 @@ int mock_socket_get_tx(int sock, void *buf, size_t max_len)
 static mock_asic_module_t mock_modules[MOCK_ASIC_MODULES];
 static int mock_asic_initialized = 0;
 
+/**
+ * @brief xorshift32 - генератор эмулятора (состояние не 0)
+ */
+static uint32_t mock_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    
+    return x;
+}
+
 void mock_asic_init(void)
 {
     if (mock_asic_initialized) return;
@@ -276,29 +298,79 @@ void mock_asic_init(void)
     for (int i = 0; i < MOCK_ASIC_MODULES; i++) {
         mock_modules[i].detected = 1;
         mock_modules[i].enabled = 1;
-        mock_modules[i].temp_in = 450 + (rand() % 100);    /* 45.0-55.0°C */
-        mock_modules[i].temp_out = 550 + (rand() % 100);   /* 55.0-65.0°C */
+        mock_modules[i].temp_in = MOCK_TEMP_IN;
+        mock_modules[i].temp_out = MOCK_TEMP_IN + 100;
+        mock_modules[i].temp_model = mock_modules[i].temp_out;
         mock_modules[i].freq = 500;
+        for (int j = 0; j < MOCK_ASIC_CHIPS_PER_MODULE; j++) {
+            mock_modules[i].chip_freq[j] = 500;
+        }
         mock_modules[i].voltage = 780;
         mock_modules[i].fan_speed = 50;
         mock_modules[i].nonce_counter = 0;
-        mock_modules[i].last_nonce_time = 0;
+        mock_modules[i].nonce_fifo = 0;
+        mock_modules[i].reply_pending = 0;
+        mock_modules[i].last_fill_tick = xTaskGetTickCount();
+        mock_modules[i].thermal_tick = xTaskGetTickCount();
+        mock_modules[i].hw_err_ppm = MOCK_SIM_HW_ERR_PPM;
+        mock_modules[i].stall_ppm = MOCK_SIM_STALL_PPM;
     }
     
+    mock_asic_sim_seed(MOCK_SIM_SEED);
     mock_asic_initialized = 1;
     log_message(LOG_INFO, "%s: ASIC эмуляция инициализирована (%d модулей)", 
                 TAG, MOCK_ASIC_MODULES);
 }
 
+/**
+ * @brief Эмуляция обмена одним кадром
+ * 
+ * Как и реальный ASIC, ответ на запрос выдвигается в следующем кадре:
+ * в rx попадает ответ на предыдущий запрос, а кадр tx с заголовком 'CN'
+ * становится новым запросом. Холостой кадр (0xFF) только забирает ответ.
+ */
+static void mock_asic_spi_frame(int module_id, const uint8_t *tx, uint8_t *rx, size_t len)
+{
+    mock_asic_module_t *m = &mock_modules[module_id];
+    
+    if (rx) {
+        if (!m->reply_pending || len < AVALON10_PKT_TOTAL_LEN ||
+            mock_asic_recv(module_id, rx, len, 0) < 0) {
+            memset(rx, 0xFF, len);  /* Линия MISO в покое */
+        }
+    }
+    m->reply_pending = 0;
+    
+    if (tx && len >= AVALON10_PKT_TOTAL_LEN &&
+        tx[0] == AVALON10_PKT_HEAD1 && tx[1] == AVALON10_PKT_HEAD2) {
+        mock_asic_send(module_id, tx, len);
+        m->reply_pending = 1;
+    }
+}
+
+/**
+ * @brief Эмуляция полнодуплексного SPI обмена
+ * 
+ * Передача длиннее кадра - пакет (burst) при одном CS: модуль разбирает
+ * её по кадрам AVALON10_PKT_TOTAL_LEN байт, ответ на каждый кадр уходит
+ * в следующем кадре той же передачи.
+ */
 int mock_asic_spi_transfer(int module_id, const uint8_t *tx, uint8_t *rx, size_t len)
 {
+    size_t off = 0;
+    
     if (module_id < 0 || module_id >= MOCK_ASIC_MODULES) return -1;
     if (!mock_modules[module_id].detected) return -1;
     
-    /* Заполняем rx нулями по умолчанию */
-    if (rx) {
-        memset(rx, 0, len);
-    }
+    do {
+        size_t n = len - off;
+    
+        if (n > AVALON10_PKT_TOTAL_LEN) {
+            n = AVALON10_PKT_TOTAL_LEN;
+        }
+        mock_asic_spi_frame(module_id, tx ? tx + off : NULL, rx ? rx + off : NULL, n);
+        off += n;
+    } while (off < len);
     
     return 0;
 }
@@ -308,40 +380,125 @@ void mock_asic_set_temperature(int module_id, int16_t temp_in, int16_t temp_out)
     if (module_id >= 0 && module_id < MOCK_ASIC_MODULES) {
         mock_modules[module_id].temp_in = temp_in;
         mock_modules[module_id].temp_out = temp_out;
+        mock_modules[module_id].temp_model = temp_out;
     }
 }
 
+/**
+ * @brief Шаг модели питания и нагрева
+ * 
+ * Утечка растёт с температурой, температура - с мощностью: при снижении
+ * напряжения модуль остывает и теряет ещё часть мощности. Очередь
+ * заданий продвигает вызывающий (простой чипов - без динамической части).
+ */
+uint32_t mock_asic_thermal_step(int module_id)
+{
+    static const uint8_t airflow_pct[MOCK_ASIC_MODULES] = MOCK_AIRFLOW_PCT;
+    mock_asic_module_t *m;
+    TickType_t now = xTaskGetTickCount();
+    uint32_t dt_ms;
+    
+    if (module_id < 0 || module_id >= MOCK_ASIC_MODULES) return 0;
+    
+    m = &mock_modules[module_id];
+    m->power = mock_thermal_power(module_id, m->voltage, m->temp_out,
+                                  m->chip_freq, m->chip_off, m->work_q_len != 0);
+    
+    /* Опрос идёт каждые 2 мс: короткие шаги копятся до MOCK_THERMAL_STEP_MS */
+    dt_ms = (uint32_t)(now - m->thermal_tick) * portTICK_PERIOD_MS;
+    if (dt_ms >= MOCK_THERMAL_STEP_MS) {
+        m->thermal_tick = now;
+        m->fan_speed = (uint8_t)(mock_fan_airflow() * airflow_pct[module_id] / 100);
+        m->temp_model = mock_thermal_temp(m->temp_model, m->temp_in, m->power,
+                                          m->fan_speed, dt_ms);
+        m->temp_out = (int16_t)(m->temp_model + 0.5f);
+    }
+    
+    return m->power;
+}
+
+static void mock_asic_fill_fifo(mock_asic_module_t *m);
+
+/**
+ * @brief Выгрузка одного найденного nonce из FIFO модуля
+ */
 int mock_asic_poll_nonce(int module_id, uint32_t *nonce)
 {
+    mock_asic_module_t *m;
+    
     if (module_id < 0 || module_id >= MOCK_ASIC_MODULES) return 0;
     if (!mock_modules[module_id].enabled) return 0;
     if (!nonce) return 0;
     
-    mock_asic_module_t *m = &mock_modules[module_id];
+    m = &mock_modules[module_id];
+    mock_asic_fill_fifo(m);
+    if (m->nonce_fifo == 0) {
+        return 0;
+    }
     
-    /* Генерируем nonce с заданной частотой */
-    uint32_t now = (uint32_t)time(NULL);
-    if (now > m->last_nonce_time) {
-        m->last_nonce_time = now;
-        m->nonce_counter++;
-        
-        /* Генерируем случайный nonce */
-        *nonce = (uint32_t)rand() ^ ((uint32_t)rand() << 16);
-        
-        /* Обновляем температуру (немного случайно) */
-        m->temp_in += (rand() % 3) - 1;
-        m->temp_out += (rand() % 3) - 1;
-        
-        /* Ограничиваем температуру */
-        if (m->temp_in < 400) m->temp_in = 400;
-        if (m->temp_in > 1000) m->temp_in = 1000;
-        if (m->temp_out < 500) m->temp_out = 500;
-        if (m->temp_out > 1050) m->temp_out = 1050;
-        
-        return 1;
+    *nonce = m->fifo[m->fifo_head].nonce;
+    m->fifo_head = (m->fifo_head + 1) % MOCK_NONCE_FIFO_DEPTH;
+    m->nonce_fifo--;
+    m->nonce_counter++;
+    
+    return 1;
+}
+
+/**
+ * @brief Новое зерно эмулятора
+ */
+void mock_asic_sim_seed(uint32_t seed)
+{
+    for (int i = 0; i < MOCK_ASIC_MODULES; i++) {
+        mock_asic_module_t *m = &mock_modules[i];
+    
+        /* Разные ненулевые состояния модулей */
+        m->rng = (seed ^ (0x9E3779B9u * (uint32_t)(i + 1))) | 1;
+        m->scan_nonce = mock_rand(&m->rng);
+        m->sim_acc = 0;
+        for (int j = 0; j < MOCK_ASIC_CHIPS_PER_MODULE; j++) {
+            m->chip_rate[j] = (uint8_t)(100 - MOCK_SIM_CHIP_SPREAD_PCT +
+                                        mock_rand(&m->rng) % (2 * MOCK_SIM_CHIP_SPREAD_PCT + 1));
+        }
     }
     
-    return 0;
+    log_message(LOG_INFO, "%s: Зерно эмулятора 0x%08lX", TAG, (unsigned long)seed);
+}
+
+void mock_asic_set_chip_rate(int module_id, int chip_id, int pct)
+{
+    if (module_id < 0 || module_id >= MOCK_ASIC_MODULES) return;
+    if (chip_id < 0 || chip_id >= MOCK_ASIC_CHIPS_PER_MODULE) return;
+    
+    mock_modules[module_id].chip_rate[chip_id] = (uint8_t)MIN(MAX(pct, 0), 255);
+}
+
+void mock_asic_set_faults(int module_id, uint32_t hw_err_ppm, uint32_t stall_ppm)
+{
+    if (module_id < 0 || module_id >= MOCK_ASIC_MODULES) return;
+    
+    mock_modules[module_id].hw_err_ppm = hw_err_ppm;
+    mock_modules[module_id].stall_ppm = stall_ppm;
+    
+    log_message(LOG_INFO, "%s: Модуль %d: HW ошибки %lu ppm, зависания %lu ppm",
+                TAG, module_id, (unsigned long)hw_err_ppm, (unsigned long)stall_ppm);
+}
+
+/**
+ * @brief Нулевые старшие биты хэша
+ */
+int mock_asic_hash_zero_bits(const uint8_t *hash)
+{
+    int bits = 0;
+    
+    for (int i = 31; i >= 28; i--) {
+        if (hash[i]) {
+            return bits + __builtin_clz((uint32_t)hash[i]) - 24;
+        }
+        bits += 8;
+    }
+    
+    return bits;
 }
 
 mock_asic_module_t *mock_asic_get_module(int module_id)
@@ -352,6 +509,131 @@ mock_asic_module_t *mock_asic_get_module(int module_id)
     return NULL;
 }
 
+void mock_asic_set_wedge(int module_id, int wedge)
+{
+    if (module_id < 0 || module_id >= MOCK_ASIC_MODULES) return;
+    
+    mock_modules[module_id].wedge = (uint8_t)wedge;
+    
+    log_message(LOG_INFO, "%s: Модуль %d: зависание %d", TAG, module_id, wedge);
+}
+
+/**
+ * @brief Продвижение очереди заголовков модуля по прошедшему времени
+ * 
+ * Модуль перебирает nonce одного заголовка за MOCK_WORK_HEADER_MS и берёт
+ * следующий из очереди. Пустая очередь - чипы простаивают.
+ */
+static void mock_asic_work_advance(mock_asic_module_t *m)
+{
+    TickType_t now = xTaskGetTickCount();
+    TickType_t per = pdMS_TO_TICKS(MOCK_WORK_HEADER_MS);
+    
+    while (m->work_q_len > 0 && (TickType_t)(now - m->work_start_tick) >= per) {
+        m->work_q_len--;
+        memmove(m->work_q, m->work_q + 1, m->work_q_len);
+        memmove(m->work_mid, m->work_mid + 1, m->work_q_len * sizeof(m->work_mid[0]));
+        memmove(m->work_tail, m->work_tail + 1, m->work_q_len * sizeof(m->work_tail[0]));
+        m->work_start_tick += per;
+        m->scan_nonce = mock_rand(&m->rng);
+    }
+    
+    if (m->work_q_len > 0) {
+        m->job_idx = m->work_q[0];
+    }
+}
+
+/**
+ * @brief Приём заголовка: WORK очищает очередь, WORK_TO_CHIP добавляет в конец
+ * 
+ * Заголовок собран в work_rx; в очередь идут его midstate и байты 64-79.
+ */
+static void mock_asic_work_push(mock_asic_module_t *m, uint8_t type, uint8_t job_idx)
+{
+    int q;
+    
+    mock_asic_work_advance(m);
+    
+    if (type == AVALON10_P_WORK) {
+        m->work_q_len = 0;
+    }
+    if (m->work_q_len == 0) {
+        m->work_start_tick = xTaskGetTickCount();
+        m->job_idx = job_idx;
+        m->scan_nonce = mock_rand(&m->rng);
+    }
+    if (m->work_q_len >= MOCK_WORK_QUEUE_MAX) {
+        return;
+    }
+    
+    q = m->work_q_len++;
+    m->work_q[q] = job_idx;
+    memcpy(m->work_mid[q], sha256_soft_iv, sizeof(m->work_mid[q]));
+    sha256_soft_transform(m->work_mid[q], m->work_rx);
+    memcpy(m->work_tail[q], m->work_rx + 64, sizeof(m->work_tail[q]));
+}
+
+/**
+ * @brief Применение управляющего пакета: частота, напряжение, включение чипа
+ * 
+ * Прошивка шлёт их без ожидания ответа (send_pkg), поэтому состояние
+ * меняется при приёме пакета, а не при выдаче ответа.
+ * Значение - big-endian в data[0-3] (младшие байты - data[2-3]),
+ * opt = 0 - весь модуль, opt = N - чип N - 1.
+ */
+static void mock_asic_apply(mock_asic_module_t *m, const uint8_t *data, size_t len)
+{
+    uint16_t val;
+    uint8_t opt;
+    
+    if (len < 40) {
+        return;
+    }
+    val = (data[8] << 8) | data[9];
+    opt = data[3];
+    
+    switch (data[2]) {
+        case AVALON10_P_SET_FREQ:
+            if (opt == 0) {
+                m->freq = val;
+                for (int j = 0; j < MOCK_ASIC_CHIPS_PER_MODULE; j++) {
+                    m->chip_freq[j] = val;
+                }
+            } else if (opt <= MOCK_ASIC_CHIPS_PER_MODULE) {
+                m->chip_freq[opt - 1] = val;
+            }
+            break;
+            
+        case AVALON10_P_SET_VOLTAGE:
+            m->voltage = val;
+            break;
+            
+        case AVALON10_P_SET_MINING:
+            if (opt && opt <= MOCK_ASIC_CHIPS_PER_MODULE) {
+                m->chip_off[opt - 1] = !data[6];
+            }
+            break;
+            
+        case AVALON10_P_RESET:
+            /* Чипы к настройкам по умолчанию, очередь и FIFO пусты */
+            m->wedge = MOCK_WEDGE_NONE;
+            m->freq = 500;
+            for (int j = 0; j < MOCK_ASIC_CHIPS_PER_MODULE; j++) {
+                m->chip_freq[j] = 500;
+                m->chip_off[j] = 0;
+            }
+            m->voltage = 780;
+            m->work_q_len = 0;
+            m->nonce_fifo = 0;
+            m->sim_acc = 0;
+            m->last_fill_tick = xTaskGetTickCount();
+            break;
+            
+        default:
+            break;
+    }
+}
+
 /**
  * @brief Эмуляция отправки пакета на ASIC
  */
@@ -367,9 +649,145 @@ int mock_asic_send(int module_id, const uint8_t *data, size_t len)
         m->last_tx_len = len;
     }
     
+    /* Заголовок задания: пакет idx несёт байты (idx - 1) * 32 ... ,
+     * принят целиком - по последнему пакету (idx == cnt) */
+    if (len >= 38 && (data[2] == AVALON10_P_WORK || data[2] == AVALON10_P_WORK_TO_CHIP) &&
+        data[4] >= 1) {
+        size_t off = (size_t)(data[4] - 1) * 32;
+    
+        if (off < MOCK_WORK_HEADER_LEN) {
+            memcpy(m->work_rx + off, data + 6, MIN(32, MOCK_WORK_HEADER_LEN - off));
+        }
+        if (data[4] == data[5]) {
+            mock_asic_work_push(m, data[2], data[3]);
+        }
+    }
+    
+    mock_asic_apply(m, data, len);
+    
+    return 0;
+}
+
+/**
+ * @brief Чип, нашедший nonce: с вероятностью его вклада в темп модуля
+ */
+static uint8_t mock_asic_pick_chip(mock_asic_module_t *m, uint32_t weight)
+{
+    uint32_t r = mock_rand(&m->rng) % weight;
+    
+    for (int j = 0; j < MOCK_ASIC_CHIPS_PER_MODULE; j++) {
+        uint32_t w = m->chip_off[j] ? 0 : (uint32_t)m->chip_freq[j] * m->chip_rate[j];
+    
+        if (r < w) {
+            return (uint8_t)j;
+        }
+        r -= w;
+    }
+    
     return 0;
 }
 
+/**
+ * @brief Перебор nonce первого заголовка очереди
+ * 
+ * @param weight    Сумма частота × темп включённых чипов
+ */
+static void mock_asic_search(mock_asic_module_t *m, uint32_t hashes, uint32_t weight)
+{
+    uint8_t tail[16];
+    uint8_t hash[32];
+    
+    memcpy(tail, m->work_tail[0], sizeof(tail));
+    
+    for (uint32_t i = 0; i < hashes; i++) {
+        uint32_t nonce = m->scan_nonce++;
+        mock_nonce_t *rec;
+    
+        tail[12] = nonce & 0xFF;
+        tail[13] = (nonce >> 8) & 0xFF;
+        tail[14] = (nonce >> 16) & 0xFF;
+        tail[15] = (nonce >> 24) & 0xFF;
+        sha256d_soft_header(m->work_mid[0], tail, hash);
+    
+        if (mock_asic_hash_zero_bits(hash) < MOCK_SIM_DIFF_BITS) {
+            continue;
+        }
+    
+        m->sim_found++;
+        if (m->nonce_fifo >= MOCK_NONCE_FIFO_DEPTH) {
+            m->sim_lost++;     /* FIFO полон - nonce теряется, как в ASIC */
+            continue;
+        }
+    
+        rec = &m->fifo[(m->fifo_head + m->nonce_fifo) % MOCK_NONCE_FIFO_DEPTH];
+        rec->nonce = nonce;
+        rec->chip_id = mock_asic_pick_chip(m, weight);
+        rec->core_id = (uint8_t)(mock_rand(&m->rng) % MOCK_ASIC_CORES_PER_CHIP);
+        rec->job_idx = m->work_q[0];
+        if (mock_rand(&m->rng) % 1000000 < m->hw_err_ppm) {
+            rec->nonce ^= 1u << (mock_rand(&m->rng) & 31);
+            m->sim_hw_errors++;
+        }
+        m->nonce_fifo++;
+    }
+    
+    m->sim_hashes += hashes;
+}
+
+/**
+ * @brief Пополнение FIFO nonce модуля по прошедшему времени
+ * 
+ * Модуль находит MOCK_NONCE_RATE_HZ nonce в секунду при частоте чипов
+ * MOCK_NONCE_RATE_FREQ (пропорционально частотам и темпам включённых
+ * чипов) - столько хэшей и перебирается, FIFO ограничен
+ * MOCK_NONCE_FIFO_DEPTH (лишние nonce теряются, как в реальном ASIC).
+ */
+static void mock_asic_fill_fifo(mock_asic_module_t *m)
+{
+    const uint64_t per_hash = (uint64_t)MOCK_NONCE_RATE_FREQ * 100 *
+                              MOCK_ASIC_CHIPS_PER_MODULE * 1000;
+    TickType_t now = xTaskGetTickCount();
+    uint32_t elapsed_ms = (uint32_t)(now - m->last_fill_tick) * portTICK_PERIOD_MS;
+    uint32_t weight = 0;
+    uint64_t hashes;
+    
+    m->last_fill_tick = now;
+    
+    for (int j = 0; j < MOCK_ASIC_CHIPS_PER_MODULE; j++) {
+        if (!m->chip_off[j]) {
+            weight += (uint32_t)m->chip_freq[j] * m->chip_rate[j];
+        }
+    }
+    
+    /* Без заголовков чипы ничего не находят */
+    mock_asic_work_advance(m);
+    if (m->work_q_len == 0 || m->wedge == MOCK_WEDGE_NONCE || weight == 0) {
+        m->sim_acc = 0;
+        return;
+    }
+    
+    /* Зависание: stall_ppm на секунду работы */
+    if (m->stall_ppm &&
+        mock_rand(&m->rng) % 1000000000u < (uint64_t)m->stall_ppm * elapsed_ms) {
+        m->wedge = MOCK_WEDGE_NONCE;
+        log_message(LOG_INFO, "%s: Модуль %d: зависание (эмуляция отказа)",
+                    TAG, (int)(m - mock_modules));
+        return;
+    }
+    
+    /* Темп в долях хэша: nonce в секунду × 2^DIFF_BITS хэшей на nonce */
+    m->sim_acc += ((uint64_t)elapsed_ms * MOCK_NONCE_RATE_HZ * weight) << MOCK_SIM_DIFF_BITS;
+    hashes = m->sim_acc / per_hash;
+    m->sim_acc %= per_hash;
+    
+    if (hashes > MOCK_SIM_HASH_BUDGET) {
+        m->sim_lag += hashes - MOCK_SIM_HASH_BUDGET;
+        hashes = MOCK_SIM_HASH_BUDGET;
+    }
+    
+    mock_asic_search(m, (uint32_t)hashes, weight);
+}
+
 /**
  * @brief Эмуляция приёма пакета от ASIC (формат Avalon4+)
  * 
@@ -384,6 +802,8 @@ int mock_asic_recv(int module_id, uint8_t *data, size_t len, int timeout)
     
     mock_asic_module_t *m = &mock_modules[module_id];
     
+    if (m->wedge == MOCK_WEDGE_SILENT) return -1;
+    
     /* Эмулируем формат ответа ASIC (Avalon4+ protocol) */
     /* [0-1] Head: 'C', 'N' */
     /* [2]   Type */
@@ -403,8 +823,8 @@ int mock_asic_recv(int module_id, uint8_t *data, size_t len, int timeout)
     uint8_t cmd_type = m->last_tx_pkg[2];
     
     switch (cmd_type) {
-        case 0x10:  /* DETECT */
-            data[2] = 0x10;  /* type */
+        case AVALON10_P_DETECT:
+            data[2] = AVALON10_P_DETECT;  /* type */
             data[3] = 0;     /* opt */
             data[4] = 1;     /* idx */
             data[5] = 1;     /* cnt */
@@ -415,12 +835,14 @@ int mock_asic_recv(int module_id, uint8_t *data, size_t len, int timeout)
             data[9] = MOCK_ASIC_CHIPS_PER_MODULE & 0xFF;
             break;
             
-        case 0x11:  /* STATUS */
-            data[2] = 0x11;
+        case AVALON10_P_STATUS:
+            data[2] = AVALON10_P_STATUS;
             data[3] = 0;
             data[4] = 1;
             data[5] = 1;
             /* Data[32]: Temperature, voltage, frequency в data[6-37] */
+            mock_asic_work_advance(m);
+            mock_asic_thermal_step(module_id);
             data[6] = (m->temp_in >> 8) & 0xFF;
             data[7] = m->temp_in & 0xFF;
             data[8] = (m->temp_out >> 8) & 0xFF;
@@ -429,63 +851,72 @@ int mock_asic_recv(int module_id, uint8_t *data, size_t len, int timeout)
             data[11] = m->voltage & 0xFF;
             data[12] = (m->freq >> 8) & 0xFF;
             data[13] = m->freq & 0xFF;
+            /* Очередь заданий: заголовков в очереди, чипов без задания */
+            mock_asic_work_advance(m);
+            data[6 + AVALON10_STATUS_WORK_QUEUED] = m->work_q_len;
+            data[6 + AVALON10_STATUS_IDLE_CHIPS] = m->work_q_len ? 0 : MOCK_ASIC_CHIPS_PER_MODULE;
+            data[6 + AVALON10_STATUS_POWER] = (m->power >> 8) & 0xFF;
+            data[6 + AVALON10_STATUS_POWER + 1] = m->power & 0xFF;
             break;
             
-        case 0x12:  /* NONCE */
-            data[2] = 0x12;
-            data[3] = 0;
-            data[4] = 1;
-            data[5] = 1;
-            /* Data[32]: Nonce data в data[6-37] */
-            if ((rand() % 100) < 5) {  /* 5% шанс найти nonce */
-                uint32_t nonce = (uint32_t)rand() ^ ((uint32_t)rand() << 16);
-                data[6] = (nonce >> 24) & 0xFF;
-                data[7] = (nonce >> 16) & 0xFF;
-                data[8] = (nonce >> 8) & 0xFF;
-                data[9] = nonce & 0xFF;
-                data[10] = rand() % MOCK_ASIC_CHIPS_PER_MODULE;  /* Chip ID */
-                data[11] = rand() % MOCK_ASIC_CORES_PER_CHIP;    /* Core ID */
-                data[12] = 0x01;  /* Nonce found flag */
+        case AVALON10_P_NONCE: {
+            /* opt = записей в пакете, cnt = остаток FIFO, data = 4 записи по 8 байт */
+            int n;
+            
+            mock_asic_fill_fifo(m);
+            n = (m->nonce_fifo < AVALON10_NONCE_PER_PKG) ? 
+                (int)m->nonce_fifo : AVALON10_NONCE_PER_PKG;
+            
+            for (int i = 0; i < n; i++) {
+                uint8_t *rec = &data[6 + i * AVALON10_NONCE_REC_LEN];
+                const mock_nonce_t *f = &m->fifo[m->fifo_head];
+                
+                rec[0] = (f->nonce >> 24) & 0xFF;
+                rec[1] = (f->nonce >> 16) & 0xFF;
+                rec[2] = (f->nonce >> 8) & 0xFF;
+                rec[3] = f->nonce & 0xFF;
+                rec[4] = f->chip_id;                            /* Chip ID */
+                rec[5] = f->core_id;                            /* Core ID */
+                rec[6] = f->job_idx;                            /* Job idx */
+                rec[7] = AVALON10_NONCE_FLAG_VALID;
+                m->fifo_head = (m->fifo_head + 1) % MOCK_NONCE_FIFO_DEPTH;
                 m->nonce_counter++;
-            } else {
-                data[12] = 0x00;  /* No nonce */
             }
+            m->nonce_fifo -= n;
+            
+            data[2] = AVALON10_P_NONCE;
+            data[3] = (uint8_t)n;
+            data[4] = 1;
+            data[5] = (m->nonce_fifo > 0xFF) ? 0xFF : (uint8_t)m->nonce_fifo;
             break;
+        }
             
-        case 0x20:  /* SET_FREQ */
-            data[2] = 0x20;
+        case AVALON10_P_SET_FREQ:
+            data[2] = AVALON10_P_SET_FREQ;
             data[3] = 0;
             data[4] = 1;
             data[5] = 1;
-            data[6] = 0x00;  /* Status: OK */
-            /* Обновляем частоту из последней команды */
-            if (m->last_tx_len >= 40) {
-                m->freq = (m->last_tx_pkg[6] << 8) | m->last_tx_pkg[7];
-            }
+            data[6] = 0x00;  /* Status: OK (частота применена при приёме) */
             break;
             
-        case 0x21:  /* SET_VOLTAGE */
-            data[2] = 0x21;
+        case AVALON10_P_SET_VOLTAGE:
+            data[2] = AVALON10_P_SET_VOLTAGE;
             data[3] = 0;
             data[4] = 1;
             data[5] = 1;
-            data[6] = 0x00;  /* Status: OK */
-            /* Обновляем напряжение из последней команды */
-            if (m->last_tx_len >= 40) {
-                m->voltage = (m->last_tx_pkg[6] << 8) | m->last_tx_pkg[7];
-            }
+            data[6] = 0x00;  /* Status: OK (напряжение применено при приёме) */
             break;
             
-        case 0x30:  /* WORK */
-            data[2] = 0x30;
+        case AVALON10_P_WORK:
+            data[2] = AVALON10_P_WORK;
             data[3] = 0;
             data[4] = 1;
             data[5] = 1;
             data[6] = 0x00;  /* Status: Accepted */
             break;
             
-        case 0xF0:  /* RESET */
-            data[2] = 0xF0;
+        case AVALON10_P_RESET:
+            data[2] = AVALON10_P_RESET;
             data[3] = 0;
             data[4] = 1;
             data[5] = 1;
@@ -545,132 +976,125 @@ int mock_asic_recv(int module_id, uint8_t *data, size_t len, int timeout)
     data[38] = (crc >> 8) & 0xFF;
     data[39] = crc & 0xFF;
     
+    if (m->wedge == MOCK_WEDGE_CRC) {
+        data[39] ^= 0x5A;
+    }
+    
     return 0;
 }
 
-#endif /* MOCK_ASIC */
-
 /* ===========================================================================
- * SOFTWARE SHA256 IMPLEMENTATION
+ * MOCK AUC UART
  * =========================================================================== */
 
-/* SHA256 константы */
-static const uint32_t sha256_k[64] = {
-    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
-    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
-    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
-    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
-    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
-    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
-    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
-    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-};
-
-#define ROTR(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
-#define CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
-#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
-#define EP0(x)  (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
-#define EP1(x)  (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
-#define SIG0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
-#define SIG1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
-
-static void sha256_transform(uint32_t *state, const uint8_t *data)
-{
-    uint32_t a, b, c, d, e, f, g, h, t1, t2, m[64];
-    int i;
-    
-    /* Подготовка сообщения */
-    for (i = 0; i < 16; i++) {
-        m[i] = ((uint32_t)data[i * 4] << 24) |
-               ((uint32_t)data[i * 4 + 1] << 16) |
-               ((uint32_t)data[i * 4 + 2] << 8) |
-               ((uint32_t)data[i * 4 + 3]);
-    }
-    
-    for (i = 16; i < 64; i++) {
-        m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
-    }
-    
-    a = state[0]; b = state[1]; c = state[2]; d = state[3];
-    e = state[4]; f = state[5]; g = state[6]; h = state[7];
-    
-    for (i = 0; i < 64; i++) {
-        t1 = h + EP1(e) + CH(e, f, g) + sha256_k[i] + m[i];
-        t2 = EP0(a) + MAJ(a, b, c);
-        h = g; g = f; f = e; e = d + t1;
-        d = c; c = b; b = a; a = t1 + t2;
-    }
-    
-    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
-    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
-}
-
-void mock_sha256(const uint8_t *data, size_t len, uint8_t *hash)
-{
-    uint32_t state[8] = {
-        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
-        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
-    };
-    
-    uint8_t block[64];
-    size_t i;
-    size_t remaining = len;
-    const uint8_t *ptr = data;
-    
-    /* Обработка полных блоков */
-    while (remaining >= 64) {
-        sha256_transform(state, ptr);
-        ptr += 64;
-        remaining -= 64;
+static uint8_t auc_ring[MOCK_AUC_RING_SIZE];
+static size_t auc_ring_head = 0;
+static size_t auc_ring_len = 0;
+static SemaphoreHandle_t auc_ring_lock = NULL;
+static SemaphoreHandle_t auc_ring_event = NULL;
+static int auc_module = -1;
+static uint32_t auc_replies = 0;
+
+void mock_auc_init(void)
+{
+    if (!auc_ring_lock) {
+        auc_ring_lock = xSemaphoreCreateMutex();
+        auc_ring_event = xSemaphoreCreateBinary();
     }
     
-    /* Padding */
-    memset(block, 0, 64);
-    memcpy(block, ptr, remaining);
-    block[remaining] = 0x80;
+    auc_ring_head = 0;
+    auc_ring_len = 0;
+    auc_module = -1;
+    auc_replies = 0;
     
-    if (remaining >= 56) {
-        sha256_transform(state, block);
-        memset(block, 0, 64);
+    log_message(LOG_INFO, "%s: AUC петля инициализирована", TAG);
+}
+
+/**
+ * @brief Байты в поток приёма (при переполнении теряются, как в UART)
+ */
+static void mock_auc_put(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len && auc_ring_len < MOCK_AUC_RING_SIZE; i++) {
+        auc_ring[(auc_ring_head + auc_ring_len) % MOCK_AUC_RING_SIZE] = data[i];
+        auc_ring_len++;
     }
+}
+
+void mock_auc_select(int module_id)
+{
+    auc_module = module_id;
+}
+
+int mock_auc_write(const uint8_t *data, size_t len)
+{
+    uint8_t reply[AVALON10_PKT_TOTAL_LEN];
     
-    /* Длина в битах (big-endian) */
-    uint64_t bits = len * 8;
-    block[63] = bits & 0xff;
-    block[62] = (bits >> 8) & 0xff;
-    block[61] = (bits >> 16) & 0xff;
-    block[60] = (bits >> 24) & 0xff;
-    block[59] = (bits >> 32) & 0xff;
-    block[58] = (bits >> 40) & 0xff;
-    block[57] = (bits >> 48) & 0xff;
-    block[56] = (bits >> 56) & 0xff;
+    if (!auc_ring_lock || !data) return -1;
     
-    sha256_transform(state, block);
+    /* Без выбранного модуля линия никуда не подключена */
+    if (auc_module < 0) return 0;
     
-    /* Результат (big-endian) */
-    for (i = 0; i < 8; i++) {
-        hash[i * 4] = (state[i] >> 24) & 0xff;
-        hash[i * 4 + 1] = (state[i] >> 16) & 0xff;
-        hash[i * 4 + 2] = (state[i] >> 8) & 0xff;
-        hash[i * 4 + 3] = state[i] & 0xff;
+    for (size_t off = 0; off + AVALON10_PKT_TOTAL_LEN <= len; off += AVALON10_PKT_TOTAL_LEN) {
+        const uint8_t *f = data + off;
+        
+        if (f[0] != AVALON10_PKT_HEAD1 || f[1] != AVALON10_PKT_HEAD2) {
+            continue;
+        }
+        if (mock_asic_send(auc_module, f, AVALON10_PKT_TOTAL_LEN) < 0) {
+            continue;   /* Модуля нет - ответа нет */
+        }
+        mock_asic_recv(auc_module, reply, sizeof(reply), 0);
+        auc_replies++;
+        
+        if (MOCK_AUC_DROP_EVERY && auc_replies % MOCK_AUC_DROP_EVERY == 0) {
+            continue;
+        }
+        if (MOCK_AUC_CORRUPT_EVERY && auc_replies % MOCK_AUC_CORRUPT_EVERY == 0) {
+            reply[6 + (auc_replies / MOCK_AUC_CORRUPT_EVERY) % 32] ^= 0x5A;
+        }
+        
+        xSemaphoreTake(auc_ring_lock, portMAX_DELAY);
+        if (MOCK_AUC_NOISE_EVERY && auc_replies % MOCK_AUC_NOISE_EVERY == 0) {
+            /* Ложный заголовок - худший случай для поиска 'CN' */
+            uint8_t junk = AVALON10_PKT_HEAD1;
+            mock_auc_put(&junk, 1);
+        }
+        mock_auc_put(reply, sizeof(reply));
+        xSemaphoreGive(auc_ring_lock);
+        
+        xSemaphoreGive(auc_ring_event);
     }
+    
+    return 0;
 }
 
-void mock_sha256d(const uint8_t *data, size_t len, uint8_t *hash)
+int mock_auc_read(uint8_t *buf, size_t len, uint32_t timeout_ms)
 {
-    uint8_t temp[32];
-    mock_sha256(data, len, temp);
-    mock_sha256(temp, 32, hash);
+    size_t cnt = 0;
+    
+    if (!auc_ring_lock || !buf) return -1;
+    
+    while (cnt < len) {
+        xSemaphoreTake(auc_ring_lock, portMAX_DELAY);
+        while (auc_ring_len > 0 && cnt < len) {
+            buf[cnt++] = auc_ring[auc_ring_head];
+            auc_ring_head = (auc_ring_head + 1) % MOCK_AUC_RING_SIZE;
+            auc_ring_len--;
+        }
+        xSemaphoreGive(auc_ring_lock);
+        
+        if (cnt < len &&
+            xSemaphoreTake(auc_ring_event, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+            break;
+        }
+    }
+    
+    return cnt ? (int)cnt : -1;
 }
 
+#endif /* MOCK_ASIC */
+
 /* ===========================================================================
  * HELPER FUNCTIONS
  * =========================================================================== */
@@ -155,7 +155,95 @@ int mock_socket_get_tx(int sock, void *buf, size_t max_len);
 #define MOCK_ASIC_CHIPS             114
 #define MOCK_ASIC_CHIPS_PER_MODULE  114
 #define MOCK_ASIC_CORES_PER_CHIP    72
-#define MOCK_NONCE_RATE_HZ          10      /* Частота генерации nonce */
+#define MOCK_NONCE_RATE_HZ          500     /* Nonce в секунду на модуль */
+#define MOCK_NONCE_FIFO_DEPTH       1024    /* Глубина FIFO nonce модуля */
+#define MOCK_WORK_HEADER_MS         40      /* Перебор nonce одного заголовка модулем */
+#define MOCK_WORK_QUEUE_MAX         4       /* Очередь заголовков (AVALON10_WORK_QUEUE_MAX) */
+#define MOCK_NONCE_RATE_FREQ        500     /* Частота чипов, при которой rate = MOCK_NONCE_RATE_HZ */
+#define MOCK_WORK_HEADER_LEN        80      /* Заголовок блока из пакетов WORK */
+
+/* ---------------------------------------------------------------------------
+ * Поиск nonce
+ * 
+ * Модуль перебирает nonce заголовка, пришедшего пакетами WORK (SHA256d по
+ * midstate заголовка), и отдаёт те, у которых старшие MOCK_SIM_DIFF_BITS
+ * бит хэша нулевые - сложность 1 эмулятора вместо 32 бит. Validator в
+ * сборке MOCK_ASIC считает так же, шара - MOCK_SIM_SHARE_BITS нулевых бит.
+ * 
+ * Темп - MOCK_NONCE_RATE_HZ nonce в секунду на модуль при частоте
+ * MOCK_NONCE_RATE_FREQ, т.е. 2^MOCK_SIM_DIFF_BITS хэшей на nonce. Вклад
+ * чипа пропорционален частоте и его темпу chip_rate (%, разброс
+ * MOCK_SIM_CHIP_SPREAD_PCT); найденный nonce достаётся чипу с вероятностью
+ * его вклада. За один вызов - не больше MOCK_SIM_HASH_BUDGET хэшей:
+ * неуспевающий эмулятор отстаёт (sim_lag), а не задерживает опрос.
+ * 
+ * Отказы: найденный nonce с вероятностью hw_err_ppm портится одним битом
+ * (HW error); с вероятностью stall_ppm за секунду работы модуль зависает
+ * как MOCK_WEDGE_NONCE до пакета RESET.
+ * 
+ * Случайные величины эмулятора - xorshift32 от зерна (MOCK_SIM_SEED,
+ * mock_asic_sim_seed()): при одних и тех же заголовках nonce, чипы и
+ * отказы повторяются, от времени зависит только их число.
+ * --------------------------------------------------------------------------- */
+
+#define MOCK_SIM_SEED               0x1126u
+#define MOCK_SIM_DIFF_BITS          4       /* Нулевых старших бит хэша у nonce */
+#define MOCK_SIM_SHARE_BITS         12      /* Нулевых старших бит хэша у шары */
+#define MOCK_SIM_HASH_BUDGET        1024    /* Хэшей модуля за один вызов */
+#define MOCK_SIM_CHIP_SPREAD_PCT    5       /* Разброс темпа чипов */
+#define MOCK_SIM_HW_ERR_PPM         2000    /* Испорченных nonce на миллион */
+#define MOCK_SIM_STALL_PPM          0       /* Зависаний на миллион секунд работы */
+
+/**
+ * @brief Найденный nonce в FIFO модуля
+ */
+typedef struct mock_nonce {
+    uint32_t nonce;
+    uint8_t chip_id;
+    uint8_t core_id;
+    uint8_t job_idx;
+} mock_nonce_t;
+
+/* ---------------------------------------------------------------------------
+ * Модель питания и нагрева модуля
+ * 
+ * Чип: динамическая мощность MOCK_POWER_DYN_UW мкВт на (В² · МГц) и утечка
+ * MOCK_POWER_LEAK_MW при 780 mV / 60°C (квадратично по напряжению, +2% на
+ * градус). Модули различаются на MOCK_POWER_SPREAD_PCT, так что телеметрия
+ * расходится с моделью прошивки (efficiency.c). Выход модуля стремится к
+ * temp_in + P · MOCK_THERMAL_R / (обдув + 20) (°C × 10) с постоянной
+ * времени MOCK_THERMAL_TAU_MS, обдув (%) - средние обороты эмулируемых
+ * вентиляторов от MOCK_FAN_RPM_MAX, умноженные на долю потока модуля
+ * MOCK_AIRFLOW_PCT (модуль 3 стоит в худшем месте корпуса). Мощность
+ * отдаётся в ответе STATUS. Вход модели случайных величин не содержит:
+ * прогон с одними и теми же действиями даёт одни и те же температуры.
+ * Формулы - в mock_thermal.c без FreeRTOS: на той же модели регуляторы
+ * проверяются на хосте (host/efficiency_sim.c, host/fan_sim.c).
+ * --------------------------------------------------------------------------- */
+
+#define MOCK_POWER_DYN_UW           24500
+#define MOCK_POWER_LEAK_MW          500
+#define MOCK_POWER_SPREAD_PCT       3
+#define MOCK_PSU_EFF                94      /* КПД БП (%) */
+#define MOCK_THERMAL_R              15
+#define MOCK_THERMAL_TAU_MS         20000
+#define MOCK_THERMAL_STEP_MS        100     /* Шаг модели нагрева не короче */
+#define MOCK_TEMP_IN                500     /* Воздух на входе (°C × 10) */
+#define MOCK_AIRFLOW_PCT            { 110, 100, 100, 75 }
+
+/* ---------------------------------------------------------------------------
+ * Зависание модуля (mock_asic_set_wedge), снимается пакетом RESET:
+ * - SILENT - модуль принимает пакеты, но не отвечает;
+ * - NONCE - ответы идут, FIFO nonce не пополняется;
+ * - CRC - у всех ответов неверная CRC.
+ * Сброс возвращает частоты и напряжение модуля к значениям по умолчанию,
+ * очищает очередь заданий и FIFO nonce, включает все чипы.
+ * --------------------------------------------------------------------------- */
+
+#define MOCK_WEDGE_NONE             0
+#define MOCK_WEDGE_SILENT           1
+#define MOCK_WEDGE_NONCE            2
+#define MOCK_WEDGE_CRC              3
 
 typedef struct mock_asic_module {
     int detected;
@@ -163,12 +251,42 @@ typedef struct mock_asic_module {
     int16_t temp_in;        /* Температура × 10 */
     int16_t temp_out;
     uint16_t freq;
+    uint16_t chip_freq[MOCK_ASIC_CHIPS_PER_MODULE];    /* Частота каждого чипа */
+    uint8_t chip_off[MOCK_ASIC_CHIPS_PER_MODULE];      /* 1 = чип выключен (SET_MINING) */
     uint16_t voltage;
     uint8_t fan_speed;
+    uint16_t power;         /* Мощность от розетки (Вт) */
+    uint32_t thermal_tick;  /* Тик последнего шага модели нагрева */
+    float temp_model;       /* temp_out модели без округления */
     
     /* Счётчики для эмуляции */
-    uint32_t nonce_counter;
-    uint32_t last_nonce_time;
+    uint32_t nonce_counter;     /* Выгружено nonce */
+    uint32_t nonce_fifo;        /* Nonce, ожидающие выгрузки */
+    uint32_t fifo_head;         /* Первый из них в fifo[] */
+    mock_nonce_t fifo[MOCK_NONCE_FIFO_DEPTH];
+    uint32_t last_fill_tick;    /* Тик последнего пополнения FIFO */
+    uint8_t job_idx;            /* Индекс задания в работе (opt пакета WORK) */
+    uint8_t work_q[MOCK_WORK_QUEUE_MAX];    /* Очередь заголовков (индексы заданий) */
+    uint8_t work_q_len;
+    uint32_t work_start_tick;   /* Тик начала перебора первого заголовка очереди */
+    uint8_t work_rx[MOCK_WORK_HEADER_LEN];  /* Сборка заголовка из пакетов */
+    uint32_t work_mid[MOCK_WORK_QUEUE_MAX][8];  /* midstate заголовков очереди */
+    uint8_t work_tail[MOCK_WORK_QUEUE_MAX][16]; /* Байты 64-79 заголовков */
+    
+    /* Поиск nonce */
+    uint32_t rng;               /* Состояние xorshift32 модуля */
+    uint32_t scan_nonce;        /* Следующий nonce первого заголовка */
+    uint64_t sim_acc;           /* Накопленный темп (доли хэша) */
+    uint8_t chip_rate[MOCK_ASIC_CHIPS_PER_MODULE];     /* Темп чипа (%) */
+    uint32_t hw_err_ppm;
+    uint32_t stall_ppm;
+    uint64_t sim_hashes;        /* Посчитано хэшей */
+    uint32_t sim_found;         /* Найдено nonce */
+    uint32_t sim_hw_errors;     /* Из них испорчено */
+    uint32_t sim_lost;          /* Потеряно при полном FIFO */
+    uint64_t sim_lag;           /* Хэшей сверх MOCK_SIM_HASH_BUDGET (не посчитано) */
+    uint8_t reply_pending;      /* Ответ на запрос ждёт следующего кадра SPI */
+    uint8_t wedge;              /* MOCK_WEDGE_* */
     
     /* Буфер последнего отправленного пакета */
     uint8_t last_tx_pkg[128];
@@ -181,7 +299,8 @@ typedef struct mock_asic_module {
 void mock_asic_init(void);
 
 /**
- * @brief Эмуляция SPI передачи
+ * @brief Эмуляция полнодуплексного SPI обмена (ответ в следующем кадре,
+ *        передача из нескольких кадров - пакет при одном CS)
  */
 int mock_asic_spi_transfer(int module_id, const uint8_t *tx, uint8_t *rx, size_t len);
 
@@ -201,31 +320,150 @@ int mock_asic_recv(int module_id, uint8_t *data, size_t len, int timeout);
 void mock_asic_set_temperature(int module_id, int16_t temp_in, int16_t temp_out);
 
 /**
- * @brief Генерация фиктивного nonce
+ * @brief Шаг модели питания и нагрева модуля
+ * @return Мощность модуля (Вт)
+ */
+uint32_t mock_asic_thermal_step(int module_id);
+
+/**
+ * @brief Мощность модуля по модели (Вт, mock_thermal.c)
+ * @param temp Температура выхода (°C × 10), от неё зависит утечка
+ * @param busy 0 - очередь заданий пуста, динамической мощности нет
+ */
+uint16_t mock_thermal_power(int module_id, uint16_t voltage, int16_t temp,
+                            const uint16_t *chip_freq, const uint8_t *chip_off, int busy);
+
+/**
+ * @brief Температура выхода модуля через dt_ms (°C × 10, mock_thermal.c)
+ * 
+ * Без округления: при шаге в десятки мс приращение меньше 0.1°C, и
+ * целая температура не сдвинулась бы с места.
+ * 
+ * @param airflow Обдув модуля (%)
+ */
+float mock_thermal_temp(float temp, int16_t temp_in, uint16_t power,
+                        int airflow, uint32_t dt_ms);
+
+/**
+ * @brief Выгрузка одного найденного nonce из FIFO модуля (без пакета NONCE)
+ * @return 1 - nonce выдан, 0 - FIFO пуст
  */
 int mock_asic_poll_nonce(int module_id, uint32_t *nonce);
 
+/**
+ * @brief Новое зерно эмулятора: состояния генераторов, разброс темпа
+ *        чипов и начала перебора всех модулей
+ */
+void mock_asic_sim_seed(uint32_t seed);
+
+/**
+ * @brief Темп чипа (% от номинала, 0 - чип ничего не находит)
+ */
+void mock_asic_set_chip_rate(int module_id, int chip_id, int pct);
+
+/**
+ * @brief Частота отказов модуля (на миллион): испорченные nonce и
+ *        зависания за секунду работы
+ */
+void mock_asic_set_faults(int module_id, uint32_t hw_err_ppm, uint32_t stall_ppm);
+
+/**
+ * @brief Нулевые старшие биты хэша (0-32, как у validator: байты 31..28)
+ */
+int mock_asic_hash_zero_bits(const uint8_t *hash);
+
 /**
  * @brief Получение состояния mock модуля
  */
 mock_asic_module_t *mock_asic_get_module(int module_id);
 
-#endif /* MOCK_ASIC */
+/**
+ * @brief Зависание модуля (MOCK_WEDGE_*) до пакета RESET
+ */
+void mock_asic_set_wedge(int module_id, int wedge);
 
-/* ===========================================================================
- * MOCK SHA256
- * =========================================================================== */
+/* ---------------------------------------------------------------------------
+ * Петля AUC UART: поток байт к эмулятору модулей и обратно
+ * 
+ * Запись разбирается на 40-байтные пакеты выбранного модуля, ответы
+ * дописываются в поток приёма. Шум канала проверяет ресинхронизацию,
+ * CRC и повторы драйвера auc_uart.c (0 - выключено).
+ * --------------------------------------------------------------------------- */
+
+#define MOCK_AUC_RING_SIZE          1024
+#define MOCK_AUC_NOISE_EVERY        97      /* Лишний байт 'C' перед каждым N-м ответом */
+#define MOCK_AUC_CORRUPT_EVERY      211     /* Искажённый байт данных в каждом N-м ответе */
+#define MOCK_AUC_DROP_EVERY         503     /* Каждый N-й ответ теряется */
 
 /**
- * @brief Software SHA256 для тестирования
- * Используется когда нет аппаратного SHA256
+ * @brief Инициализация петли AUC
  */
-void mock_sha256(const uint8_t *data, size_t len, uint8_t *hash);
+void mock_auc_init(void);
 
 /**
- * @brief Double SHA256 (SHA256(SHA256(data)))
+ * @brief Выбор модуля линиями module select
  */
-void mock_sha256d(const uint8_t *data, size_t len, uint8_t *hash);
+void mock_auc_select(int module_id);
+
+/**
+ * @brief Запись в UART: пакеты уходят выбранному модулю
+ */
+int mock_auc_write(const uint8_t *data, size_t len);
+
+/**
+ * @brief Чтение из UART (семантика драйвера SDK)
+ * @return Прочитано байт, -1 если за timeout_ms ничего не пришло
+ */
+int mock_auc_read(uint8_t *buf, size_t len, uint32_t timeout_ms);
+
+/* ---------------------------------------------------------------------------
+ * Вентиляторы: обороты следуют за ШИМ с инерцией MOCK_FAN_TAU_MS, тахометр
+ * выдаёт FAN_TACH_PULSES_PER_REV импульсов на оборот. Останов задаётся
+ * mock_fan_set_stalled() - для проверки обнаружения в fan.c. Реализация -
+ * в mock_thermal.c рядом с моделью нагрева.
+ * --------------------------------------------------------------------------- */
+
+#define MOCK_FAN_COUNT              2
+#define MOCK_FAN_RPM_MAX            6000    /* Обороты при ШИМ 100% */
+#define MOCK_FAN_PWM_START          5       /* Ниже - вентилятор не крутится (%) */
+#define MOCK_FAN_TAU_MS             1500
+
+typedef struct mock_fan {
+    uint8_t pwm;            /* ШИМ (%) */
+    uint8_t stalled;        /* 1 = ротор заблокирован */
+    float rpm;
+    double revs;            /* Оборотов с начала работы */
+    uint32_t pulses;        /* Импульсов тахометра */
+    uint64_t edge_us;       /* Время последнего импульса */
+    uint64_t at_us;         /* Время последнего шага модели */
+} mock_fan_t;
+
+/**
+ * @brief Инициализация эмулятора вентиляторов (ШИМ 100%)
+ */
+void mock_fan_init(void);
+
+/**
+ * @brief ШИМ вентилятора
+ */
+void mock_fan_set_pwm(int fan_id, int pwm);
+
+/**
+ * @brief Счётчик импульсов тахометра и время последнего импульса
+ */
+void mock_fan_tach(int fan_id, uint32_t *pulses, uint64_t *edge_us);
+
+/**
+ * @brief Заблокировать или освободить ротор
+ */
+void mock_fan_set_stalled(int fan_id, int stalled);
+
+/**
+ * @brief Обдув: средние обороты вентиляторов (% от MOCK_FAN_RPM_MAX)
+ */
+int mock_fan_airflow(void);
+
+#endif /* MOCK_ASIC */
 
 /* ===========================================================================
  * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
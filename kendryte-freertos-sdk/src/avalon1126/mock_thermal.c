@@ -0,0 +1,174 @@
+/**
+ * =============================================================================
+ * @file    mock_thermal.c
+ * @brief   Avalon A1126pro - Модель питания, нагрева и вентиляторов эмулятора
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Формулы модели питания и нагрева модуля без состояния и эмулятор
+ * вентиляторов - без FreeRTOS (время - cgminer_time_us()): их вызывает
+ * mock_asic_thermal_step() и fan.c в прошивке и симуляторы в каталоге
+ * host, так что регуляторы проверяются на одной и той же модели.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mock_hardware.h"
+#include "cgminer.h"
+#include "fan.h"
+
+#if MOCK_ASIC
+
+static const char *TAG = "Mock";
+
+/* ===========================================================================
+ * МОДЕЛЬ ПИТАНИЯ И НАГРЕВА
+ * =========================================================================== */
+
+/**
+ * @brief Мощность модуля от розетки
+ */
+uint16_t mock_thermal_power(int module_id, uint16_t voltage, int16_t temp,
+                            const uint16_t *chip_freq, const uint8_t *chip_off, int busy)
+{
+    uint64_t v = voltage, mw = 0;
+    int32_t leak;
+    
+    /* Утечка: квадратично по напряжению, +2% на градус выше 60°C */
+    leak = (int32_t)(MOCK_POWER_LEAK_MW * v * v / (780 * 780));
+    leak += leak * (temp - 600) / 500;
+    if (leak < 0) leak = 0;
+    
+    /* Пустая очередь заданий - чипы простаивают, остаётся утечка */
+    for (int j = 0; j < MOCK_ASIC_CHIPS_PER_MODULE; j++) {
+        if (busy && !chip_off[j]) {
+            mw += MOCK_POWER_DYN_UW * v * v * chip_freq[j] / 1000000000;
+        }
+        mw += leak;
+    }
+    
+    /* Разброс модулей: -3%, -1%, +1%, +3% */
+    mw = mw * (100 + MOCK_POWER_SPREAD_PCT * (2 * module_id - (MOCK_ASIC_MODULES - 1)) /
+               (MOCK_ASIC_MODULES - 1)) / 100;
+    
+    return (uint16_t)(mw * 100 / MOCK_PSU_EFF / 1000);
+}
+
+/**
+ * @brief Температура выхода модуля через dt_ms
+ */
+float mock_thermal_temp(float temp, int16_t temp_in, uint16_t power,
+                        int airflow, uint32_t dt_ms)
+{
+    int32_t target;
+    
+    /* Нагрев: первый порядок к установившейся температуре */
+    target = temp_in + (int32_t)power * MOCK_THERMAL_R / (airflow + 20);
+    temp += (target - temp) * dt_ms / (MOCK_THERMAL_TAU_MS + dt_ms);
+    if (temp > 1050.0f) temp = 1050.0f;
+    
+    return temp;
+}
+
+/* ===========================================================================
+ * ВЕНТИЛЯТОРЫ
+ * =========================================================================== */
+
+static mock_fan_t mock_fans[MOCK_FAN_COUNT];
+
+/**
+ * @brief Продвижение модели вентилятора до текущего момента
+ */
+static void mock_fan_step(mock_fan_t *f)
+{
+    uint64_t now = cgminer_time_us();
+    float dt_ms = (now - f->at_us) / 1000.0f;
+    float target = 0.0f;
+    double pulses;
+    
+    f->at_us = now;
+    
+    if (!f->stalled && f->pwm >= MOCK_FAN_PWM_START) {
+        target = (float)f->pwm * MOCK_FAN_RPM_MAX / 100.0f;
+    }
+    f->rpm += (target - f->rpm) * dt_ms / (MOCK_FAN_TAU_MS + dt_ms);
+    if (f->stalled) {
+        f->rpm = 0.0f;
+    }
+    
+    f->revs += f->rpm * dt_ms / 60000.0f;
+    pulses = f->revs * FAN_TACH_PULSES_PER_REV;
+    
+    /* Последний импульс - дробная часть назад по текущей скорости */
+    if ((uint32_t)pulses != f->pulses && f->rpm > 0.0f) {
+        f->pulses = (uint32_t)pulses;
+        f->edge_us = now - (uint64_t)((pulses - f->pulses) * 60e6 /
+                                      (f->rpm * FAN_TACH_PULSES_PER_REV));
+    }
+}
+
+void mock_fan_init(void)
+{
+    memset(mock_fans, 0, sizeof(mock_fans));
+    
+    for (int i = 0; i < MOCK_FAN_COUNT; i++) {
+        mock_fans[i].pwm = 100;
+        mock_fans[i].rpm = MOCK_FAN_RPM_MAX;
+        mock_fans[i].at_us = cgminer_time_us();
+    }
+}
+
+void mock_fan_set_pwm(int fan_id, int pwm)
+{
+    if (fan_id < 0 || fan_id >= MOCK_FAN_COUNT) return;
+    
+    mock_fan_step(&mock_fans[fan_id]);
+    mock_fans[fan_id].pwm = (uint8_t)pwm;
+}
+
+void mock_fan_tach(int fan_id, uint32_t *pulses, uint64_t *edge_us)
+{
+    if (fan_id < 0 || fan_id >= MOCK_FAN_COUNT) return;
+    
+    mock_fan_step(&mock_fans[fan_id]);
+    *pulses = mock_fans[fan_id].pulses;
+    *edge_us = mock_fans[fan_id].edge_us;
+}
+
+void mock_fan_set_stalled(int fan_id, int stalled)
+{
+    if (fan_id < 0 || fan_id >= MOCK_FAN_COUNT) return;
+    
+    mock_fan_step(&mock_fans[fan_id]);
+    mock_fans[fan_id].stalled = stalled != 0;
+    
+    log_message(LOG_INFO, "%s: Вентилятор %d %s", TAG, fan_id,
+               stalled ? "заблокирован" : "освобождён");
+}
+
+int mock_fan_airflow(void)
+{
+    float rpm = 0.0f;
+    
+    for (int i = 0; i < MOCK_FAN_COUNT; i++) {
+        mock_fan_step(&mock_fans[i]);
+        rpm += mock_fans[i].rpm;
+    }
+    
+    return (int)(rpm * 100.0f / (MOCK_FAN_RPM_MAX * MOCK_FAN_COUNT));
+}
+
+#endif /* MOCK_ASIC */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА mock_thermal.c
+ * =========================================================================== */
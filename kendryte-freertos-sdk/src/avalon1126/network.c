@@ -22,6 +22,7 @@
 
 #include "network.h"
 #include "cgminer.h"
+#include "cores.h"
 #include "mock_hardware.h"
 #include <osdefs.h>
 
@@ -286,8 +287,9 @@ static int network_init_hardware(void)
         memcpy(s_gateway, gw_cfg.data, 4);
     }
     
-    /* Создаём задачу обработки пакетов */
-    xTaskCreate(network_rx_task, "net_rx", 4096, NULL, 3, &network_task_handle);
+    /* Создаём задачу обработки пакетов на сетевом ядре */
+    cores_task_create(network_rx_task, "net_rx", 4096, NULL,
+                      TASK_PRIO_NET_RX, CORE_NET, &network_task_handle);
     
     s_initialized = 1;
     
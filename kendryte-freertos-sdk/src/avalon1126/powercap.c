@@ -0,0 +1,265 @@
+/**
+ * =============================================================================
+ * @file    powercap.c
+ * @brief   Avalon A1126pro - Жёсткий лимит мощности (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Модель мощности чипов с калибровкой по телеметрии и распределение
+ * лимита между модулями по цене хэшрейта. Доли исполняет throttle.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include "powercap.h"
+#include "cgminer.h"
+#include "efficiency.h"
+#include "throttle.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "PowerCap";
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static powercap_module_t pc[AVALON10_DEFAULT_MODULARS];
+static powercap_stats_t stats;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Установка доли модуля (с учётом смены)
+ */
+static void share_set(int m, float share, uint32_t now)
+{
+    powercap_module_t *pm = &pc[m];
+    
+    if (share >= 100.0f) {
+        share = 100.0f;
+    }
+    if (share < pm->share - 0.05f || share > pm->share + 0.05f) {
+        stats.changed_at = now;
+    }
+    pm->share = share;
+    throttle_set_limit(m, THROTTLE_LIMIT_POWER, share);
+}
+
+/**
+ * @brief Замер и модель модуля
+ * 
+ * Динамическая мощность при 100% доли считается от частот до снижения
+ * (throttle их помнит), текущая - от частот и скважности сейчас.
+ */
+static void module_measure(const avalon10_module_t *module, int m)
+{
+    const throttle_module_t *tm = throttle_get_module(m);
+    powercap_module_t *pm = &pc[m];
+    float activity = tm->engaged ? tm->duty / 100.0f : 1.0f;
+    float leak = 0.0f, full = 0.0f, cur = 0.0f;
+    uint32_t mhz = 0;
+    
+    for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+        int base;
+    
+        if (!module->chips[c].enabled) {
+            continue;
+        }
+        base = tm->engaged ? tm->base_freq[c] : module->chips[c].freq;
+    
+        leak += efficiency_chip_mw(module->voltage, 0, 0.0f);
+        full += efficiency_chip_mw(module->voltage, base, 1.0f);
+        cur += efficiency_chip_mw(module->voltage, module->chips[c].freq, activity);
+        mhz += base;
+    }
+    
+    if (!pm->cal) {
+        pm->cal = 1.0f;
+    }
+    
+    /* Калибровка: модель подтягивается к телеметрии БП */
+    if (module->power && module->power <= EFFICIENCY_POWER_MAX_W && cur > 0.0f) {
+        pm->cal += POWERCAP_CAL_FILTER * (module->power * 1000.0f / cur - pm->cal);
+        if (pm->cal < POWERCAP_CAL_MIN) pm->cal = POWERCAP_CAL_MIN;
+        if (pm->cal > POWERCAP_CAL_MAX) pm->cal = POWERCAP_CAL_MAX;
+        pm->power = module->power;
+    } else {
+        pm->power = cur * pm->cal / 1000.0f;
+    }
+    
+    pm->fixed = leak * pm->cal / 1000.0f;
+    pm->full = (full - leak) * pm->cal / 1000.0f;
+    pm->cost = mhz ? pm->full * 1000.0f / mhz : 0.0f;
+}
+
+/**
+ * @brief Распределение бюджета между модулями в майнинге
+ * 
+ * @param budget    Бюджет динамической мощности сверх минимальной доли (Вт)
+ */
+static void allocate(float budget, uint32_t now)
+{
+    int order[AVALON10_DEFAULT_MODULARS];
+    int n = 0;
+    
+    /* Модули по возрастанию цены, при равной цене - по номеру */
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        int i;
+    
+        if (!pc[m].active) {
+            continue;
+        }
+        for (i = n++; i > 0 && pc[order[i - 1]].cost > pc[m].cost; i--) {
+            order[i] = order[i - 1];
+        }
+        order[i] = m;
+    }
+    
+    for (int i = 0; i < n;) {
+        float tie = pc[order[i]].cost * (100 + POWERCAP_COST_TIE_PCT) / 100.0f;
+        float extra = 0.0f, share;
+        int j = i;
+    
+        /* Группа модулей с равной ценой получает бюджет вместе */
+        while (j < n && pc[order[j]].cost <= tie) {
+            extra += pc[order[j]].full * (100 - THROTTLE_MIN_PCT) / 100.0f;
+            j++;
+        }
+    
+        if (budget >= extra) {
+            share = 100.0f;
+            budget -= extra;
+        } else {
+            share = THROTTLE_MIN_PCT + (100 - THROTTLE_MIN_PCT) * budget / extra;
+            budget = 0.0f;
+        }
+    
+        for (; i < j; i++) {
+            share_set(order[i], share, now);
+        }
+    }
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг распределения
+ */
+void powercap_poll(avalon10_info_t *info)
+{
+    uint32_t now = cgminer_time_s();
+    uint32_t limit;
+    float power = 0.0f, demand = 0.0f, fixed = 0.0f, budget;
+    int limited = 0;
+    
+    if (!info || !info->initialized) {
+        return;
+    }
+    
+    limit = g_config.power_cap > 0 ? (uint32_t)g_config.power_cap : 0;
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        avalon10_module_t *module = &info->modules[m];
+        powercap_module_t *pm = &pc[m];
+    
+        if (module->state == AVALON10_MODULE_STATE_NONE) {
+            if (pm->active) {
+                throttle_set_limit(m, THROTTLE_LIMIT_POWER, 0.0f);
+            }
+            memset(pm, 0, sizeof(*pm));
+            continue;
+        }
+    
+        module_measure(module, m);
+        power += pm->power;
+        demand += module->state == AVALON10_MODULE_STATE_MINING ?
+                  pm->fixed + pm->full : pm->power;
+    
+        /* Не майнит - мощность не регулируется, но расходует бюджет */
+        if (module->state != AVALON10_MODULE_STATE_MINING || !limit) {
+            if (pm->active) {
+                throttle_set_limit(m, THROTTLE_LIMIT_POWER, 0.0f);
+            }
+            pm->active = 0;
+            pm->share = 100.0f;
+            fixed += pm->power;
+            continue;
+        }
+    
+        pm->active = 1;
+        fixed += pm->fixed + pm->full * THROTTLE_MIN_PCT / 100.0f;
+    }
+    
+    if (stats.limit != limit) {
+        log_message(LOG_INFO, "%s: Лимит %lu Вт", TAG, (unsigned long)limit);
+        stats.limit = limit;
+        stats.changed_at = now;
+    }
+    stats.power = (uint32_t)(power + 0.5f);
+    stats.headroom = limit ? (int32_t)limit - (int32_t)stats.power : 0;
+    stats.demand = demand;
+    
+    if (!limit) {
+        stats.limited = 0;
+        stats.short_budget = 0;
+        return;
+    }
+    
+    budget = limit * (100 - POWERCAP_MARGIN_PCT) / 100.0f - fixed;
+    if (budget < 0.0f) {
+        if (!stats.short_budget) {
+            log_message(LOG_WARNING, "%s: Лимит %lu Вт ниже мощности при доле %d%% (%.0f Вт)",
+                       TAG, (unsigned long)limit, THROTTLE_MIN_PCT, (double)fixed);
+        }
+        stats.short_budget = 1;
+        budget = 0.0f;
+    } else {
+        stats.short_budget = 0;
+    }
+    
+    allocate(budget, now);
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        limited += pc[m].active && pc[m].share < 100.0f;
+    }
+    stats.limited = (uint8_t)limited;
+}
+
+/**
+ * @brief Мощность и доля модуля
+ */
+const powercap_module_t *powercap_get_module(int module_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return NULL;
+    }
+    
+    return &pc[module_id];
+}
+
+/**
+ * @brief Состояние лимита
+ */
+const powercap_stats_t *powercap_get_stats(void)
+{
+    return &stats;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА powercap.c
+ * =========================================================================== */
@@ -0,0 +1,131 @@
+/**
+ * =============================================================================
+ * @file    powercap.h
+ * @brief   Avalon A1126pro - Жёсткий лимит мощности (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Лимит мощности всего майнера (g_config.power_cap, Вт) для стоек на
+ * линиях с жёстким ограничением. Раз в секунду мощность делится между
+ * модулями так, чтобы хэшрейт под лимитом был максимальным; смена лимита
+ * через API начинает действовать со следующего шага.
+ * 
+ * МОДЕЛЬ ЧИПА:
+ *   P = k · V² · f · a + утечка(V)
+ * - модель чипа общая с efficiency (efficiency_chip_mw());
+ * - a - активность: доля времени, когда модуль получает задания
+ *   (скважность throttle), 0 у выключенного чипа.
+ * Сумма по чипам делится на КПД БП и умножается на калибровку модуля -
+ * сглаженное отношение телеметрии (AVALON10_STATUS_POWER) к модели.
+ * Без телеметрии калибровка 1.
+ * 
+ * РАСПРЕДЕЛЕНИЕ:
+ * Хэшрейт чипа пропорционален частоте, поэтому цена хэшрейта модуля -
+ * динамическая мощность на МГц (k · V² · калибровка). Каждому модулю
+ * сначала резервируется THROTTLE_MIN_PCT доли, затем остаток бюджета
+ * отдаётся модулям от дешёвых к дорогим до 100% доли. Модули с ценой в
+ * пределах POWERCAP_COST_TIE_PCT получают бюджет вместе и поровну по доле.
+ * Доля передаётся в throttle_set_limit(): исполнение (частоты чипов,
+ * ниже минимальной - скважность) общее со снижением по температуре.
+ * 
+ * Лимит не меняет напряжение: режим efficiency CAP подбирает напряжение
+ * под тот же g_config.power_cap медленно (минуты), этот модуль держит
+ * его за секунды.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __POWERCAP_H__
+#define __POWERCAP_H__
+
+#include <stdint.h>
+
+#include "avalon10.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Запас под лимитом на ошибку модели и шаг частоты (%)
+ */
+#define POWERCAP_MARGIN_PCT         2
+
+/**
+ * @brief Сглаживание калибровки по телеметрии (доля нового замера)
+ */
+#define POWERCAP_CAL_FILTER         0.1f
+
+/**
+ * @brief Пределы калибровки модели
+ */
+#define POWERCAP_CAL_MIN            0.5f
+#define POWERCAP_CAL_MAX            2.0f
+
+/**
+ * @brief Разница цены, при которой модули считаются равными (%)
+ */
+#define POWERCAP_COST_TIE_PCT       5
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct powercap_module_t
+ * @brief Мощность и доля модуля
+ */
+typedef struct powercap_module {
+    uint8_t active;                 /* 1 = модуль в распределении */
+    float cal;                      /* Калибровка модели (телеметрия / модель) */
+    float power;                    /* Мощность сейчас (Вт) */
+    float fixed;                    /* Утечка - не зависит от доли (Вт) */
+    float full;                     /* Динамическая мощность при 100% доли (Вт) */
+    float cost;                     /* Цена хэшрейта (мВт на МГц) */
+    float share;                    /* Доля (%) */
+} powercap_module_t;
+
+/**
+ * @struct powercap_stats_t
+ * @brief Состояние лимита (для API)
+ */
+typedef struct powercap_stats {
+    uint32_t limit;                 /* Лимит (Вт, 0 = нет) */
+    uint32_t power;                 /* Мощность всех модулей (Вт) */
+    int32_t headroom;               /* Запас до лимита (Вт, < 0 - превышение) */
+    float demand;                   /* Мощность при 100% доли всех модулей (Вт) */
+    uint8_t limited;                /* Модулей с долей ниже 100% */
+    uint8_t short_budget;           /* 1 = лимит ниже мощности при минимальной доле */
+    uint32_t changed_at;            /* uptime последней смены долей (с) */
+} powercap_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг распределения (раз в секунду, задача monitor, перед
+ *        throttle_poll)
+ * 
+ * @param info      Указатель на структуру информации
+ */
+void powercap_poll(avalon10_info_t *info);
+
+/**
+ * @brief Мощность и доля модуля
+ * @return          NULL при неверном номере
+ */
+const powercap_module_t *powercap_get_module(int module_id);
+
+/**
+ * @brief Состояние лимита
+ */
+const powercap_stats_t *powercap_get_stats(void);
+
+#endif /* __POWERCAP_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА powercap.h
+ * =========================================================================== */
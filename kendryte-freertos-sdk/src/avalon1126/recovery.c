@@ -0,0 +1,315 @@
+/**
+ * =============================================================================
+ * @file    recovery.c
+ * @brief   Avalon A1126pro - Сброс зависших модулей (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Признаки зависания по счётчикам опроса, сброс одного модуля, возврат
+ * подобранных настроек и паузы между неудачными сбросами.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include "recovery.h"
+#include "health.h"
+#include "cgminer.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Recovery";
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static recovery_module_t rec[AVALON10_DEFAULT_MODULARS];
+static uint8_t requested[AVALON10_DEFAULT_MODULARS];     /* RECOVERY_REASON_*, 0 = нет */
+static recovery_stats_t stats;
+static uint64_t poll_at_us;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Окна признаков заново (после сброса и вне майнинга)
+ */
+static void windows_reset(const avalon10_module_t *module, recovery_module_t *rm)
+{
+    rm->drained0 = module->nonce_drained;
+    rm->expect = 0.0f;
+    rm->nonce_s = 0;
+    rm->bad_at = 0;
+}
+
+/**
+ * @brief Признак зависания работающего модуля
+ * 
+ * @param dt        Интервал с прошлого шага (с)
+ * @return          RECOVERY_REASON_*, RECOVERY_REASON_NONE - модуль в порядке
+ */
+static int stall_check(const avalon10_module_t *module, recovery_module_t *rm,
+                       float dt, uint32_t now)
+{
+    uint32_t silent_ms = (uint32_t)(xTaskGetTickCount() - module->last_poll) * portTICK_PERIOD_MS;
+    
+    if (module->poll_errors >= RECOVERY_POLL_ERRORS && silent_ms >= RECOVERY_SILENT_MS) {
+        return RECOVERY_REASON_POLL;
+    }
+    
+    /* Нет nonce: ожидание копится, только пока у чипов есть задания */
+    if (module->nonce_drained != rm->drained0) {
+        rm->drained0 = module->nonce_drained;
+        rm->expect = 0.0f;
+        rm->nonce_s = 0;
+    } else if (module->work_queued > 0) {
+        rm->expect += avalon10_expected_diff1(module) * dt;
+        rm->nonce_s++;
+        if (rm->expect >= RECOVERY_EXPECT_NONCES && rm->nonce_s >= RECOVERY_NONCE_S) {
+            return RECOVERY_REASON_NONCE;
+        }
+    }
+    
+    /* Шторм CRC: доля опросов без верного STATUS за окно */
+    if (!rm->bad_at || module->bad_replies < rm->bad0 || module->status_seq < rm->seq0) {
+        rm->bad_at = now ? now : 1;
+        rm->bad0 = module->bad_replies;
+        rm->seq0 = module->status_seq;
+    } else if (now - rm->bad_at >= RECOVERY_BAD_WINDOW_S) {
+        uint32_t bad = module->bad_replies - rm->bad0;
+        uint32_t good = module->status_seq - rm->seq0;
+    
+        rm->bad_at = now;
+        rm->bad0 = module->bad_replies;
+        rm->seq0 = module->status_seq;
+        if (bad >= RECOVERY_BAD_MIN && bad * 100 >= (bad + good) * RECOVERY_BAD_PCT) {
+            return RECOVERY_REASON_CRC;
+        }
+    }
+    
+    return RECOVERY_REASON_NONE;
+}
+
+/**
+ * @brief Сброс модуля
+ */
+static void module_reset(avalon10_info_t *info, int m, uint32_t now_ms)
+{
+    recovery_module_t *rm = &rec[m];
+    
+    if (avalon10_reset_module(info, m) != 0) {
+        return;
+    }
+    
+    if (rm->attempts < 0xFF) {
+        rm->attempts++;
+    }
+    rm->state = RECOVERY_RESET;
+    rm->at_ms = now_ms;
+    rm->resets++;
+    stats.resets++;
+    stats.changed_at = now_ms / 1000;
+}
+
+/**
+ * @brief Пауза перед следующим сбросом, модуль в ERROR
+ */
+static void module_backoff(avalon10_info_t *info, int m, uint32_t now_ms)
+{
+    recovery_module_t *rm = &rec[m];
+    
+    info->modules[m].state = AVALON10_MODULE_STATE_ERROR;
+    rm->state = RECOVERY_BACKOFF;
+    rm->at_ms = now_ms;
+    
+    log_message(LOG_WARNING, "%s: Модуль %d: сброс %d не помог, следующий через %lu с",
+               TAG, m, rm->attempts,
+               (unsigned long)RECOVERY_BACKOFF_S << MIN(rm->attempts - 1, RECOVERY_BACKOFF_MAX_SHIFT));
+}
+
+/**
+ * @brief Шаг одного модуля
+ */
+static void module_step(avalon10_info_t *info, int m, float dt, uint32_t now_ms)
+{
+    avalon10_module_t *module = &info->modules[m];
+    recovery_module_t *rm = &rec[m];
+    uint32_t now = now_ms / 1000;
+    uint32_t wait;
+    int reason;
+    
+    switch (rm->state) {
+        case RECOVERY_WATCH:
+            if (module->state != AVALON10_MODULE_STATE_MINING) {
+                windows_reset(module, rm);
+                requested[m] = 0;
+                return;
+            }
+    
+            /* Долго без зависания - прошлые сбросы удались */
+            if (rm->attempts && now - rm->restored_at >= RECOVERY_STABLE_S) {
+                rm->attempts = 0;
+            }
+    
+            reason = requested[m] ? requested[m] : stall_check(module, rm, dt, now);
+            requested[m] = 0;
+            if (reason == RECOVERY_REASON_NONE) {
+                return;
+            }
+    
+            rm->reason = (uint8_t)reason;
+            log_message(LOG_WARNING, "%s: Модуль %d завис (%s): ошибок опроса %d, CRC %lu",
+                       TAG, m, recovery_reason_str(reason), module->poll_errors,
+                       (unsigned long)module->bad_replies);
+    
+            /* Завис вскоре после прошлого сброса - сначала пауза */
+            if (rm->attempts && reason != RECOVERY_REASON_MANUAL) {
+                module_backoff(info, m, now_ms);
+            } else {
+                module_reset(info, m, now_ms);
+            }
+            return;
+    
+        case RECOVERY_RESET:
+            if (module->state != AVALON10_MODULE_STATE_INIT) {
+                rm->state = RECOVERY_WATCH;
+                return;
+            }
+            if (now_ms - rm->at_ms < RECOVERY_BOOT_MS) {
+                return;
+            }
+    
+            if (avalon10_restore_module(info, m) == 0) {
+                /* Модуль снова отвечает - выключенные health чипы на пробу */
+                if (rm->reason == RECOVERY_REASON_CHIPS) {
+                    health_release(info, m);
+                }
+                rm->state = RECOVERY_WATCH;
+                rm->restored_at = now;
+                windows_reset(module, rm);
+                stats.restores++;
+                stats.changed_at = now;
+                return;
+            }
+    
+            if (now_ms - rm->at_ms >= AVALON10_RESET_TIMEOUT_MS) {
+                stats.failures++;
+                module_backoff(info, m, now_ms);
+            }
+            return;
+    
+        case RECOVERY_BACKOFF:
+            if (module->state != AVALON10_MODULE_STATE_ERROR) {
+                rm->state = RECOVERY_WATCH;
+                return;
+            }
+    
+            wait = (uint32_t)RECOVERY_BACKOFF_S << MIN(rm->attempts - 1, RECOVERY_BACKOFF_MAX_SHIFT);
+            if (requested[m] || now_ms - rm->at_ms >= wait * 1000) {
+                requested[m] = 0;
+                module_reset(info, m, now_ms);
+            }
+            return;
+    
+        default:
+            rm->state = RECOVERY_WATCH;
+            return;
+    }
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг проверки
+ */
+void recovery_poll(avalon10_info_t *info)
+{
+    uint64_t now_us = cgminer_time_us();
+    uint32_t now_ms = (uint32_t)(now_us / 1000);
+    int recovering = 0;
+    float dt;
+    
+    if (!info || !info->initialized || !info->mining_enabled) {
+        poll_at_us = 0;
+        return;
+    }
+    
+    dt = cgminer_poll_dt(&poll_at_us, now_us, 0.0f);
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        if (info->modules[m].state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+        module_step(info, m, dt, now_ms);
+        recovering += rec[m].state != RECOVERY_WATCH;
+    }
+    
+    stats.recovering = (uint8_t)recovering;
+}
+
+/**
+ * @brief Сброс модуля на следующем шаге
+ */
+int recovery_request(int module_id, int reason)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        rec[module_id].state == RECOVERY_RESET) {
+        return -1;
+    }
+    
+    requested[module_id] = (uint8_t)reason;
+    log_message(LOG_INFO, "%s: Сброс модуля %d по запросу (%s)",
+               TAG, module_id, recovery_reason_str(reason));
+    
+    return 0;
+}
+
+/**
+ * @brief Название причины сброса
+ */
+const char *recovery_reason_str(int reason)
+{
+    switch (reason) {
+        case RECOVERY_REASON_POLL:   return "Poll";
+        case RECOVERY_REASON_NONCE:  return "Nonce";
+        case RECOVERY_REASON_CRC:    return "CRC";
+        case RECOVERY_REASON_MANUAL: return "Manual";
+        case RECOVERY_REASON_CHIPS:  return "Chips";
+        default:                     return "None";
+    }
+}
+
+/**
+ * @brief Состояние модуля
+ */
+const recovery_module_t *recovery_get_module(int module_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return NULL;
+    }
+    
+    return &rec[module_id];
+}
+
+/**
+ * @brief Состояние
+ */
+const recovery_stats_t *recovery_get_stats(void)
+{
+    return &stats;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА recovery.c
+ * =========================================================================== */
@@ -0,0 +1,188 @@
+/**
+ * =============================================================================
+ * @file    recovery.h
+ * @brief   Avalon A1126pro - Сброс зависших модулей (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Зависший модуль перестаёт хэшировать молча: опрос только считает
+ * ошибки (module->poll_errors), а avalon10_reset() вызывается вручную.
+ * Этот модуль раз в секунду ищет зависание и сбрасывает только
+ * зависший модуль - остальные продолжают майнинг.
+ * 
+ * ПРИЗНАКИ ЗАВИСАНИЯ (модуль в AVALON10_MODULE_STATE_MINING):
+ * - Опрос: RECOVERY_POLL_ERRORS ошибок подряд и ни одного ответа за
+ *   RECOVERY_SILENT_MS.
+ * - Нет nonce: пока в очереди модуля есть задания, ожидаемое по частотам
+ *   число nonce (avalon10_expected_diff1) набралось до
+ *   RECOVERY_EXPECT_NONCES, а FIFO не отдал ни одного nonce, хотя бы
+ *   RECOVERY_NONCE_S секунд. Считаются и nonce с HW ошибкой: сбойные
+ *   чипы выключает health, здесь - только полная тишина.
+ * - Шторм CRC: за окно RECOVERY_BAD_WINDOW_S от RECOVERY_BAD_MIN опросов
+ *   без верного STATUS, и это RECOVERY_BAD_PCT % опросов и больше.
+ * 
+ * ВОССТАНОВЛЕНИЕ:
+ * 1. avalon10_reset_module() - сброс без ожидания, модуль не опрашивается.
+ * 2. Через RECOVERY_BOOT_MS и до AVALON10_RESET_TIMEOUT_MS - проба DETECT
+ *    раз в секунду; ответивший модуль получает подобранные напряжение,
+ *    частоты и выключенные чипы и возвращается в майнинг
+ *    (avalon10_restore_module).
+ * 3. Модуль не ответил или завис снова раньше RECOVERY_STABLE_S -
+ *    AVALON10_MODULE_STATE_ERROR и пауза RECOVERY_BACKOFF_S, удваиваемая
+ *    после каждой неудачи (до 2^RECOVERY_BACKOFF_MAX_SHIFT раз), затем
+ *    новый сброс. Попытки не кончаются: модуль мог зависнуть от помехи
+ *    или просадки питания.
+ * 
+ * health не переводит модуль в ERROR сам: при HEALTH_MODULE_FAIL_PCT
+ * выключенных чипов он просит сброс (recovery_request с
+ * RECOVERY_REASON_CHIPS). Модуль идёт тем же путём сброса и пауз, а после
+ * возврата в майнинг выключенные чипы снова проходят пробу
+ * (health_release).
+ * 
+ * =============================================================================
+ */
+
+#ifndef __RECOVERY_H__
+#define __RECOVERY_H__
+
+#include <stdint.h>
+
+#include "avalon10.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Ошибок опроса подряд и время без ответа (мс)
+ */
+#define RECOVERY_POLL_ERRORS        100
+#define RECOVERY_SILENT_MS          3000
+
+/**
+ * @brief Ожидаемых nonce без единого принятого и минимальное окно (секунды)
+ * Вероятность не получить ни одного nonce у исправного модуля - e^-64
+ */
+#define RECOVERY_EXPECT_NONCES      64
+#define RECOVERY_NONCE_S            10
+
+/**
+ * @brief Шторм CRC: окно (секунды), минимум и доля плохих ответов (%)
+ */
+#define RECOVERY_BAD_WINDOW_S       5
+#define RECOVERY_BAD_MIN            50
+#define RECOVERY_BAD_PCT            50
+
+/**
+ * @brief Загрузка модуля после сброса до первой пробы DETECT (мс)
+ */
+#define RECOVERY_BOOT_MS            1000
+
+/**
+ * @brief Пауза после неудачного сброса (секунды) и предел удвоений
+ * 10 с, 20 с, ... 10 мин 40 с
+ */
+#define RECOVERY_BACKOFF_S          10
+#define RECOVERY_BACKOFF_MAX_SHIFT  6
+
+/**
+ * @brief Майнинг без зависания после сброса - сброс удался (секунды)
+ */
+#define RECOVERY_STABLE_S           300
+
+/**
+ * @brief Состояния модуля
+ */
+#define RECOVERY_WATCH              0   /* Майнинг, проверка признаков */
+#define RECOVERY_RESET              1   /* Сброшен, ждёт ответа на DETECT */
+#define RECOVERY_BACKOFF            2   /* Пауза перед новым сбросом */
+
+/**
+ * @brief Причины сброса
+ */
+#define RECOVERY_REASON_NONE        0
+#define RECOVERY_REASON_POLL        1   /* Модуль не отвечает на опрос */
+#define RECOVERY_REASON_NONCE       2   /* Нет nonce */
+#define RECOVERY_REASON_CRC         3   /* Шторм CRC */
+#define RECOVERY_REASON_MANUAL      4   /* Команда API */
+#define RECOVERY_REASON_CHIPS       5   /* Много выключенных чипов (health) */
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct recovery_module_t
+ * @brief Состояние модуля
+ */
+typedef struct recovery_module {
+    uint8_t state;                  /* RECOVERY_WATCH / RESET / BACKOFF */
+    uint8_t reason;                 /* RECOVERY_REASON_* последнего сброса */
+    uint8_t attempts;               /* Сбросов без RECOVERY_STABLE_S майнинга */
+    uint32_t at_ms;                 /* Вход в текущее состояние (мс) */
+    uint32_t restored_at;           /* Возврат в майнинг (с, 0 = не было) */
+    uint32_t drained0;              /* nonce_drained в начале окна без nonce */
+    float expect;                   /* Ожидаемых nonce в окне */
+    uint32_t nonce_s;               /* Секунд в окне */
+    uint32_t bad_at;                /* Начало окна CRC (с, 0 = окна нет) */
+    uint32_t bad0;                  /* bad_replies в начале окна */
+    uint32_t seq0;                  /* status_seq в начале окна */
+    uint32_t resets;                /* Сбросов с начала работы */
+} recovery_module_t;
+
+/**
+ * @struct recovery_stats_t
+ * @brief Состояние (для API)
+ */
+typedef struct recovery_stats {
+    uint8_t recovering;             /* Модулей вне майнинга по сбросу */
+    uint32_t resets;                /* Сбросов */
+    uint32_t restores;              /* Возвратов в майнинг */
+    uint32_t failures;              /* Модуль не ответил после сброса */
+    uint32_t changed_at;            /* uptime последнего сброса/возврата (с) */
+} recovery_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг проверки (раз в секунду, задача monitor, после
+ *        avalon10_check_overheat)
+ * 
+ * @param info      Указатель на структуру информации
+ */
+void recovery_poll(avalon10_info_t *info);
+
+/**
+ * @brief Сброс модуля на следующем шаге
+ * 
+ * @param module_id ID модуля
+ * @param reason    RECOVERY_REASON_MANUAL или RECOVERY_REASON_CHIPS
+ * @return          0 при успехе, -1 - неверный номер или модуль уже сброшен
+ */
+int recovery_request(int module_id, int reason);
+
+/**
+ * @brief Название причины сброса
+ */
+const char *recovery_reason_str(int reason);
+
+/**
+ * @brief Состояние модуля
+ * @return          NULL при неверном номере
+ */
+const recovery_module_t *recovery_get_module(int module_id);
+
+/**
+ * @brief Состояние
+ */
+const recovery_stats_t *recovery_get_stats(void);
+
+#endif /* __RECOVERY_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА recovery.h
+ * =========================================================================== */
@@ -0,0 +1,193 @@
+/**
+ * =============================================================================
+ * @file    sha256_soft.c
+ * @brief   Avalon A1126pro - Программный SHA256 (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Скалярный SHA256 (перенесён из mock_hardware.c: он считает и в сборке
+ * для железа, а эталону для хоста не нужен FreeRTOS).
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include "sha256_soft.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+const uint32_t sha256_soft_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+const uint32_t sha256_soft_iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/* ===========================================================================
+ * СЖАТИЕ БЛОКА
+ * =========================================================================== */
+
+#define ROTR(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define EP0(x)  (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define EP1(x)  (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define SIG0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define SIG1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+/**
+ * @brief Сжатие одного 64-байтного блока
+ */
+void sha256_soft_transform(uint32_t *state, const uint8_t *data)
+{
+    uint32_t a, b, c, d, e, f, g, h, t1, t2, m[64];
+    int i;
+    
+    /* Подготовка сообщения */
+    for (i = 0; i < 16; i++) {
+        m[i] = ((uint32_t)data[i * 4] << 24) |
+               ((uint32_t)data[i * 4 + 1] << 16) |
+               ((uint32_t)data[i * 4 + 2] << 8) |
+               ((uint32_t)data[i * 4 + 3]);
+    }
+    
+    for (i = 16; i < 64; i++) {
+        m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+    }
+    
+    a = state[0]; b = state[1]; c = state[2]; d = state[3];
+    e = state[4]; f = state[5]; g = state[6]; h = state[7];
+    
+    for (i = 0; i < 64; i++) {
+        t1 = h + EP1(e) + CH(e, f, g) + sha256_soft_k[i] + m[i];
+        t2 = EP0(a) + MAJ(a, b, c);
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief SHA256
+ */
+void sha256_soft(const uint8_t *data, size_t len, uint8_t *hash)
+{
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t i;
+    size_t remaining = len;
+    const uint8_t *ptr = data;
+    
+    memcpy(state, sha256_soft_iv, sizeof(state));
+    
+    /* Обработка полных блоков */
+    while (remaining >= 64) {
+        sha256_soft_transform(state, ptr);
+        ptr += 64;
+        remaining -= 64;
+    }
+    
+    /* Padding */
+    memset(block, 0, 64);
+    memcpy(block, ptr, remaining);
+    block[remaining] = 0x80;
+    
+    if (remaining >= 56) {
+        sha256_soft_transform(state, block);
+        memset(block, 0, 64);
+    }
+    
+    /* Длина в битах (big-endian) */
+    uint64_t bits = len * 8;
+    block[63] = bits & 0xff;
+    block[62] = (bits >> 8) & 0xff;
+    block[61] = (bits >> 16) & 0xff;
+    block[60] = (bits >> 24) & 0xff;
+    block[59] = (bits >> 32) & 0xff;
+    block[58] = (bits >> 40) & 0xff;
+    block[57] = (bits >> 48) & 0xff;
+    block[56] = (bits >> 56) & 0xff;
+    
+    sha256_soft_transform(state, block);
+    
+    /* Результат (big-endian) */
+    for (i = 0; i < 8; i++) {
+        hash[i * 4] = (state[i] >> 24) & 0xff;
+        hash[i * 4 + 1] = (state[i] >> 16) & 0xff;
+        hash[i * 4 + 2] = (state[i] >> 8) & 0xff;
+        hash[i * 4 + 3] = state[i] & 0xff;
+    }
+}
+
+/**
+ * @brief Double SHA256
+ */
+void sha256d_soft(const uint8_t *data, size_t len, uint8_t *hash)
+{
+    uint8_t temp[32];
+    sha256_soft(data, len, temp);
+    sha256_soft(temp, 32, hash);
+}
+
+/**
+ * @brief SHA256d заголовка по состоянию первых 64 байт
+ */
+void sha256d_soft_header(const uint32_t midstate[8], const uint8_t *tail, uint8_t *hash)
+{
+    uint32_t state[8];
+    uint8_t block[64];
+    
+    /* 16 байт хвоста, 0x80, длина 640 бит */
+    memset(block, 0, 64);
+    memcpy(block, tail, 16);
+    block[16] = 0x80;
+    block[62] = 0x02;
+    block[63] = 0x80;
+    
+    memcpy(state, midstate, sizeof(state));
+    sha256_soft_transform(state, block);
+    
+    for (int i = 0; i < 8; i++) {
+        block[i * 4] = (state[i] >> 24) & 0xff;
+        block[i * 4 + 1] = (state[i] >> 16) & 0xff;
+        block[i * 4 + 2] = (state[i] >> 8) & 0xff;
+        block[i * 4 + 3] = state[i] & 0xff;
+    }
+    sha256_soft(block, 32, hash);
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА sha256_soft.c
+ * =========================================================================== */
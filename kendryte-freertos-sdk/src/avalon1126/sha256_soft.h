@@ -0,0 +1,67 @@
+/**
+ * =============================================================================
+ * @file    sha256_soft.h
+ * @brief   Avalon A1126pro - Программный SHA256 (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Скалярный SHA256 по FIPS 180-4: один блок за вызов sha256_soft_transform().
+ * Бэкенд HASHER_SOFT и эталон для проверки остальных бэкендов (hasher.c,
+ * host/sha256_bench.c). Без FreeRTOS - собирается и на хосте.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __SHA256_SOFT_H__
+#define __SHA256_SOFT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Константы раундов и начальное состояние SHA256
+ */
+extern const uint32_t sha256_soft_k[64];
+extern const uint32_t sha256_soft_iv[8];
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Сжатие одного 64-байтного блока
+ * 
+ * @param state     Состояние (8 слов), обновляется
+ * @param data      Блок (big-endian слова)
+ */
+void sha256_soft_transform(uint32_t *state, const uint8_t *data);
+
+/**
+ * @brief SHA256
+ */
+void sha256_soft(const uint8_t *data, size_t len, uint8_t *hash);
+
+/**
+ * @brief Double SHA256 (SHA256(SHA256(data)))
+ */
+void sha256d_soft(const uint8_t *data, size_t len, uint8_t *hash);
+
+/**
+ * @brief SHA256d заголовка по состоянию первых 64 байт
+ * 
+ * @param midstate  Состояние после первых 64 байт (sha256_soft_transform)
+ * @param tail      Байты 64-79 заголовка
+ */
+void sha256d_soft_header(const uint32_t midstate[8], const uint8_t *tail, uint8_t *hash);
+
+#endif /* __SHA256_SOFT_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА sha256_soft.h
+ * =========================================================================== */
@@ -0,0 +1,231 @@
+/**
+ * =============================================================================
+ * @file    sha256_swar.c
+ * @brief   Avalon A1126pro - SHA256 двух сообщений в 64-битных регистрах (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Раунды SHA256 над парами 32-битных слов: a - биты 63..32, b - биты
+ * 31..0. Операции над словом-парой - макросы *2 ниже.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include "sha256_swar.h"
+#include "sha256_soft.h"
+
+/* ===========================================================================
+ * ОПЕРАЦИИ НАД ПАРОЙ СЛОВ
+ * =========================================================================== */
+
+/* Старший бит каждой половины */
+#define LANE_TOP            0x8000000080000000ULL
+
+/* Одно 32-битное значение в обеих половинах */
+#define LANE_DUP(x)         ((uint64_t)(uint32_t)(x) * 0x0000000100000001ULL)
+
+/* Биты, остающиеся в своей половине после сдвига вправо на n */
+#define LANE_SHR_MASK(n)    LANE_DUP(0xFFFFFFFFu >> (n))
+
+/**
+ * Сложение без переноса между половинами: младшие 31 бит складываются
+ * (их сумма не выходит за бит 31), старшие биты - XOR с переносом в них
+ */
+#define ADD2(x, y)          ((((x) & ~LANE_TOP) + ((y) & ~LANE_TOP)) ^ (((x) ^ (y)) & LANE_TOP))
+
+#define SHR2(x, n)          (((x) >> (n)) & LANE_SHR_MASK(n))
+#define ROTR2(x, n)         (SHR2(x, n) | (((x) << (32 - (n))) & ~LANE_SHR_MASK(n)))
+
+#define CH2(x, y, z)        (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ2(x, y, z)       (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define EP0_2(x)            (ROTR2(x, 2) ^ ROTR2(x, 13) ^ ROTR2(x, 22))
+#define EP1_2(x)            (ROTR2(x, 6) ^ ROTR2(x, 11) ^ ROTR2(x, 25))
+#define SIG0_2(x)           (ROTR2(x, 7) ^ ROTR2(x, 18) ^ SHR2(x, 3))
+#define SIG1_2(x)           (ROTR2(x, 17) ^ ROTR2(x, 19) ^ SHR2(x, 10))
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Чтение big-endian слова
+ */
+static uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/**
+ * @brief Пары слов блоков a и b
+ */
+static void load2(uint64_t w[16], const uint8_t *block_a, const uint8_t *block_b)
+{
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint64_t)be32(block_a + i * 4) << 32) | be32(block_b + i * 4);
+    }
+}
+
+/**
+ * @brief Начальное состояние в обеих половинах
+ */
+static void init2(uint64_t state[8], const uint32_t iv[8])
+{
+    for (int i = 0; i < 8; i++) {
+        state[i] = LANE_DUP(iv[i]);
+    }
+}
+
+/**
+ * @brief Сжатие пары блоков, заданных словами (w затирается)
+ */
+static void transform2_w(uint64_t state[8], uint64_t w[16])
+{
+    uint64_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint64_t e = state[4], f = state[5], g = state[6], h = state[7];
+    uint64_t t1, t2, wi;
+    
+    for (int i = 0; i < 64; i++) {
+        /* Расписание сообщения - скользящее окно из 16 слов */
+        if (i < 16) {
+            wi = w[i];
+        } else {
+            wi = ADD2(ADD2(SIG1_2(w[(i - 2) & 15]), w[(i - 7) & 15]),
+                      ADD2(SIG0_2(w[(i - 15) & 15]), w[i & 15]));
+            w[i & 15] = wi;
+        }
+    
+        t1 = ADD2(ADD2(h, EP1_2(e)), ADD2(CH2(e, f, g), ADD2(LANE_DUP(sha256_soft_k[i]), wi)));
+        t2 = ADD2(EP0_2(a), MAJ2(a, b, c));
+        h = g; g = f; f = e; e = ADD2(d, t1);
+        d = c; c = b; b = a; a = ADD2(t1, t2);
+    }
+    
+    state[0] = ADD2(state[0], a); state[1] = ADD2(state[1], b);
+    state[2] = ADD2(state[2], c); state[3] = ADD2(state[3], d);
+    state[4] = ADD2(state[4], e); state[5] = ADD2(state[5], f);
+    state[6] = ADD2(state[6], g); state[7] = ADD2(state[7], h);
+}
+
+/**
+ * @brief Второй SHA256 пары дайджестов и запись результатов
+ * 
+ * Блок - 32 байта дайджеста, 0x80 и длина 256 бит: слова берутся прямо
+ * из состояния первого хэша.
+ */
+static void second2(const uint64_t digest[8], uint8_t *hash_a, uint8_t *hash_b)
+{
+    uint64_t state[8], w[16];
+    
+    for (int i = 0; i < 8; i++) {
+        w[i] = digest[i];
+    }
+    w[8] = LANE_DUP(0x80000000u);
+    for (int i = 9; i < 15; i++) {
+        w[i] = 0;
+    }
+    w[15] = LANE_DUP(256);
+    
+    init2(state, sha256_soft_iv);
+    transform2_w(state, w);
+    
+    for (int i = 0; i < 8; i++) {
+        uint32_t wa = (uint32_t)(state[i] >> 32);
+        uint32_t wb = (uint32_t)state[i];
+    
+        hash_a[i * 4] = wa >> 24; hash_a[i * 4 + 1] = wa >> 16;
+        hash_a[i * 4 + 2] = wa >> 8; hash_a[i * 4 + 3] = wa;
+        hash_b[i * 4] = wb >> 24; hash_b[i * 4 + 1] = wb >> 16;
+        hash_b[i * 4 + 2] = wb >> 8; hash_b[i * 4 + 3] = wb;
+    }
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Сжатие двух блоков
+ */
+void sha256_swar_transform2(uint64_t state[8], const uint8_t *block_a, const uint8_t *block_b)
+{
+    uint64_t w[16];
+    
+    load2(w, block_a, block_b);
+    transform2_w(state, w);
+}
+
+/**
+ * @brief SHA256d двух сообщений одной длины
+ */
+void sha256d_swar2(const uint8_t *data_a, const uint8_t *data_b, size_t len,
+                   uint8_t *hash_a, uint8_t *hash_b)
+{
+    uint64_t state[8];
+    uint8_t block_a[64], block_b[64];
+    uint64_t bits = (uint64_t)len * 8;
+    size_t off = 0, rem;
+    
+    init2(state, sha256_soft_iv);
+    
+    for (; len - off >= 64; off += 64) {
+        sha256_swar_transform2(state, data_a + off, data_b + off);
+    }
+    
+    /* Дополнение: одинаковая длина - одинаковое число блоков */
+    rem = len - off;
+    memset(block_a, 0, 64);
+    memset(block_b, 0, 64);
+    memcpy(block_a, data_a + off, rem);
+    memcpy(block_b, data_b + off, rem);
+    block_a[rem] = block_b[rem] = 0x80;
+    
+    if (rem >= 56) {
+        sha256_swar_transform2(state, block_a, block_b);
+        memset(block_a, 0, 64);
+        memset(block_b, 0, 64);
+    }
+    
+    for (int i = 0; i < 8; i++) {
+        block_a[63 - i] = block_b[63 - i] = (uint8_t)(bits >> (i * 8));
+    }
+    sha256_swar_transform2(state, block_a, block_b);
+    
+    second2(state, hash_a, hash_b);
+}
+
+/**
+ * @brief SHA256d двух заголовков с общими первыми 64 байтами
+ */
+void sha256d_swar2_header(const uint32_t midstate[8], const uint8_t *tail_a,
+                          const uint8_t *tail_b, uint8_t *hash_a, uint8_t *hash_b)
+{
+    uint64_t state[8], w[16];
+    
+    /* 16 байт хвоста, 0x80, длина 640 бит */
+    for (int i = 0; i < 4; i++) {
+        w[i] = ((uint64_t)be32(tail_a + i * 4) << 32) | be32(tail_b + i * 4);
+    }
+    w[4] = LANE_DUP(0x80000000u);
+    for (int i = 5; i < 15; i++) {
+        w[i] = 0;
+    }
+    w[15] = LANE_DUP(640);
+    
+    init2(state, midstate);
+    transform2_w(state, w);
+    
+    second2(state, hash_a, hash_b);
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА sha256_swar.c
+ * =========================================================================== */
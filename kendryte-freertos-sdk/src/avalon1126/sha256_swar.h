@@ -0,0 +1,73 @@
+/**
+ * =============================================================================
+ * @file    sha256_swar.h
+ * @brief   Avalon A1126pro - SHA256 двух сообщений в 64-битных регистрах (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Ядра K210 - rv64imafc: 32-битный SHA256 занимает половину каждого
+ * регистра. Здесь два независимых сообщения идут в старшей (a) и младшей
+ * (b) половинах одного uint64_t (SWAR - SIMD within a register):
+ * 
+ * - XOR, AND, NOT - одна инструкция на обе половины.
+ * - Сдвиг и поворот - сдвиг всего слова и маска, отсекающая биты соседней
+ *   половины.
+ * - Сложение с маской: старший бит каждой половины складывается отдельно
+ *   (XOR), поэтому перенос не переходит из b в a.
+ * 
+ * Сложение с маской стоит 6 инструкций против 2 у двух скалярных, а
+ * сложения - основная часть раунда; без инструкции поворота (Zbb) поворот
+ * выигрывает мало. Выигрыш против двух скалярных хэшей зависит от
+ * конвейера ядра - бэкенд выбирает hasher по замеру.
+ * 
+ * Заголовки одного задания: первые 64 байта общие, их состояние
+ * (midstate) считается один раз, на nonce - два сжатия вместо трёх.
+ * 
+ * Эталон - sha256_soft.c. Без FreeRTOS - собирается и на хосте
+ * (host/sha256_bench.c).
+ * 
+ * =============================================================================
+ */
+
+#ifndef __SHA256_SWAR_H__
+#define __SHA256_SWAR_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Сжатие двух блоков
+ * 
+ * @param state     Состояние: слово i = (a[i] << 32) | b[i], обновляется
+ * @param block_a   Блок сообщения a (64 байта)
+ * @param block_b   Блок сообщения b
+ */
+void sha256_swar_transform2(uint64_t state[8], const uint8_t *block_a, const uint8_t *block_b);
+
+/**
+ * @brief SHA256d двух сообщений одной длины
+ */
+void sha256d_swar2(const uint8_t *data_a, const uint8_t *data_b, size_t len,
+                   uint8_t *hash_a, uint8_t *hash_b);
+
+/**
+ * @brief SHA256d двух заголовков с общими первыми 64 байтами
+ * 
+ * @param midstate  Состояние после первых 64 байт (sha256_soft_transform)
+ * @param tail_a    Байты 64-79 заголовка a
+ * @param tail_b    Байты 64-79 заголовка b
+ */
+void sha256d_swar2_header(const uint32_t midstate[8], const uint8_t *tail_a,
+                          const uint8_t *tail_b, uint8_t *hash_a, uint8_t *hash_b);
+
+#endif /* __SHA256_SWAR_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА sha256_swar.h
+ * =========================================================================== */
@@ -0,0 +1,342 @@
+/**
+ * =============================================================================
+ * @file    throttle.c
+ * @brief   Avalon A1126pro - Плавное снижение хэшрейта при нагреве (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Доля хэшрейта каждого модуля по прогнозу температуры. Исполнение -
+ * частоты чипов (avalon10_set_chip_freq), а ниже минимальной частоты -
+ * скважность пополнения очереди заданий (avalon10_refill_work).
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+
+#include "throttle.h"
+#include "cgminer.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Throttle";
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static throttle_module_t thr[AVALON10_DEFAULT_MODULARS];
+static throttle_stats_t stats;
+static uint64_t poll_at_us;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Сумма частот чипов до снижения (MHz)
+ */
+static uint32_t base_sum(const avalon10_module_t *module, const throttle_module_t *tm)
+{
+    uint32_t sum = 0;
+    
+    for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+        if (module->chips[c].enabled) {
+            sum += tm->base_freq[c];
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Частоты чипов с суммой не выше target
+ * 
+ * Общий потолок опускается шагами AVALON10_FREQ_STEP, пока сумма не
+ * уложится в цель, затем чипы по порядку получают шаг выше потолка, пока
+ * остаётся запас. Частота ниже fmin не ставится.
+ * 
+ * @return          Сумма установленных частот (MHz)
+ */
+static uint32_t freq_apply(avalon10_info_t *info, int m, uint32_t target, uint32_t now)
+{
+    avalon10_module_t *module = &info->modules[m];
+    throttle_module_t *tm = &thr[m];
+    int fmin = info->default_freq[0];
+    int cap = AVALON10_DEFAULT_FREQ_MAX;
+    uint32_t sum;
+    
+    for (;;) {
+        sum = 0;
+        for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            if (module->chips[c].enabled) {
+                sum += MIN(tm->base_freq[c], cap);
+            }
+        }
+        if (sum <= target || cap - AVALON10_FREQ_STEP < fmin) {
+            break;
+        }
+        cap -= AVALON10_FREQ_STEP;
+    }
+    
+    for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+        int f = MIN(tm->base_freq[c], cap);
+    
+        if (!module->chips[c].enabled) {
+            continue;
+        }
+    
+        if (tm->base_freq[c] > cap) {
+            int up = MIN(tm->base_freq[c], cap + AVALON10_FREQ_STEP);
+    
+            if (sum + (up - f) <= target) {
+                sum += up - f;
+                f = up;
+            }
+        }
+    
+        if (module->chips[c].freq != f && avalon10_set_chip_freq(info, m, c, f) == 0) {
+            stats.changed_at = now;
+        }
+    }
+    
+    return sum;
+}
+
+/**
+ * @brief Возврат запомненных частот и выход из снижения
+ */
+static void release(avalon10_info_t *info, int m, uint32_t now)
+{
+    throttle_module_t *tm = &thr[m];
+    
+    freq_apply(info, m, base_sum(&info->modules[m], tm), now);
+    tm->engaged = 0;
+    tm->duty = 100;
+    
+    log_message(LOG_INFO, "%s: Модуль %d: снижение снято через %u с",
+               TAG, m, (unsigned)(now - tm->engaged_at));
+}
+
+/**
+ * @brief Шаг регулятора одного модуля
+ */
+static void module_step(avalon10_info_t *info, int m, float dt, uint32_t now)
+{
+    avalon10_module_t *module = &info->modules[m];
+    throttle_module_t *tm = &thr[m];
+    float start = info->temp_overheat - THROTTLE_BAND_C;
+    float target, limit = 0.0f;
+    uint32_t full, want, sum;
+    int thermal;
+    
+    /* Первый замер после входа в майнинг */
+    if (!tm->temp_prev) {
+        tm->temp_prev = module->temp_max;
+        if (!tm->engaged) {
+            tm->scale = 100.0f;
+            tm->duty = 100;
+        }
+    }
+    
+    tm->slope += THROTTLE_SLOPE_FILTER *
+                 ((module->temp_max - tm->temp_prev) / 10.0f / dt - tm->slope);
+    tm->temp_prev = module->temp_max;
+    tm->predicted = module->temp_max / 10.0f + tm->slope * THROTTLE_LOOKAHEAD_S;
+    
+    target = 100.0f - (100.0f - THROTTLE_MIN_PCT) * (tm->predicted - start) / THROTTLE_BAND_C;
+    if (target > 100.0f) target = 100.0f;
+    if (target < THROTTLE_MIN_PCT) target = THROTTLE_MIN_PCT;
+    thermal = target < 100.0f;
+    for (int s = 0; s < THROTTLE_LIMIT_SOURCES; s++) {
+        if (tm->limit[s] > 0.0f && (limit <= 0.0f || tm->limit[s] < limit)) limit = tm->limit[s];
+    }
+    if (limit > 0.0f && target > limit) target = limit;
+    
+    if (module->state == AVALON10_MODULE_STATE_OVERHEAT) {
+        /* Остановлен по temp_cutoff - вернётся с минимальной долей */
+        tm->scale = THROTTLE_MIN_PCT;
+    } else if (target < tm->scale) {
+        tm->scale = MAX(target, tm->scale - THROTTLE_DROP_PCT * dt);
+    } else {
+        tm->scale = MIN(target, tm->scale + THROTTLE_RISE_PCT * dt);
+    }
+    
+    if (!tm->engaged) {
+        if (tm->scale >= 100.0f) {
+            return;
+        }
+    
+        for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+            tm->base_freq[c] = module->chips[c].freq;
+        }
+        tm->engaged = 1;
+        tm->applied = 100.0f;
+        tm->engaged_at = now;
+        tm->events++;
+    
+        if (thermal) {
+            log_message(LOG_WARNING, "%s: Модуль %d: %.1f°C (прогноз %.1f°C), снижение хэшрейта",
+                       TAG, m, module->temp_max / 10.0, (double)tm->predicted);
+        } else {
+            log_message(LOG_INFO, "%s: Модуль %d: лимит доли %.1f%%", TAG, m, (double)limit);
+        }
+    }
+    
+    if (tm->scale >= 100.0f) {
+        release(info, m, now);
+        return;
+    }
+    
+    if (tm->scale > tm->applied - THROTTLE_APPLY_PCT &&
+        tm->scale < tm->applied + THROTTLE_APPLY_PCT) {
+        return;
+    }
+    tm->applied = tm->scale;
+    
+    full = base_sum(module, tm);
+    want = (uint32_t)(full * tm->scale / 100.0f);
+    sum = freq_apply(info, m, want, now);
+    
+    /* Частоты на минимуме - остаток скважностью работы */
+    tm->duty = sum > want ? (uint8_t)MAX(1, want * 100 / sum) : 100;
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг регулятора
+ */
+void throttle_poll(avalon10_info_t *info)
+{
+    uint64_t now_us = cgminer_time_us();
+    uint32_t now = cgminer_time_s();
+    int throttled = 0;
+    float dt;
+    
+    if (!info || !info->initialized) {
+        return;
+    }
+    
+    dt = cgminer_poll_dt(&poll_at_us, now_us, 0.1f);
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        avalon10_module_t *module = &info->modules[m];
+        throttle_module_t *tm = &thr[m];
+    
+        /* Модуль не майнит: запомненные частоты возвращаются сразу */
+        if (module->state != AVALON10_MODULE_STATE_MINING &&
+            module->state != AVALON10_MODULE_STATE_OVERHEAT) {
+            if (tm->engaged && module->state != AVALON10_MODULE_STATE_NONE) {
+                release(info, m, now);
+            }
+            tm->engaged = 0;
+            tm->duty = 100;
+            tm->scale = 100.0f;
+            tm->slope = 0.0f;
+            tm->temp_prev = 0;
+            continue;
+        }
+    
+        module_step(info, m, dt, now);
+        throttled += tm->engaged;
+    }
+    
+    stats.throttled = (uint8_t)throttled;
+}
+
+/**
+ * @brief Учёт остановки модуля по temp_cutoff
+ */
+void throttle_note_cutoff(int module_id)
+{
+    if (module_id >= 0 && module_id < AVALON10_DEFAULT_MODULARS) {
+        stats.cutoffs++;
+    }
+}
+
+/**
+ * @brief Внешний лимит доли хэшрейта модуля
+ */
+void throttle_set_limit(int module_id, int source, float pct)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        source < 0 || source >= THROTTLE_LIMIT_SOURCES) {
+        return;
+    }
+    
+    if (pct >= 100.0f) pct = 0.0f;
+    if (pct > 0.0f && pct < THROTTLE_MIN_PCT) pct = THROTTLE_MIN_PCT;
+    
+    thr[module_id].limit[source] = pct;
+}
+
+/**
+ * @brief Модуль в снижении
+ */
+int throttle_active(int module_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return 0;
+    }
+    
+    return thr[module_id].engaged;
+}
+
+/**
+ * @brief Модулю можно отправлять задания в этот момент
+ * 
+ * Окна модулей сдвинуты на четверть периода, чтобы простой чипов не
+ * совпадал и нагрузка на блок питания не шла ступенями.
+ */
+int throttle_work_allowed(int module_id)
+{
+    uint32_t duty, ms;
+    
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return 1;
+    }
+    
+    duty = thr[module_id].duty;
+    if (!thr[module_id].engaged || duty >= 100) {
+        return 1;
+    }
+    
+    ms = (uint32_t)(cgminer_time_us() / 1000) +
+         module_id * THROTTLE_DUTY_PERIOD_MS / AVALON10_DEFAULT_MODULARS;
+    
+    return ms % THROTTLE_DUTY_PERIOD_MS < duty * THROTTLE_DUTY_PERIOD_MS / 100;
+}
+
+/**
+ * @brief Состояние снижения модуля
+ */
+const throttle_module_t *throttle_get_module(int module_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return NULL;
+    }
+    
+    return &thr[module_id];
+}
+
+/**
+ * @brief Состояние снижения
+ */
+const throttle_stats_t *throttle_get_stats(void)
+{
+    return &stats;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА throttle.c
+ * =========================================================================== */
@@ -0,0 +1,183 @@
+/**
+ * =============================================================================
+ * @file    throttle.h
+ * @brief   Avalon A1126pro - Плавное снижение хэшрейта при нагреве (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Вместо остановки модуля при перегреве хэшрейт каждого модуля снижается
+ * пропорционально тому, насколько прогноз температуры зашёл в полосу
+ * THROTTLE_BAND_C ниже temp_overheat. Тёплый корпус теряет несколько
+ * процентов хэшрейта, а не модули целиком.
+ * 
+ * РЕГУЛЯТОР (раз в секунду, задача monitor, для каждого модуля):
+ *   T' = T + dT/dt · THROTTLE_LOOKAHEAD_S
+ *   цель = 100% - (100% - THROTTLE_MIN_PCT) · (T' - (temp_overheat - BAND)) / BAND
+ * - Прогноз по наклону температуры начинает снижение до того, как
+ *   модуль дойдёт до полосы.
+ * - Снижение быстрое (THROTTLE_DROP_PCT % в секунду), возврат медленный
+ *   (THROTTLE_RISE_PCT % в секунду) - без качания между двумя уровнями.
+ * 
+ * ИСПОЛНЕНИЕ (доля хэшрейта S):
+ * - Сначала частоты: сумма частот чипов доводится до S от частот,
+ *   запомненных при входе в снижение. Частоты снижаются с самых высоких
+ *   шагами AVALON10_FREQ_STEP, поэтому разрешение - один шаг одного чипа.
+ * - Когда все чипы на минимальной частоте, остаток - скважностью работы:
+ *   модуль получает задания только часть периода THROTTLE_DUTY_PERIOD_MS,
+ *   остальное время чипы простаивают с пустой очередью.
+ * - При возврате к 100% чипы получают запомненные частоты.
+ * 
+ * Другие модули (балансировка, лимит мощности) могут ограничить долю
+ * сверху throttle_set_limit(): доля = min(тепловая цель, лимиты) с теми же
+ * скоростями и тем же исполнением.
+ * 
+ * Пока модуль в снижении, autotune и efficiency его не трогают, а
+ * tune_store сохраняет частоты до снижения. temp_cutoff по-прежнему
+ * останавливает модуль (avalon10_check_overheat), после остывания он
+ * возвращается с THROTTLE_MIN_PCT.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __THROTTLE_H__
+#define __THROTTLE_H__
+
+#include <stdint.h>
+
+#include "avalon10.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Ширина полосы снижения под temp_overheat (°C)
+ */
+#define THROTTLE_BAND_C             10
+
+/**
+ * @brief Горизонт прогноза температуры (секунды)
+ */
+#define THROTTLE_LOOKAHEAD_S        15
+
+/**
+ * @brief Сглаживание наклона температуры (доля нового замера)
+ */
+#define THROTTLE_SLOPE_FILTER       0.1f
+
+/**
+ * @brief Минимальная доля хэшрейта (%) у temp_overheat
+ */
+#define THROTTLE_MIN_PCT            20
+
+/**
+ * @brief Скорость изменения доли хэшрейта (% в секунду)
+ */
+#define THROTTLE_DROP_PCT           10.0f
+#define THROTTLE_RISE_PCT           1.0f
+
+/**
+ * @brief Изменение доли, при котором частоты пересчитываются (%)
+ * Шаг датчика 0.1°C не должен гонять пакеты SET_FREQ каждую секунду
+ */
+#define THROTTLE_APPLY_PCT          1.0f
+
+/**
+ * @brief Период скважности работы (мс)
+ * Очередь модуля пустеет за десятки мс, тепловая постоянная - десятки секунд
+ */
+#define THROTTLE_DUTY_PERIOD_MS     1000
+
+/**
+ * @brief Источники внешнего лимита доли (throttle_set_limit)
+ */
+#define THROTTLE_LIMIT_BALANCE      0   /* Тепловая балансировка */
+#define THROTTLE_LIMIT_POWER        1   /* Лимит мощности */
+#define THROTTLE_LIMIT_SOURCES      2
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct throttle_module_t
+ * @brief Состояние снижения модуля
+ */
+typedef struct throttle_module {
+    uint8_t engaged;                /* 1 = частоты модуля снижены */
+    uint8_t duty;                   /* Скважность работы (%) */
+    int16_t temp_prev;              /* temp_max прошлого шага (°C × 10) */
+    float slope;                    /* Сглаженный наклон (°C/с) */
+    float predicted;                /* Прогноз температуры (°C) */
+    float scale;                    /* Доля хэшрейта (%) */
+    float applied;                  /* Доля, под которую выставлены частоты (%) */
+    float limit[THROTTLE_LIMIT_SOURCES];  /* Внешние лимиты доли (%, 0 = нет) */
+    uint32_t engaged_at;            /* Начало снижения (с) */
+    uint32_t events;                /* Входов в снижение */
+    uint16_t base_freq[AVALON10_DEFAULT_MINER_CNT];  /* Частоты до снижения */
+} throttle_module_t;
+
+/**
+ * @struct throttle_stats_t
+ * @brief Состояние снижения (для API)
+ */
+typedef struct throttle_stats {
+    uint8_t throttled;              /* Модулей в снижении */
+    uint32_t cutoffs;               /* Остановок по temp_cutoff */
+    uint32_t changed_at;            /* uptime последней смены частот (с) */
+} throttle_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг регулятора (раз в секунду, задача monitor, после
+ *        avalon10_check_overheat)
+ * 
+ * @param info      Указатель на структуру информации
+ */
+void throttle_poll(avalon10_info_t *info);
+
+/**
+ * @brief Учёт остановки модуля по temp_cutoff
+ */
+void throttle_note_cutoff(int module_id);
+
+/**
+ * @brief Внешний лимит доли хэшрейта модуля
+ * 
+ * @param module_id ID модуля
+ * @param source    THROTTLE_LIMIT_*
+ * @param pct       Доля (THROTTLE_MIN_PCT-100%), 0 или 100 - снять лимит
+ */
+void throttle_set_limit(int module_id, int source, float pct);
+
+/**
+ * @brief Модуль в снижении (частоты не его собственные)
+ */
+int throttle_active(int module_id);
+
+/**
+ * @brief Модулю можно отправлять задания в этот момент
+ */
+int throttle_work_allowed(int module_id);
+
+/**
+ * @brief Состояние снижения модуля
+ * @return          NULL при неверном номере
+ */
+const throttle_module_t *throttle_get_module(int module_id);
+
+/**
+ * @brief Состояние снижения
+ */
+const throttle_stats_t *throttle_get_stats(void);
+
+#endif /* __THROTTLE_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА throttle.h
+ * =========================================================================== */
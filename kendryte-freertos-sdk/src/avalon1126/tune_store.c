@@ -0,0 +1,434 @@
+/**
+ * =============================================================================
+ * @file    tune_store.c
+ * @brief   Avalon A1126pro - Сохранение топологии и настроек ASIC (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Запись A/B во flash W25Q64, снимок и восстановление состояния драйвера.
+ * Изменения отслеживаются по CRC снимка: запись во flash происходит только
+ * после того, как новое состояние продержалось TUNE_STORE_SETTLE_S секунд.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "tune_store.h"
+#include "cgminer.h"
+#include "w25qxx.h"
+#include "throttle.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Tune";
+
+static const uint32_t slot_addr[2] = { W25QXX_TUNE_ADDR_A, W25QXX_TUNE_ADDR_B };
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static tune_store_stats_t store = { .slot = -1 };
+
+/* Снимок для tune_store_poll() (запись ~1.4 KB - не на стеке задачи) */
+static tune_record_t poll_rec;
+static uint32_t poll_crc = 0;           /* CRC текущего состояния */
+static uint32_t saved_crc = 0;          /* CRC состояния в последней записи */
+static uint32_t changed_at = 0;         /* Когда состояние стало poll_crc (с) */
+static uint32_t tried_at = 0;           /* Последняя попытка записи (с) */
+static volatile uint8_t save_requested = 0;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief CRC32 (полином 0xEDB88320)
+ */
+static uint32_t calc_crc32(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    
+    return ~crc;
+}
+
+/**
+ * @brief CRC полей записи (без поля crc)
+ */
+static uint32_t record_crc(const tune_record_t *rec)
+{
+    return calc_crc32((const uint8_t *)rec, offsetof(tune_record_t, crc));
+}
+
+/**
+ * @brief CRC состояния без заголовка (для отслеживания изменений)
+ */
+static uint32_t state_crc(const tune_record_t *rec)
+{
+    size_t start = offsetof(tune_record_t, fan_pwm);
+    
+    return calc_crc32((const uint8_t *)rec + start, offsetof(tune_record_t, crc) - start);
+}
+
+/**
+ * @brief Проверка копии
+ * @return          0 если копия пригодна для восстановления
+ */
+static int record_check(const tune_record_t *rec)
+{
+    if (rec->magic != TUNE_STORE_MAGIC) {
+        return -1;      /* Пустой сектор - не ошибка */
+    }
+    
+    if (rec->version != TUNE_STORE_VERSION || rec->size != sizeof(tune_record_t) ||
+        rec->modules != AVALON10_DEFAULT_MODULARS ||
+        rec->chips != AVALON10_DEFAULT_MINER_CNT ||
+        rec->freq_slots != AVALON10_FREQ_SLOTS ||
+        rec->fan_count != AVALON10_FAN_COUNT) {
+        log_message(LOG_WARNING, "%s: Запись другой версии или платы", TAG);
+        return -2;
+    }
+    
+    if (rec->crc != record_crc(rec)) {
+        log_message(LOG_WARNING, "%s: CRC записи #%lu не сходится", TAG, (unsigned long)rec->seq);
+        return -2;
+    }
+    
+    if (rec->fan_min > rec->fan_max || rec->fan_max > 100) {
+        return -2;
+    }
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        const tune_module_t *m = &rec->module[i];
+    
+        if (!m->present) {
+            continue;
+        }
+    
+        if (m->voltage < AVALON10_VOLTAGE_MIN || m->voltage > AVALON10_VOLTAGE_MAX) {
+            return -2;
+        }
+        for (int j = 0; j < AVALON10_FREQ_SLOTS; j++) {
+            if (m->freq[j] < AVALON10_DEFAULT_FREQ_MIN || m->freq[j] > AVALON10_DEFAULT_FREQ_MAX) {
+                return -2;
+            }
+        }
+        for (int j = 0; j < AVALON10_DEFAULT_MINER_CNT; j++) {
+            if (m->chip_freq[j] && (m->chip_freq[j] < AVALON10_DEFAULT_FREQ_MIN ||
+                                    m->chip_freq[j] > AVALON10_DEFAULT_FREQ_MAX)) {
+                return -2;
+            }
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief Чтение и проверка копии
+ * @return          0 если копия верна
+ */
+static int slot_read(int slot, tune_record_t *rec)
+{
+    int ret;
+    
+    if (w25qxx_read(slot_addr[slot], (uint8_t *)rec, sizeof(*rec)) != 0) {
+        return -1;
+    }
+    
+    ret = record_check(rec);
+    if (ret == -2) {
+        store.rejected++;
+    }
+    
+    return ret == 0 ? 0 : -1;
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Чтение последней верной записи из flash
+ */
+int tune_store_load(tune_record_t *rec)
+{
+    static tune_record_t other;
+    int ok_a, ok_b;
+    
+    if (!rec) {
+        return -1;
+    }
+    
+    if (!w25qxx_is_initialized() && w25qxx_init() != 0) {
+        log_message(LOG_WARNING, "%s: Flash недоступна", TAG);
+        return -1;
+    }
+    
+    ok_a = slot_read(0, rec) == 0;
+    ok_b = slot_read(1, &other) == 0;
+    
+    /* Обе копии верны - берём более новую */
+    if (ok_b && (!ok_a || (int32_t)(other.seq - rec->seq) > 0)) {
+        memcpy(rec, &other, sizeof(*rec));
+        store.slot = 1;
+    } else if (ok_a) {
+        store.slot = 0;
+    } else {
+        log_message(LOG_INFO, "%s: Сохранённых настроек нет", TAG);
+        return -1;
+    }
+    
+    store.loaded = 1;
+    store.seq = rec->seq;
+    saved_crc = state_crc(rec);
+    
+    log_message(LOG_INFO, "%s: Настройки #%lu из копии %c",
+               TAG, (unsigned long)rec->seq, 'A' + store.slot);
+    
+    return 0;
+}
+
+/**
+ * @brief Запись состояния во flash
+ */
+int tune_store_save(tune_record_t *rec)
+{
+    int slot = store.slot < 0 ? 0 : store.slot ^ 1;
+    
+    if (!rec) {
+        return -1;
+    }
+    
+    rec->magic = TUNE_STORE_MAGIC;
+    rec->version = TUNE_STORE_VERSION;
+    rec->size = sizeof(tune_record_t);
+    rec->seq = store.seq + 1;
+    rec->crc = record_crc(rec);
+    
+    if (w25qxx_erase_sector(slot_addr[slot]) != 0 ||
+        w25qxx_write(slot_addr[slot], (const uint8_t *)rec, sizeof(*rec)) != 0) {
+        log_message(LOG_ERR, "%s: Ошибка записи копии %c", TAG, 'A' + slot);
+        store.errors++;
+        return -1;
+    }
+    
+    store.slot = slot;
+    store.seq = rec->seq;
+    store.saves++;
+    store.saved_at = cgminer_time_s();
+    saved_crc = state_crc(rec);
+    
+    log_message(LOG_INFO, "%s: Настройки #%lu сохранены в копию %c",
+               TAG, (unsigned long)rec->seq, 'A' + slot);
+    
+    return 0;
+}
+
+/**
+ * @brief Стирание обеих копий
+ */
+int tune_store_clear(void)
+{
+    int ret = 0;
+    
+    for (int slot = 0; slot < 2; slot++) {
+        if (w25qxx_erase_sector(slot_addr[slot]) != 0) {
+            ret = -1;
+        }
+    }
+    
+    store.slot = -1;
+    store.loaded = 0;
+    saved_crc = 0;
+    
+    log_message(LOG_INFO, "%s: Сохранённые настройки стёрты", TAG);
+    
+    return ret;
+}
+
+/**
+ * @brief Снимок текущего состояния драйвера в запись
+ */
+void tune_store_capture(const avalon10_info_t *info, tune_record_t *rec)
+{
+    memset(rec, 0, sizeof(*rec));
+    
+    rec->modules = AVALON10_DEFAULT_MODULARS;
+    rec->chips = AVALON10_DEFAULT_MINER_CNT;
+    rec->freq_slots = AVALON10_FREQ_SLOTS;
+    rec->fan_count = AVALON10_FAN_COUNT;
+    
+    /* ШИМ с шагом 5%: подстройка ПИД на 1-2% - не повод писать во flash */
+    for (int i = 0; i < AVALON10_FAN_COUNT; i++) {
+        rec->fan_pwm[i] = (info->fan_pwm[i] + 2) / 5 * 5;
+    }
+    rec->fan_min = info->fan_min;
+    rec->fan_max = info->fan_max;
+    rec->temp_target = info->temp_target;
+    
+    for (int i = 0; i < AVALON10_DEFAULT_MODULARS; i++) {
+        const avalon10_module_t *module = &info->modules[i];
+        tune_module_t *m = &rec->module[i];
+        const uint16_t *freq = NULL;
+    
+        if (module->state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+    
+        /* Снижение по температуре временное - сохраняются частоты до него */
+        if (throttle_active(i)) {
+            freq = throttle_get_module(i)->base_freq;
+        }
+    
+        m->present = 1;
+        m->voltage = module->voltage;
+        memcpy(m->freq, module->freq, sizeof(m->freq));
+        for (int j = 0; j < AVALON10_DEFAULT_MINER_CNT; j++) {
+            m->chip_freq[j] = !module->chips[j].enabled ? 0 :
+                              freq ? freq[j] : module->chips[j].freq;
+        }
+    }
+}
+
+/**
+ * @brief Восстановление модуля из записи
+ */
+int tune_store_restore_module(avalon10_info_t *info, const tune_record_t *rec, int module_id)
+{
+    avalon10_module_t *module = &info->modules[module_id];
+    const tune_module_t *m;
+    int active = 0;
+    
+    if (!rec || module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return 0;
+    }
+    
+    m = &rec->module[module_id];
+    if (!m->present) {
+        return 0;
+    }
+    
+    module->voltage = m->voltage;
+    memcpy(module->freq, m->freq, sizeof(module->freq));
+    
+    for (int j = 0; j < AVALON10_DEFAULT_MINER_CNT; j++) {
+        avalon10_chip_t *chip = &module->chips[j];
+    
+        chip->enabled = m->chip_freq[j] != 0;
+        chip->freq = chip->enabled ? m->chip_freq[j] : module->freq[0];
+        active += chip->enabled;
+    }
+    
+    module->active_chips = active;
+    module->failed_chips = AVALON10_DEFAULT_MINER_CNT - active;
+    store.restored++;
+    
+    log_message(LOG_INFO, "%s: Модуль %d восстановлен: %d mV, %d MHz, %d чипов",
+               TAG, module_id, m->voltage, m->freq[0], active);
+    
+    return 1;
+}
+
+/**
+ * @brief Восстановление вентиляторов из записи
+ */
+void tune_store_restore_fans(avalon10_info_t *info, const tune_record_t *rec)
+{
+    if (!rec) {
+        return;
+    }
+    
+    info->fan_min = rec->fan_min;
+    info->fan_max = rec->fan_max;
+    info->temp_target = rec->temp_target;
+    
+    /* Старт с последнего ШИМ, а не с fan_min - без перегрева на разгоне */
+    for (int i = 0; i < AVALON10_FAN_COUNT; i++) {
+        avalon10_set_fan_speed(info, i, rec->fan_pwm[i]);
+    }
+}
+
+/**
+ * @brief Периодическая проверка изменений
+ */
+void tune_store_poll(avalon10_info_t *info)
+{
+    uint32_t now = cgminer_time_s();
+    uint32_t crc;
+    
+    if (!info || !info->initialized) {
+        return;
+    }
+    
+    tune_store_capture(info, &poll_rec);
+    crc = state_crc(&poll_rec);
+    
+    if (save_requested) {
+        save_requested = 0;
+        poll_crc = crc;
+        tried_at = now;
+        tune_store_save(&poll_rec);
+        return;
+    }
+    
+    if (crc != poll_crc) {
+        poll_crc = crc;
+        changed_at = now;
+        return;
+    }
+    
+    /* Сохраняем только последнее рабочее состояние */
+    if (crc == saved_crc || !info->mining_enabled || info->overheat) {
+        return;
+    }
+    
+    if (now - changed_at < TUNE_STORE_SETTLE_S) {
+        return;
+    }
+    
+    /* Интервал считается и от неудачной попытки - без записи каждую секунду */
+    if (tried_at && now - tried_at < TUNE_STORE_MIN_INTERVAL_S) {
+        return;
+    }
+    
+    tried_at = now;
+    tune_store_save(&poll_rec);
+}
+
+/**
+ * @brief Запрос записи на следующем проходе tune_store_poll()
+ */
+void tune_store_request_save(void)
+{
+    save_requested = 1;
+}
+
+/**
+ * @brief Состояние хранилища
+ */
+const tune_store_stats_t *tune_store_get_stats(void)
+{
+    return &store;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА tune_store.c
+ * =========================================================================== */
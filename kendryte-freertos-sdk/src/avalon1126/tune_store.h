@@ -0,0 +1,184 @@
+/**
+ * =============================================================================
+ * @file    tune_store.h
+ * @brief   Avalon A1126pro - Сохранение топологии и настроек ASIC (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Последнее рабочее состояние ASIC во flash: какие модули стоят, частота
+ * и включение каждого чипа, напряжение модулей, состояние вентиляторов.
+ * При загрузке запись восстанавливается сразу после обнаружения модуля,
+ * и хэшрейт выходит на рабочий уровень без повторной настройки.
+ * 
+ * ХРАНЕНИЕ:
+ * Две копии (A/B) в соседних секторах W25Q64. Новая запись пишется в
+ * сектор со старой копией, поэтому обрыв питания во время записи
+ * оставляет предыдущую копию целой. При чтении берётся верная копия
+ * с большим порядковым номером.
+ * 
+ *   0x060000  [копия A: заголовок | модули | CRC32]
+ *   0x061000  [копия B: заголовок | модули | CRC32]
+ * 
+ * Запись отклоняется, если не сходятся magic, версия, размер, размеры
+ * массивов (модули, чипы, слоты частоты), CRC32 или значения выходят за
+ * допустимые диапазоны.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __TUNE_STORE_H__
+#define __TUNE_STORE_H__
+
+#include <stdint.h>
+
+#include "avalon10.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+#define TUNE_STORE_MAGIC        0x454E5554  /* "TUNE" */
+#define TUNE_STORE_VERSION      1
+
+/**
+ * @brief Состояние должно не меняться столько секунд перед записью
+ */
+#define TUNE_STORE_SETTLE_S     60
+
+/**
+ * @brief Минимальный интервал между записями (секунды, износ flash)
+ */
+#define TUNE_STORE_MIN_INTERVAL_S   600
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct tune_module_t
+ * @brief Сохранённое состояние модуля
+ */
+typedef struct tune_module {
+    uint8_t present;                                    /* 1 = модуль был обнаружен */
+    uint8_t reserved;
+    uint16_t voltage;                                   /* Напряжение (mV) */
+    uint16_t freq[AVALON10_FREQ_SLOTS];                 /* Частоты по слотам (MHz) */
+    uint16_t chip_freq[AVALON10_DEFAULT_MINER_CNT];     /* Частота чипа, 0 = чип выключен */
+} tune_module_t;
+
+/**
+ * @struct tune_record_t
+ * @brief Запись во flash
+ */
+typedef struct tune_record {
+    uint32_t magic;                 /* TUNE_STORE_MAGIC */
+    uint16_t version;               /* TUNE_STORE_VERSION */
+    uint16_t size;                  /* sizeof(tune_record_t) */
+    uint32_t seq;                   /* Порядковый номер записи */
+    uint8_t modules;                /* AVALON10_DEFAULT_MODULARS */
+    uint8_t chips;                  /* AVALON10_DEFAULT_MINER_CNT */
+    uint8_t freq_slots;             /* AVALON10_FREQ_SLOTS */
+    uint8_t fan_count;              /* AVALON10_FAN_COUNT */
+    
+    /* Вентиляторы */
+    uint8_t fan_pwm[AVALON10_FAN_COUNT];    /* Последний ШИМ (%) */
+    uint8_t fan_min;
+    uint8_t fan_max;
+    int8_t temp_target;
+    uint8_t reserved[3];
+    
+    tune_module_t module[AVALON10_DEFAULT_MODULARS];
+    
+    uint32_t crc;                   /* CRC32 всех полей выше */
+} tune_record_t;
+
+/**
+ * @struct tune_store_stats_t
+ * @brief Состояние хранилища (для API)
+ */
+typedef struct tune_store_stats {
+    uint8_t loaded;                 /* 1 = запись прочитана при загрузке */
+    uint8_t restored;               /* Модулей восстановлено из записи */
+    int8_t slot;                    /* Копия с последней записью (0 = A, 1 = B, -1 = нет) */
+    uint32_t seq;                   /* Номер последней записи */
+    uint32_t saves;                 /* Записей за время работы */
+    uint32_t errors;                /* Ошибки записи */
+    uint32_t rejected;              /* Копии, отклонённые проверкой */
+    uint32_t saved_at;              /* uptime последней записи (с) */
+} tune_store_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Чтение последней верной записи из flash
+ * 
+ * @param rec       Запись для результата
+ * @return          0 при успехе, -1 если верной копии нет
+ */
+int tune_store_load(tune_record_t *rec);
+
+/**
+ * @brief Запись состояния во flash (в сектор со старой копией)
+ * 
+ * @param rec       Запись (magic, версия, номер и CRC заполняются здесь)
+ * @return          0 при успехе, -1 при ошибке
+ */
+int tune_store_save(tune_record_t *rec);
+
+/**
+ * @brief Стирание обеих копий
+ * @return          0 при успехе, -1 при ошибке
+ */
+int tune_store_clear(void);
+
+/**
+ * @brief Снимок текущего состояния драйвера в запись
+ */
+void tune_store_capture(const avalon10_info_t *info, tune_record_t *rec);
+
+/**
+ * @brief Восстановление модуля из записи
+ * 
+ * Вызывается при обнаружении модуля. Модуль, которого не было в записи,
+ * остаётся с настройками по умолчанию.
+ * 
+ * @return          1 если модуль восстановлен, 0 если его нет в записи
+ */
+int tune_store_restore_module(avalon10_info_t *info, const tune_record_t *rec, int module_id);
+
+/**
+ * @brief Восстановление вентиляторов из записи
+ */
+void tune_store_restore_fans(avalon10_info_t *info, const tune_record_t *rec);
+
+/**
+ * @brief Периодическая проверка изменений (раз в секунду, задача monitor)
+ * 
+ * Записывает состояние, если оно изменилось, не меняется
+ * TUNE_STORE_SETTLE_S секунд, майнинг идёт без перегрева и с прошлой
+ * записи прошло TUNE_STORE_MIN_INTERVAL_S секунд.
+ */
+void tune_store_poll(avalon10_info_t *info);
+
+/**
+ * @brief Запрос записи без ожидания (API)
+ * 
+ * Запись выполняет tune_store_poll() на следующем проходе - снимок
+ * состояния делается только в задаче monitor.
+ */
+void tune_store_request_save(void);
+
+/**
+ * @brief Состояние хранилища
+ */
+const tune_store_stats_t *tune_store_get_stats(void);
+
+#endif /* __TUNE_STORE_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА tune_store.h
+ * =========================================================================== */
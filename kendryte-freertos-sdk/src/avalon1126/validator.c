@@ -0,0 +1,537 @@
+/**
+ * =============================================================================
+ * @file    validator.c
+ * @brief   Avalon A1126pro - Конвейер проверки nonce (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Кольцо сырых nonce (SPSC, без блокировок), задача пакетной проверки
+ * на ядре 1 и очередь шар для stratum_send_task.
+ * 
+ * ПОТОКИ ДАННЫХ:
+ * - ring_head пишет только задача опроса ASIC, ring_tail - только validator;
+ *   индексы публикуются с release/acquire, поэтому мьютекс не нужен.
+ * - Снимки заданий пишет только mining_task (под g_work_mutex), validator
+ *   читает их по счётчику версии (seqlock) и повторяет чтение при гонке.
+ * - Счётчики статистики меняются атомарно (stat_add, stat_max).
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+#include "validator.h"
+#include "avalon10.h"
+#include "stratum.h"
+#include "work.h"
+#include "hasher.h"
+#include "mock_hardware.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Validator";
+
+/**
+ * @brief Период пробуждения validator без сигнала от опроса (мс)
+ */
+#define VALIDATOR_IDLE_MS           50
+
+#define RING_MASK                   (VALIDATOR_RING_SIZE - 1)
+#define JOB_MASK                    (VALIDATOR_JOB_SLOTS - 1)
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ТИПЫ
+ * =========================================================================== */
+
+/**
+ * @brief Снимок задания, отправленного на ASIC
+ * 
+ * seq нечётный - идёт запись, читатель должен повторить попытку.
+ */
+typedef struct validator_job {
+    uint32_t seq;                   /* Версия слота (seqlock) */
+    uint8_t valid;                  /* 1 = слот заполнен */
+    uint8_t job_idx;                /* Индекс задания на ASIC */
+    uint8_t header[80];             /* Заголовок блока */
+    uint8_t target[32];             /* Цель пула */
+    char job_id[MAX_JOB_ID_LEN];    /* ID задания пула */
+    uint8_t nonce2[8];              /* ExtraNonce2 */
+    int nonce2_len;                 /* Длина ExtraNonce2 */
+    uint32_t ntime;                 /* nTime */
+} validator_job_t;
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static validator_nonce_t ring[VALIDATOR_RING_SIZE];
+static uint32_t ring_head = 0;      /* Пишет задача опроса */
+static uint32_t ring_tail = 0;      /* Пишет validator */
+
+static validator_job_t jobs[VALIDATOR_JOB_SLOTS];
+
+static QueueHandle_t submit_queue = NULL;
+static TaskHandle_t validator_task_handle = NULL;
+
+static validator_stats_t stats;
+
+extern avalon10_info_t *g_avalon10_info;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Атомарные счётчики stats
+ * 
+ * stats пишут задача опроса (кольцо), validator и stratum_send_task
+ * (очередь отправки), поэтому все изменения - через __atomic.
+ */
+static inline void stat_add(uint64_t *p, uint64_t v)
+{
+    __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+}
+
+static inline void stat_inc32(uint32_t *p)
+{
+    __atomic_fetch_add(p, 1, __ATOMIC_RELAXED);
+}
+
+static void stat_max(uint32_t *max, uint32_t v)
+{
+    uint32_t m = __atomic_load_n(max, __ATOMIC_RELAXED);
+    
+    while (v > m && !__atomic_compare_exchange_n(max, &m, v, 1,
+                                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * @brief Текущая глубина очереди и её максимум
+ */
+static void stat_level(uint32_t *cur, uint32_t *max, uint32_t v)
+{
+    __atomic_store_n(cur, v, __ATOMIC_RELAXED);
+    stat_max(max, v);
+}
+
+/**
+ * @brief Учёт задержки записи на ступени конвейера
+ */
+static void stage_account(validator_stage_t *stage, uint64_t t_in, uint64_t t_out)
+{
+    uint32_t lat = (t_out > t_in) ? (uint32_t)(t_out - t_in) : 0;
+    
+    stat_add(&stage->count, 1);
+    stat_add(&stage->lat_sum_us, lat);
+    stat_max(&stage->lat_max_us, lat);
+}
+
+/**
+ * @brief Чтение снимка задания по индексу
+ * 
+ * @param job_idx   Индекс задания из nonce-записи
+ * @param out       Копия снимка
+ * @return          1 если задание найдено, 0 если вытеснено или не было
+ */
+static int job_snapshot(uint8_t job_idx, validator_job_t *out)
+{
+    validator_job_t *slot = &jobs[job_idx & JOB_MASK];
+    uint32_t s1, s2;
+    
+    do {
+        s1 = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        memcpy(out, slot, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        s2 = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    } while ((s1 & 1) || s1 != s2);
+    
+    return out->valid && out->job_idx == job_idx;
+}
+
+/**
+ * @brief Класс nonce по хэшу заголовка
+ * 
+ * @param job       Снимок задания
+ * @param hash      SHA256d заголовка с nonce
+ * @return          AVALON10_NONCE_HW_ERROR, AVALON10_NONCE_DIFF1
+ *                  или AVALON10_NONCE_SHARE
+ */
+static int classify_hash(const validator_job_t *job, const uint8_t *hash)
+{
+#if MOCK_ASIC
+    /* Эмулятор ищет nonce пониженной сложности (mock_hardware.h) */
+    int zeros = mock_asic_hash_zero_bits(hash);
+    
+    (void)job;
+    if (zeros < MOCK_SIM_DIFF_BITS) {
+        return AVALON10_NONCE_HW_ERROR;
+    }
+    
+    return (zeros >= MOCK_SIM_SHARE_BITS) ? AVALON10_NONCE_SHARE : AVALON10_NONCE_DIFF1;
+#else
+    /* Сложность 1: старшие 32 бита хэша (байты 28-31) равны нулю */
+    if (hash[31] | hash[30] | hash[29] | hash[28]) {
+        return AVALON10_NONCE_HW_ERROR;
+    }
+    
+    return work_hash_meets_target(hash, job->target) ? AVALON10_NONCE_SHARE
+                                                     : AVALON10_NONCE_DIFF1;
+#endif
+}
+
+/**
+ * @brief Модуль записи (NULL до инициализации драйвера)
+ */
+static avalon10_module_t *rec_module(const validator_nonce_t *rec)
+{
+    if (g_avalon10_info && rec->module_id < AVALON10_DEFAULT_MODULARS) {
+        return &g_avalon10_info->modules[rec->module_id];
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Учёт проверенной записи и постановка шары в очередь
+ * 
+ * @param rec       Запись nonce
+ * @param job       Снимок задания записи
+ * @param ret       Результат classify_hash()
+ * @param t_valid   Время проверки (мкс)
+ */
+static void finish_one(const validator_nonce_t *rec, const validator_job_t *job,
+                       int ret, uint64_t t_valid)
+{
+    validator_share_t share;
+    avalon10_module_t *module = rec_module(rec);
+    
+    stat_add(&stats.validated, 1);
+    
+    if (module) {
+        avalon10_chip_account(g_avalon10_info, rec->module_id, rec->chip_id, rec->core_id, ret);
+    }
+    
+    if (ret < 0) {
+        stat_add(&stats.hw_errors, 1);
+        if (module) {
+            module->hw_errors++;
+            g_avalon10_info->total_hw_errors++;
+        }
+        log_message(LOG_DEBUG, "%s: HW Error: nonce 0x%08X (модуль %d, чип %d)",
+                   TAG, rec->nonce, rec->module_id, rec->chip_id);
+        return;
+    }
+    
+    stat_add(&stats.diff1, 1);
+    if (ret == 0) {
+        return;
+    }
+    
+    /* Шара прошла цель пула - в очередь отправки */
+    stat_add(&stats.shares, 1);
+    
+    memset(&share, 0, sizeof(share));
+    strncpy(share.job_id, job->job_id, sizeof(share.job_id) - 1);
+    work_format_submit(job->nonce2, job->nonce2_len, job->ntime, rec->nonce,
+                       share.nonce2_hex, share.ntime_hex, share.nonce_hex);
+    share.module_id = rec->module_id;
+    share.chip_id = rec->chip_id;
+    share.t_rx = rec->t_rx;
+    share.t_valid = t_valid;
+    
+    if (xQueueSend(submit_queue, &share, 0) != pdTRUE) {
+        stat_inc32(&stats.submit.drops);
+        log_message(LOG_WARNING, "%s: Очередь отправки переполнена", TAG);
+        return;
+    }
+    
+    stat_level(&stats.submit.depth, &stats.submit.depth_max,
+               uxQueueMessagesWaiting(submit_queue));
+}
+
+/**
+ * @brief Проверка записей одного задания
+ * 
+ * Заголовки отличаются только nonce - один снимок задания и один вызов
+ * hasher_sha256d_nonces() на группу.
+ * 
+ * @param recs      Записи с одинаковым job_idx
+ * @param n         Количество (до HASHER_BATCH_MAX)
+ */
+static void validate_group(const validator_nonce_t *const *recs, int n)
+{
+    static validator_job_t job;
+    static uint32_t nonces[HASHER_BATCH_MAX];
+    static uint8_t hashes[HASHER_BATCH_MAX * 32];
+    uint64_t t0, t1;
+    
+    if (!job_snapshot(recs[0]->job_idx, &job)) {
+        for (int i = 0; i < n; i++) {
+            avalon10_module_t *module = rec_module(recs[i]);
+    
+            stat_add(&stats.stale, 1);
+            if (module) module->stale++;
+        }
+        return;
+    }
+    
+    for (int i = 0; i < n; i++) {
+        nonces[i] = recs[i]->nonce;
+    }
+    
+    t0 = cgminer_time_us();
+    hasher_sha256d_nonces(job.header, nonces, n, hashes);
+    t1 = cgminer_time_us();
+    
+    stat_add(&stats.verify_us, t1 - t0);
+    
+    for (int i = 0; i < n; i++) {
+        finish_one(recs[i], &job, classify_hash(&job, hashes + i * 32), t1);
+    }
+}
+
+/**
+ * @brief Извлечение пакета записей из кольца (только validator)
+ * 
+ * @param out       Буфер записей
+ * @param max       Размер буфера
+ * @return          Количество извлечённых записей
+ */
+static int ring_pop_batch(validator_nonce_t *out, int max)
+{
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    uint32_t avail = head - tail;
+    int n = (avail < (uint32_t)max) ? (int)avail : max;
+    
+    for (int i = 0; i < n; i++) {
+        out[i] = ring[(tail + i) & RING_MASK];
+    }
+    
+    __atomic_store_n(&ring_tail, tail + n, __ATOMIC_RELEASE);
+    
+    return n;
+}
+
+/* ===========================================================================
+ * ЗАДАЧА ПРОВЕРКИ
+ * =========================================================================== */
+
+/**
+ * @brief Задача validator
+ * 
+ * Будится задачей опроса после каждого прохода выгрузки (или по таймауту),
+ * разбирает кольцо пакетами по VALIDATOR_BATCH_MAX записей. Пакет
+ * делится на группы одного задания в порядке первой записи группы.
+ */
+static void validator_task(void *pvParameters)
+{
+    static validator_nonce_t batch[VALIDATOR_BATCH_MAX];
+    static const validator_nonce_t *group[HASHER_BATCH_MAX];
+    static uint8_t done[VALIDATOR_BATCH_MAX];
+    int core_id;
+    int n;
+    
+    (void)pvParameters;
+    
+    core_id = (int)uxPortGetProcessorId();
+    log_message(LOG_DEBUG, "TASKSTART Core %d validator", core_id);
+    
+    while (!g_want_quit) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(VALIDATOR_IDLE_MS));
+    
+        while ((n = ring_pop_batch(batch, VALIDATOR_BATCH_MAX)) > 0) {
+            uint64_t now = cgminer_time_us();
+    
+            stat_add(&stats.batches, 1);
+            stat_max(&stats.batch_max, (uint32_t)n);
+    
+            for (int i = 0; i < n; i++) {
+                stage_account(&stats.ring, batch[i].t_rx, now);
+            }
+    
+            memset(done, 0, n);
+            for (int i = 0; i < n; i++) {
+                int k = 0;
+    
+                if (done[i]) {
+                    continue;
+                }
+                for (int j = i; j < n && k < HASHER_BATCH_MAX; j++) {
+                    if (!done[j] && batch[j].job_idx == batch[i].job_idx) {
+                        group[k++] = &batch[j];
+                        done[j] = 1;
+                    }
+                }
+                validate_group(group, k);
+            }
+        }
+    }
+    
+    vTaskDelete(NULL);
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Инициализация конвейера и запуск задачи validator
+ */
+int validator_init(void)
+{
+    if (validator_task_handle) {
+        return 0;
+    }
+    
+    memset(&stats, 0, sizeof(stats));
+    memset(jobs, 0, sizeof(jobs));
+    ring_head = 0;
+    ring_tail = 0;
+    
+    submit_queue = xQueueCreate(VALIDATOR_SUBMIT_QUEUE_LEN, sizeof(validator_share_t));
+    if (submit_queue == NULL) {
+        log_message(LOG_ERR, "%s: Не удалось создать очередь отправки", TAG);
+        return -1;
+    }
+    
+    if (cores_task_create(validator_task, "validator", VALIDATOR_TASK_STACK, NULL,
+                          VALIDATOR_TASK_PRIORITY, VALIDATOR_TASK_CORE,
+                          &validator_task_handle) != 0) {
+        log_message(LOG_ERR, "%s: Не удалось создать задачу", TAG);
+        return -1;
+    }
+    
+    log_message(LOG_INFO, "%s: Конвейер запущен (кольцо %d, ядро %d)",
+               TAG, VALIDATOR_RING_SIZE, VALIDATOR_TASK_CORE);
+    
+    return 0;
+}
+
+/**
+ * @brief Сохранение снимка задания, отправленного на ASIC
+ */
+void validator_job_publish(uint8_t job_idx, const work_t *work)
+{
+    validator_job_t *slot = &jobs[job_idx & JOB_MASK];
+    uint32_t seq;
+    
+    if (!work) {
+        return;
+    }
+    
+    seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    slot->valid = 1;
+    slot->job_idx = job_idx;
+    memcpy(slot->header, work->header, sizeof(slot->header));
+    memcpy(slot->target, work->target, sizeof(slot->target));
+    strncpy(slot->job_id, work->job_id, sizeof(slot->job_id) - 1);
+    slot->job_id[sizeof(slot->job_id) - 1] = '\0';
+    memcpy(slot->nonce2, work->nonce2, sizeof(slot->nonce2));
+    slot->nonce2_len = work->nonce2_len;
+    slot->ntime = work->ntime;
+    
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Помещение сырого nonce в кольцо (только задача опроса)
+ */
+int validator_push(const validator_nonce_t *rec)
+{
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+    
+    if (head - tail >= VALIDATOR_RING_SIZE) {
+        stat_inc32(&stats.ring.drops);
+        return -1;
+    }
+    
+    ring[head & RING_MASK] = *rec;
+    __atomic_store_n(&ring_head, head + 1, __ATOMIC_RELEASE);
+    
+    stat_level(&stats.ring.depth, &stats.ring.depth_max, head + 1 - tail);
+    
+    return 0;
+}
+
+/**
+ * @brief Пробуждение задачи validator после прохода опроса
+ */
+void validator_kick(void)
+{
+    if (validator_task_handle) {
+        xTaskNotifyGive(validator_task_handle);
+    }
+}
+
+/**
+ * @brief Отправка накопленных шар на пул
+ */
+int validator_submit_pending(pool_t *pool)
+{
+    validator_share_t share;
+    int sent = 0;
+    
+    if (!submit_queue || !pool) {
+        return 0;
+    }
+    
+    while (xQueueReceive(submit_queue, &share, 0) == pdTRUE) {
+        if (stratum_submit(pool, share.job_id, share.nonce2_hex,
+                           share.ntime_hex, share.nonce_hex) == 0) {
+            sent++;
+            if (g_avalon10_info && share.module_id < AVALON10_DEFAULT_MODULARS) {
+                g_avalon10_info->modules[share.module_id].accepted++;
+            }
+            log_message(LOG_INFO, "%s: Nonce 0x%s отправлен на пул (модуль %d, чип %d)",
+                       TAG, share.nonce_hex, share.module_id, share.chip_id);
+        } else {
+            log_message(LOG_WARNING, "%s: Ошибка отправки nonce", TAG);
+        }
+    
+        stage_account(&stats.submit, share.t_valid, cgminer_time_us());
+    }
+    
+    __atomic_store_n(&stats.submit.depth, (uint32_t)uxQueueMessagesWaiting(submit_queue),
+                     __ATOMIC_RELAXED);
+    
+    return sent;
+}
+
+/**
+ * @brief Снимок статистики конвейера
+ */
+void validator_get_stats(validator_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+    
+    memcpy(out, &stats, sizeof(*out));
+    
+    /* Глубину кольца пересчитываем по индексам - она меняется с двух сторон */
+    out->ring.depth = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE) -
+                      __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА validator.c
+ * =========================================================================== */
@@ -0,0 +1,186 @@
+/**
+ * =============================================================================
+ * @file    validator.h
+ * @brief   Avalon A1126pro - Конвейер проверки nonce (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Проверка nonce вынесена из цикла опроса ASIC в отдельный конвейер:
+ * 
+ *   asic_poll ──► [SPSC кольцо] ──► validator (ядро 1) ──► [очередь] ──► stratum_send
+ *   (сырые nonce)                   (SHA256d пакетами)                   (mining.submit)
+ * 
+ * 1. Задача опроса только кладёт сырые записи (модуль, чип, job, nonce)
+ *    в lock-free кольцо с одним писателем и одним читателем.
+ * 2. Задача validator, закреплённая за ядром майнинга K210, пакетно
+ *    проверяет их по снимкам заданий, отправленных на ASIC.
+ * 3. Прошедшие цель пула шары уходят в очередь отправки, которую
+ *    разбирает stratum_send_task.
+ * 
+ * Для каждой ступени публикуются глубина очереди и задержка.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __VALIDATOR_H__
+#define __VALIDATOR_H__
+
+#include <stdint.h>
+#include "cgminer.h"
+#include "pool.h"
+#include "cores.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Ёмкость кольца сырых nonce (степень двойки)
+ */
+#define VALIDATOR_RING_SIZE         1024
+
+/**
+ * @brief Ёмкость очереди шар на отправку
+ */
+#define VALIDATOR_SUBMIT_QUEUE_LEN  64
+
+/**
+ * @brief Максимум nonce, проверяемых за один проход
+ */
+#define VALIDATOR_BATCH_MAX         32
+
+/**
+ * @brief Количество снимков заданий (степень двойки)
+ * Задание ищется по job_idx, пришедшему вместе с nonce. У каждого модуля
+ * в очереди свои заголовки: слотов хватает на AVALON10_WORK_QUEUE_MAX
+ * заголовков на 4 модуля с запасом на nonce, выгруженные после смены
+ * заголовка
+ */
+#define VALIDATOR_JOB_SLOTS         64
+
+/**
+ * @brief Ядро и приоритет задачи проверки (см. cores.h)
+ * Validator работает на ядре майнинга рядом с задачей опроса ASIC
+ */
+#define VALIDATOR_TASK_CORE         CORE_MINING
+#define VALIDATOR_TASK_PRIORITY     TASK_PRIO_VALIDATOR
+#define VALIDATOR_TASK_STACK        4096
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct validator_nonce_t
+ * @brief Сырая запись nonce от задачи опроса
+ */
+typedef struct validator_nonce {
+    uint32_t nonce;                 /* Nonce от ASIC */
+    uint8_t module_id;              /* Модуль */
+    uint8_t chip_id;                /* Чип */
+    uint8_t core_id;                /* Ядро чипа */
+    uint8_t job_idx;                /* Индекс задания (work_id & 0xFF) */
+    uint64_t t_rx;                  /* Время выгрузки из ASIC (мкс) */
+} validator_nonce_t;
+
+/**
+ * @struct validator_share_t
+ * @brief Проверенная шара, готовая к mining.submit
+ */
+typedef struct validator_share {
+    char job_id[MAX_JOB_ID_LEN];    /* ID задания пула */
+    char nonce2_hex[17];            /* ExtraNonce2 (hex) */
+    char ntime_hex[9];              /* nTime (hex) */
+    char nonce_hex[9];              /* Nonce (hex) */
+    uint8_t module_id;              /* Модуль, нашедший шару */
+    uint8_t chip_id;                /* Чип, нашедший шару */
+    uint64_t t_rx;                  /* Время выгрузки из ASIC (мкс) */
+    uint64_t t_valid;               /* Время проверки (мкс) */
+} validator_share_t;
+
+/**
+ * @struct validator_stage_t
+ * @brief Статистика одной ступени конвейера
+ * 
+ * Задержка ступени - время от попадания записи в её входную очередь
+ * до завершения обработки.
+ */
+typedef struct validator_stage {
+    uint32_t depth;                 /* Текущая глубина входной очереди */
+    uint32_t depth_max;             /* Максимальная глубина */
+    uint32_t drops;                 /* Потеряно из-за переполнения */
+    uint64_t count;                 /* Обработано записей */
+    uint64_t lat_sum_us;            /* Сумма задержек (мкс) */
+    uint32_t lat_max_us;            /* Максимальная задержка (мкс) */
+} validator_stage_t;
+
+/**
+ * @struct validator_stats_t
+ * @brief Статистика конвейера проверки
+ */
+typedef struct validator_stats {
+    validator_stage_t ring;         /* Кольцо: опрос -> validator */
+    validator_stage_t submit;       /* Очередь: validator -> stratum_send */
+    uint64_t validated;             /* Проверено nonce */
+    uint64_t diff1;                 /* Nonce, прошедшие сложность 1 */
+    uint64_t shares;                /* Nonce, прошедшие цель пула */
+    uint64_t hw_errors;             /* Не прошли сложность 1 */
+    uint64_t stale;                 /* Задание уже вытеснено */
+    uint64_t batches;               /* Проходов проверки */
+    uint32_t batch_max;             /* Максимальный размер пакета */
+    uint64_t verify_us;             /* Суммарное время SHA256d (мкс) */
+} validator_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Инициализация конвейера и запуск задачи validator
+ * @return 0 при успехе, -1 при ошибке
+ */
+int validator_init(void);
+
+/**
+ * @brief Сохранение снимка задания, отправленного на ASIC
+ * 
+ * Вызывается при каждой отправке работы. Снимок хранится в слоте
+ * job_idx % VALIDATOR_JOB_SLOTS до вытеснения более новым заданием.
+ * 
+ * @param job_idx   Индекс задания, переданный ASIC
+ * @param work      Задание
+ */
+void validator_job_publish(uint8_t job_idx, const work_t *work);
+
+/**
+ * @brief Помещение сырого nonce в кольцо (только задача опроса)
+ * @param rec       Запись nonce
+ * @return          0 при успехе, -1 если кольцо заполнено
+ */
+int validator_push(const validator_nonce_t *rec);
+
+/**
+ * @brief Пробуждение задачи validator после прохода опроса
+ */
+void validator_kick(void);
+
+/**
+ * @brief Отправка накопленных шар на пул (вызывается из stratum_send_task)
+ * @param pool      Активный пул
+ * @return          Количество отправленных шар
+ */
+int validator_submit_pending(pool_t *pool);
+
+/**
+ * @brief Снимок статистики конвейера
+ * @param stats     Структура для результата
+ */
+void validator_get_stats(validator_stats_t *stats);
+
+#endif /* __VALIDATOR_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА validator.h
+ * =========================================================================== */
@@ -26,6 +26,8 @@
 #define W25QXX_CONFIG_ADDR      0x000000    /* Конфигурация (64 KB) */
 #define W25QXX_CONFIG_BACKUP    0x010000    /* Резервная конфигурация */
 #define W25QXX_LOG_ADDR         0x020000    /* Логи (256 KB) */
+#define W25QXX_TUNE_ADDR_A      0x060000    /* Настройки ASIC, копия A (4 KB) */
+#define W25QXX_TUNE_ADDR_B      0x061000    /* Настройки ASIC, копия B (4 KB) */
 #define W25QXX_FIRMWARE_ADDR    0x100000    /* Область прошивки */
 
 /**
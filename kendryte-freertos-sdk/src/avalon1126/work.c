@@ -27,7 +27,7 @@
 
 #include "work.h"
 #include "cgminer.h"
-#include "mock_hardware.h"
+#include "hasher.h"
 
 static const char *TAG = "Work";
 
@@ -35,16 +35,12 @@ static const char *TAG = "Work";
  * SHA256 ФУНКЦИИ
  * =========================================================================== */
 
-/* Используем программный SHA256 из mock_hardware.c */
-extern void mock_sha256(const uint8_t *data, size_t len, uint8_t *hash);
-extern void mock_sha256d(const uint8_t *data, size_t len, uint8_t *hash);
-
 /**
  * @brief Вычисление SHA256d (двойной SHA256)
  */
 static void sha256d(const uint8_t *data, size_t len, uint8_t *hash)
 {
-    mock_sha256d(data, len, hash);
+    hasher_sha256d(data, len, hash);
 }
 
 /**
@@ -52,7 +48,7 @@ static void sha256d(const uint8_t *data, size_t len, uint8_t *hash)
  */
 static void sha256(const uint8_t *data, size_t len, uint8_t *hash)
 {
-    mock_sha256(data, len, hash);
+    hasher_sha256(data, len, hash);
 }
 
 /* ===========================================================================
@@ -278,6 +274,30 @@ void work_calculate_target(work_t *work)
     }
 }
 
+/**
+ * @brief Сравнение хэша с целью
+ * 
+ * Хэш и цель - 256-битные little-endian числа, сравниваются со
+ * старшего байта.
+ * 
+ * @param hash      SHA256d заголовка
+ * @param target    Целевой хэш
+ * @return 1 если хэш не больше цели, 0 иначе
+ */
+int work_hash_meets_target(const uint8_t *hash, const uint8_t *target)
+{
+    for (int i = 31; i >= 0; i--) {
+        if (hash[i] < target[i]) {
+            return 1;  /* Хэш меньше target - валидный */
+        }
+        if (hash[i] > target[i]) {
+            return 0;  /* Хэш больше target - невалидный */
+        }
+    }
+    
+    return 1;  /* Хэш равен target - валидный (крайне редко) */
+}
+
 /**
  * @brief Проверка nonce
  * 
@@ -304,19 +324,43 @@ int work_check_nonce(work_t *work, uint32_t nonce)
     /* Вычисляем SHA256d */
     sha256d(header, 80, hash);
     
-    /* Проверяем против target */
     /* hash должен быть меньше target */
-    /* Сравниваем с конца (big-endian comparison) */
-    for (int i = 31; i >= 0; i--) {
-        if (hash[i] < work->target[i]) {
-            return 1;  /* Хэш меньше target - валидный */
-        }
-        if (hash[i] > work->target[i]) {
-            return 0;  /* Хэш больше target - невалидный */
+    return work_hash_meets_target(hash, work->target);
+}
+
+/**
+ * @brief Формирование строк для submit по полям задания
+ * 
+ * @param nonce2        ExtraNonce2
+ * @param nonce2_len    Длина ExtraNonce2 (до 8 байт)
+ * @param ntime         nTime
+ * @param nonce         Найденный nonce
+ * @param nonce2_hex    Буфер для extranonce2 (hex), NULL - не нужен
+ * @param ntime_hex     Буфер для ntime (hex), NULL - не нужен
+ * @param nonce_hex     Буфер для nonce (hex), NULL - не нужен
+ */
+void work_format_submit(const uint8_t *nonce2, int nonce2_len, uint32_t ntime,
+                        uint32_t nonce, char *nonce2_hex, char *ntime_hex,
+                        char *nonce_hex)
+{
+    /* ExtraNonce2 */
+    if (nonce2_hex) {
+        if (nonce2_len > 8) nonce2_len = 8;
+        for (int i = 0; i < nonce2_len; i++) {
+            sprintf(nonce2_hex + i * 2, "%02x", nonce2[i]);
         }
+        nonce2_hex[nonce2_len * 2] = '\0';
     }
     
-    return 1;  /* Хэш равен target - валидный (крайне редко) */
+    /* ntime */
+    if (ntime_hex) {
+        sprintf(ntime_hex, "%08x", (unsigned int)ntime);
+    }
+    
+    /* nonce */
+    if (nonce_hex) {
+        sprintf(nonce_hex, "%08x", (unsigned int)nonce);
+    }
 }
 
 /**
@@ -333,23 +377,8 @@ void work_get_submit_data(work_t *work, uint32_t nonce,
 {
     if (!work) return;
     
-    /* ExtraNonce2 */
-    if (nonce2_hex) {
-        for (int i = 0; i < work->nonce2_len; i++) {
-            sprintf(nonce2_hex + i * 2, "%02x", work->nonce2[i]);
-        }
-        nonce2_hex[work->nonce2_len * 2] = '\0';
-    }
-    
-    /* ntime */
-    if (ntime_hex) {
-        sprintf(ntime_hex, "%08x", work->ntime);
-    }
-    
-    /* nonce */
-    if (nonce_hex) {
-        sprintf(nonce_hex, "%08x", nonce);
-    }
+    work_format_submit(work->nonce2, work->nonce2_len, work->ntime, nonce,
+                       nonce2_hex, ntime_hex, nonce_hex);
 }
 
 /**
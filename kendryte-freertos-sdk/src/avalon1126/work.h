@@ -54,6 +54,14 @@ void work_calculate_target(work_t *work);
  */
 int work_check_nonce(work_t *work, uint32_t nonce);
 
+/**
+ * @brief Сравнение готового хэша с целью
+ * @param hash      SHA256d заголовка
+ * @param target    Целевой хэш
+ * @return 1 если хэш не больше цели, 0 иначе
+ */
+int work_hash_meets_target(const uint8_t *hash, const uint8_t *target);
+
 /**
  * @brief Получение данных для submit
  * @param work          Указатель на работу
@@ -65,6 +73,20 @@ int work_check_nonce(work_t *work, uint32_t nonce);
 void work_get_submit_data(work_t *work, uint32_t nonce,
                           char *nonce2_hex, char *ntime_hex, char *nonce_hex);
 
+/**
+ * @brief Получение данных для submit по полям задания (без work_t)
+ * @param nonce2        ExtraNonce2
+ * @param nonce2_len    Длина ExtraNonce2
+ * @param ntime         nTime
+ * @param nonce         Найденный nonce
+ * @param nonce2_hex    Буфер для extranonce2 (hex строка)
+ * @param ntime_hex     Буфер для ntime (hex строка)
+ * @param nonce_hex     Буфер для nonce (hex строка)
+ */
+void work_format_submit(const uint8_t *nonce2, int nonce2_len, uint32_t ntime,
+                        uint32_t nonce, char *nonce2_hex, char *ntime_hex,
+                        char *nonce_hex);
+
 /**
  * @brief Увеличение ExtraNonce2
  * @param work Указатель на работу
@@ -0,0 +1,430 @@
+/**
+ * =============================================================================
+ * @file    yieldmon.c
+ * @brief   Avalon A1126pro - Недобор nonce: мёртвые ядра и чипы (реализация)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Окна nonce сложности 1 по чипам, ожидание по медиане модуля,
+ * пуассоновская граница недобора и маски ядер без nonce.
+ * 
+ * =============================================================================
+ */
+
+/* ===========================================================================
+ * ПОДКЛЮЧАЕМЫЕ ЗАГОЛОВОЧНЫЕ ФАЙЛЫ
+ * =========================================================================== */
+
+#include <string.h>
+#include <math.h>
+
+#include "yieldmon.h"
+#include "cgminer.h"
+#include "throttle.h"
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ КОНСТАНТЫ
+ * =========================================================================== */
+
+static const char *TAG = "Yield";
+
+/* ===========================================================================
+ * ЛОКАЛЬНЫЕ ПЕРЕМЕННЫЕ
+ * =========================================================================== */
+
+static yieldmon_chip_t chips[AVALON10_DEFAULT_MODULARS][AVALON10_DEFAULT_MINER_CNT];
+static yieldmon_module_t mods[AVALON10_DEFAULT_MODULARS];
+static yieldmon_stats_t stats;
+static uint64_t poll_at_us;
+
+/* ===========================================================================
+ * ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Десятичный логарифм P(X ≤ k) для X ~ Пуассон(lambda)
+ * 
+ * P(X ≤ k) = P(χ²(2k + 2) ≥ 2λ); хвост χ² - по Уилсону-Хилферти, точность
+ * хватает для порога 10^-4 уже с k ≈ 10. При k = 0 - точно: e^-λ.
+ */
+static float poisson_log10_cdf(uint32_t k, float lambda)
+{
+    float n, z;
+    
+    if (k == 0) {
+        return -lambda * 0.4342945f;
+    }
+    if ((float)k >= lambda) {
+        return 0.0f;
+    }
+    
+    n = (float)k + 1.0f;
+    z = (cbrtf(lambda / n) - (1.0f - 1.0f / (9.0f * n))) * 3.0f * sqrtf(n);
+    
+    return log10f(0.5f * erfcf(z * 0.70710678f));
+}
+
+/**
+ * @brief Маска допустимых номеров ядер в слове w
+ */
+static uint32_t core_word_mask(int w)
+{
+    int bits = AVALON10_DEFAULT_ASIC_CORE - w * 32;
+    
+    return bits >= 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+}
+
+/**
+ * @brief Начало окна модуля
+ */
+static void window_start(avalon10_module_t *module, int m, uint32_t now)
+{
+    yieldmon_module_t *ym = &mods[m];
+    
+    cgminer_window_start(&ym->win, now, module->diff1, 0);
+    ym->expect = 0.0f;
+    
+    for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+        avalon10_chip_t *chip = &module->chips[c];
+        yieldmon_chip_t *yc = &chips[m][c];
+    
+        yc->diff1_0 = chip->diff1;
+        yc->exposure = 0.0f;
+        yc->fmax = 0;
+        for (int w = 0; w < AVALON10_CORE_MASK_WORDS; w++) {
+            __atomic_store_n(&chip->core_seen[w], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Замер секунды: экспозиция чипов и ожидание модуля по модели
+ */
+static void window_sample(const avalon10_module_t *module, int m, float dt)
+{
+    const throttle_module_t *tm = throttle_get_module(m);
+    yieldmon_module_t *ym = &mods[m];
+    
+    if (module->work_queued > 0) {
+        ym->expect += avalon10_expected_diff1(module) * dt * (tm->engaged ? tm->duty / 100.0f : 1.0f);
+    }
+    
+    for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+        const avalon10_chip_t *chip = &module->chips[c];
+        yieldmon_chip_t *yc = &chips[m][c];
+    
+        if (!chip->enabled) {
+            continue;
+        }
+        yc->exposure += chip->freq * dt;
+        yc->fmax = MAX(yc->fmax, chip->freq);
+    }
+}
+
+/**
+ * @brief Мёртвые ядра чипа: без nonce два окна подряд
+ * 
+ * @param core_lambda   Ожидаемых nonce на ядро за окно
+ */
+static void cores_close(avalon10_chip_t *chip, yieldmon_chip_t *yc, int m, int c, float core_lambda)
+{
+    uint32_t seen[AVALON10_CORE_MASK_WORDS];
+    int dead = 0;
+    
+    for (int w = 0; w < AVALON10_CORE_MASK_WORDS; w++) {
+        seen[w] = __atomic_exchange_n(&chip->core_seen[w], 0, __ATOMIC_RELAXED);
+    }
+    
+    /* Тишина ядра при малом ожидании ничего не значит */
+    if (core_lambda < YIELDMON_CORE_EXPECT) {
+        return;
+    }
+    
+    for (int w = 0; w < AVALON10_CORE_MASK_WORDS; w++) {
+        uint32_t miss = ~seen[w] & core_word_mask(w);
+    
+        yc->dead[w] = miss & yc->missing[w];
+        yc->missing[w] = miss;
+        dead += __builtin_popcount(yc->dead[w]);
+    }
+    
+    if (dead > yc->dead_cores) {
+        log_message(LOG_WARNING, "%s: Модуль %d чип %d: мёртвых ядер %d из %d",
+                   TAG, m, c, dead, AVALON10_DEFAULT_ASIC_CORE);
+        stats.changed_at = cgminer_time_s();
+    }
+    yc->dead_cores = (uint8_t)dead;
+}
+
+/**
+ * @brief Оценка чипа по окну
+ * 
+ * @param lambda    Ожидаемых nonce сложности 1 за окно
+ */
+static void chip_close(const avalon10_chip_t *chip, yieldmon_chip_t *yc, int m, int c,
+                       float lambda, uint32_t now)
+{
+    uint32_t got = chip->diff1 - yc->diff1_0;
+    int verdict = YIELDMON_CHIP_OK;
+    
+    if (lambda < YIELDMON_MIN_EXPECT / 4) {
+        yc->yield = YIELDMON_NO_YIELD;
+        return;
+    }
+    yc->yield = (uint16_t)MIN(got * 1000.0f / lambda, (float)(YIELDMON_NO_YIELD - 1));
+    
+    if (poisson_log10_cdf(got, lambda) < YIELDMON_P_LOG10) {
+        if (got * 100.0f < lambda * YIELDMON_DEAD_PCT) {
+            verdict = YIELDMON_CHIP_DEAD;
+        } else if (got * 100.0f < lambda * (100 - YIELDMON_SLOW_PCT)) {
+            verdict = YIELDMON_CHIP_SLOW;
+        }
+    }
+    
+    if (verdict == YIELDMON_CHIP_OK) {
+        yc->bad = 0;
+        yc->ok_freq = yc->fmax;
+        if (yc->state != YIELDMON_CHIP_OK) {
+            log_message(LOG_INFO, "%s: Модуль %d чип %d: nonce снова по ожиданию (%u‰, %d MHz)",
+                       TAG, m, c, yc->yield, yc->fmax);
+            yc->state = YIELDMON_CHIP_OK;
+            stats.changed_at = now;
+        }
+        return;
+    }
+    
+    if (yc->bad < 0xFF) {
+        yc->bad++;
+    }
+    if (yc->bad < YIELDMON_CONFIRM || yc->state == verdict) {
+        return;
+    }
+    
+    yc->state = (uint8_t)verdict;
+    if (verdict == YIELDMON_CHIP_SLOW) {
+        yc->slow_freq = yc->fmax;
+    }
+    stats.changed_at = now;
+    
+    log_message(LOG_WARNING, "%s: Модуль %d чип %d: %s, nonce %lu из %.0f ожидаемых (%u‰, %d MHz)",
+               TAG, m, c, yieldmon_state_str(verdict), (unsigned long)got, (double)lambda,
+               yc->yield, yc->fmax);
+}
+
+/**
+ * @brief Закрытие окна модуля
+ * 
+ * @return          1 - окно закрыто, 0 - ожидание ещё мало
+ */
+static int window_close(avalon10_module_t *module, int m, uint32_t now)
+{
+    yieldmon_module_t *ym = &mods[m];
+    float rate[AVALON10_DEFAULT_MINER_CNT];
+    float esum = 0.0f, median;
+    uint32_t live = 0;
+    int n = 0, slow = 0, dead = 0, dead_cores = 0;
+    
+    /* Выход на МГц · с живых ядер по чипам - по возрастанию */
+    for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+        const yieldmon_chip_t *yc = &chips[m][c];
+        float e = yc->exposure * (AVALON10_DEFAULT_ASIC_CORE - yc->dead_cores) /
+                  AVALON10_DEFAULT_ASIC_CORE;
+        float r;
+        int i;
+    
+        if (!module->chips[c].enabled || e <= 0.0f) {
+            continue;
+        }
+        r = (module->chips[c].diff1 - yc->diff1_0) / e;
+        for (i = n++; i > 0 && rate[i - 1] > r; i--) {
+            rate[i] = rate[i - 1];
+        }
+        rate[i] = r;
+        esum += e;
+    }
+    
+    median = n ? (n & 1 ? rate[n / 2] : (rate[n / 2 - 1] + rate[n / 2]) / 2.0f) : 0.0f;
+    
+    if (!n || median * esum / n < YIELDMON_MIN_EXPECT) {
+        if (now - ym->win.at >= YIELDMON_WINDOW_MAX_S) {
+            window_start(module, m, now);
+        }
+        return 0;
+    }
+    
+    for (int c = 0; c < AVALON10_DEFAULT_MINER_CNT; c++) {
+        avalon10_chip_t *chip = &module->chips[c];
+        yieldmon_chip_t *yc = &chips[m][c];
+    
+        if (!chip->enabled) {
+            continue;
+        }
+    
+        chip_close(chip, yc, m, c,
+                   median * yc->exposure * (AVALON10_DEFAULT_ASIC_CORE - yc->dead_cores) /
+                   AVALON10_DEFAULT_ASIC_CORE, now);
+        cores_close(chip, yc, m, c, median * yc->exposure / AVALON10_DEFAULT_ASIC_CORE);
+    
+        slow += yc->state == YIELDMON_CHIP_SLOW;
+        dead += yc->state == YIELDMON_CHIP_DEAD;
+        dead_cores += yc->dead_cores;
+        live += AVALON10_DEFAULT_ASIC_CORE - yc->dead_cores;
+    }
+    
+    ym->yield = ym->expect >= YIELDMON_MIN_EXPECT ?
+                (uint16_t)MIN((module->diff1 - ym->win.count0) * 1000.0f / ym->expect,
+                              (float)(YIELDMON_NO_YIELD - 1)) :
+                YIELDMON_NO_YIELD;
+    ym->capacity = (uint16_t)(live * 1000 / AVALON10_CORES_PER_MODULE);
+    ym->slow = (uint8_t)slow;
+    ym->dead = (uint8_t)dead;
+    ym->dead_cores = (uint16_t)dead_cores;
+    
+    /* Потеряна доля ядер платы - кандидат на ремонт */
+    if (!ym->degraded && ym->capacity < 1000 - YIELDMON_RMA_PCT * 10) {
+        ym->degraded = 1;
+        stats.changed_at = now;
+        log_message(LOG_WARNING, "%s: Модуль %d деградировал: живых ядер %u‰ "
+                   "(мёртвых %d, чипов SLOW %d, DEAD %d, выключено %d)",
+                   TAG, m, ym->capacity, dead_cores, slow, dead, module->failed_chips);
+    } else if (ym->degraded && ym->capacity >= 1000 - YIELDMON_RMA_PCT * 10) {
+        ym->degraded = 0;
+        stats.changed_at = now;
+    }
+    
+    stats.windows++;
+    window_start(module, m, now);
+    return 1;
+}
+
+/* ===========================================================================
+ * ПУБЛИЧНЫЕ ФУНКЦИИ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг оценки
+ */
+void yieldmon_poll(avalon10_info_t *info)
+{
+    uint64_t now_us = cgminer_time_us();
+    uint32_t now = cgminer_time_s();
+    int slow = 0, dead = 0, dead_cores = 0, degraded = 0;
+    float dt;
+    
+    if (!info || !info->initialized || !info->mining_enabled) {
+        poll_at_us = 0;
+        return;
+    }
+    
+    dt = cgminer_poll_dt(&poll_at_us, now_us, 0.0f);
+    
+    for (int m = 0; m < AVALON10_DEFAULT_MODULARS; m++) {
+        avalon10_module_t *module = &info->modules[m];
+        yieldmon_module_t *ym = &mods[m];
+    
+        if (module->state == AVALON10_MODULE_STATE_NONE) {
+            continue;
+        }
+    
+        /* Окно - только непрерывный майнинг; окно модуля заново - и окна чипов */
+        if (module->state != AVALON10_MODULE_STATE_MINING) {
+            ym->win.at = 0;
+        } else if (!cgminer_window_check(&ym->win, now, module->diff1, 0)) {
+            window_start(module, m, now);
+        } else {
+            window_sample(module, m, dt);
+            if (now - ym->win.at >= YIELDMON_WINDOW_S) {
+                window_close(module, m, now);
+            }
+        }
+    
+        slow += ym->slow;
+        dead += ym->dead;
+        dead_cores += ym->dead_cores;
+        degraded += ym->degraded;
+    }
+    
+    stats.slow = (uint16_t)slow;
+    stats.dead = (uint16_t)dead;
+    stats.dead_cores = (uint16_t)dead_cores;
+    stats.degraded = (uint8_t)degraded;
+}
+
+/**
+ * @brief Оценка заново
+ */
+void yieldmon_reset(void)
+{
+    memset(chips, 0, sizeof(chips));
+    memset(mods, 0, sizeof(mods));
+    memset(&stats, 0, sizeof(stats));
+    
+    log_message(LOG_INFO, "%s: Оценка заново", TAG);
+}
+
+/**
+ * @brief Частота, на которой чип теряет nonce
+ */
+int yieldmon_freq_limit(int module_id, int chip_id)
+{
+    const yieldmon_chip_t *yc = yieldmon_get_chip(module_id, chip_id);
+    
+    /* Только если ниже этой частоты чип работал без недобора */
+    if (!yc || yc->state != YIELDMON_CHIP_SLOW || !yc->ok_freq || yc->slow_freq <= yc->ok_freq) {
+        return 0;
+    }
+    
+    return yc->slow_freq;
+}
+
+/**
+ * @brief Название состояния чипа
+ */
+const char *yieldmon_state_str(int state)
+{
+    switch (state) {
+        case YIELDMON_CHIP_OK:   return "OK";
+        case YIELDMON_CHIP_SLOW: return "Slow";
+        case YIELDMON_CHIP_DEAD: return "Dead";
+        default:                 return "Unknown";
+    }
+}
+
+/**
+ * @brief Оценка чипа
+ */
+const yieldmon_chip_t *yieldmon_get_chip(int module_id, int chip_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS ||
+        chip_id < 0 || chip_id >= AVALON10_DEFAULT_MINER_CNT) {
+        return NULL;
+    }
+    
+    return &chips[module_id][chip_id];
+}
+
+/**
+ * @brief Оценка модуля
+ */
+const yieldmon_module_t *yieldmon_get_module(int module_id)
+{
+    if (module_id < 0 || module_id >= AVALON10_DEFAULT_MODULARS) {
+        return NULL;
+    }
+    
+    return &mods[module_id];
+}
+
+/**
+ * @brief Состояние
+ */
+const yieldmon_stats_t *yieldmon_get_stats(void)
+{
+    return &stats;
+}
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА yieldmon.c
+ * =========================================================================== */
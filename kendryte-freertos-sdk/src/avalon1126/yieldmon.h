@@ -0,0 +1,206 @@
+/**
+ * =============================================================================
+ * @file    yieldmon.h
+ * @brief   Avalon A1126pro - Недобор nonce: мёртвые ядра и чипы (заголовочный файл)
+ * @version 1.0
+ * @date    2024
+ * =============================================================================
+ * 
+ * ОПИСАНИЕ:
+ * Чип может потерять часть из 72 ядер без HW ошибок - он просто находит
+ * меньше nonce. Модуль сравнивает число nonce сложности 1 каждого чипа с
+ * ожидаемым по его частоте и числу живых ядер и отмечает чипы и ядра с
+ * недобором. Итог - доля живых ядер модуля для решения о ремонте платы.
+ * 
+ * ОЖИДАНИЕ (окно YIELDMON_WINDOW_S, все чипы модуля вместе):
+ * - Экспозиция чипа - сумма f · dt за окно (МГц · с), так что смена
+ *   частоты внутри окна учтена; умноженная на долю живых ядер.
+ * - Выход на МГц · с - медиана по включённым чипам модуля. Медиана
+ *   устойчива к половине плохих чипов и не зависит от скважности
+ *   throttle и пауз в заданиях: они одинаковы для всех чипов модуля.
+ * - Ожидание чипа λ = медиана · экспозиция. Пока у типичного чипа
+ *   λ < YIELDMON_MIN_EXPECT, окно продлевается (до YIELDMON_WINDOW_MAX_S).
+ * 
+ * ПРИЗНАКИ:
+ * - Чип: P(X ≤ nonce | Пуассон(λ)) < 10^YIELDMON_P_LOG10 и nonce меньше
+ *   λ на YIELDMON_SLOW_PCT % (SLOW) или меньше YIELDMON_DEAD_PCT % λ
+ *   (DEAD). Признак YIELDMON_CONFIRM окон подряд - состояние чипа.
+ * - Ядро: номер ядра есть в каждой nonce-записи. Ядро без единого nonce
+ *   два окна подряд, когда на ядро ожидалось от YIELDMON_CORE_EXPECT
+ *   nonce (вероятность тишины у живого ядра e^-16), мёртвое. Мёртвые
+ *   ядра уменьшают ожидание чипа: недобор SLOW - сверх них.
+ * - Модуль: живые ядра включённых чипов от всех ядер платы (выключенные
+ *   health чипы - потерянные ядра). Потеряно YIELDMON_RMA_PCT % и больше -
+ *   плата деградировала. Отдельно - выход модуля от модели
+ *   avalon10_expected_diff1() (с учётом скважности throttle).
+ * 
+ * СВЯЗЬ С AUTOTUNE:
+ * Чип в SLOW, который работал без недобора на частоте ниже, теряет
+ * ядра от частоты (ошибки тайминга без HW ошибок). yieldmon_freq_limit()
+ * отдаёт autotune частоту недобора: чип снижается на шаг ниже неё, и
+ * частота становится потолком, как при превышении бюджета HW ошибок.
+ * 
+ * =============================================================================
+ */
+
+#ifndef __YIELDMON_H__
+#define __YIELDMON_H__
+
+#include <stdint.h>
+
+#include "avalon10.h"
+
+/* ===========================================================================
+ * КОНСТАНТЫ
+ * =========================================================================== */
+
+/**
+ * @brief Окно оценки (секунды) и предел продления
+ */
+#define YIELDMON_WINDOW_S           60
+#define YIELDMON_WINDOW_MAX_S       600
+
+/**
+ * @brief Ожидаемых nonce у типичного чипа, чтобы закрыть окно
+ */
+#define YIELDMON_MIN_EXPECT         200
+
+/**
+ * @brief Порог вероятности недобора (десятичный логарифм)
+ */
+#define YIELDMON_P_LOG10            (-4.0f)
+
+/**
+ * @brief Окон с недобором подряд до смены состояния чипа
+ */
+#define YIELDMON_CONFIRM            2
+
+/**
+ * @brief Недобор SLOW (%) и остаток DEAD (% от ожидания)
+ */
+#define YIELDMON_SLOW_PCT           5
+#define YIELDMON_DEAD_PCT           10
+
+/**
+ * @brief Ожидаемых nonce на ядро, чтобы считать тишину ядра
+ */
+#define YIELDMON_CORE_EXPECT        16
+
+/**
+ * @brief Потерянных ядер платы для деградации (%)
+ */
+#define YIELDMON_RMA_PCT            5
+
+/**
+ * @brief Нет оценки (поле yield)
+ */
+#define YIELDMON_NO_YIELD           0xFFFF
+
+/**
+ * @brief Состояния чипа
+ */
+#define YIELDMON_CHIP_OK            0   /* Nonce по ожиданию */
+#define YIELDMON_CHIP_SLOW          1   /* Недобор */
+#define YIELDMON_CHIP_DEAD          2   /* Почти нет nonce */
+
+/* ===========================================================================
+ * СТРУКТУРЫ ДАННЫХ
+ * =========================================================================== */
+
+/**
+ * @struct yieldmon_chip_t
+ * @brief Оценка чипа
+ */
+typedef struct yieldmon_chip {
+    uint8_t state;                  /* YIELDMON_CHIP_* */
+    uint8_t bad;                    /* Окон с недобором подряд */
+    uint8_t dead_cores;             /* Мёртвых ядер */
+    uint16_t yield;                 /* Nonce прошлого окна от ожидания (‰) */
+    uint16_t fmax;                  /* Наибольшая частота в окне (MHz) */
+    uint16_t ok_freq;               /* Частота последнего окна без недобора (MHz) */
+    uint16_t slow_freq;             /* Частота, на которой подтверждён SLOW (MHz) */
+    uint32_t diff1_0;               /* chip->diff1 в начале окна */
+    float exposure;                 /* Сумма f · dt в окне (МГц · с) */
+    uint32_t missing[AVALON10_CORE_MASK_WORDS];     /* Ядра без nonce в прошлом окне */
+    uint32_t dead[AVALON10_CORE_MASK_WORDS];        /* Мёртвые ядра */
+} yieldmon_chip_t;
+
+/**
+ * @struct yieldmon_module_t
+ * @brief Оценка модуля
+ */
+typedef struct yieldmon_module {
+    cgminer_window_t win;           /* Окно module->diff1 */
+    float expect;                   /* Ожидаемых по модели nonce в окне */
+    uint16_t yield;                 /* Nonce прошлого окна от модели (‰) */
+    uint16_t capacity;              /* Живые ядра включённых чипов от всех (‰) */
+    uint16_t dead_cores;            /* Мёртвых ядер во включённых чипах */
+    uint8_t slow;                   /* Чипов в SLOW */
+    uint8_t dead;                   /* Чипов в DEAD */
+    uint8_t degraded;               /* 1 = потеряно YIELDMON_RMA_PCT % ядер */
+} yieldmon_module_t;
+
+/**
+ * @struct yieldmon_stats_t
+ * @brief Состояние (для API)
+ */
+typedef struct yieldmon_stats {
+    uint16_t slow;                  /* Чипов в SLOW */
+    uint16_t dead;                  /* Чипов в DEAD */
+    uint16_t dead_cores;            /* Мёртвых ядер */
+    uint8_t degraded;               /* Деградировавших модулей */
+    uint32_t windows;               /* Закрытых окон модулей */
+    uint32_t changed_at;            /* uptime последней смены состояния (с) */
+} yieldmon_stats_t;
+
+/* ===========================================================================
+ * ПРОТОТИПЫ ФУНКЦИЙ
+ * =========================================================================== */
+
+/**
+ * @brief Шаг оценки (раз в секунду, задача monitor, перед autotune_poll)
+ * 
+ * @param info      Указатель на структуру информации
+ */
+void yieldmon_poll(avalon10_info_t *info);
+
+/**
+ * @brief Оценка заново: состояния, ядра и окна всех модулей
+ */
+void yieldmon_reset(void);
+
+/**
+ * @brief Частота, на которой чип теряет nonce (для autotune)
+ * 
+ * @return          Частота SLOW (MHz), если ниже неё чип работал без
+ *                  недобора; 0 - ограничения нет
+ */
+int yieldmon_freq_limit(int module_id, int chip_id);
+
+/**
+ * @brief Название состояния чипа
+ */
+const char *yieldmon_state_str(int state);
+
+/**
+ * @brief Оценка чипа
+ * @return          NULL при неверных номерах
+ */
+const yieldmon_chip_t *yieldmon_get_chip(int module_id, int chip_id);
+
+/**
+ * @brief Оценка модуля
+ * @return          NULL при неверном номере
+ */
+const yieldmon_module_t *yieldmon_get_module(int module_id);
+
+/**
+ * @brief Состояние
+ */
+const yieldmon_stats_t *yieldmon_get_stats(void);
+
+#endif /* __YIELDMON_H__ */
+
+/* ===========================================================================
+ * КОНЕЦ ФАЙЛА yieldmon.h
+ * =========================================================================== */